@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: BSD-2-Clause
+#
+# Generator for the compiler-scaling corpus: synthetic MyLang programs of a
+# given size (10k-200k lines) that stress one part of the compile pipeline
+# each, so a compile-time regression in the lexer, parser, inferencer or
+# resolver shows up as a number instead of as a slow production launch.
+#
+# The programs are cheap to RUN (a handful of calls at the end, printing one
+# `result:` line): the time that matters is the compile, which
+# `mylang --time-passes=csv` reports per stage. bench/run.py --compile drives
+# it; this script can also write the programs out on its own for a profiler:
+#
+#   python3 bench/gen_compile.py --kind funcs --lines 50000 -o /tmp/f.my
+#   python3 bench/gen_compile.py --list
+#
+# Kinds:
+#   funcs         thousands of small functions with loops, ifs and locals
+#   nesting       functions nested 24 statements deep, deep expressions
+#   structs       thousands of struct types, constructed and field-accessed
+#   literals      huge literal arrays and dicts
+#   inline_chain  long chains of tiny expression functions (inliner food)
+
+import argparse
+import sys
+
+
+def gen_funcs(lines):
+    out = ["func g(int a, int b) { return a * b + 1; }"]
+    i = 0
+    while len(out) < lines:
+        call = " + g(a, b)" if i % 2 else ""
+        prev = " + h%d(a - 1, b)" % (i - 1) if i and i % 7 == 0 else ""
+        out += [
+            "func h%d(int a, int b) {" % i,
+            "    var s = 0;",
+            "    if (a <= 0) { return b; }",
+            "    for (var k = 0; k < a; k++) {",
+            "        if (k %% 3 == 0) { s += k * b; } else { s -= %d; }" % (i % 5),
+            "    }",
+            "    var arr = [a, b, s];",
+            "    foreach (var x in arr) { s += x; }",
+            "    return s%s%s;" % (call, prev),
+            "}",
+        ]
+        i += 1
+    out.append("var r = 0;")
+    out.append("for (var j = 0; j < %d; j += %d) { r += j; }" % (i, max(i // 8, 1)))
+    out.append("print(\"result:\", h%d(3, 4) + r);" % (i - 1))
+    return out
+
+
+def gen_nesting(lines, depth=24):
+    out = []
+    i = 0
+    while len(out) < lines:
+        out.append("func n%d(int a) {" % i)
+        out.append("    var s = 0;")
+        ind = "    "
+        for d in range(depth):
+            if d % 3 == 0:
+                out.append("%sif (a > %d) {" % (ind, d))
+            elif d % 3 == 1:
+                out.append("%sfor (var k%d = 0; k%d < 2; k%d++) {" % (ind, d, d, d))
+            else:
+                out.append("%s{" % ind)
+            ind += "    "
+            out.append("%ss += %s;" % (ind, "(" * 8 + "a" + " + 1)" * 8))
+        for d in range(depth):
+            ind = ind[:-4]
+            out.append("%s}" % ind)
+        out.append("    return s;")
+        out.append("}")
+        i += 1
+    out.append("print(\"result:\", n%d(1));" % (i - 1))
+    return out
+
+
+def gen_structs(lines):
+    out = []
+    i = 0
+    while len(out) < lines:
+        out += [
+            "struct S%d { int a; int b; float c; array<int> d; int e; }" % i,
+            "func mk%d(int v) {" % i,
+            "    var s = S%d(v, v + 1, 0.5, [v], %d);" % (i, i),
+            "    s.a += s.b * s.e;",
+            "    s.c = s.c + s.a;",
+            "    append(s.d, s.b);",
+            "    return s.a + len(s.d);",
+            "}",
+        ]
+        i += 1
+    out.append("print(\"result:\", mk0(1) + mk%d(2));" % (i - 1))
+    return out
+
+
+def gen_literals(lines, arr_len=1000, dict_len=500):
+    out = ["var b = 1;"]
+    i = 0
+    while len(out) < lines:
+        # every other pair is built at run time (a var in each row), the rest
+        # folds to a constant at parse time
+        var = "b, " if i % 2 else ""
+        rows = [var + ", ".join(str((r + k) * 7 % 1009) for k in range(10))
+                for r in range(0, arr_len, 10)]
+        out.append("var a%d = [" % i)
+        out += ["    " + row + "," for row in rows[:-1]]
+        out.append("    " + rows[-1])
+        out.append("];")
+        rows = [", ".join("\"k%d\": %s" % (r + k, "b" if var and not k
+                                               else str(r + k))
+                          for k in range(5))
+                for r in range(0, dict_len, 5)]
+        out.append("var d%d = {" % i)
+        out += ["    " + row + "," for row in rows[:-1]]
+        out.append("    " + rows[-1])
+        out.append("};")
+        i += 1
+    out.append("print(\"result:\", len(a0) + a%d[3] + d%d[\"k7\"]);"
+               % (i - 1, i - 1))
+    return out
+
+
+def gen_inline_chain(lines, chain=40):
+    out = []
+    c = 0
+    while len(out) < lines:
+        out.append("func c%d_0(x) => x + %d;" % (c, c % 10))
+        for k in range(1, chain):
+            op = "+" if k % 2 else "*"
+            out.append("func c%d_%d(x) => c%d_%d(x) %s %d;"
+                       % (c, k, c, k - 1, op, k % 3 + 1))
+        out.append("var v%d = c%d_%d(%d);" % (c, c, chain - 1, c % 4))
+        c += 1
+    out.append("print(\"result:\", v0 + v%d);" % (c - 1))
+    return out
+
+
+KINDS = {
+    "funcs": gen_funcs,
+    "nesting": gen_nesting,
+    "structs": gen_structs,
+    "literals": gen_literals,
+    "inline_chain": gen_inline_chain,
+}
+
+
+def generate(kind, lines):
+    """The program text for `kind`, at least `lines` lines long."""
+    return "\n".join(KINDS[kind](lines)) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(
+        description="generate a compiler-scaling MyLang program")
+    ap.add_argument("--kind", choices=sorted(KINDS), default="funcs")
+    ap.add_argument("--lines", type=int, default=10000,
+                    help="approximate program size in lines (default 10000)")
+    ap.add_argument("-o", "--output", default="-",
+                    help="output file (default stdout)")
+    ap.add_argument("--list", action="store_true",
+                    help="list the program kinds and exit")
+    args = ap.parse_args()
+
+    if args.list:
+        print("\n".join(sorted(KINDS)))
+        return
+
+    text = generate(args.kind, args.lines)
+    if args.output == "-":
+        sys.stdout.write(text)
+    else:
+        with open(args.output, "w") as f:
+            f.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -23,13 +23,26 @@
 #   python3 bench/run.py --csv out.csv   # also write the table as CSV
 #   python3 bench/run.py -s              # also re-dump sorted by ratio (wins
 #                                        # first, regressions last)
+#   python3 bench/run.py --compile       # compile-time scaling instead: time
+#                                        # each pipeline stage on generated
+#                                        # 10k-200k line programs (see
+#                                        # gen_compile.py; --compile-lines)
+#   python3 bench/run.py --startup       # per-process startup instead: launch
+#                                        # tiny scripts many times (as a shell
+#                                        # pipeline does; --startup-runs)
 
 import argparse
+import csv
+import io
 import os
+import re
 import subprocess
 import sys
+import tempfile
 import time
 
+import gen_compile
+
 HERE = os.path.dirname(os.path.abspath(__file__))
 MY_DIR = os.path.join(HERE, "my")
 PY_DIR = os.path.join(HERE, "py")
@@ -210,6 +223,349 @@ def results_match(a, b):
     return True
 
 
+# The pipeline stages reported for --compile: (column, pass name, depth) as
+# `mylang --time-passes=csv` prints them.
+COMPILE_STAGES = [
+    ("lex", "lex", 0),
+    ("parse", "parse", 0),
+    ("infer", "infer types", 0),
+    ("resolve", "resolve names", 1),
+    ("inline", "inline", 1),
+    ("licm", "licm", 1),
+    ("specialize", "specialize types", 1),
+]
+
+
+def parse_passes(err):
+    """The --time-passes rows in a run's stderr as (name, depth, ms), plus
+    (total_ms, peak_rss_kb) or None. Reads the CSV form, or the table an
+    older binary prints (see time_passes_flag)."""
+    rows, total = [], None
+    start = err.find("pass,depth,")
+    if start >= 0:
+        for r in csv.DictReader(io.StringIO(err[start:])):
+            if r["pass"] == "total":
+                total = (float(r["wall_ms"]), int(r["rss_kb"]))
+            else:
+                rows.append((r["pass"], int(r["depth"]), float(r["wall_ms"])))
+        return rows, total
+    start = err.find("\nCompile passes\n")
+    if start < 0:
+        return rows, total
+    for line in err[start:].splitlines()[4:]:
+        label = line[2:28].rstrip()
+        fields = line[28:].split()
+        if not label or not fields:
+            continue
+        if label == "total":
+            rss = re.search(r"peak RSS (\d+) KB", line)
+            total = (float(fields[0]), int(rss.group(1)) if rss else 0)
+            break
+        name = label.lstrip()
+        rows.append((name, (len(label) - len(name)) // 2, float(fields[0])))
+    return rows, total
+
+
+_passes_flags = {}
+
+
+def time_passes_flag(mylang):
+    """`--time-passes=csv`, or plain `--time-passes` for a binary older than
+    the CSV form - so --baseline can be a build from before it."""
+    if mylang not in _passes_flags:
+        try:
+            p = subprocess.run([mylang, "--time-passes=csv", "-e", "1;"],
+                               stdout=subprocess.DEVNULL,
+                               stderr=subprocess.PIPE, timeout=30)
+            ok = b"pass,depth," in p.stderr
+        except (OSError, subprocess.TimeoutExpired):
+            ok = False
+        _passes_flags[mylang] = "--time-passes=csv" if ok else "--time-passes"
+    return _passes_flags[mylang]
+
+
+def time_compile(mylang, path, repeat, timeout):
+    """Compile+run `path` `repeat` times under --time-passes; return
+    (stage_ms dict of the fastest run by total compile time, error_or_None).
+    The dict also has "total" (ms) and "rss" (peak KB)."""
+    best = None
+    for _ in range(repeat):
+        try:
+            p = subprocess.run([mylang, time_passes_flag(mylang), path],
+                               stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                               timeout=timeout)
+        except subprocess.TimeoutExpired:
+            return (None, "timeout")
+        except OSError as e:
+            return (None, str(e))
+        out = p.stdout.decode("utf-8", "replace")
+        if p.returncode != 0 or "result:" not in out:
+            return (None, "exit %d" % p.returncode)
+        rows, total = parse_passes(p.stderr.decode("utf-8", "replace"))
+        if not total:
+            return (None, "no --time-passes output")
+        ms = {"total": total[0], "rss": total[1]}
+        for pname, depth, wall in rows:
+            for col, name, d in COMPILE_STAGES:
+                if pname == name and depth == d:
+                    ms[col] = ms.get(col, 0.0) + wall
+        if best is None or ms["total"] < best["total"]:
+            best = ms
+    return (best, None)
+
+
+def run_compile(args, mylang):
+    """--compile: time each pipeline stage on the generated corpus."""
+    kinds = sorted(gen_compile.KINDS)
+    if args.filter:
+        subs = [s for s in args.filter.split(",") if s]
+        kinds = [k for k in kinds if any(s in k for s in subs)]
+    if not kinds:
+        sys.exit("no compile benchmarks matched")
+    sizes = [int(n) for n in args.compile_lines.split(",") if n]
+
+    has_base = bool(args.baseline)
+    print("mylang : %s" % mylang)
+    if has_base:
+        print("baseline: %s" % args.baseline)
+    print("sizes  : %s lines    repeat (best of): %d\n"
+          % (", ".join(str(n) for n in sizes), args.repeat))
+
+    warn = optimization_warning(mylang)
+    if warn:
+        print(warn + "\n")
+
+    cols = [c for c, _n, _d in COMPILE_STAGES] + ["total"]
+    hdr = "%-22s %7s" % ("benchmark", "lines")
+    hdr += "".join(" %9s" % c for c in cols) + " %8s" % "rss MB"
+    if has_base:
+        hdr += " %9s %8s" % ("base", "cur/base")
+    print("compile ms per stage (fastest run)")
+    print(hdr)
+    print("-" * len(hdr))
+
+    rows = []
+    speedups = []
+    with tempfile.TemporaryDirectory(prefix="mylang-compile-") as tmp:
+        for kind in kinds:
+            for lines in sizes:
+                name = "%s_%dk" % (kind, lines // 1000)
+                text = gen_compile.generate(kind, lines)
+                path = os.path.join(tmp, name + ".my")
+                with open(path, "w") as f:
+                    f.write(text)
+                nlines = text.count("\n")
+
+                ms, err = time_compile(mylang, path, args.repeat, args.timeout)
+                base = None
+                if has_base:
+                    base, _berr = time_compile(args.baseline, path,
+                                               args.repeat, args.timeout)
+
+                out = "%-22s %7d" % (name, nlines)
+                if err:
+                    out += "  " + err
+                else:
+                    out += "".join(" %9.1f" % ms.get(c, 0.0) for c in cols)
+                    out += " %8.1f" % (ms["rss"] / 1024.0)
+                speedup = None
+                if has_base:
+                    if base and ms:
+                        speedup = ms["total"] / base["total"]
+                        speedups.append(speedup)
+                        out += " %9.1f %s" % (base["total"], colorize_ratio(
+                            speedup, "%7.2fx" % speedup))
+                    else:
+                        out += " %9s %8s" % ("-", "-")
+                print(out)
+                sys.stdout.flush()
+                rows.append((name, nlines, ms, err, base, speedup))
+
+    if speedups:
+        sp_v = geomean(speedups)
+        print("-" * len(hdr))
+        print("geomean cur/base compile time over %d programs: %s"
+              % (len(speedups), colorize_ratio(sp_v, "%.2fx" % sp_v)))
+
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write("benchmark,lines,%s,peak_rss_kb,status"
+                    % ",".join(c + "_ms" for c in cols))
+            f.write(",base_total_ms,cur_over_base\n" if has_base else "\n")
+            for name, nlines, ms, err, base, speedup in rows:
+                if err:
+                    vals = ["-"] * (len(cols) + 1)
+                else:
+                    vals = ["%.3f" % ms.get(c, 0.0) for c in cols]
+                    vals.append(str(ms["rss"]))
+                f.write("%s,%d,%s,%s" % (name, nlines, ",".join(vals),
+                                         err or "ok"))
+                if has_base:
+                    f.write(",%s,%s" % (
+                        "%.3f" % base["total"] if base else "-",
+                        "%.3f" % speedup if speedup else "-"))
+                f.write("\n")
+        print("\nwrote %s" % args.csv)
+
+
+# --startup cases: (name, mylang args, python source). Each is a script small
+# enough that launching the process is nearly all of its cost. The "script"
+# case is a file (STARTUP_SCRIPT_MY/PY) run with two arguments.
+STARTUP_CASES = [
+    ("noop", ["-e", "1;"], "1"),
+    ("print", ["-e", "print(1);"], "print(1)"),
+    ("builtins",
+     ["-e", 'print(len("abc") + int(sqrt(16.0)) + sum([1, 2]));'],
+     'import math; print(len("abc") + int(math.sqrt(16.0)) + sum([1, 2]))'),
+    ("rand", ["-e", "print(rand(1, 6) * 0 + 1);"],
+     "import random; print(random.randint(1, 6) * 0 + 1)"),
+    ("script", None, None),
+]
+
+STARTUP_SCRIPT_MY = """\
+func fmt(x) => str(x * 2);
+var parts = [];
+foreach (var a in argv) { append(parts, a); }
+for (var i = 0; i < 10; i++) { append(parts, fmt(i)); }
+print(join(parts, ","));
+"""
+
+STARTUP_SCRIPT_PY = """\
+import sys
+parts = list(sys.argv[1:])
+for i in range(10):
+    parts.append(str(i * 2))
+print(",".join(parts))
+"""
+
+
+def time_launches(cmds, runs, timeout):
+    """Launch each of `cmds` `runs` times, taking turns so that machine noise
+    hits them alike; return a (median_ms, min_ms, stdout, error) per cmd."""
+    times = [[] for _ in cmds]
+    outs = [""] * len(cmds)
+    errs = [None] * len(cmds)
+    for _ in range(runs):
+        for i, cmd in enumerate(cmds):
+            if errs[i]:
+                continue
+            start = time.perf_counter()
+            try:
+                p = subprocess.run(cmd, stdout=subprocess.PIPE,
+                                   stderr=subprocess.STDOUT, timeout=timeout)
+            except subprocess.TimeoutExpired:
+                errs[i] = "timeout"
+                continue
+            except OSError as e:
+                errs[i] = str(e)
+                continue
+            times[i].append((time.perf_counter() - start) * 1000.0)
+            outs[i] = p.stdout.decode("utf-8", "replace").strip()
+            if p.returncode != 0:
+                errs[i] = "exit %d" % p.returncode
+    res = []
+    for t, out, err in zip(times, outs, errs):
+        if err:
+            res.append((None, None, out, err))
+        else:
+            t.sort()
+            res.append((t[len(t) // 2], t[0], out, None))
+    return res
+
+
+def run_startup(args, mylang):
+    """--startup: per-process launch time of tiny scripts."""
+    cases = STARTUP_CASES
+    if args.filter:
+        subs = [s for s in args.filter.split(",") if s]
+        cases = [c for c in cases if any(s in c[0] for s in subs)]
+    if not cases:
+        sys.exit("no startup benchmarks matched")
+
+    has_base = bool(args.baseline)
+    print("mylang : %s" % mylang)
+    if has_base:
+        print("baseline: %s" % args.baseline)
+    print("python : %s" % args.python)
+    print("runs   : %d launches per case (median kept)\n" % args.startup_runs)
+
+    hdr = "%-10s %9s %9s %9s %7s" % ("case", "my ms", "my min", "py ms",
+                                      "my/py")
+    if has_base:
+        hdr += " %9s %8s" % ("base ms", "cur/base")
+    print(hdr)
+    print("-" * len(hdr))
+
+    rows = []
+    speedups = []
+    with tempfile.TemporaryDirectory(prefix="mylang-startup-") as tmp:
+        my_script = os.path.join(tmp, "script.my")
+        py_script = os.path.join(tmp, "script.py")
+        with open(my_script, "w") as f:
+            f.write(STARTUP_SCRIPT_MY)
+        with open(py_script, "w") as f:
+            f.write(STARTUP_SCRIPT_PY)
+
+        for name, my_args, py_src in cases:
+            if my_args is None:
+                my_args = [my_script, "a", "b"]
+                py_cmd = [args.python, "-B", py_script, "a", "b"]
+            else:
+                py_cmd = [args.python, "-B", "-c", py_src]
+
+            cmds = [[mylang] + my_args, py_cmd]
+            if has_base:
+                cmds.append([args.baseline] + my_args)
+            res = time_launches(cmds, args.startup_runs, args.timeout)
+            my_ms, my_min, my_out, my_err = res[0]
+            py_ms, _pmin, py_out, _perr = res[1]
+            base_ms = res[2][0] if has_base else None
+
+            if my_err:
+                out = "%-10s  mylang: %s" % (name, my_err)
+            else:
+                ratio = my_ms / py_ms if py_ms else None
+                note = ""
+                if py_ms and not results_match(my_out, py_out):
+                    note = "  MISMATCH"
+                out = "%-10s %9.2f %9.2f %9s %s" % (
+                    name, my_ms, my_min,
+                    "%.2f" % py_ms if py_ms else "-",
+                    colorize_ratio(ratio, "%6.2fx" % ratio) if ratio
+                    else "%7s" % "-")
+                if has_base:
+                    if base_ms:
+                        sp = my_ms / base_ms
+                        speedups.append(sp)
+                        out += " %9.2f %s" % (base_ms, colorize_ratio(
+                            sp, "%7.2fx" % sp))
+                    else:
+                        out += " %9s %8s" % ("-", "-")
+                out += note
+            print(out)
+            sys.stdout.flush()
+            rows.append((name, my_ms, my_min, py_ms, base_ms, my_err))
+
+    if speedups:
+        sp_v = geomean(speedups)
+        print("-" * len(hdr))
+        print("geomean cur/base startup over %d cases: %s"
+              % (len(speedups), colorize_ratio(sp_v, "%.2fx" % sp_v)))
+
+    if args.csv:
+        with open(args.csv, "w") as f:
+            f.write("case,mylang_ms,mylang_min_ms,python_ms,status")
+            f.write(",base_ms\n" if has_base else "\n")
+            for name, my_ms, my_min, py_ms, base_ms, err in rows:
+                fmt = lambda v: "%.3f" % v if v is not None else "-"
+                f.write("%s,%s,%s,%s,%s" % (name, fmt(my_ms), fmt(my_min),
+                                            fmt(py_ms), err or "ok"))
+                if has_base:
+                    f.write(",%s" % fmt(base_ms))
+                f.write("\n")
+        print("\nwrote %s" % args.csv)
+
+
 def main():
     ap = argparse.ArgumentParser(description="MyLang vs Python benchmarks")
     ap.add_argument("--scale", type=int, default=1,
@@ -234,6 +590,19 @@ def main():
                     help="after the run, re-dump the table sorted by my/py "
                          "ratio ascending (biggest win first, worst regression "
                          "last)")
+    ap.add_argument("--compile", action="store_true",
+                    help="time the compile pipeline stages on the generated "
+                         "compiler-scaling corpus (gen_compile.py) instead; "
+                         "--filter selects program kinds")
+    ap.add_argument("--compile-lines", default="10000,50000",
+                    help="--compile program sizes in lines, comma-separated "
+                         "(default 10000,50000; the corpus goes to 200000)")
+    ap.add_argument("--startup", action="store_true",
+                    help="time per-process startup on tiny scripts instead; "
+                         "--filter selects cases")
+    ap.add_argument("--startup-runs", type=int, default=200,
+                    help="--startup launches per case, median kept "
+                         "(default 200)")
     args = ap.parse_args()
 
     mylang = find_mylang(args.mylang)
@@ -245,6 +614,14 @@ def main():
                          and os.access(args.baseline, os.X_OK)):
         sys.exit("error: --baseline '%s' is not an executable file" % args.baseline)
 
+    if args.compile:
+        run_compile(args, mylang)
+        return
+
+    if args.startup:
+        run_startup(args, mylang)
+        return
+
     names = sorted(f[:-3] for f in os.listdir(MY_DIR) if f.endswith(".my"))
     if args.filter:
         # comma-separated: a name matches if it contains ANY of the substrings.
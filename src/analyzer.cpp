@@ -23,6 +23,7 @@ anno_code(AnnoKind k)
         case AnnoKind::specialized: return "\033[36m";   /* cyan    */
         case AnnoKind::folded:      return "\033[35m";   /* magenta */
         case AnnoKind::counted_for: return "\033[32m";   /* green   */
+        case AnnoKind::hoisted:     return "\033[4m";    /* underline */
         default:                    return "";
     }
 }
@@ -59,6 +60,7 @@ render_analysis(ostream &o, const std::vector<string> &src,
           << "\033[36mspecialized\033[0m  "
           << "\033[35mfolded call\033[0m  "
           << "\033[32mcounted for\033[0m  "
+          << "\033[4mhoisted\033[0m  "
           << DIM << "dead code" << RESET << "\n";
         o << "--------------------------\n";
     }
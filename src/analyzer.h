@@ -30,6 +30,7 @@ enum class AnnoKind : unsigned char {
     specialized,   /* cyan:    call redirected to a $specN clone */
     folded,        /* magenta: call evaluated at compile time -> literal */
     counted_for,   /* green:   `for` specialized to a counted ForRangeStmt */
+    hoisted,       /* underline: loop-invariant expression hoisted (LICM) */
 };
 
 struct AnalysisInfo {
@@ -56,7 +57,8 @@ struct AnalysisInfo {
         switch (k) {
             case AnnoKind::inlined:
             case AnnoKind::specialized:
-            case AnnoKind::folded:      return 3;   /* call-site decisions */
+            case AnnoKind::folded:
+            case AnnoKind::hoisted:     return 3;   /* call-site decisions */
             case AnnoKind::dyn_array:
             case AnnoKind::flat_array:  return 2;   /* array storage */
             /* on the `for` keyword - never collides with the above (those land
@@ -104,8 +106,8 @@ void render_analysis(std::ostream &o, const std::vector<std::string> &src,
  * The full `-a` / `:analyze` pipeline, shared by the file driver (mylang.cpp)
  * and the REPL's `:analyze` so they record IDENTICAL optimization decisions:
  * collect array-storage annotations, run the resolver (which records
- * auto-const / inlined / specialized / folded / dead-code into `info` as it
- * mutates the tree), collect its auto-pure/param annotations, run
+ * auto-const / inlined / specialized / folded / dead-code / hoisted into `info`
+ * as it mutates the tree), collect its auto-pure/param annotations, run
  * specialize_types (which records a counted_for annotation for each `for` it
  * rewrites to a ForRangeStmt), then render the colored source. `info` must
  * already hold the parser's parse-time records (the parser writes them during
@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "astarena.h"
+#include "defs.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+/* Under ASan a node on a free list is poisoned, so a use after free is still
+ * caught although the memory stays in the arena (see RECYCLE_ALLOC's
+ * allocator in syntax.cpp for the same detection). */
+#if defined(__SANITIZE_ADDRESS__)
+#  define ARENA_ASAN 1
+#elif defined(__has_feature)
+#  if __has_feature(address_sanitizer)
+#    define ARENA_ASAN 1
+#  endif
+#endif
+
+#ifdef ARENA_ASAN
+#  include <sanitizer/asan_interface.h>
+#  define ARENA_POISON(p, n)   __asan_poison_memory_region((p), (n))
+#  define ARENA_UNPOISON(p, n) __asan_unpoison_memory_region((p), (n))
+#else
+#  define ARENA_POISON(p, n)   ((void) 0)
+#  define ARENA_UNPOISON(p, n) ((void) 0)
+#endif
+
+namespace {
+
+constexpr std::size_t chunk_size = 64 * 1024;
+constexpr std::size_t node_align = alignof(std::max_align_t);
+constexpr std::size_t max_small = chunk_size / 2;
+constexpr std::size_t bin_count = max_small / node_align + 1;
+
+std::size_t total_bytes;
+
+void *chunk_alloc(std::size_t size)
+{
+#ifdef _WIN32
+    void *p = _aligned_malloc(size, chunk_size);
+#else
+    void *p = std::aligned_alloc(chunk_size, size);
+#endif
+
+    if (!p)
+        throw std::bad_alloc();
+
+    total_bytes += size;
+    return p;
+}
+
+void chunk_free(void *p, std::size_t size)
+{
+    total_bytes -= size;
+
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+inline std::size_t round_up(std::size_t n, std::size_t a)
+{
+    return (n + a - 1) & ~(a - 1);
+}
+
+}   /* anonymous namespace */
+
+class AstArena {
+
+    /* At the start of every chunk; padded so the first node is aligned. */
+    struct alignas(std::max_align_t) Chunk {
+        AstArena *owner;
+        Chunk *next;
+        std::size_t size;
+    };
+
+    struct FreeNode {
+        FreeNode *next;
+    };
+
+    Chunk *chunks = nullptr;        /* the bump chunks, newest first */
+    char *bump = nullptr;
+    char *bump_end = nullptr;
+    FreeNode *bins[bin_count] = { };
+    std::size_t live = 0;
+    bool orphaned = false;
+
+    static Chunk *chunk_of(void *p) {
+        return reinterpret_cast<Chunk *>(
+            reinterpret_cast<std::uintptr_t>(p) & ~(chunk_size - 1));
+    }
+
+    Chunk *new_chunk(std::size_t size) {
+        Chunk *c = static_cast<Chunk *>(chunk_alloc(size));
+        c->owner = this;
+        c->size = size;
+        return c;
+    }
+
+    void *alloc_big(std::size_t n) {
+        /* Its own chunk (still chunk-aligned, so masking finds the header),
+         * freed as soon as the node is. */
+        Chunk *c = new_chunk(round_up(sizeof(Chunk) + n, chunk_size));
+        c->next = nullptr;
+        return c + 1;
+    }
+
+public:
+
+    static AstArena *current;
+
+    AstArena() = default;
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    ~AstArena() {
+        while (chunks) {
+            Chunk *next = chunks->next;
+            ARENA_UNPOISON(chunks, chunks->size);
+            chunk_free(chunks, chunks->size);
+            chunks = next;
+        }
+    }
+
+    void *alloc(std::size_t n) {
+
+        live++;
+        n = round_up(n, node_align);
+
+        if (n > max_small)
+            return alloc_big(n);
+
+        FreeNode *&bin = bins[n / node_align];
+
+        if (bin) {
+            FreeNode *f = bin;
+            ARENA_UNPOISON(f, n);
+            bin = f->next;
+            return f;
+        }
+
+        if (static_cast<std::size_t>(bump_end - bump) < n) {
+            Chunk *c = new_chunk(chunk_size);
+            c->next = chunks;
+            chunks = c;
+            bump = reinterpret_cast<char *>(c + 1);
+            bump_end = reinterpret_cast<char *>(c) + chunk_size;
+        }
+
+        void *ret = bump;
+        bump += n;
+        return ret;
+    }
+
+    static void free(void *p, std::size_t n) noexcept {
+
+        Chunk *c = chunk_of(p);
+        AstArena *a = c->owner;
+
+        n = round_up(n, node_align);
+
+        if (n > max_small) {
+            chunk_free(c, c->size);
+        } else {
+            FreeNode *f = static_cast<FreeNode *>(p);
+            f->next = a->bins[n / node_align];
+            a->bins[n / node_align] = f;
+            ARENA_POISON(p, n);
+        }
+
+        ML_CHECK(a->live > 0);
+
+        if (!--a->live && a->orphaned)
+            delete a;
+    }
+
+    /* The scope that created this arena ended: release it now if it has no
+     * live nodes, else when the last one is freed. */
+    void end_scope() {
+        if (live)
+            orphaned = true;
+        else
+            delete this;
+    }
+};
+
+AstArena *AstArena::current;
+
+static AstArena *current_arena()
+{
+    if (!AstArena::current)
+        AstArena::current = new AstArena;   /* the process-wide default */
+
+    return AstArena::current;
+}
+
+void *ast_alloc(std::size_t n)
+{
+    return current_arena()->alloc(n);
+}
+
+void ast_free(void *p, std::size_t n) noexcept
+{
+    if (p)
+        AstArena::free(p, n);
+}
+
+std::size_t ast_arena_bytes()
+{
+    return total_bytes;
+}
+
+AstArenaScope::AstArenaScope()
+    : arena(new AstArena)
+    , prev(current_arena())
+{
+    AstArena::current = arena;
+}
+
+AstArenaScope::~AstArenaScope()
+{
+    AstArena::current = prev;
+    arena->end_scope();
+}
@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Bump arena for AST nodes: Construct's operator new/delete (syntax.h) carve
+ * every node out of the CURRENT arena, so the nodes the parser builds for one
+ * function - and the clones the inliner / specializer make next to them - sit
+ * contiguously in memory instead of wherever the heap had a free block. A tree
+ * walk then touches a few dense chunks, not a node per cache line.
+ *
+ * Chunks are `chunk_size`-aligned and start with a header naming their arena,
+ * so a node needs no per-node header: delete finds the owner by masking the
+ * node's address. A deleted node goes onto its arena's size-class free list
+ * and the next same-size node reuses it (the optimizer replaces nodes all the
+ * time); a node bigger than half a chunk gets a chunk of its own.
+ *
+ * By default nodes come from a process-wide arena that is never released
+ * (the file driver's program and the REPL's accumulated definitions live to
+ * exit anyway). An AstArenaScope makes a fresh arena current for a tree with
+ * a shorter life (a unit test's program): when the scope ends, destroying the
+ * tree is just running destructors and the arena's chunks go back in one
+ * release. A node still alive then (held by something outside the scope)
+ * keeps the arena around, orphaned, until its last node goes.
+ *
+ * Single-threaded, like Construct::next_node_id: nodes are only created and
+ * destroyed by the compile pipeline and the main thread.
+ */
+
+class AstArena;
+
+/* Allocate / free `n` bytes for a Construct from the current arena. */
+void *ast_alloc(std::size_t n);
+void ast_free(void *p, std::size_t n) noexcept;
+
+/* Bytes of chunks held by all arenas (live nodes + free lists + bump slack). */
+std::size_t ast_arena_bytes();
+
+class AstArenaScope {
+
+    AstArena *arena;
+    AstArena *prev;
+
+public:
+
+    AstArenaScope();
+    ~AstArenaScope();
+
+    AstArenaScope(const AstArenaScope &) = delete;
+    AstArenaScope &operator=(const AstArenaScope &) = delete;
+};
@@ -57,10 +57,16 @@ num_digits(size_t n)
 }
 
 void
-flush_inline_frames(const InlineCtx *ic, Exception &e)
+inline_frames(const InlineCtx *ic, vector<BacktraceFrame> &out)
 {
     for (; ic; ic = ic->parent)
-        e.backtrace.push_back({ ic->callee_name, ic->params, ic->call_site });
+        out.push_back({ ic->callee_name, ic->params, ic->call_site });
+}
+
+void
+flush_inline_frames(const InlineCtx *ic, Exception &e)
+{
+    inline_frames(ic, e.backtrace);
 }
 
 string
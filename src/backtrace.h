@@ -3,9 +3,18 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 struct Exception;
 struct InlineCtx;
+struct BacktraceFrame;
+
+/*
+ * Append the virtual frames of an inlined-at chain to `out`, innermost first
+ * (one BacktraceFrame per InlineCtx). The one walk of the chain, shared by the
+ * error path below and the profiler's stack resolution (profiler.cpp).
+ */
+void inline_frames(const InlineCtx *ic, std::vector<BacktraceFrame> &out);
 
 /*
  * Append the virtual frames of an inlined-at chain to e.backtrace, innermost
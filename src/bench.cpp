@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "bench.h"
+#include "syntax.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+using std::vector;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/* The wall time of `n` calls, in ns. */
+double time_batch(const std::function<void()> &call, uint64_t n)
+{
+    const Clock::time_point t0 = Clock::now();
+
+    for (uint64_t i = 0; i < n; i++)
+        call();
+
+    return std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+}
+
+double median_of_sorted(const vector<double> &v)
+{
+    const size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2;
+}
+
+bool is_constant(const Construct *c)
+{
+    if (!c)
+        return true;
+
+    if (dynamic_cast<const Literal *>(c))
+        return true;
+
+    if (auto *r = dynamic_cast<const ReturnStmt *>(c))
+        return is_constant(r->elem.get());
+
+    if (auto *b = dynamic_cast<const Block *>(c)) {
+        for (const auto &e : b->elems)
+            if (!is_constant(e.get()))
+                return false;
+        return true;
+    }
+
+    return false;
+}
+
+}  /* anonymous namespace */
+
+bool bench_body_is_constant(const FuncDeclStmt *f)
+{
+    return is_constant(f->body.get());
+}
+
+BenchResult bench_run(const std::function<void()> &call,
+                      const BenchOptions &opts)
+{
+    const double sample_ns = opts.sample_ms * 1e6;
+    const double warmup_ns = opts.warmup_ms * 1e6;
+
+    /* Warm-up + calibration: doubling batches. */
+    uint64_t n = 1;
+    double spent = 0, t;
+
+    for (;;) {
+
+        t = time_batch(call, n);
+        spent += t;
+
+        if (t >= sample_ns / 10 && spent >= warmup_ns)
+            break;
+
+        n *= 2;
+    }
+
+    BenchResult r;
+    r.iters = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(n * sample_ns / std::max(t, 1.0)))
+    );
+    r.samples = opts.samples;
+
+    vector<double> per_call;
+    per_call.reserve(opts.samples);
+
+    for (int i = 0; i < opts.samples; i++)
+        per_call.push_back(time_batch(call, r.iters) / r.iters);
+
+    std::sort(per_call.begin(), per_call.end());
+
+    double sum = 0;
+    for (double x : per_call)
+        sum += x;
+
+    r.median_ns = median_of_sorted(per_call);
+    r.min_ns = per_call.front();
+    r.mean_ns = sum / per_call.size();
+
+    vector<double> dev;
+    dev.reserve(per_call.size());
+    for (double x : per_call)
+        dev.push_back(std::fabs(x - r.median_ns));
+    std::sort(dev.begin(), dev.end());
+    r.mad_ns = median_of_sorted(dev);
+
+    /*
+     * The 95% CI of the median: the order statistics j < k around n/2 with
+     * P(x_j <= median <= x_k) ~ 0.95, by the normal approximation to the
+     * Binomial(n, 1/2) count of samples below the median.
+     */
+    const double N = per_call.size();
+    const double h = 1.96 * std::sqrt(N) / 2;
+    const long lo = std::max(0L, static_cast<long>(std::floor(N / 2 - h)));
+    const long hi = std::min(static_cast<long>(N) - 1,
+                             static_cast<long>(std::ceil(N / 2 + h)));
+
+    r.ci_low_ns = per_call[lo];
+    r.ci_high_ns = per_call[hi];
+    return r;
+}
@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+class FuncDeclStmt;
+
+/*
+ * In-language micro-benchmarking (the `bench(func, options)` builtin).
+ *
+ * A run warms the body up while calibrating: it calls it in doubling batches
+ * until `warmup_ms` have passed and a batch lasts at least a tenth of
+ * `sample_ms`, then sizes every sample to about `sample_ms`. Each sample is
+ * one batch's time over its iterations, so the clock is read twice per batch,
+ * not per call. The result is robust to the odd slow sample (a page fault, a
+ * preemption): the median per-call time, the median absolute deviation around
+ * it, and a distribution-free 95% confidence interval for the median (a pair
+ * of order statistics).
+ *
+ * The optimizer can delete what a benchmark means to measure: auto-const and
+ * constant folding turn a body computing from constants into `return <lit>`
+ * (bench/my/48_const_fold, 50_autoconst_dce). `folded` says the body, as it
+ * will run, does no work; the timing is then just the call overhead.
+ */
+
+/* The accepted option ranges: enough for any real measurement, small enough
+ * that the samples vector and a run's length stay sane. */
+constexpr int BENCH_MIN_SAMPLES = 3;
+constexpr int BENCH_MAX_SAMPLES = 1000000;
+constexpr double BENCH_MAX_MS = 60000;
+
+struct BenchOptions {
+    int samples = 10;
+    double warmup_ms = 50;
+    double sample_ms = 10;
+};
+
+struct BenchResult {
+    uint64_t iters = 0;         /* calls per sample */
+    int samples = 0;
+    double median_ns = 0;       /* per call */
+    double mad_ns = 0;
+    double ci_low_ns = 0;
+    double ci_high_ns = 0;
+    double min_ns = 0;
+    double mean_ns = 0;
+    bool folded = false;
+};
+
+/* Benchmark `call` (one call of the body). */
+BenchResult bench_run(const std::function<void()> &call,
+                      const BenchOptions &opts);
+
+/* True when `f`'s body, after the optimizers, does no work: it is empty or
+ * only returns literals. */
+bool bench_body_is_constant(const FuncDeclStmt *f);
@@ -42,19 +42,19 @@ EvalValue builtin_array(EvalContext *ctx, ExprList *exprList)
     const size_t nargs = exprList->elems.size();
 
     if (nargs < 1 || nargs > 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg->start, arg->end);
+        throw TypeErrorEx("Expected integer", arg->start(), arg->end());
 
     const int_type n = e.get<int_type>();
 
     if (n < 0)
         throw InvalidValueEx("Expected non-negative integer",
-                             arg->start, arg->end);
+                             arg->start(), arg->end());
 
     const ArrHint hint = exprList->arr_hint;
 
@@ -124,25 +124,25 @@ EvalValue builtin_array(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_make_array(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &e = RValue(arg0->eval(ctx));
 
     if (!e.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected integer", arg0->start(), arg0->end());
 
     const int_type n = e.get<int_type>();
 
     if (n < 0)
         throw InvalidValueEx("Expected non-negative integer",
-                             arg0->start, arg0->end);
+                             arg0->start(), arg0->end());
 
     Construct *arg1 = exprList->elems[1].get();
     const EvalValue &fval = RValue(arg1->eval(ctx));
 
     if (!fval.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx("Expected function", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected function", arg1->start(), arg1->end());
 
     FuncObject &funcObj = *fval.get<intrusive_ptr<FuncObject>>().get();
 
@@ -222,13 +222,13 @@ EvalValue builtin_make_array(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_array_storage(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg->start, arg->end);
+        throw TypeErrorEx("Expected array", arg->start(), arg->end());
 
     switch (e.get<SharedArrayObj>().skind()) {
         case SharedArrayObj::Storage::ints:
@@ -258,13 +258,13 @@ EvalValue builtin_array_storage(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_dynarray(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg->start, arg->end);
+        throw TypeErrorEx("Expected array", arg->start(), arg->end());
 
     const SharedArrayObj &arr = e.get<SharedArrayObj>();
     const size_type n = arr.size();
@@ -295,27 +295,27 @@ static void arr_append_maintain_hash(SharedArrayObj &arr, const EvalValue &elem)
 EvalValue builtin_append(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
     const EvalValue &arr_lval = arg0->eval(ctx);
 
     if (!arr_lval.is<LValue *>())
-        throw NotLValueEx(arg0->start, arg0->end);
+        throw NotLValueEx(arg0->start(), arg0->end());
 
     LValue *lval = arr_lval.get<LValue *>();
 
     if (!lval->is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected array", arg0->start(), arg0->end());
 
     if (lval->is_const_var())
-        throw CannotChangeConstEx(arg0->start, arg0->end);
+        throw CannotChangeConstEx(arg0->start(), arg0->end());
 
     SharedArrayObj &arr = lval->getval<SharedArrayObj>();
 
     if (arr.is_readonly())
-        throw CannotChangeConstEx(arg0->start, arg0->end);
+        throw CannotChangeConstEx(arg0->start(), arg0->end());
 
     if (arr.is_slice())
         arr.clone_internal_vec();
@@ -374,7 +374,7 @@ EvalValue builtin_append(EvalContext *ctx, ExprList *exprList)
     }
 
     if (arr.skind() != SharedArrayObj::Storage::general)
-        throw TypeErrorEx(flat_array_violation_msg, arg0->start, arg1->end);
+        throw TypeErrorEx(flat_array_violation_msg, arg0->start(), arg1->end());
 
     arr.get_vec().emplace_back(elem, ctx->const_ctx);
     arr_append_maintain_hash(arr, elem);
@@ -384,31 +384,31 @@ EvalValue builtin_append(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_pop(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &arr_lval = arg->eval(ctx);
 
     if (!arr_lval.is<LValue *>())
-        throw NotLValueEx(arg->start, arg->end);
+        throw NotLValueEx(arg->start(), arg->end());
 
     LValue *lval = arr_lval.get<LValue *>();
 
     if (!lval->is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg->start, arg->end);
+        throw TypeErrorEx("Expected array", arg->start(), arg->end());
 
     if (lval->is_const_var())
-        throw CannotChangeConstEx(arg->start, arg->end);
+        throw CannotChangeConstEx(arg->start(), arg->end());
 
     SharedArrayObj &arr = lval->getval<SharedArrayObj>();
 
     if (arr.is_readonly())
-        throw CannotChangeConstEx(arg->start, arg->end);
+        throw CannotChangeConstEx(arg->start(), arg->end());
 
     const size_type n = arr.size();
 
     if (!n)
-        throw OutOfBoundsEx(arg->start, arg->end);
+        throw OutOfBoundsEx(arg->start(), arg->end());
 
     arr.invalidate_hash();   /* pop removes the last element */
 
@@ -453,19 +453,19 @@ EvalValue builtin_pop(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_top(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg->start, arg->end);
+        throw TypeErrorEx("Expected array", arg->start(), arg->end());
 
     const SharedArrayObj &arr = e.get<SharedArrayObj>();
     const size_type n = arr.size();
 
     if (!n)
-        throw OutOfBoundsEx(arg->start, arg->end);
+        throw OutOfBoundsEx(arg->start(), arg->end());
 
     return arr_elem_at(arr, n - 1);   /* no promotion of flat storage */
 }
@@ -584,14 +584,14 @@ EvalValue builtin_insert_arr(LValue *lval, int_type index, const EvalValue &val)
 EvalValue builtin_range(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1 || exprList->elems.size() > 3)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     int_type end, start = 0, step = 1;
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &val0 = RValue(arg0->eval(ctx));
 
     if (!val0.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected integer", arg0->start(), arg0->end());
 
     if (exprList->elems.size() >= 2) {
 
@@ -599,7 +599,7 @@ EvalValue builtin_range(EvalContext *ctx, ExprList *exprList)
         const EvalValue &val1 = RValue(arg1->eval(ctx));
 
         if (!val1.is<int_type>())
-            throw TypeErrorEx("Expected integer", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected integer", arg1->start(), arg1->end());
 
         start = val0.get<int_type>();
         end = val1.get<int_type>();
@@ -610,12 +610,14 @@ EvalValue builtin_range(EvalContext *ctx, ExprList *exprList)
             const EvalValue &val2 = RValue(arg2->eval(ctx));
 
             if (!val2.is<int_type>())
-                throw TypeErrorEx("Expected integer", arg2->start, arg2->end);
+                throw TypeErrorEx("Expected integer", arg2->start(),
+                                  arg2->end());
 
             step = val2.get<int_type>();
 
             if (step == 0)
-                throw InvalidValueEx("Expected integer != 0", arg2->start, arg2->end);
+                throw InvalidValueEx("Expected integer != 0", arg2->start(),
+                                     arg2->end());
         }
 
     } else {
@@ -760,14 +762,14 @@ static EvalValue
 sort_arr(EvalContext *ctx, ExprList *exprList, bool reverse)
 {
     if (exprList->elems.size() == 0)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &val0_lval = arg0->eval(ctx);
     EvalValue val0 = RValue(val0_lval);
 
     if (!val0.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected array", arg0->start(), arg0->end());
 
     /*
      * Sorting a `const` (a read-only value, or a const-declared variable)
@@ -856,7 +858,7 @@ sort_arr(EvalContext *ctx, ExprList *exprList, bool reverse)
         const EvalValue &val1 = RValue(arg1->eval(ctx));
 
         if (!val1.is<intrusive_ptr<FuncObject>>())
-            throw TypeErrorEx("Expected function", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected function", arg1->start(), arg1->end());
 
         FuncObject &funcObj = *val1.get<intrusive_ptr<FuncObject>>().get();
 
@@ -923,14 +925,14 @@ EvalValue builtin_rev_sort(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_reverse(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &val0_lval = arg0->eval(ctx);
     EvalValue val0 = RValue(val0_lval);
 
     if (!val0.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected array", arg0->start(), arg0->end());
 
     SharedArrayObj &arr = val0.get<SharedArrayObj>();
 
@@ -978,13 +980,13 @@ EvalValue builtin_reverse(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_sum(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1 || exprList->elems.size() > 2)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &val0 = RValue(arg0->eval(ctx));
 
     if (!val0.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected array", arg0->start(), arg0->end());
 
     const SharedArrayObj &arr = val0.get<SharedArrayObj>();
 
@@ -1025,13 +1027,12 @@ EvalValue builtin_sum(EvalContext *ctx, ExprList *exprList)
         return EvalValue(acc);
     }
 
-    const ArrayConstView &view = arr.get_view();
-
-    if (view.size() == 0)
+    if (arr.size() == 0)
         return none; /* sum of an empty array is none, like min()/max() */
 
     if (exprList->elems.size() == 1) {
 
+        const ArrayConstView &view = arr.get_view();
         const EvalValue &first = view[0].get();
 
         /*
@@ -1083,15 +1084,16 @@ EvalValue builtin_sum(EvalContext *ctx, ExprList *exprList)
         const EvalValue &val1 = RValue(arg1->eval(ctx));
 
         if (!val1.is<intrusive_ptr<FuncObject>>())
-            throw TypeErrorEx("Expected function", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected function", arg1->start(), arg1->end());
 
+        /* arr_elem_at boxes a flat array's element for the call */
         FuncObject &funcObj = *val1.get<intrusive_ptr<FuncObject>>().get();
-        EvalValue val = eval_func(ctx, funcObj, view[0].get());
+        EvalValue val = RValue(eval_func(ctx, funcObj, arr_elem_at(arr, 0)));
 
-        for (size_type i = 1; i < view.size(); i++) {
+        for (size_type i = 1; i < arr.size(); i++) {
             num_bin_op(
                 val,
-                eval_func(ctx, funcObj, view[i].get()),
+                RValue(eval_func(ctx, funcObj, arr_elem_at(arr, i))),
                 &Type::add
             );
         }
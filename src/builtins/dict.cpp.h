@@ -39,7 +39,7 @@ static EvalValue
 dict_get_impl(EvalContext *ctx, ExprList *exprList, bool throw_if_absent)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -47,7 +47,7 @@ dict_get_impl(EvalContext *ctx, ExprList *exprList, bool throw_if_absent)
     const EvalValue &key = RValue(arg1->eval(ctx));
 
     if (!d.is<intrusive_ptr<DictObject>>())
-        throw TypeErrorEx("Expected dict object", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected dict object", arg0->start(), arg0->end());
 
     const DictObject::inner_type &data =
         d.get<intrusive_ptr<DictObject>>()->get_ref();
@@ -57,7 +57,7 @@ dict_get_impl(EvalContext *ctx, ExprList *exprList, bool throw_if_absent)
         return it->second.get();
 
     if (throw_if_absent)
-        throw KeyNotFoundEx(arg1->start, arg1->end);
+        throw KeyNotFoundEx(arg1->start(), arg1->end());
 
     return none;
 }
@@ -177,13 +177,13 @@ dict_1arg_func(EvalContext *ctx,
                EvalValue (*f)(const DictObject::inner_type &, ArrHint))
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &val0 = RValue(arg0->eval(ctx));
 
     if (!val0.is<intrusive_ptr<DictObject>>())
-        throw TypeErrorEx("Expected dict object", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected dict object", arg0->start(), arg0->end());
 
     const DictObject::inner_type &data
         = val0.get<intrusive_ptr<DictObject>>()->get_ref();
@@ -215,7 +215,7 @@ EvalValue
 builtin_dict(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -232,7 +232,7 @@ builtin_dict(EvalContext *ctx, ExprList *exprList)
 
         if (e.is<NoneVal>())
             throw InvalidValueEx(
-                "dict() default value cannot be none", arg->start, arg->end
+                "dict() default value cannot be none", arg->start(), arg->end()
             );
 
         auto obj = make_intrusive<DictObject>();
@@ -251,7 +251,7 @@ builtin_dict(EvalContext *ctx, ExprList *exprList)
 
         if (!pe.is<SharedArrayObj>()) {
             throw TypeErrorEx(
-                "Expected array of [key, value] pairs", arg->start, arg->end
+                "Expected array of [key, value] pairs", arg->start(), arg->end()
             );
         }
 
@@ -259,7 +259,7 @@ builtin_dict(EvalContext *ctx, ExprList *exprList)
 
         if (pair.size() != 2) {
             throw TypeErrorEx(
-                "Expected array of [key, value] pairs", arg->start, arg->end
+                "Expected array of [key, value] pairs", arg->start(), arg->end()
             );
         }
 
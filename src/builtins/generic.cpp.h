@@ -12,11 +12,21 @@
 #include "eval.h"
 #include "evaltypes.cpp.h"
 #include "syntax.h"
+#include "parallel.h"
+#include "memo.h"
+#include "memacct.h"
+#include "heapsnap.h"
+#include "perfcount.h"
+#include "bench.h"
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
 
 EvalValue builtin_defined(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     return !arg->eval(ctx).is<UndefinedId>();
@@ -25,7 +35,7 @@ EvalValue builtin_defined(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_len(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -35,7 +45,7 @@ EvalValue builtin_len(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &e = RValue(arg0->eval(ctx));
@@ -47,7 +57,7 @@ EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
     } else if (e.is<float_type>()) {
 
         if (exprList->elems.size() > 2)
-            throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+            throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
         if (exprList->elems.size() == 2) {
 
@@ -58,8 +68,8 @@ EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
 
                 throw TypeErrorEx(
                     "Expected an integer in the range [0, 64]",
-                    arg1->start,
-                    arg1->end
+                    arg1->start(),
+                    arg1->end()
                 );
             }
 
@@ -74,7 +84,7 @@ EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
             const int n = snprintf(nullptr, 0, "%.*f", precision, fval);
 
             if (n < 0)
-                throw InternalErrorEx(arg0->start, arg0->end);
+                throw InternalErrorEx(arg0->start(), arg0->end());
 
             std::vector<char> buf(static_cast<size_t>(n) + 1);
             snprintf(buf.data(), buf.size(), "%.*f", precision, fval);
@@ -84,7 +94,7 @@ EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
     } else {
 
         if (exprList->elems.size() > 1)
-            throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+            throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
     }
 
     return SharedStr(e.to_string());
@@ -103,7 +113,7 @@ EvalValue builtin_str(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_runtime(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     return RValue(exprList->elems[0]->eval(ctx));
 }
@@ -122,7 +132,7 @@ EvalValue builtin_runtime(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_isconst(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     return exprList->elems[0]->is_const;
 }
@@ -130,7 +140,7 @@ EvalValue builtin_isconst(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_isconstdecl(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     return exprList->elems[0]->is_const;
 }
@@ -143,13 +153,13 @@ EvalValue builtin_isconstdecl(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_ispure(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &v = RValue(arg->eval(ctx));
 
     if (!v.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx(arg->start, arg->end);
+        throw TypeErrorEx(arg->start(), arg->end());
 
     return v.get<intrusive_ptr<FuncObject>>()->func->effective_pure;
 }
@@ -157,21 +167,357 @@ EvalValue builtin_ispure(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_ispuredecl(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &v = RValue(arg->eval(ctx));
 
     if (!v.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx(arg->start, arg->end);
+        throw TypeErrorEx(arg->start(), arg->end());
 
     return v.get<intrusive_ptr<FuncObject>>()->func->explicit_pure;
 }
 
+static bool memoizable(const FuncDeclStmt *fd)
+{
+    return fd->effective_pure && (!fd->captures || fd->captures->elems.empty());
+}
+
+/*
+ * memoize(f): memoize f's calls across the whole program (see memo.h) and
+ * return f. f must be pure and capture nothing, so that its result depends on
+ * its arguments alone. A call may have been redirected to one of f's template
+ * instances / specializations (their display_name is f's name), so those are
+ * memoized too.
+ */
+EvalValue builtin_memoize(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() != 1)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    Construct *arg = exprList->elems[0].get();
+    const EvalValue &v = RValue(arg->eval(ctx));
+
+    if (!v.is<intrusive_ptr<FuncObject>>())
+        throw TypeErrorEx("Expected function", arg->start(), arg->end());
+
+    const FuncDeclStmt *fd = v.get<intrusive_ptr<FuncObject>>()->func;
+
+    if (!memoizable(fd))
+        throw TypeErrorEx(
+            "memoize() requires a pure function without captures",
+            arg->start(), arg->end()
+        );
+
+    fd->memoized = true;
+
+    const string name = !fd->display_name.empty()
+        ? fd->display_name
+        : fd->id ? string(fd->id->get_str()) : string();
+
+    auto mark_clone = [&](const EvalValue &g) {
+        if (!g.is<intrusive_ptr<FuncObject>>())
+            return;
+        const FuncDeclStmt *gd = g.get<intrusive_ptr<FuncObject>>()->func;
+        if (gd->display_name == name && memoizable(gd))
+            gd->memoized = true;
+    };
+
+    if (!name.empty()) {
+
+        if (const GlobalFuncTable *gt = ctx->gfuncs)
+            for (size_t i = 0; i < gt->slots.size(); i++)
+                if (gt->defined[i])
+                    mark_clone(gt->slots[i].get());
+
+        std::vector<std::pair<const UniqueId *, const LValue *>> syms;
+        get_root_ctx(ctx)->collect_symbols(syms);
+        for (const auto &kv : syms)
+            mark_clone(kv.second->get());
+    }
+
+    return v;
+}
+
+/* memostats(): the memo table's counters, as a dict<str, int>. */
+EvalValue builtin_memostats(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() != 0)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    const MemoStats ms = memo_stats();
+    DictObject::inner_type data;
+
+    auto put = [&](const char *key, size_t val) {
+        data.insert_or_assign(
+            EvalValue(SharedStr(string(key))),
+            LValue(EvalValue(static_cast<int_type>(val)), false)
+        );
+    };
+
+    put("hits", ms.hits);
+    put("misses", ms.misses);
+    put("evictions", ms.evictions);
+    put("entries", ms.entries);
+    put("bytes", ms.bytes);
+    return intrusive_ptr<DictObject>(make_intrusive<DictObject>(move(data)));
+}
+
+EvalValue builtin_memstats(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() > 1)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    bool reset = false;
+
+    if (exprList->elems.size() == 1) {
+
+        const EvalValue &e = RValue(exprList->elems[0]->eval(ctx));
+
+        if (!e.is<bool>())
+            throw TypeErrorEx("Expected bool (reset the peaks)",
+                              exprList->elems[0]->start(),
+                              exprList->elems[0]->end());
+
+        reset = e.get<bool>();
+    }
+
+    DictObject::inner_type data;
+
+    for (unsigned i = 0; i < static_cast<unsigned>(MemKind::count_); i++) {
+
+        const MemCounters &c = g_mem[i];
+        DictObject::inner_type kd;
+
+        auto put = [&](const char *key, uint64_t val) {
+            kd.insert_or_assign(
+                EvalValue(SharedStr(string(key))),
+                LValue(EvalValue(static_cast<int_type>(val)), false)
+            );
+        };
+
+        put("allocs", c.allocs.load());
+        put("frees", c.frees.load());
+        put("live", c.live.load());
+        put("peak", c.peak.load());
+
+        data.insert_or_assign(
+            EvalValue(SharedStr(string(mem_kind_name(static_cast<MemKind>(i))))),
+            LValue(EvalValue(intrusive_ptr<DictObject>(
+                make_intrusive<DictObject>(move(kd)))), false)
+        );
+    }
+
+    /* After the snapshot, so this call's own dicts count toward the next. */
+    if (reset)
+        mem_reset_peaks();
+
+    return intrusive_ptr<DictObject>(make_intrusive<DictObject>(move(data)));
+}
+
+/*
+ * heap_snapshot(path): write the reachable object graph to `path` (see
+ * heapsnap.h) and return a summary dict<str, int>: objects, bytes, cycles,
+ * unreachable.
+ */
+EvalValue builtin_heap_snapshot(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() != 1)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    Construct *arg = exprList->elems[0].get();
+    const EvalValue &e = RValue(arg->eval(ctx));
+
+    if (!e.is<SharedStr>())
+        throw TypeErrorEx("Expect filename (string)", arg->start(), arg->end());
+
+    std::ofstream fs(string(e.get<SharedStr>().get_view()));
+
+    if (!fs)
+        throw CannotOpenFileEx(arg->start(), arg->end());
+
+    const HeapSnapSummary hs = heap_snapshot(ctx, fs);
+    DictObject::inner_type data;
+
+    auto put = [&](const char *key, size_t val) {
+        data.insert_or_assign(
+            EvalValue(SharedStr(string(key))),
+            LValue(EvalValue(static_cast<int_type>(val)), false)
+        );
+    };
+
+    put("objects", hs.objects);
+    put("bytes", hs.bytes);
+    put("cycles", hs.cycles);
+    put("unreachable", hs.unreachable);
+    return intrusive_ptr<DictObject>(make_intrusive<DictObject>(move(data)));
+}
+
+/* perf_begin(name) / perf_end(name): a hardware-counter region (perfcount.h).
+ * The name is a string; perf_end must close the innermost open region. */
+static string perf_region_name(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() != 1)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    Construct *arg = exprList->elems[0].get();
+    const EvalValue &e = RValue(arg->eval(ctx));
+
+    if (!e.is<SharedStr>())
+        throw TypeErrorEx("Expected a region name (string)",
+                          arg->start(), arg->end());
+
+    return string(e.get<SharedStr>().get_view());
+}
+
+EvalValue builtin_perf_begin(EvalContext *ctx, ExprList *exprList)
+{
+    perf_region_begin(perf_region_name(ctx, exprList));
+    return none;
+}
+
+/* Returns the region's counts: a dict of cycles, instructions, cache_misses,
+ * branch_misses (-1 where unavailable) and wall_ns. */
+EvalValue builtin_perf_end(EvalContext *ctx, ExprList *exprList)
+{
+    const string name = perf_region_name(ctx, exprList);
+    PerfSample ps;
+
+    if (!perf_region_end(name, ps))
+        throw InvalidValueEx("perf_end() must close the innermost perf_begin()",
+                             exprList->start(), exprList->end());
+
+    DictObject::inner_type data;
+
+    auto put = [&](const char *key, int64_t val) {
+        data.insert_or_assign(
+            EvalValue(SharedStr(string(key))),
+            LValue(EvalValue(static_cast<int_type>(val)), false)
+        );
+    };
+
+    for (unsigned i = 0; i < perf_counter_count; i++)
+        put(perf_counter_name(i), ps.ctr[i]);
+
+    put("wall_ns", ps.wall_ns);
+    return intrusive_ptr<DictObject>(make_intrusive<DictObject>(move(data)));
+}
+
+/*
+ * bench(func, [options]): micro-benchmark a zero-argument function (bench.h).
+ * options is a dict with any of "samples" (>= 3), "warmup_ms", "sample_ms".
+ * Returns a dict: iters, samples, median_ns, mad_ns, ci_low_ns, ci_high_ns,
+ * min_ns, mean_ns (per call) and folded.
+ */
+EvalValue builtin_bench(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() < 1 || exprList->elems.size() > 2)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    Construct *arg0 = exprList->elems[0].get();
+    const EvalValue fv = RValue(arg0->eval(ctx));
+
+    if (!fv.is<intrusive_ptr<FuncObject>>())
+        throw TypeErrorEx("Expected function object", arg0->start(),
+                          arg0->end());
+
+    BenchOptions opts;
+
+    if (exprList->elems.size() == 2) {
+
+        Construct *arg1 = exprList->elems[1].get();
+        const EvalValue &ov = RValue(arg1->eval(ctx));
+
+        if (!ov.is<intrusive_ptr<DictObject>>())
+            throw TypeErrorEx("Expected an options dict", arg1->start(),
+                              arg1->end());
+
+        for (const auto &kv : ov.get<intrusive_ptr<DictObject>>()->get_ref()) {
+
+            const EvalValue &v = kv.second.get();
+            const string_view key = kv.first.is<SharedStr>()
+                ? kv.first.get<SharedStr>().get_view() : string_view();
+            double num;
+
+            if (v.is<int_type>())
+                num = static_cast<double>(v.get<int_type>());
+            else if (v.is<float_type>())
+                num = v.get<float_type>();
+            else
+                throw TypeErrorEx("Expected a number", arg1->start(),
+                                  arg1->end());
+
+            if (num < 0)
+                throw InvalidValueEx("Negative bench() option",
+                                     arg1->start(), arg1->end());
+
+            /* `!(num <= max)` also rejects a NaN */
+            if (key == "samples") {
+
+                if (num < BENCH_MIN_SAMPLES || !(num <= BENCH_MAX_SAMPLES) ||
+                    num != std::floor(num))
+                {
+                    throw InvalidValueEx("bench() samples must be a whole "
+                                         "number in 3..1000000",
+                                         arg1->start(), arg1->end());
+                }
+
+                opts.samples = static_cast<int>(num);
+
+            } else if (key == "warmup_ms" || key == "sample_ms") {
+
+                if (!(num <= BENCH_MAX_MS))
+                    throw InvalidValueEx("bench() times must be in "
+                                         "0..60000 ms",
+                                         arg1->start(), arg1->end());
+
+                if (key == "warmup_ms")
+                    opts.warmup_ms = num;
+                else
+                    opts.sample_ms = num;
+
+            } else {
+                throw InvalidValueEx("Unknown or invalid bench() option",
+                                     arg1->start(), arg1->end());
+            }
+        }
+    }
+
+    /* Hold the function for the whole run: an inline lambda has no other
+     * owner (as in builtin_find). */
+    intrusive_ptr<FuncObject> fobj = fv.get<intrusive_ptr<FuncObject>>();
+    const std::vector<EvalValue> no_args;
+
+    const BenchResult br = bench_run(
+        [&] { eval_func(ctx, *fobj, no_args); },
+        opts
+    );
+
+    DictObject::inner_type data;
+
+    auto put = [&](const char *key, const EvalValue &val) {
+        data.insert_or_assign(
+            EvalValue(SharedStr(string(key))),
+            LValue(val, false)
+        );
+    };
+
+    put("iters", static_cast<int_type>(br.iters));
+    put("samples", static_cast<int_type>(br.samples));
+    put("median_ns", static_cast<float_type>(br.median_ns));
+    put("mad_ns", static_cast<float_type>(br.mad_ns));
+    put("ci_low_ns", static_cast<float_type>(br.ci_low_ns));
+    put("ci_high_ns", static_cast<float_type>(br.ci_high_ns));
+    put("min_ns", static_cast<float_type>(br.min_ns));
+    put("mean_ns", static_cast<float_type>(br.mean_ns));
+    put("folded", bench_body_is_constant(fobj->func));
+    return intrusive_ptr<DictObject>(make_intrusive<DictObject>(move(data)));
+}
+
 EvalValue builtin_clone(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -194,7 +540,7 @@ EvalValue builtin_clone(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_deepclone(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     return make_deep_mutable_clone(RValue(arg->eval(ctx)));
@@ -203,13 +549,13 @@ EvalValue builtin_deepclone(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_intptr(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &lval = arg->eval(ctx);
 
     if (!lval.is<LValue *>())
-        throw NotLValueEx(arg->start, arg->end);
+        throw NotLValueEx(arg->start(), arg->end());
 
     const EvalValue &e = lval.get<LValue *>()->get();
     return e.get_type()->intptr(e);
@@ -218,13 +564,13 @@ EvalValue builtin_intptr(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_assert(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.get_type()->is_true(e))
-        throw AssertionFailureEx(exprList->start, exprList->end);
+        throw AssertionFailureEx(exprList->start(), exprList->end());
 
     return none;
 }
@@ -232,7 +578,7 @@ EvalValue builtin_assert(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_erase(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -240,27 +586,27 @@ EvalValue builtin_erase(EvalContext *ctx, ExprList *exprList)
     const EvalValue &index_val = RValue(arg1->eval(ctx));
 
     if (!container_lval.is<LValue *>())
-        throw NotLValueEx(arg0->start, arg0->end);
+        throw NotLValueEx(arg0->start(), arg0->end());
 
     LValue *lval = container_lval.get<LValue *>();
 
     if (lval->is_const_var())
-        throw CannotChangeConstEx(arg0->start, arg0->end);
+        throw CannotChangeConstEx(arg0->start(), arg0->end());
 
     if (lval->is<intrusive_ptr<DictObject>>()) {
 
         if (lval->getval<intrusive_ptr<DictObject>>()->is_readonly())
-            throw CannotChangeConstEx(arg0->start, arg0->end);
+            throw CannotChangeConstEx(arg0->start(), arg0->end());
 
         return builtin_erase_dict(lval, index_val);
 
     } else if (lval->is<SharedArrayObj>()) {
 
         if (lval->getval<SharedArrayObj>().is_readonly())
-            throw CannotChangeConstEx(arg0->start, arg0->end);
+            throw CannotChangeConstEx(arg0->start(), arg0->end());
 
         if (!index_val.is<int_type>())
-            throw TypeErrorEx("Expected integer", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected integer", arg1->start(), arg1->end());
 
         return builtin_erase_arr(lval, index_val.get<int_type>());
 
@@ -268,8 +614,8 @@ EvalValue builtin_erase(EvalContext *ctx, ExprList *exprList)
 
         throw TypeErrorEx(
             "Unsupported container type by erase()",
-            arg0->start,
-            arg0->end
+            arg0->start(),
+            arg0->end()
         );
     }
 }
@@ -277,7 +623,7 @@ EvalValue builtin_erase(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_insert(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 3)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -287,27 +633,27 @@ EvalValue builtin_insert(EvalContext *ctx, ExprList *exprList)
     const EvalValue &val = RValue(arg2->eval(ctx));
 
     if (!container_lval.is<LValue *>())
-        throw NotLValueEx(arg0->start, arg0->end);
+        throw NotLValueEx(arg0->start(), arg0->end());
 
     LValue *lval = container_lval.get<LValue *>();
 
     if (lval->is_const_var())
-        throw CannotChangeConstEx(arg0->start, arg0->end);
+        throw CannotChangeConstEx(arg0->start(), arg0->end());
 
     if (lval->is<intrusive_ptr<DictObject>>()) {
 
         if (lval->getval<intrusive_ptr<DictObject>>()->is_readonly())
-            throw CannotChangeConstEx(arg0->start, arg0->end);
+            throw CannotChangeConstEx(arg0->start(), arg0->end());
 
         return builtin_insert_dict(lval, index_val, val);
 
     } else if (lval->is<SharedArrayObj>()) {
 
         if (lval->getval<SharedArrayObj>().is_readonly())
-            throw CannotChangeConstEx(arg0->start, arg0->end);
+            throw CannotChangeConstEx(arg0->start(), arg0->end());
 
         if (!index_val.is<int_type>())
-            throw TypeErrorEx("Expected integer", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected integer", arg1->start(), arg1->end());
 
         return builtin_insert_arr(lval, index_val.get<int_type>(), val);
 
@@ -315,8 +661,8 @@ EvalValue builtin_insert(EvalContext *ctx, ExprList *exprList)
 
         throw TypeErrorEx(
             "Unsupported container type by erase()",
-            arg0->start,
-            arg0->end
+            arg0->start(),
+            arg0->end()
         );
     }
 }
@@ -324,7 +670,7 @@ EvalValue builtin_insert(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_find(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 2 || exprList->elems.size() > 3)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -351,18 +697,20 @@ EvalValue builtin_find(EvalContext *ctx, ExprList *exprList)
             const EvalValue &keyval = RValue(arg2->eval(ctx));
 
             if (!keyval.is<intrusive_ptr<FuncObject>>())
-                throw TypeErrorEx("Expected function object", arg2->start, arg2->end);
+                throw TypeErrorEx("Expected function object", arg2->start(),
+                                  arg2->end());
 
             key_holder = keyval.get<intrusive_ptr<FuncObject>>();
             key = key_holder.get();
         }
 
-        return builtin_find_arr(container_val.get<SharedArrayObj>(), elem_val, key, ctx);
+        return builtin_find_arr(container_val.get<SharedArrayObj>(), elem_val,
+                                key, ctx);
 
     } else if (container_val.is<SharedStr>()) {
 
         if (!elem_val.is<SharedStr>())
-            throw TypeErrorEx("Expected string", arg1->start, arg1->end);
+            throw TypeErrorEx("Expected string", arg1->start(), arg1->end());
 
         return builtin_find_str(
             container_val.get<SharedStr>(),
@@ -371,31 +719,91 @@ EvalValue builtin_find(EvalContext *ctx, ExprList *exprList)
 
     } else {
 
-        throw TypeErrorEx("Unsupported container type by find()", arg0->start, arg0->end);
+        throw TypeErrorEx("Unsupported container type by find()",
+                          arg0->start(), arg0->end());
     }
 }
 
 EvalValue builtin_hash(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
     return static_cast<int_type>(e.hash());
 }
 
+/*
+ * The parallel fast path of map()/filter(): call `funcObj` on every element of
+ * a FLAT scalar array across the worker pool (parallel.h), writing the results
+ * to `out` (one per element, in order). Applies only to a par_safe callback
+ * (pure, capture-free, scalar-only body - see FuncDeclStmt::par_safe) over a
+ * big enough int/float/bool array outside const-eval; returns false otherwise,
+ * and the caller runs its ordinary sequential loop.
+ *
+ * Element 0 runs first on this thread: it warms the callee's lazily cached
+ * fields (min_args_cache) before any worker reads them, and an error there
+ * propagates exactly as the sequential loop would raise it. An error on a
+ * worker is not rethrown across threads: the workers just stop, and we return
+ * false so the sequential loop re-runs and raises it with its usual loc and
+ * backtrace. The callback is pure, so the partial parallel run is unobservable.
+ */
+static bool
+par_eval_each(EvalContext *ctx,
+              FuncObject &funcObj,
+              const SharedArrayObj &arr,
+              std::vector<EvalValue> &out)
+{
+    const size_type n = arr.size();
+    const SharedArrayObj::Storage k = arr.skind();
+
+    if (n < PAR_MIN_ITEMS || !funcObj.func->par_safe ||
+        !funcObj.capture_slots.empty() || ctx->in_const_eval())
+        return false;
+
+    if (k != SharedArrayObj::Storage::ints &&
+        k != SharedArrayObj::Storage::floats &&
+        k != SharedArrayObj::Storage::bools)
+        return false;
+
+    if (par_workers() <= 1)
+        return false;
+
+    out.resize(n);
+    out[0] = RValue(eval_func(ctx, funcObj, arr_elem_at(arr, 0)));
+
+    std::atomic<bool> failed{false};
+
+    par_for(n - 1, [&](size_t b, size_t e) {
+
+        /* per-worker context: do_func_call builds the callee's own Frame */
+        EvalContext wctx(ctx);
+
+        try {
+
+            for (size_t i = b + 1; i <= e && !failed.load(); i++)
+                out[i] = RValue(eval_func(&wctx, funcObj, arr_elem_at(arr, i)));
+
+        } catch (...) {
+            failed.store(true);
+        }
+    });
+
+    return !failed.load();
+}
+
 EvalValue builtin_map(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
     const EvalValue &val0 = RValue(arg0->eval(ctx));
 
     if (!val0.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx("Expected function", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected function", arg0->start(), arg0->end());
 
     const EvalValue &val1 = RValue(arg1->eval(ctx));
     FuncObject &funcObj = *val0.get<intrusive_ptr<FuncObject>>().get();
@@ -407,6 +815,16 @@ EvalValue builtin_map(EvalContext *ctx, ExprList *exprList)
          * (arr_elem_at). map() builds a fresh array - not a promotion. */
         const SharedArrayObj &arr = val1.get<SharedArrayObj>();
         const size_type n = arr.size();
+        std::vector<EvalValue> par_out;
+
+        if (par_eval_each(ctx, funcObj, arr, par_out)) {
+
+            result.reserve(n);
+            for (auto &v : par_out)
+                result.emplace_back(move(v), ctx->const_ctx);
+
+            return SharedArrayObj(move(result));
+        }
 
         for (size_type i = 0; i < n; i++) {
 
@@ -433,8 +851,8 @@ EvalValue builtin_map(EvalContext *ctx, ExprList *exprList)
 
         throw TypeErrorEx(
             "Unsupported container type for map()",
-            arg1->start,
-            arg1->end
+            arg1->start(),
+            arg1->end()
         );
     }
 
@@ -444,14 +862,14 @@ EvalValue builtin_map(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_filter(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
     const EvalValue &val0 = RValue(arg0->eval(ctx));
 
     if (!val0.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx("Expected function", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected function", arg0->start(), arg0->end());
 
     const EvalValue &val1 = RValue(arg1->eval(ctx));
     FuncObject &funcObj = *val0.get<intrusive_ptr<FuncObject>>().get();
@@ -462,6 +880,16 @@ EvalValue builtin_filter(EvalContext *ctx, ExprList *exprList)
         const SharedArrayObj &arr = val1.get<SharedArrayObj>();
         const size_type n = arr.size();
         SharedArrayObj::vec_type result;
+        std::vector<EvalValue> par_out;
+
+        if (par_eval_each(ctx, funcObj, arr, par_out)) {
+
+            for (size_type i = 0; i < n; i++)
+                if (par_out[i].is_true())
+                    result.emplace_back(arr_elem_at(arr, i), ctx->const_ctx);
+
+            return SharedArrayObj(move(result));
+        }
 
         for (size_type i = 0; i < n; i++) {
 
@@ -490,8 +918,8 @@ EvalValue builtin_filter(EvalContext *ctx, ExprList *exprList)
 
         throw TypeErrorEx(
             "Unsupported container type for filter()",
-            arg1->start,
-            arg1->end
+            arg1->start(),
+            arg1->end()
         );
     }
 }
@@ -30,13 +30,13 @@ EvalValue builtin_print(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_write(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1 || exprList->elems.size() > 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &e = RValue(arg0->eval(ctx));
 
     if (!e.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected string", arg0->start(), arg0->end());
 
     ostream *s = &cout;
     std::ofstream fs;
@@ -47,12 +47,13 @@ EvalValue builtin_write(EvalContext *ctx, ExprList *exprList)
         const EvalValue &fstr = RValue(arg1->eval(ctx));
 
         if (!fstr.is<SharedStr>())
-            throw TypeErrorEx("Expect filename (string)", arg1->start, arg1->end);
+            throw TypeErrorEx("Expect filename (string)", arg1->start(),
+                              arg1->end());
 
         fs.open(string(fstr.get<SharedStr>().get_view()));
 
         if (!fs)
-            throw CannotOpenFileEx(arg1->start, arg1->end);
+            throw CannotOpenFileEx(arg1->start(), arg1->end());
 
         s = &fs;
     }
@@ -72,7 +73,7 @@ EvalValue builtin_writeln(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_read(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() > 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     std::istream *s = &cin;
     std::ifstream fs;
@@ -83,12 +84,13 @@ EvalValue builtin_read(EvalContext *ctx, ExprList *exprList)
         const EvalValue &fstr = RValue(arg0->eval(ctx));
 
         if (!fstr.is<SharedStr>())
-            throw TypeErrorEx("Expect filename (string)", arg0->start, arg0->end);
+            throw TypeErrorEx("Expect filename (string)", arg0->start(),
+                              arg0->end());
 
         fs.open(string(fstr.get<SharedStr>().get_view()));
 
         if (!fs)
-            throw CannotOpenFileEx(arg0->start, arg0->end);
+            throw CannotOpenFileEx(arg0->start(), arg0->end());
 
         s = &fs;
     }
@@ -99,7 +101,7 @@ EvalValue builtin_read(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_readln(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     string str;
     getline(cin, str);
@@ -109,7 +111,7 @@ EvalValue builtin_readln(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_readlines(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() > 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     SharedArrayObj::vec_type vec;
     std::istream *s = &cin;
@@ -122,12 +124,13 @@ EvalValue builtin_readlines(EvalContext *ctx, ExprList *exprList)
         const EvalValue &fstr = RValue(arg0->eval(ctx));
 
         if (!fstr.is<SharedStr>())
-            throw TypeErrorEx("Expect filename (string)", arg0->start, arg0->end);
+            throw TypeErrorEx("Expect filename (string)", arg0->start(),
+                              arg0->end());
 
         fs.open(string(fstr.get<SharedStr>().get_view()));
 
         if (!fs)
-            throw CannotOpenFileEx(arg0->start, arg0->end);
+            throw CannotOpenFileEx(arg0->start(), arg0->end());
 
         s = &fs;
     }
@@ -143,13 +146,13 @@ EvalValue builtin_readlines(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_writelines(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1 || exprList->elems.size() > 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg->start, arg->end);
+        throw TypeErrorEx("Expected array", arg->start(), arg->end());
 
     ostream *s = &cout;
     std::ofstream fs;
@@ -160,12 +163,13 @@ EvalValue builtin_writelines(EvalContext *ctx, ExprList *exprList)
         const EvalValue &fstr = RValue(arg1->eval(ctx));
 
         if (!fstr.is<SharedStr>())
-            throw TypeErrorEx("Expect filename (string)", arg1->start, arg1->end);
+            throw TypeErrorEx("Expect filename (string)", arg1->start(),
+                              arg1->end());
 
         fs.open(string(fstr.get<SharedStr>().get_view()));
 
         if (!fs)
-            throw CannotOpenFileEx(arg1->start, arg1->end);
+            throw CannotOpenFileEx(arg1->start(), arg1->end());
 
         s = &fs;
     }
@@ -189,13 +193,14 @@ EvalValue builtin_writelines(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_remove(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &fstr = RValue(arg0->eval(ctx));
 
     if (!fstr.is<SharedStr>())
-        throw TypeErrorEx("Expect filename (string)", arg0->start, arg0->end);
+        throw TypeErrorEx("Expect filename (string)", arg0->start(),
+                          arg0->end());
 
     const string path(fstr.get<SharedStr>().get_view());
     return static_cast<int_type>(std::remove(path.c_str()) == 0 ? 1 : 0);
@@ -209,7 +214,7 @@ EvalValue builtin_remove(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_tmpdir(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     const char *dir = nullptr;
     for (const char *var : { "TMPDIR", "TEMP", "TMP" }) {
@@ -16,14 +16,20 @@
 #include <random>
 #include <cmath>
 
-static std::random_device rdev;
-static std::mt19937_64 mt_engine(rdev());
+/* Seeded on the first rand()/randf(), not at startup: opening the entropy
+ * source costs more than running a short script. */
+static std::mt19937_64 &
+rand_engine()
+{
+    static std::mt19937_64 engine(std::random_device{}());
+    return engine;
+}
 
 
 EvalValue builtin_int(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
@@ -57,19 +63,21 @@ EvalValue builtin_int(EvalContext *ctx, ExprList *exprList)
 
         } catch (...) {
 
-            throw TypeErrorEx("The string cannot be converted to integer", arg->start, arg->end);
+            throw TypeErrorEx("The string cannot be converted to integer",
+                              arg->start(), arg->end());
         }
 
     } else {
 
-        throw TypeErrorEx("Unsupported type for int()", arg->start, arg->end);
+        throw TypeErrorEx("Unsupported type for int()", arg->start(),
+                          arg->end());
     }
 }
 
 EvalValue builtin_float(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
@@ -94,19 +102,21 @@ EvalValue builtin_float(EvalContext *ctx, ExprList *exprList)
 
         } catch (...) {
 
-            throw TypeErrorEx("The string cannot be converted to float", arg->start, arg->end);
+            throw TypeErrorEx("The string cannot be converted to float",
+                              arg->start(), arg->end());
         }
 
     } else {
 
-        throw TypeErrorEx("Unsupported type for float()", arg->start, arg->end);
+        throw TypeErrorEx("Unsupported type for float()", arg->start(),
+                          arg->end());
     }
 }
 
 EvalValue builtin_abs(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -122,7 +132,8 @@ EvalValue builtin_abs(EvalContext *ctx, ExprList *exprList)
 
     } else {
 
-        throw TypeErrorEx("Unsupported type for abs()", arg->start, arg->end);
+        throw TypeErrorEx("Unsupported type for abs()", arg->start(),
+                          arg->end());
     }
 }
 
@@ -201,7 +212,7 @@ template <bool is_max>
 EvalValue b_min_max(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() == 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *first_arg = exprList->elems[0].get();
     EvalValue val = RValue(first_arg->eval(ctx));
@@ -212,8 +223,8 @@ EvalValue b_min_max(EvalContext *ctx, ExprList *exprList)
         if (!val.is<SharedArrayObj>()) {
             throw TypeErrorEx(
                 "When a single argument is provided, it must be an array",
-                first_arg->start,
-                first_arg->end
+                first_arg->start(),
+                first_arg->end()
             );
         }
 
@@ -254,7 +265,7 @@ static EvalValue
 float_func(EvalContext *ctx, ExprList *exprList, funcT f)
 {
     if (exprList->elems.size() != N)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     float_type x[N];
 
@@ -273,7 +284,8 @@ float_func(EvalContext *ctx, ExprList *exprList, funcT f)
 
         else
 
-            throw TypeErrorEx("Expected numeric type", arg->start, arg->end);
+            throw TypeErrorEx("Expected numeric type", arg->start(),
+                              arg->end());
     }
 
     if constexpr(N == 1)
@@ -329,7 +341,7 @@ INST_FLOAT_BUILTIN_1_ex(isnan, bool (*)(float_type), std::isnan);
 EvalValue builtin_round(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 1)
-        throw InvalidArgumentEx(exprList->start, exprList->end);
+        throw InvalidArgumentEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     const EvalValue &v0 = RValue(arg0->eval(ctx));
@@ -340,7 +352,7 @@ EvalValue builtin_round(EvalContext *ctx, ExprList *exprList)
     else if (v0.is<int_type>())
         x = static_cast<float_type>(v0.get<int_type>());
     else
-        throw TypeErrorEx("Expected numeric type", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected numeric type", arg0->start(), arg0->end());
 
     if (exprList->elems.size() == 1) {
 
@@ -349,14 +361,14 @@ EvalValue builtin_round(EvalContext *ctx, ExprList *exprList)
     } else {
 
         if (exprList->elems.size() != 2)
-            throw InvalidArgumentEx(exprList->start, exprList->end);
+            throw InvalidArgumentEx(exprList->start(), exprList->end());
 
         Construct *arg1 = exprList->elems[1].get();
         const EvalValue &v1 = RValue(arg1->eval(ctx));
 
         if (!v1.is<int_type>() || v1.get<int_type>() < 0) {
             throw TypeErrorEx(
-                "Expected a non-negative integer", arg1->start, arg1->end
+                "Expected a non-negative integer", arg1->start(), arg1->end()
             );
         }
 
@@ -371,7 +383,7 @@ EvalValue builtin_round(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_rand(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -379,10 +391,10 @@ EvalValue builtin_rand(EvalContext *ctx, ExprList *exprList)
     const EvalValue &v1 = RValue(arg1->eval(ctx));
 
     if (!v0.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected integer", arg0->start(), arg0->end());
 
     if (!v1.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected integer", arg1->start(), arg1->end());
 
     if (v1.get<int_type>() < v0.get<int_type>())
         return none;
@@ -394,13 +406,13 @@ EvalValue builtin_rand(EvalContext *ctx, ExprList *exprList)
         v0.get<int_type>(), v1.get<int_type>()
     );
 
-    return distrib(mt_engine);
+    return distrib(rand_engine());
 }
 
 EvalValue builtin_randf(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -408,10 +420,10 @@ EvalValue builtin_randf(EvalContext *ctx, ExprList *exprList)
     const EvalValue &v1 = RValue(arg1->eval(ctx));
 
     if (!v0.is<float_type>())
-        throw TypeErrorEx("Expected float", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected float", arg0->start(), arg0->end());
 
     if (!v1.is<float_type>())
-        throw TypeErrorEx("Expected float", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected float", arg1->start(), arg1->end());
 
     if (v1.get<float_type>() < v0.get<float_type>())
         return none;
@@ -423,5 +435,5 @@ EvalValue builtin_randf(EvalContext *ctx, ExprList *exprList)
         v0.get<float_type>(), v1.get<float_type>()
     );
 
-    return distrib(mt_engine);
+    return distrib(rand_engine());
 }
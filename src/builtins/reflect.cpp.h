@@ -276,19 +276,18 @@ std::string reflect_layout(const StructTypeDef *def)
 EvalValue builtin_globals(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     EvalContext *root = get_root_ctx(ctx);
     std::vector<std::pair<const UniqueId *, const LValue *>> syms;
     root->collect_symbols(syms);
 
-    /* The root context copies every builtin into its symbol map; exclude them
+    /* The REPL's root context copies every builtin into its map; exclude them
      * (they are the province of :help builtins, not the user's globals). */
     std::vector<std::string> names;
     names.reserve(syms.size());
     for (const auto &kv : syms) {
-        if (EvalContext::const_builtins.count(kv.first) ||
-            EvalContext::builtins.count(kv.first))
+        if (builtin_slot_index(kv.first) >= 0)
             continue;
         names.push_back(std::string(kv.first->val));
     }
@@ -328,7 +327,7 @@ EvalValue builtin_globals(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_signature(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -342,8 +341,8 @@ EvalValue builtin_signature(EvalContext *ctx, ExprList *exprList)
         return SharedStr(
             reflect_struct_ctor(e.get<intrusive_ptr<StructObject>>()->def));
 
-    throw TypeErrorEx("Expected a function or struct type", arg->start,
-                      arg->end);
+    throw TypeErrorEx("Expected a function or struct type", arg->start(),
+                      arg->end());
 }
 
 /*
@@ -399,7 +398,7 @@ static EvalValue reflect_make_layout(const StructTypeDef *qdef)
 EvalValue builtin_layout(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
@@ -409,8 +408,8 @@ EvalValue builtin_layout(EvalContext *ctx, ExprList *exprList)
     if (e.is<intrusive_ptr<StructObject>>())
         return reflect_make_layout(e.get<intrusive_ptr<StructObject>>()->def);
 
-    throw TypeErrorEx("Expected a struct type or instance", arg->start,
-                      arg->end);
+    throw TypeErrorEx("Expected a struct type or instance", arg->start(),
+                      arg->end());
 }
 
 /*
@@ -424,13 +423,13 @@ EvalValue builtin_layout(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_specializations(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<intrusive_ptr<FuncObject>>())
-        throw TypeErrorEx("Expected a function", arg->start, arg->end);
+        throw TypeErrorEx("Expected a function", arg->start(), arg->end());
 
     const FuncDeclStmt *f = e.get<intrusive_ptr<FuncObject>>()->func;
     const std::string name =
@@ -475,7 +474,7 @@ EvalValue builtin_specializations(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_show(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
 
@@ -500,24 +499,26 @@ EvalValue builtin_show(EvalContext *ctx, ExprList *exprList)
 /*
  * trace(category, on): enable/disable a diagnostic trace category (see
  * trace.h). category is a string ("infer", "inline", "specialize", "template",
- * "autoconst", "autopure", "arrays", "fold", or "all"); on is truthy/falsy.
+ * "autoconst", "autopure", "arrays", "fold", "licm", the runtime "calls",
+ * "builtins", "exceptions", "allocs", "promotions", or "all"); on is
+ * truthy/falsy.
  * Throws InvalidValueEx on an unknown category. Returns none.
  */
 EvalValue builtin_trace(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *a0 = exprList->elems[0].get();
     const EvalValue &name = RValue(a0->eval(ctx));
     const EvalValue &on = RValue(exprList->elems[1]->eval(ctx));
 
     if (!name.is<SharedStr>())
-        throw TypeErrorEx("Expected a category string", a0->start, a0->end);
+        throw TypeErrorEx("Expected a category string", a0->start(), a0->end());
 
     const string cat(name.get<SharedStr>().get_view());
     if (!trace_set(cat, on.get_type()->is_true(on)))
-        throw InvalidValueEx("Unknown trace category", a0->start, a0->end);
+        throw InvalidValueEx("Unknown trace category", a0->start(), a0->end());
     return none;
 }
 
@@ -525,16 +526,42 @@ EvalValue builtin_trace(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_traceoff(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
     trace_clear_all();
     return none;
 }
 
+/*
+ * trace_dump(path): write the runtime trace events recorded so far as Chrome
+ * trace JSON and drop them, so the next dump starts where this one ended.
+ * Throws CannotOpenFileEx. Returns the number of events written.
+ */
+EvalValue builtin_trace_dump(EvalContext *ctx, ExprList *exprList)
+{
+    if (exprList->elems.size() != 1)
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
+
+    Construct *arg = exprList->elems[0].get();
+    const EvalValue &e = RValue(arg->eval(ctx));
+
+    if (!e.is<SharedStr>())
+        throw TypeErrorEx("Expect filename (string)", arg->start(), arg->end());
+
+    std::ofstream fs(string(e.get<SharedStr>().get_view()));
+
+    if (!fs)
+        throw CannotOpenFileEx(arg->start(), arg->end());
+
+    const size_t n = trace_dump_json(fs);
+    trace_events_clear();
+    return static_cast<int_type>(n);
+}
+
 /* tracing(): the active trace categories as a sorted array<str>. */
 EvalValue builtin_tracing(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 0)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     std::vector<std::string> active = trace_active();
     SharedArrayObj::vec_type vec;
@@ -18,7 +18,7 @@
 EvalValue builtin_split(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg_str = exprList->elems[0].get();
     Construct *arg_delim = exprList->elems[1].get();
@@ -27,10 +27,11 @@ EvalValue builtin_split(EvalContext *ctx, ExprList *exprList)
     const EvalValue &val_delim = RValue(arg_delim->eval(ctx));
 
     if (!val_str.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg_str->start, arg_str->end);
+        throw TypeErrorEx("Expected string", arg_str->start(), arg_str->end());
 
     if (!val_delim.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg_delim->start, arg_delim->end);
+        throw TypeErrorEx("Expected string", arg_delim->start(),
+                          arg_delim->end());
 
     const SharedStr &shared_str = val_str.get<SharedStr>();
     const string_view &str = shared_str.get_view();
@@ -73,7 +74,7 @@ EvalValue builtin_split(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_join(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg_arr = exprList->elems[0].get();
     Construct *arg_delim = exprList->elems[1].get();
@@ -82,10 +83,11 @@ EvalValue builtin_join(EvalContext *ctx, ExprList *exprList)
     const EvalValue &val_delim = RValue(arg_delim->eval(ctx));
 
     if (!val_arr.is<SharedArrayObj>())
-        throw TypeErrorEx("Expected array", arg_arr->start, arg_arr->end);
+        throw TypeErrorEx("Expected array", arg_arr->start(), arg_arr->end());
 
     if (!val_delim.is<SharedStr>())
-        throw TypeErrorEx("Expected array", arg_delim->start, arg_delim->end);
+        throw TypeErrorEx("Expected array", arg_delim->start(),
+                          arg_delim->end());
 
     const string_view delim = val_delim.get<SharedStr>().get_view();
     /* Read kind-aware (arr_elem_at) so a flat int/float array doesn't promote -
@@ -99,7 +101,8 @@ EvalValue builtin_join(EvalContext *ctx, ExprList *exprList)
         const EvalValue val = arr_elem_at(arr, i);
 
         if (!val.is<SharedStr>())
-            throw TypeErrorEx("Expected string", arg_arr->start, arg_arr->end);
+            throw TypeErrorEx("Expected string", arg_arr->start(),
+                              arg_arr->end());
 
         result += val.get<SharedStr>().get_view();
 
@@ -113,13 +116,13 @@ EvalValue builtin_join(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_splitlines(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg->start, arg->end);
+        throw TypeErrorEx("Expected string", arg->start(), arg->end());
 
     const SharedStr &shared_str = val.get<SharedStr>();
     const string_view &str = shared_str.get_view();
@@ -164,19 +167,20 @@ EvalValue builtin_splitlines(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_ord(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg->start, arg->end);
+        throw TypeErrorEx("Expected string", arg->start(), arg->end());
 
     const SharedStr &shared_str = val.get<SharedStr>();
     const string_view &str = shared_str.get_view();
 
     if (str.size() != 1)
-         throw InvalidValueEx("Expected 1-char string", arg->start, arg->end);
+         throw InvalidValueEx("Expected 1-char string", arg->start(),
+                              arg->end());
 
     return static_cast<int_type>(static_cast<unsigned char>(str[0]));
 }
@@ -184,19 +188,20 @@ EvalValue builtin_ord(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_chr(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg->start, arg->end);
+        throw TypeErrorEx("Expected integer", arg->start(), arg->end());
 
     const int_type n = val.get<int_type>();
 
     if (n < 0 || n > 255) {
         throw InvalidValueEx(
-            "Expected an integer in the range [0, 255]", arg->start, arg->end
+            "Expected an integer in the range [0, 255]",
+            arg->start(), arg->end()
         );
     }
 
@@ -220,7 +225,7 @@ static EvalValue
 generic_pad(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() < 2 || exprList->elems.size() > 3)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -229,10 +234,10 @@ generic_pad(EvalContext *ctx, ExprList *exprList)
     char pad_char = ' ';
 
     if (!strval.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected string", arg0->start(), arg0->end());
 
     if (!nval.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected integer", arg1->start(), arg1->end());
 
     if (exprList->elems.size() == 3) {
 
@@ -240,12 +245,13 @@ generic_pad(EvalContext *ctx, ExprList *exprList)
         const EvalValue &padc = RValue(arg2->eval(ctx));
 
         if (!padc.is<SharedStr>())
-            throw TypeErrorEx("Expected string", arg2->start, arg2->end);
+            throw TypeErrorEx("Expected string", arg2->start(), arg2->end());
 
         const string_view padstr = padc.get<SharedStr>().get_view();
 
         if (padstr.size() > 1)
-            throw InvalidValueEx("Expected 1-char string", arg2->start, arg2->end);
+            throw InvalidValueEx("Expected 1-char string", arg2->start(),
+                                 arg2->end());
 
         pad_char = padstr[0];
     }
@@ -254,7 +260,8 @@ generic_pad(EvalContext *ctx, ExprList *exprList)
     const int_type n_orig = nval.get<int_type>();
 
     if (n_orig < 0)
-        throw InvalidValueEx("Expected non-negative integer", arg1->start, arg1->end);
+        throw InvalidValueEx("Expected non-negative integer", arg1->start(),
+                             arg1->end());
 
     const size_t n = static_cast<size_t>(n_orig);
 
@@ -285,13 +292,13 @@ EvalValue builtin_rpad(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_lstrip(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg->start, arg->end);
+        throw TypeErrorEx("Expected string", arg->start(), arg->end());
 
     const SharedStr &shared_str = val.get<SharedStr>();
     const string_view &str = shared_str.get_view();
@@ -311,13 +318,13 @@ EvalValue builtin_lstrip(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_rstrip(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg->start, arg->end);
+        throw TypeErrorEx("Expected string", arg->start(), arg->end());
 
     const SharedStr &shared_str = val.get<SharedStr>();
     const string_view &str = shared_str.get_view();
@@ -337,13 +344,13 @@ EvalValue builtin_rstrip(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_strip(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &val = RValue(arg->eval(ctx));
 
     if (!val.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg->start, arg->end);
+        throw TypeErrorEx("Expected string", arg->start(), arg->end());
 
     const SharedStr &shared_str = val.get<SharedStr>();
     const string_view &str = shared_str.get_view();
@@ -368,7 +375,7 @@ EvalValue builtin_strip(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_startswith(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -376,10 +383,10 @@ EvalValue builtin_startswith(EvalContext *ctx, ExprList *exprList)
     const EvalValue &val1 = RValue(arg1->eval(ctx));
 
     if (!val0.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected string", arg0->start(), arg0->end());
 
     if (!val1.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected string", arg1->start(), arg1->end());
 
     const string_view str = val0.get<SharedStr>().get_view();
     const string_view substr = val1.get<SharedStr>().get_view();
@@ -394,7 +401,7 @@ EvalValue builtin_startswith(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_endswith(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 2)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg0 = exprList->elems[0].get();
     Construct *arg1 = exprList->elems[1].get();
@@ -402,10 +409,10 @@ EvalValue builtin_endswith(EvalContext *ctx, ExprList *exprList)
     const EvalValue &val1 = RValue(arg1->eval(ctx));
 
     if (!val0.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg0->start, arg0->end);
+        throw TypeErrorEx("Expected string", arg0->start(), arg0->end());
 
     if (!val1.is<SharedStr>())
-        throw TypeErrorEx("Expected string", arg1->start, arg1->end);
+        throw TypeErrorEx("Expected string", arg1->start(), arg1->end());
 
     const string_view str = val0.get<SharedStr>().get_view();
     const string_view substr = val1.get<SharedStr>().get_view();
@@ -110,8 +110,8 @@ struct Renderer {
     bool enter_inline(const Construct *c, const InlineCtx *&saved)
     {
         saved = cur_inline;
-        if (c->inline_ctx && c->inline_ctx != cur_inline) {
-            cur_inline = c->inline_ctx;
+        if (c->inline_ctx() && c->inline_ctx() != cur_inline) {
+            cur_inline = c->inline_ctx();
             return true;
         }
         return false;
@@ -162,6 +162,8 @@ struct Renderer {
             return 1;
         if (auto *e1 = dynamic_cast<const Expr01 *>(c))
             return e1->elem ? expr_prec(e1->elem.get()) : PREC_PRIMARY;
+        if (auto *h = dynamic_cast<const HoistedExpr *>(c))
+            return h->elem ? expr_prec(h->elem.get()) : PREC_PRIMARY;
         return PREC_PRIMARY;
     }
 
@@ -293,8 +295,8 @@ struct Renderer {
              * form, used when the body is not a temp-free guard chain - a guard
              * body is inlined as a real ternary instead). Label it once, then
              * render the single-return body as its value, else the block. */
-            const char *nm = (e->elem && e->elem->inline_ctx)
-                ? e->elem->inline_ctx->callee_name.c_str() : "?";
+            const char *nm = (e->elem && e->elem->inline_ctx())
+                ? e->elem->inline_ctx()->callee_name.c_str() : "?";
             auto *b = dynamic_cast<const Block *>(e->elem.get());
             const ReturnStmt *r = (b && b->elems.size() == 1)
                 ? dynamic_cast<const ReturnStmt *>(b->elems[0].get()) : nullptr;
@@ -311,8 +313,15 @@ struct Renderer {
             }
             return;
         }
+        if (auto *e = dynamic_cast<const HoistedExpr *>(c)) {
+            /* computed once per loop entry (LICM); the expression itself is
+             * unchanged, so label it and render it in place */
+            o << "/* hoisted */ ";
+            if (e->elem) expr_inner(e->elem.get());
+            return;
+        }
         /* fallback for an unhandled expression node */
-        o << "/* " << c->name << " */";
+        o << "/* " << c->name() << " */";
     }
 
     /* ------------------------------ statements ------------------------ */
@@ -0,0 +1,1973 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "compilecache.h"
+#include "syntax.h"
+#include "eval.h"
+#include "errors.h"
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+
+const char cc_magic[4] = { 'M', 'Y', 'L', 'C' };
+
+/* Bump on any change to what is written below. */
+const unsigned cc_format = 1;
+
+/*
+ * One tag per concrete node class. Children are written in place (pre-order);
+ * an absent child (a null unique_ptr) is `null`.
+ */
+enum class Tag : unsigned char {
+    null,
+    lit_int, lit_bool, lit_float, lit_none, lit_str, lit_array, lit_obj,
+    lit_kv, lit_dict, nop,
+    id, expr_list, id_list,
+    call, direct_call, cached_call, direct_builtin_call, inlined_call,
+    hoisted,
+    expr01, expr02, expr03, expr04, expr05, expr06, expr07, expr08, expr09,
+    expr10, expr11, expr12, typed_scalar, expr14,
+    if_stmt, block, break_stmt, continue_stmt, return_stmt, while_stmt,
+    func_decl, struct_decl, subscript, range_subscript, slice, try_catch,
+    rethrow, throw_stmt, foreach, member, incdec, ternary, coalesce,
+    for_stmt, for_range,
+    count_,
+};
+
+/* A native (interpreter-built) struct type a tree may point at: written as a
+ * fixed id instead of a table index. */
+enum NativeDef : unsigned {
+    nd_null, nd_field, nd_layout, nd_type, nd_first_table,
+};
+
+/*
+ * The writer refuses a tree it can't express and the reader a malformed
+ * entry by throwing this; either way the caller just doesn't use the cache.
+ */
+struct CacheFail { };
+
+/*
+ * The InlineCtx chains of loaded trees. Like the inliner's own pool
+ * (resolver.cpp) they are referenced by the AST and never freed; a deque
+ * keeps their addresses stable as it grows.
+ */
+std::deque<InlineCtx> loaded_inline_ctxs;
+
+/* ----------------------------- Writer ------------------------------ */
+
+class Writer {
+
+    string *cur = nullptr;
+
+    std::unordered_map<const UniqueId *, size_t> uid_idx;
+    vector<const UniqueId *> uids;
+
+    std::unordered_map<const StructTypeDef *, size_t> def_idx;
+    vector<const StructTypeDef *> defs;
+    std::unordered_set<const StructTypeDef *> owned_defs;
+
+    std::unordered_map<const InlineCtx *, size_t> ictx_idx;
+    vector<const InlineCtx *> ictxs;
+
+    void u8(unsigned v) { cur->push_back(static_cast<char>(v)); }
+    void flag(bool v) { u8(v ? 1 : 0); }
+
+    void unum(uint64_t v) {
+        while (v >= 0x80) {
+            u8(static_cast<unsigned>(v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        u8(static_cast<unsigned>(v));
+    }
+
+    /* zigzag: small negative numbers (the -1 "none" slots) stay one byte */
+    void num(int64_t v) {
+        unum((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    void f64(double v) {
+        char b[sizeof v];
+        memcpy(b, &v, sizeof v);
+        cur->append(b, sizeof v);
+    }
+
+    void bytes(const char *p, size_t n) { unum(n); cur->append(p, n); }
+    void str(string_view s) { bytes(s.data(), s.size()); }
+
+    void loc(const Loc &l) { num(l.line); num(l.col); }
+
+    void ints(const vector<int> &v) {
+        unum(v.size());
+        for (int x : v)
+            num(x);
+    }
+
+    /* Interned names: an index into the uid table (0 == null). */
+    void uid(const UniqueId *u) {
+        if (!u) {
+            unum(0);
+            return;
+        }
+        auto it = uid_idx.find(u);
+        if (it == uid_idx.end()) {
+            it = uid_idx.emplace(u, uids.size()).first;
+            uids.push_back(u);
+        }
+        unum(it->second + 1);
+    }
+
+    void def(const StructTypeDef *d) {
+        if (!d)
+            unum(nd_null);
+        else if (d == native_struct_field_def())
+            unum(nd_field);
+        else if (d == native_struct_layout_def())
+            unum(nd_layout);
+        else if (d == native_struct_type_def())
+            unum(nd_type);
+        else {
+            auto it = def_idx.find(d);
+            if (it == def_idx.end()) {
+                it = def_idx.emplace(d, defs.size()).first;
+                defs.push_back(d);
+            }
+            unum(nd_first_table + it->second);
+        }
+    }
+
+    void ictx(const InlineCtx *ic) {
+        if (!ic) {
+            unum(0);
+            return;
+        }
+        auto it = ictx_idx.find(ic);
+        if (it == ictx_idx.end()) {
+            it = ictx_idx.emplace(ic, ictxs.size()).first;
+            ictxs.push_back(ic);
+        }
+        unum(it->second + 1);
+    }
+
+    void annot(const std::shared_ptr<TypeAnnot> &a) {
+        flag(a != nullptr);
+        if (!a)
+            return;
+        u8(static_cast<unsigned>(a->kind));
+        flag(a->opt);
+        def(a->strct);
+        annot(a->elem);
+        annot(a->key);
+        annot(a->val);
+    }
+
+    /* Shared objects already written (see shared()), by identity. */
+    static constexpr size_t in_progress = static_cast<size_t>(-1);
+    std::unordered_map<const void *, size_t> obj_idx;
+    size_t next_obj = 0;
+
+    bool shared(const void *obj);
+    void shared_done(const void *obj);
+    void value(const EvalValue &v);
+    void array_storage(const SharedArrayObj &a);
+    void node(const Construct *c);
+    void base(const Construct *c);
+
+    template <class T>
+    void ops(const T &elems) {
+        unum(elems.size());
+        for (const auto &pr : elems) {
+            num(static_cast<int>(pr.first));
+            node(pr.second.get());
+        }
+    }
+
+    template <class T>
+    void list(const T &elems) {
+        unum(elems.size());
+        for (const auto &e : elems)
+            node(e.get());
+    }
+
+    void struct_def(const StructTypeDef *d);
+    void inline_ctx(const InlineCtx *ic);
+
+public:
+
+    void write(std::ostream &out, const Construct *root);
+};
+
+void Writer::base(const Construct *c)
+{
+    flag(c->is_const);
+    loc(c->start());
+    loc(c->end());
+    ictx(c->inline_ctx());
+    u8(static_cast<unsigned>(c->th));
+    u8(static_cast<unsigned>(c->arr_hint));
+    def(c->arr_hint_struct());
+}
+
+/*
+ * An array's whole storage. An array value is written as a reference to its
+ * storage plus the range it views, so aliases and slices of one buffer (the
+ * parser's CSE shares one between equal constants) still share it loaded.
+ */
+void Writer::array_storage(const SharedArrayObj &a)
+{
+    typedef SharedArrayObj::Storage Storage;
+
+    const size_type n = a.storage_size();
+
+    u8(static_cast<unsigned>(a.skind()));
+    flag(a.is_readonly());
+    unum(n);
+
+    switch (a.skind()) {
+
+        case Storage::ints:
+            for (int_type x : a.flat_ints())
+                num(x);
+            break;
+
+        case Storage::floats:
+            for (float_type x : a.flat_floats())
+                f64(x);
+            break;
+
+        case Storage::bools:
+            for (unsigned char x : a.flat_bools())
+                u8(x);
+            break;
+
+        case Storage::structs: {
+            const auto &sv = a.flat_structs();
+            def(sv.def);
+            unum(static_cast<unsigned>(sv.stride));
+            cur->append(sv.buf.data(), static_cast<size_t>(n) * sv.stride);
+            break;
+        }
+
+        default:
+            for (const LValue &e : a.get_vec()) {
+                value(e.get());
+                flag(e.is_const_var());
+            }
+            break;
+    }
+}
+
+/*
+ * A shared object (an array's storage, a dict, a struct instance): 0 and the
+ * object the first time, its index + 1 after that. False when it was already
+ * written, true when the caller must write it now.
+ */
+bool Writer::shared(const void *obj)
+{
+    auto it = obj_idx.find(obj);
+
+    if (it != obj_idx.end()) {
+
+        /* a const value can't contain itself; anything else can't be cached */
+        if (it->second == in_progress)
+            throw CacheFail();
+
+        unum(it->second + 1);
+        return false;
+    }
+
+    obj_idx.emplace(obj, in_progress);
+    unum(0);
+    return true;
+}
+
+void Writer::shared_done(const void *obj)
+{
+    obj_idx[obj] = next_obj++;
+}
+
+/*
+ * A constant value (a LiteralObj, a LiteralStr, a struct type's const). Only
+ * plain data: a function, an exception or a builtin baked into a constant
+ * makes the whole tree uncacheable.
+ */
+void Writer::value(const EvalValue &v)
+{
+    const Type::TypeE t = v.get_type()->t;
+    u8(t);
+
+    switch (t) {
+
+        case Type::t_none:
+            break;
+
+        case Type::t_int:
+            num(v.get<int_type>());
+            break;
+
+        case Type::t_float:
+            f64(v.get<float_type>());
+            break;
+
+        case Type::t_bool:
+            flag(v.get<bool>());
+            break;
+
+        case Type::t_str:
+            str(v.get_ref<SharedStr>().get_view());
+            break;
+
+        case Type::t_structtype:
+            def(v.get<StructTypeDef *>());
+            break;
+
+        case Type::t_arr: {
+
+            const SharedArrayObj &a = v.get_ref<SharedArrayObj>();
+
+            if (shared(a.storage_id())) {
+                array_storage(a);
+                shared_done(a.storage_id());
+            }
+
+            flag(a.is_slice());
+            unum(a.offset());
+            unum(a.size());
+            break;
+        }
+
+        case Type::t_dict: {
+
+            const auto &d = v.get_ref<intrusive_ptr<DictObject>>();
+            const auto &data = d->get_ref();
+
+            if (!shared(d.get()))
+                break;
+
+            flag(d->is_readonly());
+            flag(d->get_has_default());
+            if (d->get_has_default())
+                value(d->get_default());
+
+            /* The bucket count and iteration order, so the reader can
+             * rebuild a dict that iterates (prints) in the same order. */
+            unum(data.bucket_count());
+            unum(data.size());
+            for (const auto &p : data) {
+                value(p.first);
+                value(p.second.get());
+                flag(p.second.is_const_var());
+            }
+
+            shared_done(d.get());
+            break;
+        }
+
+        case Type::t_struct: {
+
+            const auto &o = v.get_ref<intrusive_ptr<StructObject>>();
+
+            if (!shared(o.get()))
+                break;
+
+            def(o->def);
+            flag(o->is_readonly());
+
+            if (o->is_pod()) {
+                bytes(o->bytes.data(), o->bytes.size());
+            } else {
+                unum(o->fields.size());
+                for (const auto &f : o->fields) {
+                    value(f.get());
+                    flag(f.is_const_var());
+                }
+            }
+
+            shared_done(o.get());
+            break;
+        }
+
+        default:
+            throw CacheFail();
+    }
+}
+
+void Writer::node(const Construct *c)
+{
+    if (!c) {
+        u8(static_cast<unsigned>(Tag::null));
+        return;
+    }
+
+    const std::type_info &t = typeid(*c);
+
+    if (t == typeid(LiteralInt)) {
+        u8(static_cast<unsigned>(Tag::lit_int));
+        base(c);
+        num(static_cast<const LiteralInt *>(c)->ival());
+
+    } else if (t == typeid(LiteralBool)) {
+        u8(static_cast<unsigned>(Tag::lit_bool));
+        base(c);
+        flag(static_cast<const LiteralBool *>(c)->bval());
+
+    } else if (t == typeid(LiteralFloat)) {
+        u8(static_cast<unsigned>(Tag::lit_float));
+        base(c);
+        f64(static_cast<const LiteralFloat *>(c)->fval());
+
+    } else if (t == typeid(LiteralNone)) {
+        u8(static_cast<unsigned>(Tag::lit_none));
+        base(c);
+
+    } else if (t == typeid(LiteralStr)) {
+        u8(static_cast<unsigned>(Tag::lit_str));
+        base(c);
+        value(static_cast<const LiteralStr *>(c)->strval());
+
+    } else if (t == typeid(LiteralArray)) {
+        u8(static_cast<unsigned>(Tag::lit_array));
+        base(c);
+        list(static_cast<const LiteralArray *>(c)->elems);
+
+    } else if (t == typeid(LiteralObj)) {
+        auto *n = static_cast<const LiteralObj *>(c);
+        u8(static_cast<unsigned>(Tag::lit_obj));
+        base(c);
+        value(n->literal_value());
+        flag(n->is_immutable());
+
+    } else if (t == typeid(LiteralDictKVPair)) {
+        auto *n = static_cast<const LiteralDictKVPair *>(c);
+        u8(static_cast<unsigned>(Tag::lit_kv));
+        base(c);
+        node(n->key.get());
+        node(n->value.get());
+
+    } else if (t == typeid(LiteralDict)) {
+        u8(static_cast<unsigned>(Tag::lit_dict));
+        base(c);
+        list(static_cast<const LiteralDict *>(c)->elems);
+
+    } else if (t == typeid(NopConstruct)) {
+        u8(static_cast<unsigned>(Tag::nop));
+        base(c);
+
+    } else if (t == typeid(Identifier)) {
+        auto *n = static_cast<const Identifier *>(c);
+        u8(static_cast<unsigned>(Tag::id));
+        base(c);
+        uid(n->uid);
+        u8(static_cast<unsigned>(n->sym.kind));
+        num(n->sym.slot);
+        flag(n->const_param);
+        flag(n->auto_const_param);
+        flag(n->opt_mod);
+        flag(n->dyn_mod);
+        u8(static_cast<unsigned>(n->decl_type));
+        def(n->decl_struct);
+        annot(n->decl_annot);
+
+    } else if (t == typeid(ExprList)) {
+        auto *n = static_cast<const ExprList *>(c);
+        u8(static_cast<unsigned>(Tag::expr_list));
+        base(c);
+        list(n->elems);
+        unum(n->arg_names.size());
+        for (const UniqueId *u : n->arg_names)
+            uid(u);
+
+    } else if (t == typeid(IdList)) {
+        u8(static_cast<unsigned>(Tag::id_list));
+        base(c);
+        list(static_cast<const IdList *>(c)->elems);
+
+    } else if (t == typeid(CallExpr) || t == typeid(DirectCallExpr) ||
+               t == typeid(CachedCallExpr) ||
+               t == typeid(DirectBuiltinCallExpr)) {
+
+        auto *n = static_cast<const CallExpr *>(c);
+        Tag tag = Tag::call;
+
+        if (t == typeid(DirectCallExpr))
+            tag = Tag::direct_call;
+        else if (t == typeid(CachedCallExpr))
+            tag = Tag::cached_call;
+        else if (t == typeid(DirectBuiltinCallExpr)) {
+
+            /* The baked function pointer is re-baked on load from the
+             * callee's builtin slot: it must be the one it came from. */
+            auto *id = dynamic_cast<const Identifier *>(n->what.get());
+            if (!id || id->sym.kind != SymKind::builtin ||
+                builtin_slot(id->sym.slot).getval<Builtin>().func !=
+                    static_cast<const DirectBuiltinCallExpr *>(c)->builtin.func)
+                throw CacheFail();
+
+            tag = Tag::direct_builtin_call;
+        }
+
+        u8(static_cast<unsigned>(tag));
+        base(c);
+        node(n->what.get());
+        node(n->args.get());
+        num(n->direct_func_slot);
+
+    } else if (t == typeid(InlinedCallExpr)) {
+        u8(static_cast<unsigned>(Tag::inlined_call));
+        base(c);
+        node(static_cast<const InlinedCallExpr *>(c)->elem.get());
+
+    } else if (t == typeid(HoistedExpr)) {
+        auto *n = static_cast<const HoistedExpr *>(c);
+        u8(static_cast<unsigned>(Tag::hoisted));
+        base(c);
+        node(n->elem.get());
+        num(n->slot);
+
+    } else if (t == typeid(Expr01)) {
+        u8(static_cast<unsigned>(Tag::expr01));
+        base(c);
+        node(static_cast<const Expr01 *>(c)->elem.get());
+
+    } else if (auto *n = dynamic_cast<const MultiOpConstruct *>(c)) {
+
+        static const std::pair<const std::type_info *, Tag> multi_ops[] = {
+            { &typeid(Expr02), Tag::expr02 },
+            { &typeid(Expr03), Tag::expr03 },
+            { &typeid(Expr04), Tag::expr04 },
+            { &typeid(Expr05), Tag::expr05 },
+            { &typeid(Expr06), Tag::expr06 },
+            { &typeid(Expr07), Tag::expr07 },
+            { &typeid(Expr08), Tag::expr08 },
+            { &typeid(Expr09), Tag::expr09 },
+            { &typeid(Expr10), Tag::expr10 },
+            { &typeid(Expr11), Tag::expr11 },
+            { &typeid(Expr12), Tag::expr12 },
+        };
+
+        Tag tag = Tag::null;
+        for (const auto &mo : multi_ops)
+            if (t == *mo.first)
+                tag = mo.second;
+
+        if (tag == Tag::null)
+            throw CacheFail();
+
+        u8(static_cast<unsigned>(tag));
+        base(c);
+        ops(n->elems);
+
+    } else if (t == typeid(TypedScalarExpr)) {
+        auto *n = static_cast<const TypedScalarExpr *>(c);
+        u8(static_cast<unsigned>(Tag::typed_scalar));
+        base(c);
+        u8(static_cast<unsigned>(n->cat));
+        u8(static_cast<unsigned>(n->kind));
+        ops(n->elems);
+
+    } else if (t == typeid(Expr14)) {
+        auto *n = static_cast<const Expr14 *>(c);
+        u8(static_cast<unsigned>(Tag::expr14));
+        base(c);
+        node(n->lvalue.get());
+        node(n->rvalue.get());
+        unum(n->fl);
+        num(static_cast<int>(n->op));
+
+    } else if (t == typeid(IfStmt)) {
+        auto *n = static_cast<const IfStmt *>(c);
+        u8(static_cast<unsigned>(Tag::if_stmt));
+        base(c);
+        node(n->condExpr.get());
+        node(n->thenBlock.get());
+        node(n->elseBlock.get());
+
+    } else if (t == typeid(Block)) {
+        auto *n = static_cast<const Block *>(c);
+        u8(static_cast<unsigned>(Tag::block));
+        base(c);
+        list(n->elems);
+        num(n->slot_start);
+        num(n->slot_count);
+        unum(n->global_func_names.size());
+        for (const UniqueId *u : n->global_func_names)
+            uid(u);
+        flag(n->scope_free);
+
+    } else if (t == typeid(BreakStmt)) {
+        u8(static_cast<unsigned>(Tag::break_stmt));
+        base(c);
+
+    } else if (t == typeid(ContinueStmt)) {
+        u8(static_cast<unsigned>(Tag::continue_stmt));
+        base(c);
+
+    } else if (t == typeid(ReturnStmt)) {
+        u8(static_cast<unsigned>(Tag::return_stmt));
+        base(c);
+        node(static_cast<const ReturnStmt *>(c)->elem.get());
+
+    } else if (t == typeid(WhileStmt)) {
+        auto *n = static_cast<const WhileStmt *>(c);
+        u8(static_cast<unsigned>(Tag::while_stmt));
+        base(c);
+        node(n->condExpr.get());
+        node(n->body.get());
+        ints(n->hoisted);
+
+    } else if (t == typeid(FuncDeclStmt)) {
+        auto *n = static_cast<const FuncDeclStmt *>(c);
+        u8(static_cast<unsigned>(Tag::func_decl));
+        base(c);
+        node(n->id.get());
+        node(n->captures.get());
+        node(n->params.get());
+        node(n->body.get());
+        flag(n->resolved);
+        num(n->frame_size);
+        ints(n->slot_writes);
+        flag(n->explicit_pure);
+        flag(n->effective_pure);
+        flag(n->cache_results);
+        flag(n->memoized);
+        flag(n->par_safe);
+        str(n->display_name);
+
+    } else if (t == typeid(StructDeclStmt)) {
+        auto *n = static_cast<const StructDeclStmt *>(c);
+        u8(static_cast<unsigned>(Tag::struct_decl));
+        base(c);
+        node(n->id.get());
+        def(n->def.get());
+        owned_defs.insert(n->def.get());
+
+    } else if (t == typeid(Subscript)) {
+        auto *n = static_cast<const Subscript *>(c);
+        u8(static_cast<unsigned>(Tag::subscript));
+        base(c);
+        node(n->what.get());
+        node(n->index.get());
+        flag(n->in_range);
+
+    } else if (t == typeid(RangeSubscript)) {
+        auto *n = static_cast<const RangeSubscript *>(c);
+        u8(static_cast<unsigned>(Tag::range_subscript));
+        base(c);
+        node(n->what.get());
+        node(n->index.get());
+        num(n->arr_slot);
+        num(n->i_slot);
+        num(n->guard_slot);
+
+    } else if (t == typeid(Slice)) {
+        auto *n = static_cast<const Slice *>(c);
+        u8(static_cast<unsigned>(Tag::slice));
+        base(c);
+        node(n->what.get());
+        node(n->start_idx.get());
+        node(n->end_idx.get());
+
+    } else if (t == typeid(TryCatchStmt)) {
+        auto *n = static_cast<const TryCatchStmt *>(c);
+        u8(static_cast<unsigned>(Tag::try_catch));
+        base(c);
+        node(n->tryBody.get());
+        node(n->finallyBody.get());
+        unum(n->catchStmts.size());
+        for (const auto &cs : n->catchStmts) {
+            node(cs.first.exList.get());
+            node(cs.first.asId.get());
+            node(cs.second.get());
+        }
+
+    } else if (t == typeid(RethrowStmt)) {
+        u8(static_cast<unsigned>(Tag::rethrow));
+        base(c);
+
+    } else if (t == typeid(ThrowStmt)) {
+        u8(static_cast<unsigned>(Tag::throw_stmt));
+        base(c);
+        node(static_cast<const ThrowStmt *>(c)->elem.get());
+
+    } else if (t == typeid(ForeachStmt)) {
+        auto *n = static_cast<const ForeachStmt *>(c);
+        u8(static_cast<unsigned>(Tag::foreach));
+        base(c);
+        node(n->ids.get());
+        node(n->container.get());
+        node(n->body.get());
+        flag(n->idsVarDecl);
+        flag(n->indexed);
+        ints(n->hoisted);
+
+    } else if (t == typeid(MemberExpr)) {
+        auto *n = static_cast<const MemberExpr *>(c);
+        u8(static_cast<unsigned>(Tag::member));
+        base(c);
+        node(n->what.get());
+        value(n->memId);
+        uid(n->memUid);
+        flag(n->optional);
+
+    } else if (t == typeid(IncDecExpr)) {
+        auto *n = static_cast<const IncDecExpr *>(c);
+        u8(static_cast<unsigned>(Tag::incdec));
+        base(c);
+        node(n->lvalue.get());
+        flag(n->is_prefix);
+        flag(n->is_inc);
+
+    } else if (t == typeid(TernaryExpr)) {
+        auto *n = static_cast<const TernaryExpr *>(c);
+        u8(static_cast<unsigned>(Tag::ternary));
+        base(c);
+        node(n->condExpr.get());
+        node(n->thenExpr.get());
+        node(n->elseExpr.get());
+
+    } else if (t == typeid(CoalesceExpr)) {
+        auto *n = static_cast<const CoalesceExpr *>(c);
+        u8(static_cast<unsigned>(Tag::coalesce));
+        base(c);
+        node(n->lhs.get());
+        node(n->rhs.get());
+
+    } else if (t == typeid(ForStmt)) {
+        auto *n = static_cast<const ForStmt *>(c);
+        u8(static_cast<unsigned>(Tag::for_stmt));
+        base(c);
+        node(n->init.get());
+        node(n->cond.get());
+        node(n->inc.get());
+        node(n->body.get());
+        ints(n->hoisted);
+
+    } else if (t == typeid(ForRangeStmt)) {
+        auto *n = static_cast<const ForRangeStmt *>(c);
+        u8(static_cast<unsigned>(Tag::for_range));
+        base(c);
+        node(n->init.get());
+        node(n->bound.get());
+        node(n->step.get());
+        node(n->body.get());
+        num(n->i_slot);
+        num(static_cast<int>(n->cmp_op));
+        ints(n->hoisted);
+        num(n->bce_slot);
+        ints(n->bce_arrays);
+        flag(n->parallel);
+        ints(n->par_stores);
+        ints(n->par_reads);
+        ints(n->par_own);
+        ints(n->par_calls);
+
+    } else {
+
+        /* A node class added without a case here: not cacheable. */
+        throw CacheFail();
+    }
+}
+
+void Writer::struct_def(const StructTypeDef *d)
+{
+    uid(d->name);
+
+    unum(d->fields.size());
+    for (const FieldDef &f : d->fields) {
+        uid(f.name);
+        u8(static_cast<unsigned>(f.kind));
+        uid(f.struct_ty);
+        def(f.struct_def);
+        flag(f.is_opt);
+        annot(f.annot);
+        num(f.slot);
+        num(f.offset);
+    }
+
+    unum(d->consts.size());
+    for (const auto &k : d->consts) {
+        uid(k.first);
+        value(k.second);
+    }
+
+    u8(static_cast<unsigned>(d->layout));
+    num(d->size);
+    num(d->align);
+}
+
+void Writer::inline_ctx(const InlineCtx *ic)
+{
+    str(ic->callee_name);
+    unum(ic->params.size());
+    for (const string &p : ic->params)
+        str(p);
+    loc(ic->call_site);
+    ictx(ic->parent);
+}
+
+/*
+ * The body is written first, registering the names, struct types and inline
+ * contexts it references; then their tables (which can register more of
+ * each: a struct's field types, an InlineCtx's parent). The file puts the
+ * tables first, so the reader has them before the first node.
+ */
+void Writer::write(std::ostream &out, const Construct *root)
+{
+    string body, def_tab, ictx_tab, uid_tab;
+
+    cur = &body;
+    node(root);
+
+    cur = &def_tab;
+    for (size_t i = 0; i < defs.size(); i++) {
+
+        /* every struct type must be owned by a StructDeclStmt in the tree:
+         * the loaded tree owns its types the same way */
+        if (!owned_defs.count(defs[i]))
+            throw CacheFail();
+
+        struct_def(defs[i]);
+    }
+
+    cur = &ictx_tab;
+    for (size_t i = 0; i < ictxs.size(); i++)
+        inline_ctx(ictxs[i]);
+
+    cur = &uid_tab;
+    unum(uids.size());
+    for (const UniqueId *u : uids)
+        str(u->val);
+    unum(defs.size());
+    uid_tab += def_tab;
+    unum(ictxs.size());
+    uid_tab += ictx_tab;
+
+    out.write(uid_tab.data(), static_cast<std::streamsize>(uid_tab.size()));
+    out.write(body.data(), static_cast<std::streamsize>(body.size()));
+}
+
+/* ----------------------------- Reader ------------------------------ */
+
+class Reader {
+
+    const string &buf;
+    size_t pos = 0;
+
+    vector<const UniqueId *> uids;
+    vector<unique_ptr<StructTypeDef>> defs;
+    vector<StructTypeDef *> def_ptrs;
+    const InlineCtx *ictx_base = nullptr;
+    size_t ictx_first = 0;
+    size_t ictx_count = 0;
+
+    unsigned u8() {
+        if (pos >= buf.size())
+            throw CacheFail();
+        return static_cast<unsigned char>(buf[pos++]);
+    }
+
+    bool flag() { return u8() != 0; }
+
+    uint64_t unum() {
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            const unsigned b = u8();
+            v |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        throw CacheFail();
+    }
+
+    int64_t num() {
+        const uint64_t v = unum();
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    int inum() { return static_cast<int>(num()); }
+
+    /* A count of things each taking at least a byte: bounded by what is left,
+     * so a corrupt count can't make a reserve() allocate gigabytes. */
+    size_t count() {
+        const uint64_t n = unum();
+        if (n > buf.size() - pos)
+            throw CacheFail();
+        return static_cast<size_t>(n);
+    }
+
+    double f64() {
+        double v;
+        if (buf.size() - pos < sizeof v)
+            throw CacheFail();
+        memcpy(&v, buf.data() + pos, sizeof v);
+        pos += sizeof v;
+        return v;
+    }
+
+    string_view raw(size_t n) {
+        if (n > buf.size() - pos)
+            throw CacheFail();
+        string_view s(buf.data() + pos, n);
+        pos += n;
+        return s;
+    }
+
+    string_view str() { return raw(count()); }
+
+    Loc loc() {
+        const int line = inum();
+        const int col = inum();
+        return Loc(line, col);
+    }
+
+    vector<int> ints() {
+        vector<int> v(count());
+        for (int &x : v)
+            x = inum();
+        return v;
+    }
+
+    template <class E>
+    E en(unsigned limit) {
+        const unsigned v = u8();
+        if (v >= limit)
+            throw CacheFail();
+        return static_cast<E>(v);
+    }
+
+    const UniqueId *uid() {
+        const uint64_t i = unum();
+        if (!i)
+            return nullptr;
+        if (i > uids.size())
+            throw CacheFail();
+        return uids[i - 1];
+    }
+
+    StructTypeDef *def() {
+        const uint64_t i = unum();
+        switch (i) {
+            case nd_null:   return nullptr;
+            case nd_field:
+                return const_cast<StructTypeDef *>(native_struct_field_def());
+            case nd_layout:
+                return const_cast<StructTypeDef *>(native_struct_layout_def());
+            case nd_type:
+                return const_cast<StructTypeDef *>(native_struct_type_def());
+        }
+        if (i - nd_first_table >= def_ptrs.size())
+            throw CacheFail();
+        return def_ptrs[i - nd_first_table];
+    }
+
+    const InlineCtx *ictx() {
+        const uint64_t i = unum();
+        if (!i)
+            return nullptr;
+        if (i > ictx_count)
+            throw CacheFail();
+        return &loaded_inline_ctxs[ictx_first + i - 1];
+    }
+
+    std::shared_ptr<TypeAnnot> annot() {
+        if (!flag())
+            return nullptr;
+        auto a = std::make_shared<TypeAnnot>();
+        a->kind = en<DeclType>(static_cast<unsigned>(DeclType::dyn) + 1);
+        a->opt = flag();
+        a->strct = def();
+        a->elem = annot();
+        a->key = annot();
+        a->val = annot();
+        return a;
+    }
+
+    /* The base fields, read ahead of the node they belong to: a literal
+     * needs its own value to be constructed. */
+    struct Base {
+        bool is_const;
+        Loc start, end;
+        const InlineCtx *inline_ctx;
+        TypeHint th;
+        ArrHint arr_hint;
+        const StructTypeDef *arr_hint_struct;
+    };
+
+    /* The shared objects read so far, in the order they were written. */
+    std::deque<EvalValue> objs;
+
+    const EvalValue *shared();
+    EvalValue value();
+    EvalValue array_storage();
+    unique_ptr<Construct> node();
+    Base base();
+
+    static void set_base(Construct &c, const Base &b) {
+        c.is_const = b.is_const;
+        c.start() = b.start;
+        c.end() = b.end;
+        c.inline_ctx() = b.inline_ctx;
+        c.th = b.th;
+        c.arr_hint = b.arr_hint;
+        c.arr_hint_struct() = b.arr_hint_struct;
+    }
+
+    template <class T>
+    unique_ptr<T> node_as() {
+        unique_ptr<Construct> c = node();
+        if (c && !dynamic_cast<T *>(c.get()))
+            throw CacheFail();
+        return unique_ptr<T>(static_cast<T *>(c.release()));
+    }
+
+    /* A child every node of its kind has (bodies, which can be empty, are
+     * read with node()). */
+    template <class T = Construct>
+    unique_ptr<T> child() {
+        unique_ptr<T> c = node_as<T>();
+        if (!c)
+            throw CacheFail();
+        return c;
+    }
+
+    template <class T>
+    void ops(T &elems) {
+        const size_t n = count();
+        for (size_t i = 0; i < n; i++) {
+            const Op op = static_cast<Op>(inum());
+            elems.emplace_back(op, child());
+        }
+    }
+
+    template <class T>
+    void list(T &elems) {
+        typedef typename T::value_type::element_type E;
+        const size_t n = count();
+        for (size_t i = 0; i < n; i++)
+            elems.push_back(child<E>());
+    }
+
+    template <class T>
+    unique_ptr<Construct> multi_op() {
+        auto c = make_unique<T>();
+        ops(c->elems);
+        return c;
+    }
+
+    template <class T>
+    unique_ptr<T> call() {
+        auto c = make_unique<T>();
+        c->what = child();
+        c->args = child<ExprList>();
+        c->direct_func_slot = inum();
+        return c;
+    }
+
+    void struct_def(StructTypeDef &d);
+    void inline_ctx(InlineCtx &ic);
+
+public:
+
+    explicit Reader(const string &buf) : buf(buf) { }
+
+    unique_ptr<Construct> read(size_t start);
+};
+
+Reader::Base Reader::base()
+{
+    Base b;
+    b.is_const = flag();
+    b.start = loc();
+    b.end = loc();
+    b.inline_ctx = ictx();
+    b.th = en<TypeHint>(static_cast<unsigned>(TypeHint::f) + 1);
+    b.arr_hint = en<ArrHint>(static_cast<unsigned>(ArrHint::flat_s) + 1);
+    b.arr_hint_struct = def();
+    return b;
+}
+
+EvalValue Reader::array_storage()
+{
+    typedef SharedArrayObj::Storage Storage;
+
+    const Storage kind =
+        en<Storage>(static_cast<unsigned>(Storage::structs) + 1);
+    const bool readonly = flag();
+    const size_t n = count();
+    SharedArrayObj arr;
+
+    switch (kind) {
+
+        case Storage::ints: {
+            SharedArrayObj::ivec_type v(n);
+            for (auto &x : v)
+                x = static_cast<int_type>(num());
+            arr = SharedArrayObj(move(v));
+            break;
+        }
+
+        case Storage::floats: {
+            SharedArrayObj::fvec_type v(n);
+            for (auto &x : v)
+                x = f64();
+            arr = SharedArrayObj(move(v));
+            break;
+        }
+
+        case Storage::bools: {
+            SharedArrayObj::bvec_type v(n);
+            for (auto &x : v)
+                x = static_cast<unsigned char>(u8());
+            arr = SharedArrayObj(move(v));
+            break;
+        }
+
+        case Storage::structs: {
+            StructTypeDef *d = def();
+            const size_t stride = count();
+            if (!d || stride != static_cast<size_t>(d->size))
+                throw CacheFail();
+            const string_view b = raw(n * stride);
+            SharedArrayObj::sbuf_type sb(b.begin(), b.end());
+            arr = SharedArrayObj(SharedArrayObj::svec_type(
+                move(sb), d, static_cast<int>(stride)));
+            break;
+        }
+
+        default: {
+            SharedArrayObj::vec_type v;
+            v.reserve(n);
+            for (size_t i = 0; i < n; i++) {
+                EvalValue e = value();
+                v.emplace_back(move(e), flag());
+            }
+            arr = SharedArrayObj(move(v));
+            break;
+        }
+    }
+
+    if (readonly)
+        arr.set_readonly();
+
+    return EvalValue(move(arr));
+}
+
+/* A shared object: null when it comes next in the data (the caller reads it
+ * and calls shared_done), else the one read before. */
+const EvalValue *Reader::shared()
+{
+    const uint64_t i = unum();
+
+    if (!i)
+        return nullptr;
+
+    if (i > objs.size())
+        throw CacheFail();
+
+    return &objs[i - 1];
+}
+
+EvalValue Reader::value()
+{
+    switch (u8()) {
+
+        case Type::t_none:
+            return none;
+
+        case Type::t_int:
+            return EvalValue(static_cast<int_type>(num()));
+
+        case Type::t_float:
+            return EvalValue(f64());
+
+        case Type::t_bool:
+            return EvalValue(flag());
+
+        case Type::t_str: {
+            const string_view s = str();
+            return s.empty() ? empty_str : EvalValue(SharedStr(string(s)));
+        }
+
+        case Type::t_structtype: {
+            StructTypeDef *d = def();
+            if (!d)
+                throw CacheFail();
+            return EvalValue(d);
+        }
+
+        case Type::t_arr: {
+
+            const EvalValue *seen = shared();
+            EvalValue whole;
+
+            if (seen) {
+                whole = *seen;
+            } else {
+                whole = array_storage();
+                objs.push_back(whole);
+            }
+
+            const SharedArrayObj &base = whole.get_ref<SharedArrayObj>();
+            const bool slice = flag();
+            const uint64_t off = unum();
+            const uint64_t len = unum();
+
+            if (!slice)
+                return whole;
+
+            if (off > base.size() || len > base.size() - off)
+                throw CacheFail();
+
+            return EvalValue(SharedArrayObj(base,
+                                            static_cast<size_type>(off),
+                                            static_cast<size_type>(len)));
+        }
+
+        case Type::t_dict: {
+
+            if (const EvalValue *seen = shared())
+                return *seen;
+
+            const bool readonly = flag();
+            const bool has_default = flag();
+            EvalValue dflt;
+
+            if (has_default)
+                dflt = value();
+
+            const size_t buckets = count();
+            const size_t n = count();
+            vector<std::pair<EvalValue, LValue>> kv;
+            kv.reserve(n);
+
+            for (size_t i = 0; i < n; i++) {
+                EvalValue k = value();
+                EvalValue v = value();
+                kv.emplace_back(move(k), LValue(move(v), flag()));
+            }
+
+            /*
+             * Same bucket count, entries inserted last-first: an unordered_map
+             * links a new entry at the front of its bucket (or of the list),
+             * so this rebuilds the order the compiled dict iterated in.
+             */
+            DictObject::inner_type data;
+            data.rehash(buckets);
+            for (size_t i = n; i-- > 0; )
+                data.emplace(move(kv[i].first), move(kv[i].second));
+
+            auto d = make_intrusive<DictObject>(move(data));
+            if (has_default)
+                d->set_default(dflt);
+            if (readonly)
+                d->set_readonly();
+
+            objs.emplace_back(intrusive_ptr<DictObject>(d));
+            return objs.back();
+        }
+
+        case Type::t_struct: {
+
+            if (const EvalValue *seen = shared())
+                return *seen;
+
+            StructTypeDef *d = def();
+            if (!d)
+                throw CacheFail();
+
+            const bool readonly = flag();
+            auto o = make_intrusive<StructObject>(d);
+
+            if (d->is_pod()) {
+                const string_view b = str();
+                if (b.size() != o->bytes.size())
+                    throw CacheFail();
+                memcpy(o->bytes.data(), b.data(), b.size());
+            } else {
+                const size_t n = count();
+                if (n != d->fields.size())
+                    throw CacheFail();
+                for (size_t i = 0; i < n; i++) {
+                    EvalValue v = value();
+                    o->fields.emplace_back(move(v), flag());
+                }
+            }
+
+            if (readonly)
+                o->set_readonly();
+
+            objs.emplace_back(intrusive_ptr<StructObject>(o));
+            return objs.back();
+        }
+
+        default:
+            throw CacheFail();
+    }
+}
+
+unique_ptr<Construct> Reader::node()
+{
+    const Tag tag = en<Tag>(static_cast<unsigned>(Tag::count_));
+
+    if (tag == Tag::null)
+        return nullptr;
+
+    const Base b = base();
+    unique_ptr<Construct> res;
+
+    switch (tag) {
+
+        case Tag::lit_int:
+            res = make_unique<LiteralInt>(static_cast<int_type>(num()));
+            break;
+
+        case Tag::lit_bool:
+            res = make_unique<LiteralBool>(flag());
+            break;
+
+        case Tag::lit_float:
+            res = make_unique<LiteralFloat>(f64());
+            break;
+
+        case Tag::lit_none:
+            res = make_unique<LiteralNone>();
+            break;
+
+        case Tag::lit_str:
+            res = make_unique<LiteralStr>(value());
+            break;
+
+        case Tag::lit_array: {
+            auto c = make_unique<LiteralArray>();
+            list(c->elems);
+            res = move(c);
+            break;
+        }
+
+        case Tag::lit_obj: {
+            EvalValue v = value();
+            res = make_unique<LiteralObj>(move(v), flag());
+            break;
+        }
+
+        case Tag::lit_kv: {
+            auto c = make_unique<LiteralDictKVPair>();
+            c->key = child();
+            c->value = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::lit_dict: {
+            auto c = make_unique<LiteralDict>();
+            list(c->elems);
+            res = move(c);
+            break;
+        }
+
+        case Tag::nop:
+            res = make_unique<NopConstruct>();
+            break;
+
+        case Tag::id: {
+
+            const UniqueId *u = uid();
+            if (!u)
+                throw CacheFail();
+
+            auto c = make_unique<Identifier>(u->val);
+            c->sym.kind =
+                en<SymKind>(static_cast<unsigned>(SymKind::builtin) + 1);
+            c->sym.slot = inum();
+            c->const_param = flag();
+            c->auto_const_param = flag();
+            c->opt_mod = flag();
+            c->dyn_mod = flag();
+            c->decl_type =
+                en<DeclType>(static_cast<unsigned>(DeclType::dyn) + 1);
+            c->decl_struct = def();
+            c->decl_annot = annot();
+
+            /* The builtin table is numbered per process (argv is in it): a
+             * builtin's slot is looked up again by name. */
+            if (c->sym.kind == SymKind::builtin) {
+                c->sym.slot = builtin_slot_index(c->uid);
+                if (c->sym.slot < 0)
+                    throw CacheFail();
+            }
+
+            res = move(c);
+            break;
+        }
+
+        case Tag::expr_list: {
+            auto c = make_unique<ExprList>();
+            list(c->elems);
+            const size_t n = count();
+            for (size_t i = 0; i < n; i++)
+                c->arg_names.push_back(uid());
+            res = move(c);
+            break;
+        }
+
+        case Tag::id_list: {
+            auto c = make_unique<IdList>();
+            list(c->elems);
+            res = move(c);
+            break;
+        }
+
+        case Tag::call:
+            res = call<CallExpr>();
+            break;
+
+        case Tag::direct_call:
+            res = call<DirectCallExpr>();
+            break;
+
+        case Tag::cached_call:
+            res = call<CachedCallExpr>();
+            break;
+
+        case Tag::direct_builtin_call: {
+            auto c = call<DirectBuiltinCallExpr>();
+            auto *id = dynamic_cast<Identifier *>(c->what.get());
+            if (!id || id->sym.kind != SymKind::builtin)
+                throw CacheFail();
+            c->builtin = builtin_slot(id->sym.slot).getval<Builtin>();
+            res = move(c);
+            break;
+        }
+
+        case Tag::inlined_call: {
+            auto c = make_unique<InlinedCallExpr>();
+            c->elem = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::hoisted: {
+            auto c = make_unique<HoistedExpr>();
+            c->elem = child();
+            c->slot = inum();
+            res = move(c);
+            break;
+        }
+
+        case Tag::expr01: {
+            auto c = make_unique<Expr01>();
+            c->elem = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::expr02: res = multi_op<Expr02>(); break;
+        case Tag::expr03: res = multi_op<Expr03>(); break;
+        case Tag::expr04: res = multi_op<Expr04>(); break;
+        case Tag::expr05: res = multi_op<Expr05>(); break;
+        case Tag::expr06: res = multi_op<Expr06>(); break;
+        case Tag::expr07: res = multi_op<Expr07>(); break;
+        case Tag::expr08: res = multi_op<Expr08>(); break;
+        case Tag::expr09: res = multi_op<Expr09>(); break;
+        case Tag::expr10: res = multi_op<Expr10>(); break;
+        case Tag::expr11: res = multi_op<Expr11>(); break;
+        case Tag::expr12: res = multi_op<Expr12>(); break;
+
+        case Tag::typed_scalar: {
+            typedef TypedScalarExpr::Cat Cat;
+            const Cat cat = en<Cat>(static_cast<unsigned>(Cat::lnot) + 1);
+            const TypeHint kind =
+                en<TypeHint>(static_cast<unsigned>(TypeHint::f) + 1);
+            auto c = make_unique<TypedScalarExpr>(cat, kind);
+            ops(c->elems);
+            res = move(c);
+            break;
+        }
+
+        case Tag::expr14: {
+            auto c = make_unique<Expr14>();
+            c->lvalue = child();
+            c->rvalue = child();
+            c->fl = static_cast<unsigned>(unum());
+            c->op = static_cast<Op>(inum());
+            res = move(c);
+            break;
+        }
+
+        case Tag::if_stmt: {
+            auto c = make_unique<IfStmt>();
+            c->condExpr = child();
+            c->thenBlock = node();
+            c->elseBlock = node();
+            res = move(c);
+            break;
+        }
+
+        case Tag::block: {
+            auto c = make_unique<Block>();
+            list(c->elems);
+            c->slot_start = inum();
+            c->slot_count = inum();
+            const size_t n = count();
+            for (size_t i = 0; i < n; i++)
+                c->global_func_names.push_back(uid());
+            c->scope_free = flag();
+            res = move(c);
+            break;
+        }
+
+        case Tag::break_stmt:
+            res = make_unique<BreakStmt>();
+            break;
+
+        case Tag::continue_stmt:
+            res = make_unique<ContinueStmt>();
+            break;
+
+        case Tag::return_stmt: {
+            auto c = make_unique<ReturnStmt>();
+            c->elem = node();
+            res = move(c);
+            break;
+        }
+
+        case Tag::while_stmt: {
+            auto c = make_unique<WhileStmt>();
+            c->condExpr = child();
+            c->body = node();
+            c->hoisted = ints();
+            res = move(c);
+            break;
+        }
+
+        case Tag::func_decl: {
+            auto c = make_unique<FuncDeclStmt>();
+            c->id = node_as<Identifier>();
+            c->captures = node_as<IdList>();
+            c->params = node_as<IdList>();
+            c->body = node();
+            c->resolved = flag();
+            c->frame_size = inum();
+            c->slot_writes = ints();
+            c->explicit_pure = flag();
+            c->effective_pure = flag();
+            c->cache_results = flag();
+            c->memoized = flag();
+            c->par_safe = flag();
+            c->display_name = string(str());
+            res = move(c);
+            break;
+        }
+
+        case Tag::struct_decl: {
+
+            auto c = make_unique<StructDeclStmt>();
+            c->id = child<Identifier>();
+
+            /* take over the table's def: the tree owns its struct types */
+            StructTypeDef *d = def();
+            for (auto &owned : defs)
+                if (owned && owned.get() == d)
+                    c->def = move(owned);
+
+            if (!c->def)
+                throw CacheFail();
+
+            res = move(c);
+            break;
+        }
+
+        case Tag::subscript: {
+            auto c = make_unique<Subscript>();
+            c->what = child();
+            c->index = child();
+            c->in_range = flag();
+            res = move(c);
+            break;
+        }
+
+        case Tag::range_subscript: {
+            auto c = make_unique<RangeSubscript>();
+            c->what = child();
+            c->index = child();
+            c->arr_slot = inum();
+            c->i_slot = inum();
+            c->guard_slot = inum();
+            res = move(c);
+            break;
+        }
+
+        case Tag::slice: {
+            auto c = make_unique<Slice>();
+            c->what = child();
+            c->start_idx = node();
+            c->end_idx = node();
+            res = move(c);
+            break;
+        }
+
+        case Tag::try_catch: {
+            auto c = make_unique<TryCatchStmt>();
+            c->tryBody = node();
+            c->finallyBody = node();
+            const size_t n = count();
+            for (size_t i = 0; i < n; i++) {
+                AllowedExList ael;
+                ael.exList = node_as<IdList>();
+                ael.asId = node_as<Identifier>();
+                c->catchStmts.emplace_back(move(ael), node());
+            }
+            res = move(c);
+            break;
+        }
+
+        case Tag::rethrow:
+            res = make_unique<RethrowStmt>();
+            break;
+
+        case Tag::throw_stmt: {
+            auto c = make_unique<ThrowStmt>();
+            c->elem = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::foreach: {
+            auto c = make_unique<ForeachStmt>();
+            c->ids = child<IdList>();
+            c->container = child();
+            c->body = node();
+            c->idsVarDecl = flag();
+            c->indexed = flag();
+            c->hoisted = ints();
+            res = move(c);
+            break;
+        }
+
+        case Tag::member: {
+            auto c = make_unique<MemberExpr>();
+            c->what = child();
+            c->memId = value();
+            c->memUid = uid();
+            c->optional = flag();
+            res = move(c);
+            break;
+        }
+
+        case Tag::incdec: {
+            auto c = make_unique<IncDecExpr>();
+            c->lvalue = child();
+            c->is_prefix = flag();
+            c->is_inc = flag();
+            res = move(c);
+            break;
+        }
+
+        case Tag::ternary: {
+            auto c = make_unique<TernaryExpr>();
+            c->condExpr = child();
+            c->thenExpr = child();
+            c->elseExpr = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::coalesce: {
+            auto c = make_unique<CoalesceExpr>();
+            c->lhs = child();
+            c->rhs = child();
+            res = move(c);
+            break;
+        }
+
+        case Tag::for_stmt: {
+            auto c = make_unique<ForStmt>();
+            c->init = node();
+            c->cond = node();
+            c->inc = node();
+            c->body = node();
+            c->hoisted = ints();
+            res = move(c);
+            break;
+        }
+
+        case Tag::for_range: {
+            auto c = make_unique<ForRangeStmt>();
+            c->init = child();
+            c->bound = child();
+            c->step = node();
+            c->body = node();
+            c->i_slot = inum();
+            c->cmp_op = static_cast<Op>(inum());
+            c->hoisted = ints();
+            c->bce_slot = inum();
+            c->bce_arrays = ints();
+            c->parallel = flag();
+            c->par_stores = ints();
+            c->par_reads = ints();
+            c->par_own = ints();
+            c->par_calls = ints();
+            res = move(c);
+            break;
+        }
+
+        default:
+            throw CacheFail();
+    }
+
+    set_base(*res, b);
+    return res;
+}
+
+void Reader::struct_def(StructTypeDef &d)
+{
+    d.name = uid();
+
+    const size_t nf = count();
+    for (size_t i = 0; i < nf; i++) {
+        FieldDef f;
+        f.name = uid();
+        f.kind = en<FieldKind>(static_cast<unsigned>(FieldKind::f_struct) + 1);
+        f.struct_ty = uid();
+        f.struct_def = def();
+        f.is_opt = flag();
+        f.annot = annot();
+        f.slot = inum();
+        f.offset = inum();
+        d.fields.push_back(move(f));
+    }
+
+    const size_t nc = count();
+    for (size_t i = 0; i < nc; i++) {
+        const UniqueId *n = uid();
+        d.consts.emplace_back(n, value());
+    }
+
+    typedef StructTypeDef::Layout Layout;
+    d.layout = en<Layout>(static_cast<unsigned>(Layout::pod) + 1);
+    d.size = inum();
+    d.align = inum();
+}
+
+void Reader::inline_ctx(InlineCtx &ic)
+{
+    ic.callee_name = string(str());
+    const size_t n = count();
+    for (size_t i = 0; i < n; i++)
+        ic.params.emplace_back(str());
+    ic.call_site = loc();
+    ic.parent = ictx();
+}
+
+unique_ptr<Construct> Reader::read(size_t start)
+{
+    pos = start;
+
+    const size_t nu = count();
+    for (size_t i = 0; i < nu; i++)
+        uids.push_back(UniqueId::get(str()));
+
+    /* All the struct types exist before any is filled in: a field's type
+     * (or a const's value) can point at a later one. */
+    const size_t nd = count();
+    for (size_t i = 0; i < nd; i++) {
+        defs.push_back(make_unique<StructTypeDef>());
+        def_ptrs.push_back(defs.back().get());
+    }
+
+    for (size_t i = 0; i < nd; i++)
+        struct_def(*def_ptrs[i]);
+
+    ictx_count = count();
+    ictx_first = loaded_inline_ctxs.size();
+    loaded_inline_ctxs.resize(ictx_first + ictx_count);
+
+    for (size_t i = 0; i < ictx_count; i++)
+        inline_ctx(loaded_inline_ctxs[ictx_first + i]);
+
+    unique_ptr<Construct> root = child();
+
+    /* a type no StructDeclStmt took over would be freed under its users */
+    for (const auto &d : defs)
+        if (d)
+            throw CacheFail();
+
+    if (pos != buf.size())
+        throw CacheFail();
+
+    return root;
+}
+
+/*
+ * The interpreter build: the executable's size and modification time, so a
+ * rebuilt interpreter never loads a tree its node layout or optimizer didn't
+ * produce. The compile time of this file is the fallback.
+ */
+string build_id()
+{
+    string id = __DATE__ " " __TIME__;
+
+#ifndef _WIN32
+    struct stat st;
+    if (stat("/proc/self/exe", &st) == 0) {
+        id += " " + std::to_string(st.st_size) + " " +
+              std::to_string(st.st_mtim.tv_sec) + "." +
+              std::to_string(st.st_mtim.tv_nsec);
+    }
+#endif
+
+    return id;
+}
+
+/* The header an entry starts with: magic, format, then the full key. */
+string header(const string &key)
+{
+    string h(cc_magic, sizeof(cc_magic));
+    h += std::to_string(cc_format);
+    h += '\n';
+    h += key;
+    h += '\n';
+    return h;
+}
+
+string entry_path(const string &dir, const string &key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mlc",
+             static_cast<unsigned long long>(std::hash<string>()(key)));
+    return dir + "/" + name;
+}
+
+}  /* anonymous namespace */
+
+bool cc_write(std::ostream &out, const Construct *root)
+{
+    try {
+
+        Writer w;
+        w.write(out, root);
+        return bool(out);
+
+    } catch (const CacheFail &) {
+        return false;
+    }
+}
+
+unique_ptr<Construct> cc_read(std::istream &in)
+{
+    const string buf((std::istreambuf_iterator<char>(in)),
+                     std::istreambuf_iterator<char>());
+
+    /* Loading must not leave half-built nodes or types behind: a failure
+     * unwinds through the unique_ptrs and is just a miss. */
+    try {
+
+        Reader r(buf);
+        return r.read(0);
+
+    } catch (const CacheFail &) {
+        return nullptr;
+    }
+}
+
+string cc_key(string_view source, const string &flags)
+{
+    /*
+     * The source is in the key as a hash plus its length (the entry then
+     * stores this key, not the source): a 64-bit hash and a length both
+     * colliding is not a practical concern for a cache of scripts.
+     */
+    char src[48];
+    snprintf(src, sizeof(src), "%016llx:%zu",
+             static_cast<unsigned long long>(std::hash<string_view>()(source)),
+             source.size());
+
+    return string(src) + " " + build_id() + " " + flags;
+}
+
+bool cc_dir_ok(const string &dir)
+{
+#ifndef _WIN32
+    struct stat st;
+    return !stat(dir.c_str(), &st) && S_ISDIR(st.st_mode) &&
+           !access(dir.c_str(), W_OK);
+#else
+    return true;        /* a store that fails is just not cached */
+#endif
+}
+
+unique_ptr<Construct> cc_load(const string &dir, const string &key)
+{
+    std::ifstream in(entry_path(dir, key), std::ios::binary);
+
+    if (!in)
+        return nullptr;
+
+    const string h = header(key);
+    string got(h.size(), '\0');
+
+    if (!in.read(&got[0], static_cast<std::streamsize>(got.size())) ||
+        got != h)
+        return nullptr;
+
+    return cc_read(in);
+}
+
+void cc_store(const string &dir, const string &key, const Construct *root)
+{
+    std::ostringstream body;
+
+    if (!cc_write(body, root))
+        return;
+
+    /*
+     * Write a private temp file and rename it into place: a concurrent run
+     * of the same script sees the old entry, no entry, or the whole new one,
+     * never a partial file.
+     */
+    const string path = entry_path(dir, key);
+    const string tmp = path + ".tmp" + std::to_string(
+#ifndef _WIN32
+        static_cast<long>(getpid())
+#else
+        0L
+#endif
+    );
+
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+
+        if (!out)
+            return;
+
+        out << header(key) << body.str();
+
+        if (!out.flush()) {
+            out.close();
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        std::remove(tmp.c_str());
+}
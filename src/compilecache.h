@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include "defs.h"
+
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+class Construct;
+
+/*
+ * On-disk compile cache (`--cache-dir DIR`, or $MYLANG_CACHE_DIR): the tree a
+ * script run evaluates - after lexing, parsing, implicit globals, type
+ * inference and the whole optimizer pipeline - written to DIR once and loaded
+ * on later runs of the same script, which then go straight to `root->eval`.
+ *
+ * An entry is content-addressed: its file name is a hash of the source text,
+ * the interpreter build (the executable's size and mtime) and the flags that
+ * change what the compiler emits (-nc, -ni, -it, -nti, ...), and the file
+ * repeats all three so a hash collision is a miss, not a wrong program. Only a
+ * successful compile is stored (a script with a compile error recompiles, and
+ * reports it, every time).
+ *
+ * The format is a binary pre-order walk of the tree: every node's base fields
+ * (locs, TypeHint, ArrHint, inline_ctx) and its own resolved state (slots,
+ * frame sizes, hoisted/BCE/parallel slot lists, purity and memo flags), plus
+ * tables for what nodes point at - the StructTypeDefs (owned by their
+ * StructDeclStmt, so pointers to them are indices), the inlined-at InlineCtx
+ * chains and the interned names. Folded LiteralObj constants are written as
+ * values, flat arrays as their raw elements. A tree holding something the
+ * format can't express (a function value or an exception baked into a
+ * constant) is just not cached.
+ */
+
+/* Write `root` to `out`; false (and nothing useful written) if it can't be. */
+bool cc_write(std::ostream &out, const Construct *root);
+
+/* Read a tree written by cc_write; null if the data is malformed. */
+unique_ptr<Construct> cc_read(std::istream &in);
+
+/*
+ * The cache key: source text, build id and optimizer flags, hashed. The key
+ * string itself is stored in the entry and compared on load.
+ */
+std::string cc_key(std::string_view source, const std::string &flags);
+
+/* `dir` exists and is a writable directory. A store into anything else fails
+ * silently (best effort), so main() checks once and warns instead. */
+bool cc_dir_ok(const std::string &dir);
+
+/* Load the entry for `key` from `dir`: null on a miss (or a bad entry). */
+unique_ptr<Construct> cc_load(const std::string &dir, const std::string &key);
+
+/* Store `root` as the entry for `key` in `dir` (best effort: a write error or
+ * an unsupported tree leaves the cache as it was). */
+void cc_store(const std::string &dir,
+              const std::string &key,
+              const Construct *root);
@@ -15,7 +15,7 @@ using std::string;
 using std::ostream;
 
 void
-dump_line_with_caret(ostream &o, const string &ln, int from, int to)
+dump_line_with_caret(ostream &o, std::string_view ln, int from, int to)
 {
     if (from < 1)
         from = 1;
@@ -34,7 +34,7 @@ dump_line_with_caret(ostream &o, const string &ln, int from, int to)
 
 void
 dump_loc_in_error(ostream &o, const Exception &e,
-                  const std::vector<string> &lines)
+                  const std::vector<std::string_view> &lines)
 {
     if (!e.loc_start.col) {
         o << "\n";
@@ -72,7 +72,7 @@ dump_loc_in_error(ostream &o, const Exception &e,
 
 void
 format_exception(ostream &o, const Exception &e,
-                 const std::vector<string> &lines)
+                 const std::vector<std::string_view> &lines)
 {
     if (auto *se = dynamic_cast<const SyntaxErrorEx *>(&e)) {
 
@@ -132,3 +132,11 @@ format_exception(ostream &o, const Exception &e,
     dump_loc_in_error(o, e, lines);
     o << format_backtrace(e);
 }
+
+void
+format_exception(ostream &o, const Exception &e,
+                 const std::vector<string> &lines)
+{
+    format_exception(o, e, std::vector<std::string_view>(lines.begin(),
+                                                         lines.end()));
+}
@@ -6,9 +6,17 @@
 #include "lexer.h"
 #include "backtrace.h"
 #include "bitops.h"
+#include "parallel.h"
+#include "memo.h"
+#include "profiler.h"
+#include "evalstats.h"
+#include "trace.h"
+#include "livestats.h"
 
 #include <cmath>
 #include <chrono>
+#include <atomic>
+#include <limits>
 
 using std::pair;
 using std::vector;
@@ -90,16 +98,20 @@ EvalContext::EvalContext(EvalContext *parent, bool const_ctx, bool func_ctx,
     , captures(parent ? parent->captures : nullptr)
     , flow((parent && !func_ctx) ? parent->flow : &flow_state)
 {
-    /* Load builtins into the map ONLY for a context that resolves names through
-     * the map: the const-evaluator (const_builtins) and the REPL (both). A
-     * SCRIPT runtime root loads NOTHING - the resolver slotted every name (incl.
-     * builtins), so its map stays empty (see the emplace/lookup asserts). */
-    if (!parent) {
-        if (const_ctx) {
-            symbols.insert(const_builtins.begin(), const_builtins.end());
-        } else if (repl_mode) {
-            symbols.insert(const_builtins.begin(), const_builtins.end());
-            symbols.insert(builtins.begin(), builtins.end());
+    /* Load builtins into the map ONLY in the REPL, where they are map-resident
+     * names like any other global: the const context gets the const builtins,
+     * the runtime one all of them. A SCRIPT loads NOTHING: its runtime root
+     * resolves every name through slots (incl. builtins), so its map stays
+     * empty (see the emplace/lookup asserts), and its const-eval root falls
+     * back to the shared builtin table on a miss (see lookup). */
+    if (!parent && repl_mode) {
+        for (int i = 0; i < builtin_count(); i++) {
+
+            if (const_ctx && !builtin_is_const(i))
+                continue;
+
+            symbols.emplace(UniqueId::get(builtin_name(i)),
+                            LValue(builtin_slot(i).get(), builtin_is_const(i)));
         }
     }
 }
@@ -115,6 +127,14 @@ LValue *EvalContext::lookup(const Identifier *id)
     if (it != symbols.end())
         return &it->second;
 
+    /* A script's const-eval root: the const builtins, read from the shared
+     * table like a SymKind::builtin reference (see Identifier::do_eval). */
+    if (!parent && const_ctx && !repl_mode) {
+        const int i = builtin_slot_index(id->uid);
+        if (i >= 0 && builtin_is_const(i))
+            return &builtin_slot(i);
+    }
+
     return nullptr;
 }
 
@@ -164,6 +184,9 @@ void EvalContext::collect_symbols(
 
 EvalValue Construct::eval(EvalContext *ctx, bool rec) const
 {
+    STAT_NODE(this);
+    STAT_INC(boxed_eval);
+
     try {
 
         return do_eval(ctx, rec);
@@ -171,8 +194,8 @@ EvalValue Construct::eval(EvalContext *ctx, bool rec) const
     } catch (Exception &e) {
 
         if (!e.loc_start) {
-            e.loc_start = start;
-            e.loc_end = end;
+            e.loc_start = start();
+            e.loc_end = end();
         }
 
         /*
@@ -185,8 +208,8 @@ EvalValue Construct::eval(EvalContext *ctx, bool rec) const
          * lose their frames. The innermost inlined node wins; `do_func_call`
          * sets the same flag for a real call so the CallExpr doesn't re-emit.
          */
-        if (inline_ctx && !e.inline_origin_emitted) {
-            flush_inline_frames(inline_ctx, e);
+        if (inline_ctx() && !e.inline_origin_emitted) {
+            flush_inline_frames(inline_ctx(), e);
             e.inline_origin_emitted = true;
         }
 
@@ -205,6 +228,8 @@ LiteralStr::LiteralStr(const std::string_view &v)
  */
 int_type Construct::eval_int(EvalContext *ctx) const
 {
+    STAT_INC(typed_boxed);
+
     const EvalValue v = RValue(eval(ctx));
     if (v.is<bool>())
         return v.get<bool>() ? 1 : 0;     /* bool promotes to int 0/1 */
@@ -213,6 +238,8 @@ int_type Construct::eval_int(EvalContext *ctx) const
 
 float_type Construct::eval_float(EvalContext *ctx) const
 {
+    STAT_INC(typed_boxed);
+
     const EvalValue v = RValue(eval(ctx));
     if (v.is<int_type>())
         return static_cast<float_type>(v.get<int_type>());
@@ -226,6 +253,9 @@ float_type Construct::eval_float(EvalContext *ctx) const
  * undefined-variable error) for non-slotted or undefined symbols. */
 int_type Identifier::eval_int(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
     if (sym.kind == SymKind::local && ctx->frame) {
         const LValue &lv = ctx->frame->slots[sym.slot];
         if (lv.is<bool>())
@@ -250,6 +280,9 @@ int_type Identifier::eval_int(EvalContext *ctx) const
 
 float_type Identifier::eval_float(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
     if (sym.kind == SymKind::local && ctx->frame) {
         const LValue &lv = ctx->frame->slots[sym.slot];
         if (lv.is<int_type>())
@@ -314,9 +347,9 @@ EvalValue Identifier::do_eval(EvalContext *ctx, bool rec) const
          * path.
          *
          * In a const-eval context (AutoConst / the inliner's refold) only CONST
-         * builtins are visible - mirroring the const EvalContext, which loads
-         * only const_builtins. A runtime builtin reads as undefined here, so an
-         * append()/print() call stays unfoldable (those passes catch the
+         * builtins are visible - mirroring the const EvalContext, which sees
+         * only the const builtins. A runtime builtin reads as undefined here,
+         * so an append()/print() call stays unfoldable (those passes catch the
          * resulting UndefinedVariableEx to keep it a runtime call). */
         if (ctx && ctx->const_ctx && !builtin_is_const(sym.slot))
             return UndefinedId{get_str()};
@@ -354,8 +387,8 @@ do_func_return(EvalValue &&tmp, Construct *retExpr)
     if (tmp.is<UndefinedId>()) {
         throw UndefinedVariableEx(
             tmp.get<UndefinedId>().id,
-            retExpr->start,
-            retExpr->end
+            retExpr->start(),
+            retExpr->end()
         );
     }
 
@@ -508,13 +541,52 @@ do_func_bind_params(const vector<unique_ptr<Identifier>> &funcParams,
  * the error message can point at the pure-func restriction. `call_site` (the
  * CallExpr's loc) is recorded into an unwinding exception's backtrace.
  */
+static thread_local const ActiveCall *active_call_top;
+
+const ActiveCall *active_calls()
+{
+    return active_call_top;
+}
+
+/* Links a call into the active-call chain for the scope of run_func_call,
+ * and times a top-level call for the live stats (livestats.h). */
+class ActiveCallScope {
+
+    ActiveCall ac;
+
+public:
+
+    ActiveCallScope(const FuncObject *f,
+                    const EvalContext *ctx,
+                    Loc call_site,
+                    const InlineCtx *call_site_inl)
+        : ac{ f, ctx, active_call_top, call_site, call_site_inl, -1 }
+    {
+        if (!ac.caller && !par_in_worker())
+            ac.t0_ns = live_clock_ns();
+
+        active_call_top = &ac;
+    }
+
+    ~ActiveCallScope()
+    {
+        active_call_top = ac.caller;
+
+        if (ac.t0_ns >= 0)
+            live_top_call_done(ac.func->func, ac.t0_ns);
+    }
+
+    ActiveCallScope(const ActiveCallScope &) = delete;
+    ActiveCallScope &operator=(const ActiveCallScope &) = delete;
+};
+
 template <class ArgsVecT>
 static EvalValue
-do_func_call(EvalContext *ctx,
-             FuncObject &obj,
-             const ArgsVecT &args,
-             Loc call_site = Loc(),
-             const InlineCtx *call_site_inl = nullptr)
+run_func_call(EvalContext *ctx,
+              FuncObject &obj,
+              const ArgsVecT &args,
+              Loc call_site,
+              const InlineCtx *call_site_inl)
 {
     /* func_ctx == true gives this call its own FlowState (see eval.h) */
     EvalContext args_ctx(&obj.capture_ctx, false, true);
@@ -539,6 +611,8 @@ do_func_call(EvalContext *ctx,
         args_ctx.frame = &frame;
     }
 
+    ActiveCallScope active(&obj, &args_ctx, call_site, call_site_inl);
+
     if (obj.func->params) {
         const auto &funcParams = obj.func->params->elems;
         if (obj.func->min_args_cache < 0)
@@ -613,6 +687,123 @@ do_func_call(EvalContext *ctx,
     return none;
 }
 
+/* The argument values of a memoized call, in each argument representation
+ * (see do_func_bind_params). */
+static void
+memo_eval_args(EvalContext *ctx, const vector<unique_ptr<Construct>> &args,
+               vector<EvalValue> &out)
+{
+    out.reserve(args.size());
+    for (const auto &a : args)
+        out.push_back(RValue(a->eval(ctx)));
+}
+
+static void
+memo_eval_args(EvalContext *, const vector<EvalValue> &args,
+               vector<EvalValue> &out)
+{
+    out = args;
+}
+
+static void
+memo_eval_args(EvalContext *, const EvalValue &arg, vector<EvalValue> &out)
+{
+    out.push_back(arg);
+}
+
+static void
+memo_eval_args(EvalContext *, const pair<EvalValue, EvalValue> &args,
+               vector<EvalValue> &out)
+{
+    out.push_back(args.first);
+    out.push_back(args.second);
+}
+
+/*
+ * A call to a memoized function (FuncDeclStmt::memoized, see memo.h). The args
+ * are evaluated ONCE, for the key and the bind. Only all-scalar args make a
+ * key - a container could be mutated between two calls with "the same" args -
+ * and only a scalar result is stored (as in cached_call). A pool worker runs
+ * the call uncached: the table is not thread-safe.
+ */
+template <class ArgsVecT>
+static EvalValue
+memo_func_call(EvalContext *ctx,
+               FuncObject &obj,
+               const ArgsVecT &args,
+               Loc call_site,
+               const InlineCtx *call_site_inl)
+{
+    vector<EvalValue> vals;
+    memo_eval_args(ctx, args, vals);
+
+    bool scalar_args = !par_in_worker();
+    for (const auto &v : vals)
+        scalar_args = scalar_args && v.get_type()->t < Type::t_str;
+
+    if (!scalar_args)
+        return run_func_call(ctx, obj, vals, call_site, call_site_inl);
+
+    PureCacheKey key{ obj.func, move(vals) };
+    if (const EvalValue *hit = memo_lookup(key))
+        return *hit;
+
+    EvalValue r = run_func_call(ctx, obj, key.args, call_site, call_site_inl);
+
+    if (r.get_type()->t < Type::t_str)
+        memo_store(move(key), r);
+    return r;
+}
+
+/* A function call as a span of the `calls` trace category (trace.h). */
+class CallTraceScope {
+
+    bool active = false;
+
+public:
+
+    explicit CallTraceScope(const FuncDeclStmt *f)
+    {
+        if (trace_enabled(TraceCat::calls)) {
+            trace_event_begin(
+                TraceCat::calls,
+                !f->display_name.empty() ? string_view(f->display_name)
+                    : f->id ? f->id->get_str() : string_view("<lambda>")
+            );
+            active = true;
+        }
+    }
+
+    ~CallTraceScope()
+    {
+        if (active)
+            trace_event_end(TraceCat::calls);
+    }
+
+    CallTraceScope(const CallTraceScope &) = delete;
+    CallTraceScope &operator=(const CallTraceScope &) = delete;
+};
+
+template <class ArgsVecT>
+static EvalValue
+do_func_call(EvalContext *ctx,
+             FuncObject &obj,
+             const ArgsVecT &args,
+             Loc call_site = Loc(),
+             const InlineCtx *call_site_inl = nullptr)
+{
+    live_safe_point(call_site.line, call_site_inl);
+
+    ProfScope prof(obj.func);
+    CallTraceScope trace(obj.func);
+    STAT_INC(call_real);
+
+    if (obj.func->memoized)
+        return memo_func_call(ctx, obj, args, call_site, call_site_inl);
+
+    return run_func_call(ctx, obj, args, call_site, call_site_inl);
+}
+
 EvalValue eval_func(EvalContext *ctx,
                     FuncObject &obj,
                     const vector<EvalValue> &args)
@@ -665,9 +856,12 @@ cached_call(EvalContext *ctx, FuncObject &obj,
     PureCache &cache = ctx->frame->ensure_pure_cache();
     PureCacheKey key{ obj.func, vals };
     auto it = cache.find(key);
-    if (it != cache.end())
+    if (it != cache.end()) {
+        STAT_INC(pure_hit);
         return it->second;
+    }
 
+    STAT_INC(pure_miss);
     EvalValue r = do_func_call(ctx, obj, vals, call_site, inl);
 
     /*
@@ -855,7 +1049,7 @@ construct_struct(EvalContext *ctx, StructTypeDef *def, ExprList *args)
             min_args = i + 1;
 
     if (nargs < min_args || nargs > nfields)
-        throw InvalidNumberOfArgsEx(args->start, args->end);
+        throw InvalidNumberOfArgsEx(args->start(), args->end());
 
     auto obj = make_intrusive<StructObject>(def);   /* resizes bytes if POD */
 
@@ -865,7 +1059,7 @@ construct_struct(EvalContext *ctx, StructTypeDef *def, ExprList *args)
         for (size_t i = 0; i < nfields; i++) {
             EvalValue v = coerce_struct_field(
                 def->fields[i], RValue(args->elems[i]->eval(ctx)),
-                args->elems[i]->start, args->elems[i]->end);
+                args->elems[i]->start(), args->elems[i]->end());
             obj->pod_set(static_cast<int>(i), v);
         }
         return intrusive_ptr<StructObject>(obj);
@@ -875,8 +1069,8 @@ construct_struct(EvalContext *ctx, StructTypeDef *def, ExprList *args)
 
     for (size_t i = 0; i < nfields; i++) {
         const FieldDef &fd = def->fields[i];
-        const Loc s = i < nargs ? args->elems[i]->start : args->start;
-        const Loc e = i < nargs ? args->elems[i]->end : args->end;
+        const Loc s = i < nargs ? args->elems[i]->start() : args->start();
+        const Loc e = i < nargs ? args->elems[i]->end() : args->end();
         /* an omitted trailing opt field binds to none */
         EvalValue v = i < nargs ? RValue(args->elems[i]->eval(ctx))
                                 : EvalValue();
@@ -959,7 +1153,7 @@ bool try_construct_into_struct_array(EvalContext *ctx, SharedArrayObj &arr,
     for (size_t i = 0; i < nfields; i++) {
         EvalValue v = coerce_struct_field(
             def->fields[i], RValue(cc->args->elems[i]->eval(ctx)),
-            cc->args->elems[i]->start, cc->args->elems[i]->end);
+            cc->args->elems[i]->start(), cc->args->elems[i]->end());
         pod_store_field(def->fields[i], tmp, v);
     }
 
@@ -969,6 +1163,20 @@ bool try_construct_into_struct_array(EvalContext *ctx, SharedArrayObj &arr,
     return true;
 }
 
+/* A builtin call with the `builtins` trace category on: the same call, as a
+ * span named after the callee expression when it is a plain identifier. */
+static EvalValue
+traced_builtin_call(EvalContext *ctx,
+                    const Builtin &b,
+                    ExprList *args,
+                    const Construct *what)
+{
+    auto *id = dynamic_cast<const Identifier *>(what);
+    TraceSpan span(TraceCat::builtins,
+                   id ? id->get_str() : string_view("<builtin>"));
+    return b.func(ctx, args);
+}
+
 EvalValue CallExpr::do_eval(EvalContext *ctx, bool rec) const
 {
     EvalValue callable_storage;
@@ -985,16 +1193,22 @@ EvalValue CallExpr::do_eval(EvalContext *ctx, bool rec) const
 
     try {
 
-        if (callable.is<Builtin>())
+        if (callable.is<Builtin>()) {
+
+            if (trace_enabled(TraceCat::builtins))
+                return traced_builtin_call(
+                    ctx, callable.get<Builtin>(), args.get(), what.get());
+
             return callable.get<Builtin>().func(ctx, args.get());
+        }
 
         if (callable.is<intrusive_ptr<FuncObject>>()) {
             return do_func_call(
                 ctx,
                 *callable.get<intrusive_ptr<FuncObject>>().get(),
                 args->elems,
-                start,           /* call site = this CallExpr's location */
-                inline_ctx       /* virtual frames if this call is inlined */
+                start(),         /* call site = this CallExpr's location */
+                inline_ctx()     /* virtual frames if this call is inlined */
             );
         }
 
@@ -1007,13 +1221,13 @@ EvalValue CallExpr::do_eval(EvalContext *ctx, bool rec) const
     } catch (Exception &e) {
 
         if (!e.loc_start) {
-            e.loc_start = args->start;
-            e.loc_end = args->end;
+            e.loc_start = args->start();
+            e.loc_end = args->end();
         }
         throw;
     }
 
-    throw NotCallableEx(what->start, what->end);
+    throw NotCallableEx(what->start(), what->end());
 }
 
 /*
@@ -1037,8 +1251,8 @@ EvalValue DirectCallExpr::do_eval(EvalContext *ctx, bool rec) const
                 ctx,
                 *fv.get<intrusive_ptr<FuncObject>>().get(),
                 args->elems,
-                start,
-                inline_ctx
+                start(),
+                inline_ctx()
             );
     }
     return CallExpr::do_eval(ctx, rec);
@@ -1062,8 +1276,8 @@ EvalValue CachedCallExpr::do_eval(EvalContext *ctx, bool rec) const
                 ctx,
                 *fv.get<intrusive_ptr<FuncObject>>().get(),
                 args->elems,
-                start,
-                inline_ctx
+                start(),
+                inline_ctx()
             );
     }
     return CallExpr::do_eval(ctx, rec);
@@ -1080,11 +1294,16 @@ EvalValue CachedCallExpr::do_eval(EvalContext *ctx, bool rec) const
 EvalValue DirectBuiltinCallExpr::do_eval(EvalContext *ctx, bool rec) const
 {
     try {
+
+        if (trace_enabled(TraceCat::builtins))
+            return traced_builtin_call(ctx, builtin, args.get(), what.get());
+
         return builtin.func(ctx, args.get());
+
     } catch (Exception &e) {
         if (!e.loc_start) {
-            e.loc_start = args->start;
-            e.loc_end = args->end;
+            e.loc_start = args->start();
+            e.loc_end = args->end();
         }
         throw;
     }
@@ -1104,6 +1323,8 @@ EvalValue DirectBuiltinCallExpr::do_eval(EvalContext *ctx, bool rec) const
  */
 EvalValue InlinedCallExpr::do_eval(EvalContext *ctx, bool rec) const
 {
+    STAT_INC(call_inlined);
+
     FlowState my_flow;
     FlowState *const saved = ctx->flow;
     ctx->flow = &my_flow;
@@ -1119,6 +1340,75 @@ EvalValue InlinedCallExpr::do_eval(EvalContext *ctx, bool rec) const
     return my_flow.type == FlowState::ret ? my_flow.value : none;
 }
 
+/*
+ * LICM (see HoistedExpr in syntax.h): the first evaluation inside a loop entry
+ * binds the hoisted slot - as a const LValue, which is the "computed" mark -
+ * and every later one reads it back. The value is returned as an rvalue, so a
+ * consumer can never write through to the slot. No frame (never the case for
+ * a tree the resolver hoisted in) just evaluates the expression.
+ */
+EvalValue HoistedExpr::do_eval(EvalContext *ctx, bool rec) const
+{
+    if (!ctx->frame)
+        return elem->eval(ctx);
+
+    LValue &lv = ctx->frame->slots[slot];
+
+    if (!lv.is_const_var())
+        lv = LValue(RValue(elem->eval(ctx)), true);
+
+    return lv.get();
+}
+
+int_type HoistedExpr::eval_int(EvalContext *ctx) const
+{
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
+    if (!ctx->frame)
+        return elem->eval_int(ctx);
+
+    LValue &lv = ctx->frame->slots[slot];
+
+    if (!lv.is_const_var())
+        lv = LValue(EvalValue(elem->eval_int(ctx)), true);
+
+    if (lv.is<bool>())
+        return lv.getval<bool>() ? 1 : 0;
+    return lv.getval<int_type>();
+}
+
+float_type HoistedExpr::eval_float(EvalContext *ctx) const
+{
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
+    if (!ctx->frame)
+        return elem->eval_float(ctx);
+
+    LValue &lv = ctx->frame->slots[slot];
+
+    if (!lv.is_const_var())
+        lv = LValue(EvalValue(elem->eval_float(ctx)), true);
+
+    if (lv.is<int_type>())
+        return static_cast<float_type>(lv.getval<int_type>());
+    if (lv.is<bool>())
+        return lv.getval<bool>() ? 1.0 : 0.0;
+    return lv.getval<float_type>();
+}
+
+/* Unbind a loop's hoisted slots on entry, so each entry recomputes them. */
+static inline void
+unbind_hoisted(EvalContext *ctx, const std::vector<int> &slots)
+{
+    if (slots.empty() || !ctx->frame)
+        return;
+
+    for (int s : slots)
+        ctx->frame->slots[s] = LValue();
+}
+
 EvalValue LiteralArray::do_eval(EvalContext *ctx, bool rec) const
 {
     if (!elems.size()) {
@@ -1126,8 +1416,8 @@ EvalValue LiteralArray::do_eval(EvalContext *ctx, bool rec) const
          * `array<POD struct> a;`, ...): start flat so a built-up
          * `append(a, ...)` stays unboxed - the destination type, not the
          * (empty) value, drives the representation. */
-        if (arr_hint == ArrHint::flat_s && arr_hint_struct) {
-            StructTypeDef *def = const_cast<StructTypeDef *>(arr_hint_struct);
+        if (arr_hint == ArrHint::flat_s && arr_hint_struct()) {
+            StructTypeDef *def = const_cast<StructTypeDef *>(arr_hint_struct());
             return SharedArrayObj(
                 SharedArrayObj::svec_type({}, def, def->size));
         }
@@ -1154,7 +1444,7 @@ EvalValue LiteralArray::do_eval(EvalContext *ctx, bool rec) const
     SharedArrayObj::bvec_type bvec;
     SharedArrayObj::vec_type  gvec;
     /* mode 5: a flat array of same-type POD structs (their bytes packed) */
-    std::vector<char> svecbuf;
+    SharedArrayObj::sbuf_type svecbuf;
     StructTypeDef *sdef = nullptr;
     int sstride = 0;
 
@@ -1319,7 +1609,7 @@ clone_to_mutable(const EvalValue &v, bool through_readonly)
          * references, so it is a full mutable copy). */
         if (arr.skind() == SharedArrayObj::Storage::structs) {
             const auto &sv = arr.flat_structs();
-            std::vector<char> nb(
+            SharedArrayObj::sbuf_type nb(
                 sv.buf.cbegin() + arr.offset() * sv.stride,
                 sv.buf.cbegin() + (arr.offset() + arr.size()) * sv.stride
             );
@@ -1463,7 +1753,7 @@ make_const_clone(const EvalValue &v)
          * nested references to recurse into). */
         if (src.skind() == SharedArrayObj::Storage::structs) {
             const auto &sv = src.flat_structs();
-            std::vector<char> nb(
+            SharedArrayObj::sbuf_type nb(
                 sv.buf.cbegin() + src.offset() * sv.stride,
                 sv.buf.cbegin() + (src.offset() + src.size()) * sv.stride
             );
@@ -1612,9 +1902,9 @@ EvalValue LiteralObj::do_eval(EvalContext *ctx, bool rec) const
     /* An empty baked array bound to an array<POD struct> destination starts
      * flat (the const-fold erased the element type, so the hint restores it),
      * so a built-up `var a = []; append(a, S(..))` stays unboxed. */
-    if (arr_hint == ArrHint::flat_s && arr_hint_struct &&
+    if (arr_hint == ArrHint::flat_s && arr_hint_struct() &&
         value.is<SharedArrayObj>() && value.get<SharedArrayObj>().size() == 0) {
-        StructTypeDef *def = const_cast<StructTypeDef *>(arr_hint_struct);
+        StructTypeDef *def = const_cast<StructTypeDef *>(arr_hint_struct());
         return SharedArrayObj(SharedArrayObj::svec_type({}, def, def->size));
     }
 
@@ -1631,8 +1921,8 @@ static void
 stamp_operand_loc(const Construct *c, Exception &e)
 {
     if (!e.loc_start) {
-        e.loc_start = c->start;
-        e.loc_end = c->end;
+        e.loc_start = c->start();
+        e.loc_end = c->end();
     }
 
     /*
@@ -1980,6 +2270,9 @@ static inline int_type typed_cmp(Op op, T a, T b)
 
 int_type TypedScalarExpr::eval_int(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
     switch (cat) {
 
         case Cat::neg:
@@ -2001,10 +2294,10 @@ int_type TypedScalarExpr::eval_int(EvalContext *ctx) const
                     case Op::minus: acc -= r; break;
                     case Op::times: acc *= r; break;
                     case Op::div:
-                        if (r == 0) throw DivisionByZeroEx(start, end);
+                        if (r == 0) throw DivisionByZeroEx(start(), end());
                         acc /= r; break;
                     case Op::mod:
-                        if (r == 0) throw DivisionByZeroEx(start, end);
+                        if (r == 0) throw DivisionByZeroEx(start(), end());
                         acc %= r; break;
                     case Op::band: acc &= r; break;
                     case Op::bor:  acc |= r; break;
@@ -2043,6 +2336,9 @@ int_type TypedScalarExpr::eval_int(EvalContext *ctx) const
 
 float_type TypedScalarExpr::eval_float(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
     switch (cat) {
 
         case Cat::neg:
@@ -2057,10 +2353,10 @@ float_type TypedScalarExpr::eval_float(EvalContext *ctx) const
                     case Op::minus: acc -= r; break;
                     case Op::times: acc *= r; break;
                     case Op::div:
-                        if (r == 0.0) throw DivisionByZeroEx(start, end);
+                        if (r == 0.0) throw DivisionByZeroEx(start(), end());
                         acc /= r; break;
                     case Op::mod:
-                        if (r == 0.0) throw DivisionByZeroEx(start, end);
+                        if (r == 0.0) throw DivisionByZeroEx(start(), end());
                         acc = fmod(acc, r); break;
                     default: throw InternalErrorEx();
                 }
@@ -2254,15 +2550,27 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
 
     Subscript *sub = static_cast<Subscript *>(lvalue);
 
-    /* Base must be a side-effect-free lvalue - see the note above. */
-    if (!no_side_effects(sub->what.get()))
-        return false;
+    /* A RangeSubscript whose loop guard holds hands over the base and an index
+     * already known to be in range (see RangeSubscript in syntax.h). */
+    int_type idx = 0;
+    LValue *blv = sub->in_range
+        ? static_cast<RangeSubscript *>(sub)->checked_base(ctx, idx)
+        : nullptr;
+    const bool checked = blv != nullptr;
 
-    const EvalValue base_lv = sub->what->eval(ctx);
-    if (!base_lv.is<LValue *>())
-        return false;
+    if (!checked) {
+
+        /* Base must be a side-effect-free lvalue - see the note above. */
+        if (!no_side_effects(sub->what.get()))
+            return false;
+
+        const EvalValue base_lv = sub->what->eval(ctx);
+        if (!base_lv.is<LValue *>())
+            return false;
+
+        blv = base_lv.get<LValue *>();
+    }
 
-    LValue *blv = base_lv.get<LValue *>();
     if (!blv->is<SharedArrayObj>())
         return false;
 
@@ -2276,6 +2584,21 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
     if (blv->is_const_var() || arr.is_readonly())
         return false;
 
+    /* Committed to the flat path: evaluate + bounds-check the index once. */
+    auto load_index = [&]() {
+        if (checked)
+            return;
+        const EvalValue idx_v = RValue(sub->index->eval(ctx));
+        if (!idx_v.is<int_type>())
+            throw TypeErrorEx("Expected integer as subscript",
+                              sub->index->start(), sub->index->end());
+        idx = idx_v.get<int_type>();
+        if (idx < 0)
+            idx += arr.size();
+        if (idx < 0 || static_cast<size_t>(idx) >= arr.size())
+            throw OutOfBoundsEx(sub->start(), sub->end());
+    };
+
     /*
      * Flat POD-struct array: `a[i] = <matching POD struct>` stores the value's
      * bytes (a compound op falls through; structs have no `+=`). A non-matching
@@ -2289,15 +2612,7 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
         const EvalValue r = RValue(rval);
         const auto &sv0 = arr.flat_structs();
 
-        const EvalValue idx_v = RValue(sub->index->eval(ctx));
-        if (!idx_v.is<int_type>())
-            throw TypeErrorEx("Expected integer as subscript",
-                              sub->index->start, sub->index->end);
-        int_type idx = idx_v.get<int_type>();
-        if (idx < 0)
-            idx += arr.size();
-        if (idx < 0 || static_cast<size_t>(idx) >= arr.size())
-            throw OutOfBoundsEx(sub->start, sub->end);
+        load_index();
 
         if (!r.is<intrusive_ptr<StructObject>>() ||
             !r.get<intrusive_ptr<StructObject>>()->is_pod() ||
@@ -2305,7 +2620,7 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
             throw TypeErrorEx(
                 "Cannot store a value of a different type in a flat (typed) "
                 "array; declare the array dyn for a polymorphic array",
-                sub->start, sub->end);
+                sub->start(), sub->end());
 
         if (arr.is_slice())
             arr.clone_internal_vec();
@@ -2323,17 +2638,7 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
     const bool kind_int = arr.skind() == SharedArrayObj::Storage::ints;
     const bool kind_bool = arr.skind() == SharedArrayObj::Storage::bools;
 
-    /* Committed to the flat path now: evaluate the index exactly once. */
-    const EvalValue idx_v = RValue(sub->index->eval(ctx));
-    if (!idx_v.is<int_type>())
-        throw TypeErrorEx("Expected integer as subscript",
-                          sub->index->start, sub->index->end);
-
-    int_type idx = idx_v.get<int_type>();
-    if (idx < 0)
-        idx += arr.size();
-    if (idx < 0 || static_cast<size_t>(idx) >= arr.size())
-        throw OutOfBoundsEx(sub->start, sub->end);
+    load_index();
 
     const size_type at0 = arr.offset() + idx;
     const EvalValue r = RValue(rval);
@@ -2365,7 +2670,7 @@ try_flat_subscript_store(EvalContext *ctx, Construct *lvalue, Op op,
         throw TypeErrorEx(
             "Cannot store a value of a different type in a flat (typed) array; "
             "declare the array dyn for a polymorphic array",
-            sub->start, sub->end);
+            sub->start(), sub->end());
     }
 
     /*
@@ -2447,7 +2752,7 @@ try_pod_struct_store(EvalContext *ctx, Construct *lvalue, Op op,
     /* coerce + runtime-validate to the field's scalar type (throws on mismatch,
      * e.g. a dyn-laundered wrong type) */
     newval = coerce_struct_field(obj.def->fields[slot], move(newval),
-                                 mem->start, mem->end);
+                                 mem->start(), mem->end());
     obj.pod_set(slot, newval);
 
     out = newval;
@@ -2599,8 +2904,10 @@ handle_single_expr14(EvalContext *ctx,
          * array - write the scalar straight into the flat vector, no promotion.
          */
         EvalValue flat_out;
-        if (try_flat_subscript_store(ctx, lvalue, op, rval, flat_out))
+        if (try_flat_subscript_store(ctx, lvalue, op, rval, flat_out)) {
+            STAT_INC(store_flat);
             return flat_out;
+        }
     }
 
     /*
@@ -2650,9 +2957,9 @@ handle_single_expr14(EvalContext *ctx,
         } else if (lval.get<LValue *>()->is_const_var()) {
 
             if (lval.get<LValue *>()->is<Builtin>())
-                throw CannotRebindBuiltinEx(lvalue->start, lvalue->end);
+                throw CannotRebindBuiltinEx(lvalue->start(), lvalue->end());
 
-            throw CannotRebindConstEx(lvalue->start, lvalue->end);
+            throw CannotRebindConstEx(lvalue->start(), lvalue->end());
         }
 
         if (inDecl) {
@@ -2674,7 +2981,7 @@ handle_single_expr14(EvalContext *ctx,
                     return rval;
                 }
 
-                throw AlreadyDefinedEx(lvalue->start, lvalue->end);
+                throw AlreadyDefinedEx(lvalue->start(), lvalue->end());
             }
 
             /* We're re-declaring a symbol already declared outside */
@@ -2689,7 +2996,7 @@ handle_single_expr14(EvalContext *ctx,
         }
 
     } else {
-        throw NotLValueEx(lvalue->start, lvalue->end);
+        throw NotLValueEx(lvalue->start(), lvalue->end());
     }
 
     return rval;
@@ -2891,10 +3198,10 @@ EvalValue IncDecExpr::do_eval(EvalContext *ctx, bool rec) const
     }
 
     if (lref.is<UndefinedId>())
-        throw UndefinedVariableEx(lref.get<UndefinedId>().id, start, end);
+        throw UndefinedVariableEx(lref.get<UndefinedId>().id, start(), end());
 
     if (!lref.is<LValue *>())
-        throw NotLValueEx(start, end);
+        throw NotLValueEx(start(), end());
 
     LValue *lv = lref.get<LValue *>();
 
@@ -2902,12 +3209,12 @@ EvalValue IncDecExpr::do_eval(EvalContext *ctx, bool rec) const
         throw CannotRebindBuiltinEx();
 
     if (lv->is_const_var())
-        throw CannotChangeConstEx(start, end);
+        throw CannotChangeConstEx(start(), end());
 
     EvalValue old = lv->get();
 
     if (!old.is<int_type>() && !old.is<float_type>())
-        throw TypeErrorEx("'++'/'--' requires an int or float", start, end);
+        throw TypeErrorEx("'++'/'--' requires an int or float", start(), end());
 
     EvalValue nv = old;
     apply_compound_op(nv, one, cop);
@@ -2954,7 +3261,10 @@ EvalValue ReturnStmt::do_eval(EvalContext *ctx, bool rec) const
 
 EvalValue RethrowStmt::do_eval(EvalContext *ctx, bool rec) const
 {
-    throw RethrowEx{start, end};
+    if (trace_enabled(TraceCat::exceptions))
+        trace_event_instant(TraceCat::exceptions, "rethrow");
+
+    throw RethrowEx{start(), end()};
 }
 
 EvalValue ThrowStmt::do_eval(EvalContext *ctx, bool rec) const
@@ -2968,6 +3278,14 @@ EvalValue ThrowStmt::do_eval(EvalContext *ctx, bool rec) const
      * the instance and `v.field` reads it).
      */
     if (e.is<intrusive_ptr<StructObject>>()) {
+
+        if (trace_enabled(TraceCat::exceptions))
+            trace_event_instant(
+                TraceCat::exceptions,
+                "throw " +
+                    e.get<intrusive_ptr<StructObject>>()->def->name->val
+            );
+
         throw ExceptionObject(
             string(e.get<intrusive_ptr<StructObject>>()->def->name->val),
             e
@@ -2978,13 +3296,20 @@ EvalValue ThrowStmt::do_eval(EvalContext *ctx, bool rec) const
      * Re-throwing a caught built-in exception value (bound by `catch (X as e)`,
      * which hands back an exception object for a payload-less built-in).
      */
-    if (e.is<intrusive_ptr<ExceptionObject>>())
-        throw *e.get<intrusive_ptr<ExceptionObject>>().get();
+    if (e.is<intrusive_ptr<ExceptionObject>>()) {
+
+        const ExceptionObject &ex = *e.get<intrusive_ptr<ExceptionObject>>();
+
+        if (trace_enabled(TraceCat::exceptions))
+            trace_event_instant(TraceCat::exceptions,
+                                "throw " + string(ex.get_name()));
+        throw ex;
+    }
 
     throw TypeErrorEx(
         "Can only throw a struct instance",
-        elem->start,
-        elem->end
+        elem->start(),
+        elem->end()
     );
 }
 
@@ -3003,11 +3328,14 @@ EvalValue Block::do_eval(EvalContext *ctx, bool rec) const
 
         for (const auto &e : elems) {
 
+            if (g_profiling)
+                prof_stmt(e.get());
+
             EvalValue &&tmp = e->eval(ctx);
 
             if (tmp.is<UndefinedId>())
                 throw UndefinedVariableEx(
-                    tmp.get<UndefinedId>().id, e->start, e->end);
+                    tmp.get<UndefinedId>().id, e->start(), e->end());
 
             if (ctx->flow->type != FlowState::none)
                 break;
@@ -3055,10 +3383,14 @@ EvalValue Block::do_eval(EvalContext *ctx, bool rec) const
 
     for (const auto &e: elems) {
 
+        if (g_profiling)
+            prof_stmt(e.get());
+
         EvalValue &&tmp = e->eval(&curr);
 
         if (tmp.is<UndefinedId>())
-            throw UndefinedVariableEx(tmp.get<UndefinedId>().id, e->start, e->end);
+            throw UndefinedVariableEx(tmp.get<UndefinedId>().id, e->start(),
+                                      e->end());
 
         /*
          * A return/break/continue fired in this statement (possibly nested in
@@ -3076,6 +3408,8 @@ EvalValue WhileStmt::do_eval(EvalContext *ctx, bool rec) const
 {
     FlowState &fs = *ctx->flow;
 
+    unbind_hoisted(ctx, hoisted);
+
     while (eval_cond(condExpr.get(), ctx)) {
 
         if (body)
@@ -3091,6 +3425,8 @@ EvalValue WhileStmt::do_eval(EvalContext *ctx, bool rec) const
 
         if (fs.type == FlowState::cont)
             fs.type = FlowState::none;          /* consume; loop again */
+
+        live_safe_point(this);
     }
 
     return none;
@@ -3116,7 +3452,7 @@ EvalValue StructDeclStmt::do_eval(EvalContext *ctx, bool rec) const
 
         if (!id->eval(ctx).is<UndefinedId>()) {
             if (!ctx->allow_redeclare)        /* REPL: redefining replaces */
-                throw AlreadyDefinedEx(id->start, id->end);
+                throw AlreadyDefinedEx(id->start(), id->end());
             ctx->erase(id.get());
         }
 
@@ -3153,7 +3489,7 @@ EvalValue FuncDeclStmt::do_eval(EvalContext *ctx, bool rec) const
             /* REPL: re-defining a function replaces it (the edit-and-resubmit
              * workflow); a script rejects the duplicate. */
             if (!ctx->allow_redeclare)
-                throw AlreadyDefinedEx(id->start, id->end);
+                throw AlreadyDefinedEx(id->start(), id->end());
             ctx->erase(id.get());
         }
 
@@ -3188,7 +3524,7 @@ EvalValue Subscript::do_eval(EvalContext *ctx, bool rec) const
 
     if (t->t == Type::t_undefid) {
         throw UndefinedVariableEx(
-            lval.get<UndefinedId>().id, what->start, what->end
+            lval.get<UndefinedId>().id, what->start(), what->end()
         );
     }
 
@@ -3209,6 +3545,9 @@ dict_present_value(const intrusive_ptr<DictObject> &obj, const EvalValue &key);
 
 int_type Subscript::eval_int(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
     const EvalValue &lval = what->eval(ctx);
     const EvalValue &base = lval.is<LValue *>()
         ? lval.get<LValue *>()->get() : lval;
@@ -3219,7 +3558,8 @@ int_type Subscript::eval_int(EvalContext *ctx) const
         if (idx < 0)
             idx += arr.size();
         if (idx < 0 || static_cast<size_t>(idx) >= arr.size())
-            throw OutOfBoundsEx(start, end);
+            throw OutOfBoundsEx(start(), end());
+        STAT_ELEM(arr.skind() == SharedArrayObj::Storage::general);
         const size_type at = arr.offset() + idx;
         if (arr.skind() == SharedArrayObj::Storage::ints)
             return arr.flat_ints()[at];     /* unboxed: no promotion */
@@ -3243,6 +3583,9 @@ int_type Subscript::eval_int(EvalContext *ctx) const
 
 float_type Subscript::eval_float(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
     const EvalValue &lval = what->eval(ctx);
     const EvalValue &base = lval.is<LValue *>()
         ? lval.get<LValue *>()->get() : lval;
@@ -3253,7 +3596,8 @@ float_type Subscript::eval_float(EvalContext *ctx) const
         if (idx < 0)
             idx += arr.size();
         if (idx < 0 || static_cast<size_t>(idx) >= arr.size())
-            throw OutOfBoundsEx(start, end);
+            throw OutOfBoundsEx(start(), end());
+        STAT_ELEM(arr.skind() == SharedArrayObj::Storage::general);
         const size_type at = arr.offset() + idx;
         if (arr.skind() == SharedArrayObj::Storage::floats)
             return arr.flat_floats()[at];   /* unboxed: no promotion */
@@ -3280,6 +3624,93 @@ float_type Subscript::eval_float(EvalContext *ctx) const
     return Construct::eval_float(ctx);   /* missing key / non-dict: do_eval */
 }
 
+/*
+ * Bounds-check elision (see RangeSubscript in syntax.h): with the owning
+ * loop's guard set, `i` is in range for the array in `arr_slot`, which the
+ * loop never rebinds - so read it straight out of the frame. A non-flat kind
+ * (or a false guard) takes the plain Subscript path.
+ */
+LValue *RangeSubscript::checked_base(EvalContext *ctx, int_type &idx) const
+{
+    Frame *f = ctx->frame;
+
+    if (!f || !f->slots[guard_slot].getval<int_type>())
+        return nullptr;
+
+    idx = f->slots[i_slot].getval<int_type>();
+    return &f->slots[arr_slot];
+}
+
+EvalValue RangeSubscript::do_eval(EvalContext *ctx, bool rec) const
+{
+    int_type i;
+
+    if (!ctx->assign_target) {
+        if (const LValue *lv = checked_base(ctx, i)) {
+            const SharedArrayObj &arr = lv->get().get_ref<SharedArrayObj>();
+            const size_type at = arr.offset() + i;
+            switch (arr.skind()) {
+                case SharedArrayObj::Storage::ints:
+                    STAT_ELEM(false);
+                    return EvalValue(arr.flat_ints()[at]);
+                case SharedArrayObj::Storage::floats:
+                    STAT_ELEM(false);
+                    return EvalValue(arr.flat_floats()[at]);
+                case SharedArrayObj::Storage::bools:
+                    STAT_ELEM(false);
+                    return EvalValue(static_cast<bool>(arr.flat_bools()[at]));
+                default:
+                    break;
+            }
+        }
+    }
+    return Subscript::do_eval(ctx, rec);
+}
+
+int_type RangeSubscript::eval_int(EvalContext *ctx) const
+{
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
+    int_type i;
+
+    if (const LValue *lv = checked_base(ctx, i)) {
+        const SharedArrayObj &arr = lv->get().get_ref<SharedArrayObj>();
+        const size_type at = arr.offset() + i;
+        if (arr.skind() == SharedArrayObj::Storage::ints) {
+            STAT_ELEM(false);
+            return arr.flat_ints()[at];
+        }
+        if (arr.skind() == SharedArrayObj::Storage::bools) {
+            STAT_ELEM(false);
+            return arr.flat_bools()[at] ? 1 : 0;
+        }
+    }
+    return Subscript::eval_int(ctx);
+}
+
+float_type RangeSubscript::eval_float(EvalContext *ctx) const
+{
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
+    int_type i;
+
+    if (const LValue *lv = checked_base(ctx, i)) {
+        const SharedArrayObj &arr = lv->get().get_ref<SharedArrayObj>();
+        const size_type at = arr.offset() + i;
+        if (arr.skind() == SharedArrayObj::Storage::floats) {
+            STAT_ELEM(false);
+            return arr.flat_floats()[at];
+        }
+        if (arr.skind() == SharedArrayObj::Storage::ints) {
+            STAT_ELEM(false);
+            return static_cast<float_type>(arr.flat_ints()[at]);
+        }
+    }
+    return Subscript::eval_float(ctx);
+}
+
 EvalValue Slice::do_eval(EvalContext *ctx, bool rec) const
 {
     const EvalValue &lval = what->eval(ctx);
@@ -3290,7 +3721,7 @@ EvalValue Slice::do_eval(EvalContext *ctx, bool rec) const
 
     if (t->t == Type::t_undefid) {
         throw UndefinedVariableEx(
-            lval.get<UndefinedId>().id, what->start, what->end
+            lval.get<UndefinedId>().id, what->start(), what->end()
         );
     }
 
@@ -3308,8 +3739,15 @@ do_catch(EvalContext *ctx,
          Identifier *asId,
          Construct *catchBody)
 {
+    ExceptionObject *exObj = dynamic_cast<ExceptionObject *>(saved_ex);
+    string_view ex_name = exObj ? exObj->get_name() : saved_ex->name;
+
     if (!exList) {
 
+        if (trace_enabled(TraceCat::exceptions))
+            trace_event_instant(TraceCat::exceptions,
+                                "catch " + string(ex_name));
+
         /* Catch-anything block */
         try {
             catchBody->eval(ctx);
@@ -3322,14 +3760,15 @@ do_catch(EvalContext *ctx,
         return true;
     }
 
-    ExceptionObject *exObj = dynamic_cast<ExceptionObject *>(saved_ex);
-    string_view ex_name = exObj ? exObj->get_name() : saved_ex->name;
-
     for (const unique_ptr<Identifier> &id : exList->elems) {
 
         if (id->get_str() != ex_name)
             continue;
 
+        if (trace_enabled(TraceCat::exceptions))
+            trace_event_instant(TraceCat::exceptions,
+                                "catch " + string(ex_name));
+
         try {
 
             EvalContext catch_ctx(ctx);
@@ -3587,6 +4026,7 @@ ForeachStmt::do_iter(EvalContext *ctx,
     if (fs.type == FlowState::cont)
         fs.type = FlowState::none;          /* consume; advance to next item */
 
+    live_safe_point(this);
     return true;
 }
 
@@ -3596,6 +4036,8 @@ ForeachStmt::do_eval(EvalContext *ctx, bool rec) const
     EvalContext loopCtx(ctx, ctx->const_ctx);
     const EvalValue &cval = RValue(container->eval(ctx));
 
+    unbind_hoisted(ctx, hoisted);
+
     if (cval.is<SharedArrayObj>()) {
 
         const SharedArrayObj &arr = cval.get<SharedArrayObj>();
@@ -3712,8 +4154,8 @@ ForeachStmt::do_eval(EvalContext *ctx, bool rec) const
 
         throw TypeErrorEx(
             "Unsupported container type by foreach()",
-            container->start,
-            container->end
+            container->start(),
+            container->end()
         );
     }
 
@@ -3803,7 +4245,7 @@ EvalValue MemberExpr::do_eval(EvalContext *ctx, bool rec) const
         throw TypeErrorEx(
             intern_msg("Struct '" + string(obj->def->name->val) +
                        "' has no member '" + string(memUid->val) + "'"),
-            start, end);
+            start(), end());
     }
 
     /* A struct TYPE descriptor: only its `const` members (no instance). */
@@ -3817,16 +4259,16 @@ EvalValue MemberExpr::do_eval(EvalContext *ctx, bool rec) const
         if (def->slot_of(memUid) >= 0)
             throw TypeErrorEx(
                 intern_msg("Field '" + string(memUid->val) +
-                           "' needs an instance"), start, end);
+                           "' needs an instance"), start(), end());
 
         throw TypeErrorEx(
             intern_msg("Struct '" + string(def->name->val) +
                        "' has no member '" + string(memUid->val) + "'"),
-            start, end);
+            start(), end());
     }
 
     if (!dval.is<intrusive_ptr<DictObject>>())
-        throw TypeErrorEx("Expected dict object", what->start, what->end);
+        throw TypeErrorEx("Expected dict object", what->start(), what->end());
 
     const auto &obj = dval.get<intrusive_ptr<DictObject>>();
     DictObject::inner_type &data = obj->get_ref();
@@ -3837,16 +4279,17 @@ EvalValue MemberExpr::do_eval(EvalContext *ctx, bool rec) const
      * (lvalue when mutable, so `d.k = v` / `d.k += v` work); missing -> the
      * default (default dict), else throw on a read / auto-vivify on a plain-
      * assignment target. So `d.k` is non-opt (a value or an exception, never
-     * none); use get()/get!() for explicit nullable / fail-fast lookup.
+     * none); use get()/get!() for explicit nullable / fail-fast lookup. A
+     * temporary base (`f().k`) is read like a const one (see the struct case).
      */
-    if (obj->is_readonly()) {
+    if (obj->is_readonly() || !is_lvalue_rooted(what.get())) {
         if (it != data.end())
             return it->second.get();
         if (obj->get_has_default())
             return obj->get_default();
         if (for_write)
             return none;            /* write then fails NotLValueEx */
-        throw KeyNotFoundEx(start, end);
+        throw KeyNotFoundEx(start(), end());
     }
 
     if (it != data.end())
@@ -3859,7 +4302,7 @@ EvalValue MemberExpr::do_eval(EvalContext *ctx, bool rec) const
     if (for_write)
         return &(*data.emplace(memId, LValue(none, false)).first).second;
 
-    throw KeyNotFoundEx(start, end);
+    throw KeyNotFoundEx(start(), end());
 }
 
 /*
@@ -3945,9 +4388,12 @@ dict_present_value(const intrusive_ptr<DictObject> &obj, const EvalValue &key)
 
 int_type MemberExpr::eval_int(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_int);
+
     if (auto *sub = dynamic_cast<const Subscript *>(what.get())) {
         int_type v;
-        if (member_pod_array_scalar(sub, ctx, memUid, start, end, v))
+        if (member_pod_array_scalar(sub, ctx, memUid, start(), end(), v))
             return v;
     }
 
@@ -3980,9 +4426,12 @@ int_type MemberExpr::eval_int(EvalContext *ctx) const
 
 float_type MemberExpr::eval_float(EvalContext *ctx) const
 {
+    STAT_NODE(this);
+    STAT_INC(typed_float);
+
     if (auto *sub = dynamic_cast<const Subscript *>(what.get())) {
         float_type v;
-        if (member_pod_array_scalar(sub, ctx, memUid, start, end, v))
+        if (member_pod_array_scalar(sub, ctx, memUid, start(), end(), v))
             return v;
     }
 
@@ -4024,6 +4473,8 @@ EvalValue ForStmt::do_eval(EvalContext *ctx, bool rec) const
 {
     EvalContext loop_ctx(ctx, ctx->const_ctx);
 
+    unbind_hoisted(ctx, hoisted);
+
     if (init)
         init->eval(&loop_ctx);
 
@@ -4050,11 +4501,236 @@ EvalValue ForStmt::do_eval(EvalContext *ctx, bool rec) const
 
         if (inc)
             inc->eval(&loop_ctx);
+
+        live_safe_point(this);
     }
 
     return none;
 }
 
+/* The flat storage buffer of a flat array (slices of one array share it). */
+static const void *
+flat_storage(const SharedArrayObj &arr)
+{
+    switch (arr.skind()) {
+        case SharedArrayObj::Storage::ints:   return arr.flat_ints().data();
+        case SharedArrayObj::Storage::floats: return arr.flat_floats().data();
+        case SharedArrayObj::Storage::bools:  return arr.flat_bools().data();
+        default:                              return nullptr;
+    }
+}
+
+/* The slot's flat int/float/bool array, or nullptr. */
+static const SharedArrayObj *
+slot_flat_array(const LValue &lv)
+{
+    if (!lv.is<SharedArrayObj>())
+        return nullptr;
+    const SharedArrayObj &arr = lv.get().get_ref<SharedArrayObj>();
+    return flat_storage(arr) ? &arr : nullptr;
+}
+
+/*
+ * --parallel-loops: run a ForRangeStmt marked `parallel` (see syntax.h) in
+ * chunks on the worker pool. `f` is the loop's frame, with `i` already at
+ * `start`. Returns false, having changed nothing observable, when it does not
+ * apply; the caller then runs the ordinary loop from `start`.
+ *
+ * The static proof covers the body's shape; here we check what only the
+ * values can tell: every array it touches is flat (so each element read/write
+ * is a plain scalar access, no handle copies), a stored-to array is a mutable
+ * non-slice with no live slices and shares no storage with an array read at
+ * another index, and every callee is still a par_safe function.
+ *
+ * Each participant gets its own copy of the frame, built here on this thread
+ * (the copies' refcount bumps must not race), so the loop var and the body's
+ * locals are private while every array handle still points at the shared
+ * storage. A failing iteration is not reported from the worker: the stored
+ * arrays are restored from a snapshot and we return false, so the sequential
+ * loop raises the error with the exact partial effects of a serial run.
+ */
+static bool
+par_range_run(const ForRangeStmt &fr, EvalContext *loop_ctx, Frame *f,
+              int_type start, int_type bound_val, int_type step_val)
+{
+    if (loop_ctx->in_const_eval() || step_val <= 0)
+        return false;
+
+    const unsigned nworkers = par_workers();
+    if (nworkers <= 1)
+        return false;
+
+    /* trip count (unsigned differences: no signed overflow on wide ranges) */
+    const bool asc = (fr.cmp_op == Op::lt || fr.cmp_op == Op::le);
+    const bool incl = (fr.cmp_op == Op::le || fr.cmp_op == Op::ge);
+    const int_type lo = asc ? start : bound_val;
+    const int_type hi = asc ? bound_val : start;
+    if (hi < lo || (hi == lo && !incl))
+        return false;
+
+    const uint64_t span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+    const uint64_t ustep = static_cast<uint64_t>(step_val);
+    const uint64_t count = incl ? span / ustep + 1 : (span - 1) / ustep + 1;
+    if (count < PAR_MIN_ITERS)
+        return false;
+
+    std::vector<const void *> store_bufs;
+
+    for (int s : fr.par_stores) {
+        const LValue &lv = f->slots[s];
+        const SharedArrayObj *arr = slot_flat_array(lv);
+        if (!arr || lv.is_const_var() || arr->is_readonly() ||
+            arr->is_slice() || arr->has_slices())
+            return false;
+        store_bufs.push_back(flat_storage(*arr));
+    }
+
+    for (int s : fr.par_reads) {
+        const SharedArrayObj *arr = slot_flat_array(f->slots[s]);
+        if (!arr)
+            return false;
+        for (const void *b : store_bufs)
+            if (b == flat_storage(*arr))
+                return false;
+    }
+
+    for (int s : fr.par_own)
+        if (!slot_flat_array(f->slots[s]))
+            return false;
+
+    for (int g : fr.par_calls) {
+        GlobalFuncTable *gf = loop_ctx->gfuncs;
+        if (!gf || !gf->defined[g])
+            return false;
+        const EvalValue &fv = gf->slots[g].get();
+        if (!fv.is<intrusive_ptr<FuncObject>>())
+            return false;
+        FuncObject &fo = *fv.get<intrusive_ptr<FuncObject>>().get();
+        if (!fo.func->par_safe || !fo.capture_slots.empty())
+            return false;
+        if (fo.func->min_args_cache < 0 && fo.func->params)
+            fo.func->min_args_cache =      /* warm it before the workers */
+                static_cast<int>(min_required_args(fo.func->params->elems));
+    }
+
+    /* Snapshot the stored-to arrays (for the error path) and drop their hash
+     * caches now, so the workers' element writes find nothing to invalidate. */
+    std::vector<EvalValue> snapshots;
+
+    for (int s : fr.par_stores) {
+        SharedArrayObj &arr = f->slots[s].getval<SharedArrayObj>();
+        arr.invalidate_hash();
+        EvalValue copy = f->slots[s].get();
+        copy.get<SharedArrayObj>().clone_internal_vec();
+        snapshots.push_back(move(copy));
+    }
+
+    std::vector<unique_ptr<Frame>> frames;
+    const int fsize = f->size();
+
+    for (unsigned w = 0; w < nworkers; w++) {
+        frames.push_back(make_unique<Frame>());
+        frames.back()->init(fsize);
+        for (int i = 0; i < fsize; i++)
+            frames.back()->slots[i] = f->slots[i];
+    }
+
+    const int_type delta = asc ? step_val : -step_val;
+    std::atomic<bool> failed{false};
+
+    par_for(static_cast<size_t>(count), [&](size_t b, size_t e) {
+
+        Frame &wf = *frames[par_worker_id()];
+        EvalContext wctx(loop_ctx, false, /*func_ctx=*/true);  /* own flow */
+        wctx.frame = &wf;
+        FlowState &fs = *wctx.flow;
+
+        try {
+
+            for (size_t k = b; k < e && !failed.load(); k++) {
+
+                wf.slots[fr.i_slot].getval<int_type>() =
+                    start + static_cast<int_type>(k) * delta;
+
+                fr.body->eval(&wctx);
+                fs.type = FlowState::none;      /* a top-level `continue` */
+            }
+
+        } catch (...) {
+            failed.store(true);
+        }
+    });
+
+    frames.clear();
+
+    if (!failed.load())
+        return true;
+
+    /* roll the stored-to arrays back; the sequential re-run raises the error */
+    for (size_t j = 0; j < fr.par_stores.size(); j++) {
+        SharedArrayObj &dst = f->slots[fr.par_stores[j]].getval<SharedArrayObj>();
+        const SharedArrayObj &src = snapshots[j].get_ref<SharedArrayObj>();
+        switch (dst.skind()) {
+            case SharedArrayObj::Storage::ints:
+                dst.flat_ints() = src.flat_ints(); break;
+            case SharedArrayObj::Storage::floats:
+                dst.flat_floats() = src.flat_floats(); break;
+            default:
+                dst.flat_bools() = src.flat_bools(); break;
+        }
+    }
+
+    return false;
+}
+
+/*
+ * The bounds-check-elision guard of a ForRangeStmt (see RangeSubscript in
+ * syntax.h): true if every index the loop var can take, starting at `start`,
+ * is inside each array in `bce_arrays`. An empty loop trivially qualifies; a
+ * negative step (the loop would run away from `bound`) or one that could
+ * overflow `i` never does.
+ */
+static bool
+range_fits_arrays(const ForRangeStmt &fr, const Frame *f, int_type start,
+                  int_type bound_val, int_type step_val)
+{
+    int_type lo, hi;      /* the inclusive range of `i` the body sees */
+
+    switch (fr.cmp_op) {
+        case Op::lt:
+            if (start >= bound_val) return true;
+            lo = start; hi = bound_val - 1;
+            break;
+        case Op::le:
+            if (start > bound_val) return true;
+            lo = start; hi = bound_val;
+            break;
+        case Op::ge:
+            if (start < bound_val) return true;
+            lo = bound_val; hi = start;
+            break;
+        default:                                        /* Op::gt */
+            if (start <= bound_val) return true;
+            lo = bound_val + 1; hi = start;
+            break;
+    }
+
+    if (step_val < 0 || lo < 0)
+        return false;
+
+    const bool asc = (fr.cmp_op == Op::lt || fr.cmp_op == Op::le);
+    if (asc && step_val > std::numeric_limits<int_type>::max() - hi)
+        return false;
+
+    for (int s : fr.bce_arrays) {
+        const EvalValue &v = f->slots[s].get();
+        if (!v.is<SharedArrayObj>() ||
+            static_cast<size_t>(hi) >= v.get_ref<SharedArrayObj>().size())
+            return false;
+    }
+    return true;
+}
+
 /*
  * Specialized counted loop (see syntax.h). After `init` declares the int slot,
  * `bound` and `step` are evaluated ONCE; the per-iteration condition test and
@@ -4066,6 +4742,8 @@ EvalValue ForRangeStmt::do_eval(EvalContext *ctx, bool rec) const
 {
     EvalContext loop_ctx(ctx, ctx->const_ctx);
 
+    unbind_hoisted(ctx, hoisted);
+
     init->eval(&loop_ctx);                 /* declares i in frame slot i_slot */
 
     Frame *f = loop_ctx.frame;
@@ -4079,6 +4757,18 @@ EvalValue ForRangeStmt::do_eval(EvalContext *ctx, bool rec) const
     const bool asc = (cmp_op == Op::lt || cmp_op == Op::le);
     const int_type delta = asc ? step_val : -step_val;
 
+    if (bce_slot >= 0) {
+        const bool fits = range_fits_arrays(
+            *this, f, f->slots[i_slot].getval<int_type>(), bound_val, step_val);
+        f->slots[bce_slot] = LValue(EvalValue(static_cast<int_type>(fits)),
+                                    false);
+    }
+
+    if (parallel &&
+        par_range_run(*this, &loop_ctx, f, f->slots[i_slot].getval<int_type>(),
+                      bound_val, step_val))
+        return none;
+
     FlowState &fs = *loop_ctx.flow;
 
     while (true) {
@@ -4107,6 +4797,7 @@ EvalValue ForRangeStmt::do_eval(EvalContext *ctx, bool rec) const
             fs.type = FlowState::none;      /* consume; still run the step */
 
         f->slots[i_slot].getval<int_type>() += delta;
+        live_safe_point(this);
     }
 
     return none;
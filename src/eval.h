@@ -88,13 +88,17 @@ struct PureCacheKeyHash {
     }
 };
 
-typedef std::unordered_map<PureCacheKey, EvalValue, PureCacheKeyHash> PureCache;
+typedef std::unordered_map<
+    PureCacheKey, EvalValue, PureCacheKeyHash, std::equal_to<PureCacheKey>,
+    MemAlloc<std::pair<const PureCacheKey, EvalValue>, MemKind::pure_cache>
+> PureCache;
 
 struct Frame {
     static constexpr int INLINE_SLOTS = 8;
 
     alignas(LValue) char inline_buf[INLINE_SLOTS * sizeof(LValue)];
-    std::vector<LValue> heap_buf;   /* spill when frame_size > INLINE_SLOTS */
+    /* spill when frame_size > INLINE_SLOTS */
+    std::vector<LValue, MemAlloc<LValue, MemKind::frame_spill>> heap_buf;
     LValue *slots = nullptr;
     int inline_count = 0;           /* # slots placement-built in inline_buf */
 
@@ -113,6 +117,13 @@ struct Frame {
         return *pure_cache;
     }
 
+    /* The number of slots init() made. */
+    int size() const
+    {
+        return heap_buf.empty() ? inline_count
+                                : static_cast<int>(heap_buf.size());
+    }
+
     /* Make `slots` point at storage holding exactly `frame_size` slots. */
     void init(int frame_size)
     {
@@ -286,26 +297,64 @@ public:
      * LValue is exposed too. */
     void collect_symbols(
         std::vector<std::pair<const UniqueId *, const LValue *>> &out) const;
-
-    static SymbolsType builtins;
-    static const SymbolsType const_builtins;
 };
 
 /*
  * The program-wide builtin table: a flat vector of every builtin's value, each
- * with a fixed index, built once (lazily) from const_builtins + builtins. A
- * builtin reference the resolver couldn't shadow with a user symbol resolves to
- * SymKind::builtin + its index, so it is an O(1) slot read - not a scope-chain
- * map walk. Entries are is_const-flagged (so an `aBuiltin = x` assignment to an
- * unshadowed builtin still raises CannotRebindBuiltinEx, and the shared global
- * table can't be corrupted). NOT used in the REPL (builtins stay map-resident
- * there so they remain redefinable). builtin_slot_index returns -1 if the name
- * is not a builtin.
+ * with a fixed index, built once (lazily) from the constant declaration table
+ * in types.cpp. A builtin reference the resolver couldn't shadow with a user
+ * symbol resolves to SymKind::builtin + its index, so it is an O(1) slot read -
+ * not a scope-chain map walk. A script's const-eval root reads the const
+ * builtins from here too. Entries are is_const-flagged (so an `aBuiltin = x`
+ * assignment to an unshadowed builtin still raises CannotRebindBuiltinEx, and
+ * the shared global table can't be corrupted). NOT used in the REPL (builtins
+ * are copied into its maps there so they remain redefinable).
+ * builtin_slot_index returns -1 if the name is not a builtin.
  */
 int builtin_slot_index(const UniqueId *uid);
 LValue &builtin_slot(int index);
-/* did the builtin come from const_builtins (visible during const-eval)? */
+/* is the builtin a const one (visible during const-eval)? */
 bool builtin_is_const(int index);
+/* the number of builtins, and each one's name by index */
+int builtin_count();
+std::string_view builtin_name(int index);
+/* Add a runtime builtin whose value is only known at startup (argv). */
+void add_builtin(std::string_view name, EvalValue &&val);
+
+inline bool
+is_const_builtin(const UniqueId *uid)
+{
+    const int i = builtin_slot_index(uid);
+    return i >= 0 && builtin_is_const(i);
+}
+
+/*
+ * The argument index at which a builtin takes a user function it CALLS (map's
+ * callback, sort's comparator, bench's body, ...), or -1. Such a call runs
+ * arbitrary script code, so every pass reasoning about what a call can touch
+ * (LICM, bounds-check elision, parallel safety) must treat it as opaque: keep
+ * them all on this one list.
+ */
+inline int
+builtin_callback_arg(std::string_view name)
+{
+    if (name == "map" || name == "filter" || name == "bench")
+        return 0;
+    if (name == "make_array" || name == "sort" || name == "rev_sort" ||
+        name == "sum")
+        return 1;
+    if (name == "find")
+        return 2;
+    return -1;
+}
+
+/* Does a call to builtin `name` with `nargs` arguments run user code? */
+inline bool
+builtin_runs_user_code(std::string_view name, size_t nargs)
+{
+    const int cb = builtin_callback_arg(name);
+    return cb >= 0 && nargs > static_cast<size_t>(cb);
+}
 
 /* Inlining cost-model calibration: measure per-node-type eval cost from
  * hand-built AST nodes and print the weights. Driven by `--weights`. */
@@ -325,7 +374,7 @@ get_root_ctx(EvalContext *ctx)
     return ctx;
 }
 
-class FuncObject : public RefCounted {
+class FuncObject : public RefCounted, public MemCounted<MemKind::func> {
 
 public:
 
@@ -351,6 +400,25 @@ public:
     FuncObject(const FuncObject &rhs);
 };
 
+/*
+ * One real (framed) call in progress: linked by run_func_call for its
+ * duration, innermost first, so heap_snapshot() can reach every live Frame -
+ * not just the current one, which is all the context chain leads to (a
+ * callee's args context parents to its closure, not to its caller). Inlined
+ * calls share their caller's frame and so need no entry. Per thread.
+ */
+struct ActiveCall {
+    const FuncObject *func;
+    const EvalContext *ctx;         /* the call's args context */
+    const ActiveCall *caller;
+    Loc call_site;                  /* in the caller; unset from a builtin */
+    const InlineCtx *call_site_inl;
+    int64_t t0_ns;                  /* a top-level call's start (livestats.h) */
+};
+
+/* The innermost active call on this thread, or nullptr at the top level. */
+const ActiveCall *active_calls();
+
 /*
  * Deep, read-only copy of a const-evaluated array/dict value (see eval.cpp).
  * Used by the parser to bake a `const`-decl target into a LiteralObj that can
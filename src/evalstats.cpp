@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "evalstats.h"
+
+#ifdef EVAL_STATS
+
+#include "syntax.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+bool g_stats = false;
+
+namespace {
+
+/* Rows printed per per-class / per-line table. */
+constexpr size_t STATS_TOP = 25;
+
+unsigned long counters[static_cast<unsigned>(StatCtr::count_)];
+
+/* Keyed by Construct::name: a string literal per class, so the pointer is a
+ * stable (if not necessarily unique) key; merged by text in the report. */
+std::unordered_map<const char *, unsigned long> per_class;
+std::unordered_map<int, unsigned long> per_line;
+
+const char *const ctr_names[] = {
+    "boxed do_eval",
+    "unboxed eval_int",
+    "unboxed eval_float",
+    "typed eval boxed anyway",
+    "flat array element reads",
+    "general array element reads",
+    "flat array element stores",
+    "struct array promotions",
+    "PureCache hits",
+    "PureCache misses",
+    "real calls (frames)",
+    "inlined calls",
+};
+
+static_assert(sizeof(ctr_names) / sizeof(ctr_names[0]) ==
+              static_cast<unsigned>(StatCtr::count_),
+              "one name per StatCtr");
+
+template <class K>
+vector<std::pair<K, unsigned long>>
+top_rows(const std::map<K, unsigned long> &m)
+{
+    vector<std::pair<K, unsigned long>> rows(m.begin(), m.end());
+
+    std::stable_sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.second > b.second;
+    });
+
+    return rows;
+}
+
+}  /* anonymous namespace */
+
+void stats_report(std::ostream &o)
+{
+    char buf[96];
+
+    std::map<string, unsigned long> classes;
+    std::map<int, unsigned long> lines;
+    unsigned long total = 0;
+
+    for (const auto &kv : per_class) {
+        classes[kv.first] += kv.second;
+        total += kv.second;
+    }
+
+    for (const auto &kv : per_line)
+        lines[kv.first] += kv.second;
+
+    o << "\nExecution stats\n\n  Evaluation paths\n";
+
+    for (unsigned i = 0; i < static_cast<unsigned>(StatCtr::count_); i++) {
+        snprintf(buf, sizeof(buf), "    %-30s %14lu\n",
+                 ctr_names[i], counters[i]);
+        o << buf;
+    }
+
+    const auto crows = top_rows(classes);
+    o << "\n  Node evaluations by class (" << total << " total)\n";
+
+    for (size_t i = 0; i < crows.size() && i < STATS_TOP; i++) {
+        snprintf(buf, sizeof(buf), "    %14lu  %5.1f%%  ",
+                 crows[i].second, 100.0 * crows[i].second / total);
+        o << buf << crows[i].first << "\n";
+    }
+
+    if (crows.size() > STATS_TOP)
+        o << "    ... " << crows.size() - STATS_TOP << " more\n";
+
+    const auto lrows = top_rows(lines);
+    o << "\n  Node evaluations by line\n";
+
+    for (size_t i = 0; i < lrows.size() && i < STATS_TOP; i++) {
+        snprintf(buf, sizeof(buf), "    %14lu  %5.1f%%  ",
+                 lrows[i].second, 100.0 * lrows[i].second / total);
+        o << buf;
+
+        /* A node the optimizer synthesized (no source location). */
+        if (lrows[i].first > 0)
+            o << "line " << lrows[i].first << "\n";
+        else
+            o << "(generated)\n";
+    }
+
+    if (lrows.size() > STATS_TOP)
+        o << "    ... " << lrows.size() - STATS_TOP << " more\n";
+}
+
+void stats_inc(StatCtr c)
+{
+    counters[static_cast<unsigned>(c)]++;
+}
+
+void stats_node(const Construct *n)
+{
+    per_class[n->name()]++;
+    per_line[n->start().line]++;
+}
+
+unsigned long stats_count(StatCtr c)
+{
+    return counters[static_cast<unsigned>(c)];
+}
+
+unsigned long stats_class_count(const char *name)
+{
+    unsigned long n = 0;
+
+    for (const auto &kv : per_class)
+        if (!strcmp(kv.first, name))
+            n += kv.second;
+
+    return n;
+}
+
+unsigned long stats_line_count(int line)
+{
+    const auto it = per_line.find(line);
+    return it != per_line.end() ? it->second : 0;
+}
+
+void stats_reset()
+{
+    std::fill(std::begin(counters), std::end(counters), 0);
+    per_class.clear();
+    per_line.clear();
+}
+
+void stats_start()
+{
+    g_parallel_enabled = false;     /* counts independent of the core count */
+    g_stats = true;
+
+    /* At exit, so an exit() from the script still reports. */
+    atexit([] { g_stats = false; stats_report(std::cerr); });
+}
+
+#endif   /* EVAL_STATS */
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+/*
+ * Deterministic per-node execution counters (`--stats`, in a build configured
+ * with STATS=ON / `make STATS=1`, which defines EVAL_STATS).
+ *
+ * Counts every node evaluation per Construct subclass and per source line,
+ * and how often the evaluator took each of a few paths that tell whether the
+ * optimizer fired where it matters: boxed `do_eval` vs unboxed `eval_int` /
+ * `eval_float` (and the typed entry points that had to box after all), flat vs
+ * general array element access, struct-array promotions, PureCache hits and
+ * misses, and inlined vs real calls. `-a` shows what the optimizer decided;
+ * this shows which of those decisions the hot path actually ran through.
+ *
+ * In a normal build every STAT_* macro expands to nothing, so the evaluator
+ * carries no counter code at all. A stats build tests one flag per counter;
+ * `--stats` turns counting on (and parallelism off, so the counts don't depend
+ * on the thread count) and prints the report to stderr at exit.
+ */
+
+#include <iosfwd>
+
+class Construct;
+
+enum class StatCtr : unsigned {
+    boxed_eval,       /* Construct::eval -> do_eval */
+    typed_int,        /* an eval_int override (unboxed) */
+    typed_float,      /* an eval_float override (unboxed) */
+    typed_boxed,      /* the default eval_int/eval_float: boxed after all */
+    elem_flat,        /* flat (unboxed) array element read */
+    elem_general,     /* general (vector<LValue>) array element read */
+    store_flat,       /* a[i] = v written straight into flat storage */
+    struct_promote,   /* a flat struct array promoted to general */
+    pure_hit,         /* PureCache (per-frame) hit */
+    pure_miss,        /* PureCache miss: the call ran */
+    call_real,        /* do_func_call: a real frame */
+    call_inlined,     /* InlinedCallExpr: a spliced-in body */
+    count_
+};
+
+#ifdef EVAL_STATS
+
+extern bool g_stats;
+
+void stats_inc(StatCtr c);
+void stats_node(const Construct *n);
+
+/* Turn counting on and arrange for the report at exit. */
+void stats_start();
+
+/* The report `--stats` prints at exit, to `o`. */
+void stats_report(std::ostream &o);
+
+/* Read back and clear the counts (the unit tests). A class is looked up by
+ * its Construct::name() text. */
+unsigned long stats_count(StatCtr c);
+unsigned long stats_class_count(const char *name);
+unsigned long stats_line_count(int line);
+void stats_reset();
+
+#define STAT_INC(ctr)                                                     \
+    do {                                                                  \
+        if (g_stats)                                                      \
+            stats_inc(StatCtr::ctr);                                      \
+    } while (0)
+
+#define STAT_NODE(node)                                                   \
+    do {                                                                  \
+        if (g_stats)                                                      \
+            stats_node(node);                                             \
+    } while (0)
+
+/* An array element read: general storage if `general`, else flat. */
+#define STAT_ELEM(general)                                                \
+    do {                                                                  \
+        if (g_stats)                                                      \
+            stats_inc((general) ? StatCtr::elem_general                   \
+                                : StatCtr::elem_flat);                    \
+    } while (0)
+
+#else
+
+#define STAT_INC(ctr)       do { } while (0)
+#define STAT_NODE(node)     do { } while (0)
+#define STAT_ELEM(general)  do { } while (0)
+
+#endif
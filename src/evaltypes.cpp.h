@@ -77,14 +77,10 @@ public:
 string_view
 find_builtin_name(const Builtin &b)
 {
-    for (const auto &[k, v]: EvalContext::const_builtins) {
+    for (int i = 0; i < builtin_count(); i++) {
+        const LValue &v = builtin_slot(i);
         if (v.is<Builtin>() && v.getval<Builtin>().func == b.func)
-            return k->val;
-    }
-
-    for (const auto &[k, v]: EvalContext::builtins) {
-        if (v.is<Builtin>() && v.getval<Builtin>().func == b.func)
-            return k->val;
+            return builtin_name(i);
     }
 
     throw InternalErrorEx();
@@ -0,0 +1,683 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "heapsnap.h"
+#include "syntax.h"
+#include "structtype.h"
+#include "memacct.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+constexpr unsigned NONE = static_cast<unsigned>(-1);
+
+/* Rows printed per report section (the graph itself is written in full). */
+constexpr size_t SNAP_TOP = 20;
+
+/* A dict entry's node beyond its key/value pair (the next pointer and the
+ * cached hash): the per-object sizes are estimates, memstats() is exact. */
+constexpr size_t DICT_NODE_EXTRA = 2 * sizeof(void *);
+
+struct Node {
+    const EvalValue *val;           /* a reference to it, to expand from */
+    MemKind kind;
+    size_t bytes = 0;               /* self: header + its own buffers */
+    size_t count = 0;               /* elements / entries / chars / ... */
+    string what;                    /* a struct's type, a function's name */
+    unsigned parent = NONE;         /* first retainer: a shortest path */
+    unsigned root = NONE;           /* ... or the root holding it directly */
+    string edge;                    /* how the parent (or root) reaches it */
+    vector<unsigned> out;
+    unsigned full_refs = 0;         /* references to the whole value */
+    unsigned slice_refs = 0;        /* references through a slice */
+    size_t max_slice = 0;           /* the longest such slice */
+};
+
+string func_name(const FuncDeclStmt *f)
+{
+    if (!f->display_name.empty())
+        return f->display_name;         /* e.g. a specialized clone */
+
+    return f->id ? string(f->id->get_str()) : "<lambda>";
+}
+
+const char *count_unit(MemKind k)
+{
+    switch (k) {
+        case MemKind::str:          return "chars";
+        case MemKind::dict:         return "entries";
+        case MemKind::struct_obj:   return "fields";
+        case MemKind::func:         return "captures";
+        case MemKind::exception:    return "";
+        default:                    return "elems";
+    }
+}
+
+string short_repr(const EvalValue &v)
+{
+    string s = v.to_string_repr();
+
+    if (s.size() > 32)
+        s = s.substr(0, 29) + "...";
+
+    return s;
+}
+
+class Snapshot {
+
+public:
+
+    vector<Node> nodes;
+    vector<string> roots;
+    vector<std::pair<unsigned, unsigned>> root_edges;   /* (root, node) */
+
+    void add_root(string label, const EvalValue &v)
+    {
+        roots.push_back(move(label));
+        ref(v, NONE, static_cast<unsigned>(roots.size() - 1),
+            [] { return string(); });
+    }
+
+    /* A root value made up here (not held in a slot), kept alive and at a
+     * stable address for the walk. */
+    void add_root_value(string label, EvalValue &&v)
+    {
+        made.push_back(move(v));
+        add_root(move(label), made.back());
+    }
+
+    void walk()
+    {
+        while (!queue.empty()) {
+            const unsigned n = queue.front();
+            queue.pop_front();
+            expand(n);
+        }
+    }
+
+    string path(unsigned n) const
+    {
+        vector<const string *> edges;
+
+        for (; nodes[n].parent != NONE; n = nodes[n].parent)
+            edges.push_back(&nodes[n].edge);
+
+        string p = roots[nodes[n].root] + nodes[n].edge;
+
+        for (size_t i = edges.size(); i-- > 0; )
+            p += *edges[i];
+
+        return p;
+    }
+
+    string describe(unsigned n) const
+    {
+        const Node &nd = nodes[n];
+        string s = "@" + std::to_string(n) + " " + mem_kind_name(nd.kind);
+
+        if (!nd.what.empty())
+            s += " " + nd.what;
+
+        if (*count_unit(nd.kind))
+            s += " " + std::to_string(nd.count) + " " + count_unit(nd.kind);
+
+        return s + ", " + std::to_string(nd.bytes) + " bytes";
+    }
+
+private:
+
+    std::unordered_map<const void *, unsigned> ids;
+    std::deque<unsigned> queue;
+    std::deque<EvalValue> made;
+
+    /*
+     * Record a reference to `v` from node `from` (or from root `root`) and
+     * return its node, or NONE for a scalar. `label` renders the edge, and is
+     * only called for the first reference (the one on the shortest path).
+     */
+    template <class Label>
+    unsigned ref(const EvalValue &v, unsigned from, unsigned root, Label label)
+    {
+        const void *id = nullptr;
+        MemKind kind = MemKind::str;
+        bool slice = false;
+        size_t view = 0;
+
+        switch (v.get_type()->t) {
+
+            case Type::t_str: {
+                const SharedStr &s = v.get_ref<SharedStr>();
+                id = s.storage_id();
+                kind = MemKind::str;
+                slice = s.is_slice();
+                view = id ? s.size() : 0;
+                break;
+            }
+
+            case Type::t_arr: {
+                const SharedArrayObj &a = v.get_ref<SharedArrayObj>();
+                id = a.storage_id();
+                kind = id ? a.storage_mem_kind() : MemKind::arr_general;
+                slice = a.is_slice();
+                view = id ? a.size() : 0;
+                break;
+            }
+
+            case Type::t_dict:
+                id = v.get_ref<intrusive_ptr<DictObject>>().get();
+                kind = MemKind::dict;
+                break;
+
+            case Type::t_struct:
+                id = v.get_ref<intrusive_ptr<StructObject>>().get();
+                kind = MemKind::struct_obj;
+                break;
+
+            case Type::t_func:
+                id = v.get_ref<intrusive_ptr<FuncObject>>().get();
+                kind = MemKind::func;
+                break;
+
+            case Type::t_ex:
+                id = v.get_ref<intrusive_ptr<ExceptionObject>>().get();
+                kind = MemKind::exception;
+                break;
+
+            default:
+                return NONE;
+        }
+
+        if (!id)
+            return NONE;
+
+        const auto r = ids.emplace(id, static_cast<unsigned>(nodes.size()));
+        const unsigned n = r.first->second;
+
+        if (r.second) {
+            nodes.emplace_back();
+            Node &nd = nodes.back();
+            nd.val = &v;
+            nd.kind = kind;
+            nd.parent = from;
+            nd.root = root;
+            nd.edge = label();
+            measure(nd);
+            queue.push_back(n);
+        }
+
+        Node &nd = nodes[n];
+
+        if (slice) {
+            nd.slice_refs++;
+            nd.max_slice = std::max(nd.max_slice, view);
+        } else {
+            nd.full_refs++;
+        }
+
+        if (from != NONE)
+            nodes[from].out.push_back(n);
+        else
+            root_edges.emplace_back(root, n);
+
+        return n;
+    }
+
+    static void measure(Node &nd)
+    {
+        const EvalValue &v = *nd.val;
+
+        switch (v.get_type()->t) {
+
+            case Type::t_str: {
+                const SharedStr &s = v.get_ref<SharedStr>();
+                nd.bytes = s.storage_bytes();
+                nd.count = s.storage_size();
+                break;
+            }
+
+            case Type::t_arr: {
+                const SharedArrayObj &a = v.get_ref<SharedArrayObj>();
+                nd.bytes = a.storage_bytes();
+                nd.count = a.storage_size();
+                break;
+            }
+
+            case Type::t_dict: {
+                const auto &d = v.get_ref<intrusive_ptr<DictObject>>()->get_ref();
+                nd.count = d.size();
+                nd.bytes = sizeof(DictObject) +
+                    d.size() * (sizeof(*d.begin()) + DICT_NODE_EXTRA) +
+                    d.bucket_count() * sizeof(void *);
+                break;
+            }
+
+            case Type::t_struct: {
+                const StructObject &s = *v.get_ref<intrusive_ptr<StructObject>>();
+                nd.what = s.def && s.def->name ? s.def->name->val : "?";
+                nd.count = s.def ? s.def->fields.size() : 0;
+                nd.bytes = sizeof(StructObject) +
+                    s.fields.capacity() * sizeof(LValue) + s.bytes.capacity();
+                break;
+            }
+
+            case Type::t_func: {
+                const FuncObject &f = *v.get_ref<intrusive_ptr<FuncObject>>();
+                nd.what = func_name(f.func);
+                nd.count = f.capture_slots.size();
+                nd.bytes = sizeof(FuncObject) +
+                    f.capture_slots.capacity() * sizeof(LValue);
+                break;
+            }
+
+            case Type::t_ex: {
+                const ExceptionObject &e =
+                    *v.get_ref<intrusive_ptr<ExceptionObject>>();
+                nd.what = string(e.get_name());
+                nd.bytes = sizeof(ExceptionObject);
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    void expand(unsigned n)
+    {
+        const EvalValue &v = *nodes[n].val;
+
+        switch (v.get_type()->t) {
+
+            case Type::t_arr: {
+
+                const SharedArrayObj &a = v.get_ref<SharedArrayObj>();
+
+                /* Flat storage holds no references. The whole storage is
+                 * walked, not just the range `v` views. */
+                if (a.skind() != SharedArrayObj::Storage::general)
+                    break;
+
+                const SharedArrayObj::vec_type &vec = a.get_vec();
+
+                for (size_t i = 0; i < vec.size(); i++)
+                    ref(vec[i].get(), n, NONE, [i] {
+                        return "[" + std::to_string(i) + "]";
+                    });
+
+                break;
+            }
+
+            case Type::t_dict: {
+
+                const DictObject &d = *v.get_ref<intrusive_ptr<DictObject>>();
+
+                for (const auto &kv : d.get_ref()) {
+
+                    const EvalValue &k = kv.first;
+
+                    ref(k, n, NONE, [&k] {
+                        return " key " + short_repr(k);
+                    });
+                    ref(kv.second.get(), n, NONE, [&k] {
+                        return "[" + short_repr(k) + "]";
+                    });
+                }
+
+                if (d.get_has_default())
+                    ref(d.get_default(), n, NONE, [] {
+                        return string(" default");
+                    });
+
+                break;
+            }
+
+            case Type::t_struct: {
+
+                const StructObject &s = *v.get_ref<intrusive_ptr<StructObject>>();
+
+                /* A POD struct is bytes: no references. */
+                if (!s.def || s.is_pod())
+                    break;
+
+                for (const FieldDef &f : s.def->fields) {
+
+                    if (f.slot < 0 || f.slot >= static_cast<int>(s.fields.size()))
+                        continue;
+
+                    ref(s.fields[f.slot].get(), n, NONE, [&f] {
+                        return "." + f.name->val;
+                    });
+                }
+
+                break;
+            }
+
+            case Type::t_func: {
+
+                const FuncObject &f = *v.get_ref<intrusive_ptr<FuncObject>>();
+                const IdList *caps = f.func->captures.get();
+
+                for (size_t i = 0; i < f.capture_slots.size(); i++)
+                    ref(f.capture_slots[i].get(), n, NONE, [caps, i] {
+                        if (caps && i < caps->elems.size())
+                            return " capture " +
+                                string(caps->elems[i]->get_str());
+                        return " capture " + std::to_string(i);
+                    });
+
+                break;
+            }
+
+            case Type::t_ex: {
+
+                const ExceptionObject &e =
+                    *v.get_ref<intrusive_ptr<ExceptionObject>>();
+
+                ref(e.get_data(), n, NONE, [] { return string(".data"); });
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+};
+
+/*
+ * The roots, in the order their objects get their shortest paths on a tie:
+ * the global table, then main's frame, then the active calls outermost first.
+ */
+void add_roots(Snapshot &snap, EvalContext *ctx)
+{
+    EvalContext *root = get_root_ctx(ctx);
+    std::set<const Frame *> frames;
+    std::set<const EvalContext *> maps;
+
+    auto add_map = [&](const EvalContext *c, const string &prefix) {
+
+        if (!maps.insert(c).second)
+            return;
+
+        vector<std::pair<const UniqueId *, const LValue *>> syms;
+        c->collect_symbols(syms);
+
+        for (const auto &kv : syms)
+            snap.add_root(prefix + "`" + kv.first->val + "`", kv.second->get());
+    };
+
+    if (root->gfuncs) {
+        const GlobalFuncTable &gt = *root->gfuncs;
+        for (size_t i = 0; i < gt.slots.size(); i++)
+            if (gt.defined[i])
+                snap.add_root(gt.names[i]
+                                  ? "global `" + gt.names[i]->val + "`"
+                                  : "global " + std::to_string(i),
+                              gt.slots[i].get());
+    }
+
+    add_map(root, "global ");
+
+    if (root->frame) {
+        frames.insert(root->frame);
+        for (int i = 0; i < root->frame->size(); i++)
+            snap.add_root("main slot " + std::to_string(i),
+                          root->frame->slots[i].get());
+    }
+
+    vector<const ActiveCall *> calls;
+    for (const ActiveCall *ac = active_calls(); ac; ac = ac->caller)
+        calls.push_back(ac);
+
+    for (size_t c = calls.size(); c-- > 0; ) {
+
+        const ActiveCall &ac = *calls[c];
+        const FuncDeclStmt *fd = ac.func->func;
+        const string fn = func_name(fd) + "()";
+        const Frame *fr = ac.ctx->frame;
+
+        /* The callee itself: a lambda called in place is held by nothing
+         * else, and its captures hang off it. */
+        snap.add_root_value(fn + " callee", EvalValue(
+            intrusive_ptr<FuncObject>(const_cast<FuncObject *>(ac.func))));
+
+        if (fr && frames.insert(fr).second) {
+
+            const size_t nparams = fd->params ? fd->params->elems.size() : 0;
+
+            for (int i = 0; i < fr->size(); i++) {
+
+                const size_t si = static_cast<size_t>(i);
+                snap.add_root(si < nparams
+                                  ? fn + " param `" +
+                                        string(fd->params->elems[si]->get_str()) +
+                                        "`"
+                                  : fn + " slot " + std::to_string(i),
+                              fr->slots[i].get());
+            }
+        }
+
+        add_map(ac.ctx, fn + " ");
+    }
+
+    /* The calling context's own chain: block scopes with map-resident names
+     * (the REPL, and unresolved functions). */
+    for (const EvalContext *c = ctx; c; c = c->parent)
+        add_map(c, "");
+}
+
+/*
+ * Tarjan's strongly-connected components, iteratively (a long list or a deep
+ * tree must not overflow the C++ stack). Appends the members of every
+ * component that is a cycle (two or more objects, or one referencing itself),
+ * one vector per component.
+ */
+void find_cycles(const vector<Node> &nodes, vector<vector<unsigned>> &out)
+{
+    const unsigned N = static_cast<unsigned>(nodes.size());
+    vector<unsigned> index(N, NONE), low(N, 0);
+    vector<char> on_stack(N, 0);
+    vector<unsigned> stack;
+    vector<std::pair<unsigned, size_t>> calls;    /* (node, next edge) */
+    unsigned next = 0;
+
+    for (unsigned s = 0; s < N; s++) {
+
+        if (index[s] != NONE)
+            continue;
+
+        calls.emplace_back(s, 0);
+        index[s] = low[s] = next++;
+        stack.push_back(s);
+        on_stack[s] = 1;
+
+        while (!calls.empty()) {
+
+            const unsigned v = calls.back().first;
+            size_t &e = calls.back().second;
+
+            if (e < nodes[v].out.size()) {
+
+                const unsigned w = nodes[v].out[e++];
+
+                if (index[w] == NONE) {
+                    index[w] = low[w] = next++;
+                    stack.push_back(w);
+                    on_stack[w] = 1;
+                    calls.emplace_back(w, 0);
+                } else if (on_stack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+
+                continue;
+            }
+
+            calls.pop_back();
+
+            if (!calls.empty()) {
+                const unsigned p = calls.back().first;
+                low[p] = std::min(low[p], low[v]);
+            }
+
+            if (low[v] != index[v])
+                continue;
+
+            vector<unsigned> comp;
+            unsigned w;
+
+            do {
+                w = stack.back();
+                stack.pop_back();
+                on_stack[w] = 0;
+                comp.push_back(w);
+            } while (w != v);
+
+            const vector<unsigned> &vo = nodes[v].out;
+
+            if (comp.size() > 1 || std::find(vo.begin(), vo.end(), v) != vo.end())
+                out.push_back(move(comp));
+        }
+    }
+}
+
+}  /* anonymous namespace */
+
+HeapSnapSummary heap_snapshot(EvalContext *ctx, std::ostream &o)
+{
+    Snapshot snap;
+    HeapSnapSummary sum;
+    char buf[128];
+
+    add_roots(snap, ctx);
+    snap.walk();
+
+    const vector<Node> &nodes = snap.nodes;
+    size_t reachable[static_cast<unsigned>(MemKind::count_)] = {};
+
+    for (const Node &nd : nodes) {
+        reachable[static_cast<unsigned>(nd.kind)]++;
+        sum.bytes += nd.bytes;
+    }
+
+    sum.objects = nodes.size();
+
+    o << "mylang heap snapshot\n\n";
+    o << "  " << sum.objects << " reachable objects, " << sum.bytes
+      << " bytes (self sizes), from " << snap.root_edges.size()
+      << " root references\n";
+
+    /* Largest objects */
+    vector<unsigned> order(nodes.size());
+    for (unsigned i = 0; i < order.size(); i++)
+        order[i] = i;
+
+    std::stable_sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return nodes[a].bytes > nodes[b].bytes;
+    });
+
+    o << "\nLargest objects\n\n";
+
+    for (size_t i = 0; i < order.size() && i < SNAP_TOP; i++)
+        o << "  " << snap.describe(order[i]) << "\n"
+          << "      held by " << snap.path(order[i]) << "\n";
+
+    /* Storage reachable only through slices */
+    vector<unsigned> pinned;
+
+    for (unsigned i = 0; i < nodes.size(); i++)
+        if (!nodes[i].full_refs && nodes[i].slice_refs)
+            pinned.push_back(i);
+
+    std::stable_sort(pinned.begin(), pinned.end(), [&](unsigned a, unsigned b) {
+        return nodes[a].bytes > nodes[b].bytes;
+    });
+
+    o << "\nStorage pinned only by slices (" << pinned.size() << ")\n\n";
+
+    for (size_t i = 0; i < pinned.size() && i < SNAP_TOP; i++) {
+        const Node &nd = nodes[pinned[i]];
+        o << "  " << snap.describe(pinned[i]) << ": " << nd.slice_refs
+          << " slice(s), the longest " << nd.max_slice << " "
+          << count_unit(nd.kind) << "\n"
+          << "      held by " << snap.path(pinned[i]) << "\n";
+    }
+
+    /* Reference cycles */
+    vector<vector<unsigned>> cycles;
+    find_cycles(nodes, cycles);
+    sum.cycles = cycles.size();
+
+    o << "\nReference cycles (never freed once unreachable) ("
+      << cycles.size() << ")\n\n";
+
+    for (size_t i = 0; i < cycles.size() && i < SNAP_TOP; i++) {
+
+        const unsigned first =
+            *std::min_element(cycles[i].begin(), cycles[i].end());
+        size_t bytes = 0;
+
+        for (unsigned n : cycles[i])
+            bytes += nodes[n].bytes;
+
+        o << "  " << snap.describe(first) << ": " << cycles[i].size()
+          << " object(s), " << bytes << " bytes in the cycle\n"
+          << "      held by " << snap.path(first) << "\n";
+    }
+
+    /* Live but unreachable */
+    o << "\nLive but unreachable (program constants, operands in flight, "
+         "dropped cycles)\n\n";
+
+    snprintf(buf, sizeof(buf), "  %-12s %12s %12s %12s\n",
+             "kind", "live", "reachable", "unreachable");
+    o << buf;
+
+    for (unsigned k = 0; k < static_cast<unsigned>(MemKind::count_); k++) {
+
+        const uint64_t live = g_mem[k].objects.load(std::memory_order_relaxed);
+
+        if (!live && !reachable[k])
+            continue;
+
+        const uint64_t lost = live > reachable[k] ? live - reachable[k] : 0;
+        sum.unreachable += lost;
+
+        snprintf(buf, sizeof(buf), "  %-12s %12llu %12llu %12llu\n",
+                 mem_kind_name(static_cast<MemKind>(k)),
+                 static_cast<unsigned long long>(live),
+                 static_cast<unsigned long long>(reachable[k]),
+                 static_cast<unsigned long long>(lost));
+        o << buf;
+    }
+
+    /* The graph */
+    o << "\nRoots\n\n";
+
+    for (const auto &re : snap.root_edges)
+        o << "  " << snap.roots[re.first] << " -> @" << re.second << "\n";
+
+    o << "\nObjects\n\n";
+
+    for (unsigned i = 0; i < nodes.size(); i++) {
+
+        o << "  " << snap.describe(i);
+
+        if (!nodes[i].out.empty()) {
+            o << " ->";
+            for (unsigned w : nodes[i].out)
+                o << " @" << w;
+        }
+
+        o << "\n";
+    }
+
+    return sum;
+}
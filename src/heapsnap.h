@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include "eval.h"
+
+#include <cstddef>
+#include <ostream>
+
+/*
+ * Heap snapshot (the `heap_snapshot(path)` builtin): the graph of every
+ * refcounted object reachable from the running program, to find what holds a
+ * large or leaked value.
+ *
+ * The roots are the global table (GlobalFuncTable), the main Frame, every
+ * active call's Frame (the ActiveCall chain) and the closure being run, and
+ * any symbol still map-resident (the REPL). From there the walk follows array
+ * elements, dict keys and values, struct fields, closure captures and
+ * exception payloads, breadth-first, so each object's recorded retainer path
+ * is a shortest one. An array or a string is its shared storage: its aliases
+ * and slices are one object, and storage held only through slices is listed
+ * as pinned (a 10-element slice keeping a million-element array alive).
+ *
+ * Two kinds of memory that never free are flagged. A reference cycle among
+ * reachable objects (a dict containing itself) keeps itself alive once its
+ * roots drop it; a cycle already dropped can't be walked to, so it shows up
+ * as objects live (memacct.h counts them) but not reachable, per kind. That
+ * count also includes values the interpreter itself holds (the program's
+ * constants, the operands of the statement calling heap_snapshot), so it is
+ * the GROWTH of the count between two snapshots that points at a leak.
+ */
+
+struct HeapSnapSummary {
+    size_t objects = 0;         /* reachable objects */
+    size_t bytes = 0;           /* their self sizes, summed */
+    size_t cycles = 0;          /* reachable reference cycles */
+    size_t unreachable = 0;     /* live objects not reachable, all kinds */
+};
+
+/* Walk the heap from the roots visible at `ctx` and write the report. */
+HeapSnapSummary heap_snapshot(EvalContext *ctx, std::ostream &out);
@@ -1,6 +1,7 @@
 /* SPDX-License-Identifier: BSD-2-Clause */
 
 #include "syntax.h"
+#include "passtimer.h"
 #include "statictype.h"
 #include "errors.h"
 #include "inferencer.h"
@@ -8,6 +9,8 @@
 #include "evalvalue.h"
 #include "eval.h"
 #include "trace.h"
+#include "parallel.h"
+#include "nodeshape.h"
 
 #include <unordered_map>
 #include <unordered_set>
@@ -32,7 +35,9 @@
  *                    type; repeat until stable. Reading stable values keeps the
  *                    round order-independent; kinds only climb the lattice,
  *                    so a join conflict (e.g. int vs str) is a real, stable
- *                    error and is raised immediately.
+ *                    error and is raised immediately. It is a worklist: a
+ *                    round re-walks only the top-level units (functions,
+ *                    statements) whose inputs moved and replays the rest.
  *   3. check       - with final types, validate every operation/call/assign/
  *                    return and throw on a violation.
  */
@@ -40,6 +45,8 @@
 /* intern_msg (stable const char* for a terminal compile error's message) is
  * shared from errors.h - the named-arg desugaring throws the same way. */
 
+bool g_fixpoint_walk_all = false;
+
 namespace {
 
 struct FuncInfo;
@@ -88,6 +95,8 @@ struct TypeSym {
      * not real inference, so `:trace infer` reports the template as a whole
      * rather than these. Set during the structural pass. */
     bool in_template = false;
+    /* `type` moved in the last commit_round (worklist dirtiness). */
+    bool moved = false;
     Loc decl_loc;
     FuncInfo *func = nullptr;  /* non-null when this name is a function */
     /* non-null when this name is a struct TYPE (a `struct` decl): the symbol is
@@ -101,6 +110,7 @@ struct FuncInfo {
     StaticTypeRef ret = nullptr;        /* stable return type */
     StaticTypeRef ret_acc = nullptr;    /* return accumulator (current round) */
     bool falls_through = false;
+    bool ret_moved = false;      /* `ret` moved in the last commit_round */
     bool pinned = false;         /* committed by a prior REPL input */
     /*
      * REPL: set when a call INSIDE a function body is redirected to this
@@ -125,6 +135,38 @@ struct Scope {
     Scope *parent = nullptr;
 };
 
+/* One contribution made during a fixpoint round: contribute(sym, t, loc), or
+ * (sym == nullptr) contribute_ret(t) to the return of `ret_of`. */
+struct Contribution {
+    TypeSym *sym;
+    FuncInfo *ret_of;
+    StaticTypeRef t;
+    Loc loc;
+};
+
+/*
+ * A unit of the worklist fixpoint: one element of the root block (a function
+ * with everything nested in it, or a top-level statement). Its walk reads some
+ * stable types and makes some contributions; while none of the types it read
+ * moves, walking it again would make exactly the same contributions, so a
+ * round replays them instead.
+ */
+struct FixUnit {
+    std::vector<TypeSym *> read_syms;
+    std::vector<FuncInfo *> read_rets;
+    std::vector<Contribution> contribs;
+
+    bool dirty() const {
+        for (TypeSym *s : read_syms)
+            if (s->moved)
+                return true;
+        for (FuncInfo *f : read_rets)
+            if (f->ret_moved)
+                return true;
+        return false;
+    }
+};
+
 class Inferencer {
 
 public:
@@ -139,8 +181,8 @@ public:
 
     /* Complete child-visitor (no `this`, hence static) - also used by the
      * for-range specialization in the static specialize() path. */
-    static void for_each_child(Construct *n,
-                               const std::function<void(Construct *)> &fn);
+    template <class Fn>
+    static void for_each_child(Construct *n, Fn &&fn);
 
     /* REPL :globals/:type - the inferred static type string of a committed
      * global (or "" if it is not a committed inferred symbol). */
@@ -170,6 +212,10 @@ private:
 
     std::vector<std::unique_ptr<TypeSym>> all_syms;
     std::vector<std::unique_ptr<FuncInfo>> all_funcs;
+    /* REPL: every sym/func before these indexes is pinned (committed by a
+     * prior input), so a round starts its reset/commit sweeps here. */
+    size_t live_sym_base = 0;
+    size_t live_func_base = 0;
     std::vector<std::unique_ptr<Scope>> all_scopes;
 
     std::unordered_map<const Construct *, TypeSym *> id_sym;
@@ -180,6 +226,12 @@ private:
     Scope *global = nullptr;
     bool changed = false;
     FuncInfo *cur_func = nullptr;
+    /* The fixpoint unit being walked: type reads and contributions are
+     * recorded into it. Null outside the fixpoint's walks. */
+    FixUnit *rec_unit = nullptr;
+    /* Fixpoint units walked / visited (walked or replayed), for the note. */
+    size_t unit_walks = 0;
+    size_t unit_visits = 0;
     /* >0 while the structural pass is inside a template function's body, so
      * new_sym tags that function's params/locals `in_template` (their finalized
      * types are fallbacks - see TypeSym::in_template). */
@@ -254,6 +306,20 @@ private:
     /* fixpoint */
     void reset_round();
     void commit_round();
+    void walk_unit(FixUnit &u, Construct *n);
+    void replay_unit(const FixUnit &u);
+    /* A stable type read by the fixpoint: recorded as a dependency of the
+     * unit being walked. */
+    StaticTypeRef sym_type(TypeSym *s) {
+        if (rec_unit)
+            rec_unit->read_syms.push_back(s);
+        return s->type;
+    }
+    StaticTypeRef func_ret(FuncInfo *fi) {
+        if (rec_unit)
+            rec_unit->read_rets.push_back(fi);
+        return fi->ret;
+    }
     void accumulate(Construct *n);
     void contribute(TypeSym *s, StaticTypeRef t, Loc loc);
     void contribute_arg(TypeSym *param, StaticTypeRef argT, Loc loc);
@@ -266,7 +332,7 @@ private:
 
     /* monomorphization (templates - see plans/function-templates.md) */
     void mark_lambda_templates();   /* safe var-bound lambdas -> templates */
-    void run_fixpoint(Block *root);             /* the Jacobi loop, extracted */
+    int run_fixpoint(Block *root);              /* the Jacobi loop; its rounds */
     bool instantiate_round(Block *root);     /* clone + redirect; progress? */
     FuncDeclStmt *make_template_clone(FuncInfo *tmpl, const std::string &key,
                                       Block *root);
@@ -403,9 +469,7 @@ FuncInfo *Inferencer::callee_funcinfo(Construct *e)
 
 bool Inferencer::is_builtin(const UniqueId *name)
 {
-    return EvalContext::builtins.find(name) != EvalContext::builtins.end() ||
-           EvalContext::const_builtins.find(name) !=
-               EvalContext::const_builtins.end();
+    return builtin_slot_index(name) >= 0;
 }
 
 Op Inferencer::compound_binop(Op op)
@@ -442,91 +506,113 @@ bool Inferencer::always_exits(const Construct *n)
     return false;
 }
 
-void Inferencer::for_each_child(Construct *n,
-                                const std::function<void(Construct *)> &fn)
+template <class Fn>
+void Inferencer::for_each_child(Construct *n, Fn &&fn)
 {
-    if (!n)
-        return;
+    switch (node_shape(n)) {
 
-    if (auto *e = dynamic_cast<Expr14 *>(n)) {
-        fn(e->lvalue.get()); fn(e->rvalue.get()); return;
-    }
-    if (auto *c = dynamic_cast<CallExpr *>(n)) {
-        fn(c->what.get()); fn(c->args.get()); return;
-    }
-    if (auto *m = dynamic_cast<MemberExpr *>(n)) {
-        fn(m->what.get()); return;
-    }
-    if (auto *s = dynamic_cast<Subscript *>(n)) {
-        fn(s->what.get()); fn(s->index.get()); return;
-    }
-    if (auto *s = dynamic_cast<Slice *>(n)) {
-        fn(s->what.get()); fn(s->start_idx.get()); fn(s->end_idx.get()); return;
-    }
-    if (auto *i = dynamic_cast<IfStmt *>(n)) {
-        fn(i->condExpr.get()); fn(i->thenBlock.get()); fn(i->elseBlock.get());
-        return;
-    }
-    if (auto *w = dynamic_cast<WhileStmt *>(n)) {
-        fn(w->condExpr.get()); fn(w->body.get()); return;
-    }
-    if (auto *f = dynamic_cast<ForStmt *>(n)) {
-        fn(f->init.get()); fn(f->cond.get());
-        fn(f->inc.get()); fn(f->body.get());
-        return;
-    }
-    if (auto *fr = dynamic_cast<ForRangeStmt *>(n)) {
-        fn(fr->init.get()); fn(fr->bound.get());
-        fn(fr->step.get()); fn(fr->body.get());
-        return;
-    }
-    if (auto *fe = dynamic_cast<ForeachStmt *>(n)) {
-        fn(fe->container.get()); fn(fe->body.get()); return;
-    }
-    if (auto *t = dynamic_cast<TryCatchStmt *>(n)) {
-        fn(t->tryBody.get());
-        for (auto &cs : t->catchStmts)
-            fn(cs.second.get());
-        fn(t->finallyBody.get());
-        return;
-    }
-    if (auto *r = dynamic_cast<ReturnStmt *>(n)) {
-        fn(r->elem.get()); return;
-    }
-    if (auto *idc = dynamic_cast<IncDecExpr *>(n)) {
-        fn(idc->lvalue.get()); return;
-    }
-    if (auto *te = dynamic_cast<TernaryExpr *>(n)) {
-        fn(te->condExpr.get()); fn(te->thenExpr.get());
-        fn(te->elseExpr.get()); return;
-    }
-    if (auto *co = dynamic_cast<CoalesceExpr *>(n)) {
-        fn(co->lhs.get()); fn(co->rhs.get()); return;
-    }
-    if (auto *fd = dynamic_cast<FuncDeclStmt *>(n)) {
-        fn(fd->body.get()); return;
-    }
-    if (auto *ld = dynamic_cast<LiteralDict *>(n)) {
-        for (auto &kv : ld->elems) {
-            fn(kv->key.get()); fn(kv->value.get());
+        case NodeShape::expr14: {
+            auto *e = static_cast<Expr14 *>(n);
+            fn(e->lvalue.get()); fn(e->rvalue.get());
+            break;
         }
-        return;
-    }
-    if (auto *sc = dynamic_cast<SingleChildConstruct *>(n)) {
-        fn(sc->elem.get()); return;
-    }
-    if (auto *mo = dynamic_cast<MultiOpConstruct *>(n)) {
-        for (auto &pr : mo->elems)
-            fn(pr.second.get());
-        return;
-    }
-    /* MultiElemConstruct<>: Block, LiteralArray, ExprList */
-    if (auto *me = dynamic_cast<MultiElemConstruct<> *>(n)) {
-        for (auto &e : me->elems)
-            fn(e.get());
-        return;
+        case NodeShape::call: {
+            auto *c = static_cast<CallExpr *>(n);
+            fn(c->what.get()); fn(static_cast<Construct *>(c->args.get()));
+            break;
+        }
+        case NodeShape::member:
+            fn(static_cast<MemberExpr *>(n)->what.get());
+            break;
+        case NodeShape::subscript: {
+            auto *s = static_cast<Subscript *>(n);
+            fn(s->what.get()); fn(s->index.get());
+            break;
+        }
+        case NodeShape::slice: {
+            auto *s = static_cast<Slice *>(n);
+            fn(s->what.get()); fn(s->start_idx.get()); fn(s->end_idx.get());
+            break;
+        }
+        case NodeShape::if_stmt: {
+            auto *i = static_cast<IfStmt *>(n);
+            fn(i->condExpr.get()); fn(i->thenBlock.get());
+            fn(i->elseBlock.get());
+            break;
+        }
+        case NodeShape::while_stmt: {
+            auto *w = static_cast<WhileStmt *>(n);
+            fn(w->condExpr.get()); fn(w->body.get());
+            break;
+        }
+        case NodeShape::for_stmt: {
+            auto *f = static_cast<ForStmt *>(n);
+            fn(f->init.get()); fn(f->cond.get());
+            fn(f->inc.get()); fn(f->body.get());
+            break;
+        }
+        case NodeShape::for_range: {
+            auto *fr = static_cast<ForRangeStmt *>(n);
+            fn(fr->init.get()); fn(fr->bound.get());
+            fn(fr->step.get()); fn(fr->body.get());
+            break;
+        }
+        case NodeShape::foreach: {
+            auto *fe = static_cast<ForeachStmt *>(n);
+            fn(fe->container.get()); fn(fe->body.get());
+            break;
+        }
+        case NodeShape::try_catch: {
+            auto *t = static_cast<TryCatchStmt *>(n);
+            fn(t->tryBody.get());
+            for (auto &cs : t->catchStmts)
+                fn(cs.second.get());
+            fn(t->finallyBody.get());
+            break;
+        }
+        case NodeShape::ret:
+            fn(static_cast<ReturnStmt *>(n)->elem.get());
+            break;
+        case NodeShape::incdec:
+            fn(static_cast<IncDecExpr *>(n)->lvalue.get());
+            break;
+        case NodeShape::ternary: {
+            auto *te = static_cast<TernaryExpr *>(n);
+            fn(te->condExpr.get()); fn(te->thenExpr.get());
+            fn(te->elseExpr.get());
+            break;
+        }
+        case NodeShape::coalesce: {
+            auto *co = static_cast<CoalesceExpr *>(n);
+            fn(co->lhs.get()); fn(co->rhs.get());
+            break;
+        }
+        case NodeShape::func_decl:
+            fn(static_cast<FuncDeclStmt *>(n)->body.get());
+            break;
+        case NodeShape::dict:
+            for (auto &kv : static_cast<LiteralDict *>(n)->elems) {
+                fn(kv->key.get()); fn(kv->value.get());
+            }
+            break;
+        case NodeShape::single:
+            fn(static_cast<SingleChildConstruct *>(n)->elem.get());
+            break;
+        case NodeShape::multi_op:
+            for (auto &pr : static_cast<MultiOpConstruct *>(n)->elems)
+                fn(pr.second.get());
+            break;
+        case NodeShape::elems:
+            /* MultiElemConstruct<>: Block, LiteralArray, ExprList */
+            for (auto &e : static_cast<MultiElemConstruct<> *>(n)->elems)
+                fn(e.get());
+            break;
+        default:
+            /* leaves: literals, Identifier, Break/Continue/Rethrow/Nop (and
+             * the shapes this pass never needs to enter: IdList, a dict
+             * pair on its own, TypedScalarExpr) */
+            break;
     }
-    /* leaves: literals, Identifier, Break/Continue/Rethrow/Nop */
 }
 
 /* ----------------------- monomorphization (templates) -------------------- */
@@ -567,18 +653,74 @@ void Inferencer::mark_lambda_templates()
 }
 
 /* The Jacobi fixpoint, extracted so the instantiation loop can re-run it. */
-void Inferencer::run_fixpoint(Block *rootBlock)
+/* Returns the number of rounds it took. */
+int Inferencer::run_fixpoint(Block *rootBlock)
 {
-    for (int iter = 0; iter < 1000; iter++) {
+    /* One unit per root element. The instantiation loop inserts clones and
+     * redirects calls between runs, so a run starts with every unit unwalked. */
+    std::vector<FixUnit> units(rootBlock->elems.size());
+    int iter = 0;
+
+    while (iter < 1000) {
+        iter++;
         reset_round();
         cur_func = nullptr;
-        for (auto &e : rootBlock->elems)
-            accumulate(e.get());
+        for (size_t i = 0; i < units.size(); i++) {
+            unit_visits++;
+            if (iter == 1 || units[i].dirty() || g_fixpoint_walk_all) {
+                unit_walks++;
+                walk_unit(units[i], rootBlock->elems[i].get());
+            } else {
+                replay_unit(units[i]);
+            }
+        }
+        cur_func = nullptr;
         changed = false;
         commit_round();          /* sets `changed` if any type moved */
         if (!changed)
             break;
     }
+
+    return iter;
+}
+
+/* Walk `n` (accumulate), recording what it reads and contributes into `u`. */
+void Inferencer::walk_unit(FixUnit &u, Construct *n)
+{
+    u.read_syms.clear();
+    u.read_rets.clear();
+    u.contribs.clear();
+
+    rec_unit = &u;
+    try {
+        accumulate(n);
+    } catch (...) {
+        rec_unit = nullptr;
+        throw;
+    }
+    rec_unit = nullptr;
+
+    auto dedup = [](auto &v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    };
+    dedup(u.read_syms);
+    dedup(u.read_rets);
+}
+
+/* A clean unit: make its last walk's contributions again, in the same order
+ * (contribute() joins into `acc` and reports the first conflict). */
+void Inferencer::replay_unit(const FixUnit &u)
+{
+    for (const Contribution &c : u.contribs) {
+        if (c.sym) {
+            contribute(c.sym, c.t, c.loc);
+        } else {
+            cur_func = c.ret_of;
+            contribute_ret(c.t);
+        }
+    }
+    cur_func = nullptr;
 }
 
 /* Every CallExpr in the subtree (complete traversal). */
@@ -640,9 +782,9 @@ FuncDeclStmt *Inferencer::make_template_clone(FuncInfo *tmpl,
      * ization relies on. If these were equal, clone() failed to deep-copy and
      * we would be re-resolving the template in place. (A var-bound lambda
      * template has no decl->id - it is anonymous - so guard that.) */
-    ML_CHECK(fc->node_id != tmpl->decl->node_id);
+    ML_CHECK(fc->node_id() != tmpl->decl->node_id());
     ML_CHECK(!tmpl->decl->id ||
-             fc->id->node_id != tmpl->decl->id->node_id);
+             fc->id->node_id() != tmpl->decl->id->node_id());
 
     /*
      * id_sym / func_of_decl are keyed by node POINTER and persist for the
@@ -809,8 +951,8 @@ bool Inferencer::instantiate_round(Block *rootBlock)
         }
 
         auto what = make_unique<Identifier>(clone_name->val);
-        what->start = call->what->start;
-        what->end = call->what->end;
+        what->start() = call->what->start();
+        what->end() = call->what->end();
         id_sym[what.get()] = clone_sym;
         /* The old callee Identifier is about to be freed: drop its id_sym entry
          * so nothing (e.g. -a's collect_arrays) walks a dangling key. */
@@ -869,7 +1011,14 @@ void Inferencer::infer_one(Block *rootBlock)
         return;
 
     mark_lambda_templates();   /* safe var-bound lambdas become templates */
-    run_fixpoint(rootBlock);
+
+    {
+        PassTimer pt("fixpoint");
+        const int rounds = run_fixpoint(rootBlock);
+        pt.note(std::to_string(rounds) + " rounds, " +
+                std::to_string(unit_walks) + "/" +
+                std::to_string(unit_visits) + " units walked");
+    }
 
     /*
      * Monomorphization. A template (un-annotated params) is skipped by the
@@ -879,10 +1028,18 @@ void Inferencer::infer_one(Block *rootBlock)
      * until no new signature appears - a clone's body may call other templates
      * (or itself), which surface only once its own params are settled.
      */
-    for (int round = 0; round < 64; round++) {
-        if (!instantiate_round(rootBlock))
-            break;
-        run_fixpoint(rootBlock);
+    {
+        PassTimer pt("monomorphize");
+        int round = 0, fix = 0;
+
+        for (; round < 64; round++) {
+            if (!instantiate_round(rootBlock))
+                break;
+            fix += run_fixpoint(rootBlock);
+        }
+
+        pt.note(std::to_string(round) + " instantiation rounds, " +
+                std::to_string(fix) + " fixpoint rounds");
     }
 
     /* finalize. An unconstrained value is `none` for a local ("only-none /
@@ -975,6 +1132,8 @@ void Inferencer::infer_one(Block *rootBlock)
         }
     }
 
+    PassTimer pt("check");
+
     cur_func = nullptr;
     narrowing_on = true;
     for (auto &e : rootBlock->elems)
@@ -1073,6 +1232,8 @@ void Inferencer::infer_input(Block *rootBlock)
         }
         for (size_t i = func_base; i < all_funcs.size(); i++)
             all_funcs[i]->pinned = true;
+        live_sym_base = all_syms.size();
+        live_func_base = all_funcs.size();
     };
 
     try {
@@ -1306,7 +1467,7 @@ void Inferencer::dump_debug_ti(std::ostream &os)
     std::unordered_map<const TypeSym *, std::vector<Loc>> uses;
     for (const auto &kv : id_sym) {
         if (kv.second && kv.first)
-            uses[kv.second].push_back(kv.first->start);
+            uses[kv.second].push_back(kv.first->start());
     }
 
     os << "# ti\tname\tkind\tline\tcol\tconst\ttype\tuses(line:col,...)\n";
@@ -1463,14 +1624,14 @@ void Inferencer::set_array_repr_hint(Expr14 *e)
         if (nm == "range" || nm == "array" || nm == "make_array" ||
             nm == "keys" || nm == "values") {
             call->args->arr_hint = hint;
-            call->args->arr_hint_struct = sdef;
+            call->args->arr_hint_struct() = sdef;
         }
 
     } else {
 
         /* an array literal or a folded const literal (LiteralObj) */
         rv->arr_hint = hint;
-        rv->arr_hint_struct = sdef;
+        rv->arr_hint_struct() = sdef;
     }
 }
 
@@ -1504,7 +1665,7 @@ void Inferencer::declare_structdecl(StructDeclStmt *sd, Scope *s)
         const UniqueId *nm = sd->id->uid;
         auto it = s->syms.find(nm);
         TypeSym *sym = (it != s->syms.end()) ? it->second
-                                             : new_sym(nm, s, sd->start);
+                                             : new_sym(nm, s, sd->start());
         sym->struct_type = def;
         sym->type = A.dyn_ty();
         id_sym[sd->id.get()] = sym;
@@ -1611,7 +1772,7 @@ void Inferencer::declare_funcdecl(FuncDeclStmt *fd, Scope *s)
         const UniqueId *nm = fd->id->uid;
         TypeSym *sym;
         auto it = s->syms.find(nm);
-        sym = (it != s->syms.end()) ? it->second : new_sym(nm, s, fd->start);
+        sym = (it != s->syms.end()) ? it->second : new_sym(nm, s, fd->start());
         sym->func = fi;
         id_sym[fd->id.get()] = sym;
     }
@@ -1623,7 +1784,7 @@ void Inferencer::declare_target(Construct *lvalue, Scope *s, bool is_const)
         const UniqueId *nm = id->uid;
         auto it = s->syms.find(nm);
         TypeSym *sym = (it != s->syms.end()) ? it->second
-                                             : new_sym(nm, s, id->start);
+                                             : new_sym(nm, s, id->start());
         sym->opt_decl = sym->opt_decl || id->opt_mod;
         sym->dyn_decl = sym->dyn_decl || id->dyn_mod;
         sym->const_decl = sym->const_decl || is_const;
@@ -1676,7 +1837,7 @@ void Inferencer::walk_struct(Construct *n, Scope *s)
 
         if (fd->params)
             for (auto &p : fd->params->elems) {
-                TypeSym *psym = new_sym(p->uid, fscope, p->start);
+                TypeSym *psym = new_sym(p->uid, fscope, p->start());
                 psym->is_param = true;
                 psym->opt_decl = p->opt_mod;
                 psym->dyn_decl = p->dyn_mod;
@@ -1754,7 +1915,7 @@ void Inferencer::walk_struct(Construct *n, Scope *s)
         if (fe->ids)
             for (auto &id : fe->ids->elems) {
                 if (fe->idsVarDecl) {
-                    TypeSym *sym = new_sym(id->uid, inner, id->start);
+                    TypeSym *sym = new_sym(id->uid, inner, id->start());
                     sym->is_loopvar = true;   /* type derived from container */
                     id_sym[id.get()] = sym;
                 } else {
@@ -1771,7 +1932,7 @@ void Inferencer::walk_struct(Construct *n, Scope *s)
             Scope *inner = new_scope(s);
             if (cs.first.asId) {
                 TypeSym *sym = new_sym(cs.first.asId->uid, inner,
-                                       cs.first.asId->start);
+                                       cs.first.asId->start());
                 sym->type = A.exc_ty();
                 sym->dyn_decl = true;   /* exception payload is dynamic */
                 id_sym[cs.first.asId.get()] = sym;
@@ -1837,7 +1998,7 @@ void Inferencer::lower_call_named_args(CallExpr *call)
     FuncInfo *fi = callee_funcinfo(call->what.get());
     if (!fi)
         mismatch("named arguments require a directly-named function",
-                 call->what->start, call->what->end);
+                 call->what->start(), call->what->end());
 
     std::vector<ParamSpec> params;
     for (TypeSym *p : fi->params)
@@ -1866,10 +2027,10 @@ StaticTypeRef Inferencer::func_static_type(FuncInfo *fi)
     std::vector<StaticTypeRef> ps;
     std::vector<bool> popt;
     for (TypeSym *p : fi->params) {
-        ps.push_back(p->dyn_decl ? A.dyn_ty() : p->type);
+        ps.push_back(p->dyn_decl ? A.dyn_ty() : sym_type(p));
         popt.push_back(p->opt_decl);
     }
-    return A.func_of(ps, popt, fi->ret);
+    return A.func_of(ps, popt, func_ret(fi));
 }
 
 /*
@@ -2004,7 +2165,7 @@ StaticTypeRef Inferencer::type_of(const Construct *e)
                 if (nit != narrowed.end())
                     return nit->second;
             }
-            return s->type;
+            return sym_type(s);
         }
         /* `argv` is a runtime-injected global: script args, array<str>. */
         if (std::string(id->uid->val) == "argv")
@@ -2095,13 +2256,14 @@ StaticTypeRef Inferencer::type_of(const Construct *e)
                  * DynRequiredEx and roll the instance back. */
                 if (s->func->is_template)
                     return bottom;
-                return s->func->ret;
+                return func_ret(s->func);
             }
-            if (s && is_func(s->type))
-                return static_type_resolve(s->type)->ret;
-            if (s && is_unknown(s->type))
+            StaticTypeRef st = s ? sym_type(s) : nullptr;
+            if (s && is_func(st))
+                return static_type_resolve(st)->ret;
+            if (s && is_unknown(st))
                 return bottom;          /* defer: callee not yet known */
-            if (s && is_dyn(s->type))
+            if (s && is_dyn(st))
                 return A.dyn_ty();
             if (!s && is_builtin(cid->uid))
                 return builtin_result(cid->uid, call->args.get());
@@ -2365,7 +2527,7 @@ StaticTypeRef Inferencer::builtin_result(const UniqueId *name, ExprList *args)
         n == "eps")
         return A.float_ty();
 
-    if (n == "int")    return A.int_ty();
+    if (n == "int" || n == "trace_dump")    return A.int_ty();
     if (n == "str" || n == "typestr" || n == "kindstr" || n == "chr" ||
         n == "join" || n == "lpad" || n == "rpad" || n == "lstrip" ||
         n == "rstrip" || n == "strip" || n == "readln" || n == "read" ||
@@ -2429,8 +2591,14 @@ StaticTypeRef Inferencer::builtin_result(const UniqueId *name, ExprList *args)
         return n == "get!" ? v : A.with_opt(v, true);
     }
 
-    if (n == "abs" || n == "clone" || n == "deepclone")
+    if (n == "abs" || n == "clone" || n == "deepclone" || n == "memoize")
         return arg(0);
+    if (n == "memostats" || n == "heap_snapshot" || n == "perf_end")
+        return A.dict_of(A.str_ty(), A.int_ty());
+    if (n == "memstats")
+        return A.dict_of(A.str_ty(), A.dict_of(A.str_ty(), A.int_ty()));
+    if (n == "bench")       /* ints, floats and a bool, by key */
+        return A.dict_of(A.str_ty(), A.dyn_ty());
     /* dynarray(a) -> array<dyn>: a polymorphic (general) copy. Typed array<dyn>
      * (not bare dyn) so plain `var d = dynarray(a)` is accepted under the
      * tolerant-array rule and d is built/typed general. */
@@ -2526,8 +2694,8 @@ StaticTypeRef Inferencer::builtin_result(const UniqueId *name, ExprList *args)
 
 void Inferencer::reset_round()
 {
-    for (auto &up : all_syms) {
-        TypeSym *s = up.get();
+    for (size_t i = live_sym_base; i < all_syms.size(); i++) {
+        TypeSym *s = all_syms[i].get();
         if (s->func || s->pinned)   /* pinned: a prior input's fixed type */
             continue;
         /* A scalar annotation pins the type: seed the accumulator with the
@@ -2538,18 +2706,19 @@ void Inferencer::reset_round()
         else
             s->acc = s->dyn_decl ? A.dyn_ty() : bottom;
     }
-    for (auto &up : all_funcs)
-        if (!up->pinned)
-            up->ret_acc = bottom;
+    for (size_t i = live_func_base; i < all_funcs.size(); i++)
+        if (!all_funcs[i]->pinned)
+            all_funcs[i]->ret_acc = bottom;
 }
 
 void Inferencer::commit_round()
 {
-    for (auto &up : all_syms) {
-        TypeSym *s = up.get();
+    for (size_t i = live_sym_base; i < all_syms.size(); i++) {
+        TypeSym *s = all_syms[i].get();
         if (s->func || s->pinned)
             continue;
-        if (!static_type_equal(s->acc, s->type)) {
+        s->moved = !static_type_equal(s->acc, s->type);
+        if (s->moved) {
             changed = true;
             if (s->name)
                 TRACE(infer, 1, std::string(s->name->val) + "  " +
@@ -2558,10 +2727,12 @@ void Inferencer::commit_round()
         }
         s->type = s->acc;
     }
-    for (auto &up : all_funcs) {
+    for (size_t i = live_func_base; i < all_funcs.size(); i++) {
+        FuncInfo *up = all_funcs[i].get();
         if (up->pinned)
             continue;
-        if (!static_type_equal(up->ret_acc, up->ret)) {
+        up->ret_moved = !static_type_equal(up->ret_acc, up->ret);
+        if (up->ret_moved) {
             changed = true;
             if (up->decl && up->decl->id)
                 TRACE(infer, 1, "func " +
@@ -2586,6 +2757,9 @@ void Inferencer::contribute(TypeSym *s, StaticTypeRef t, Loc loc)
     if (!s || s->func)
         return;
 
+    if (rec_unit)
+        rec_unit->contribs.push_back({ s, nullptr, t, loc });
+
     /*
      * REPL incremental: a symbol committed by a prior input has a FIXED type.
      * A new input may read it or assign to it, but an assignment must be
@@ -2663,6 +2837,8 @@ void Inferencer::contribute_ret(StaticTypeRef t)
 {
     if (!cur_func)
         return;
+    if (rec_unit)
+        rec_unit->contribs.push_back({ nullptr, cur_func, t, Loc() });
     StaticTypeRef nw = A.join(cur_func->ret_acc, t);
     cur_func->ret_acc = nw ? nw : A.dyn_ty();   /* return conflict -> dyn */
 }
@@ -2704,7 +2880,7 @@ void Inferencer::accumulate(Construct *n)
          * "++ requires int/float" check, which must still reject `b++`. */
         Construct *lv = idc->lvalue.get();
         if (dynamic_cast<Subscript *>(lv) || dynamic_cast<MemberExpr *>(lv))
-            contribute_to_lvalue(lv, type_of(idc), idc->start);
+            contribute_to_lvalue(lv, type_of(idc), idc->start());
         return;
     }
 
@@ -2743,7 +2919,7 @@ void Inferencer::accumulate_call(CallExpr *call)
         size_t n = std::min(fi->params.size(), args->elems.size());
         for (size_t i = 0; i < n; i++)
             contribute_arg(fi->params[i], type_of(args->elems[i].get()),
-                           args->elems[i]->start);
+                           args->elems[i]->start());
         return;
     }
 
@@ -2771,7 +2947,7 @@ void Inferencer::accumulate_call(CallExpr *call)
         if (!bs)
             return;
         StaticTypeRef vt = type_of(args->elems[val_i].get());
-        StaticTypeRef bt = static_type_resolve(bs->type);
+        StaticTypeRef bt = static_type_resolve(sym_type(bs));
         /* Defer if the element type isn't settled yet (the defer-on-Unknown
          * invariant): contributing `array<?>` to a PINNED global array would
          * trip its assignability check immediately - `array<?>` is not
@@ -2786,9 +2962,9 @@ void Inferencer::accumulate_call(CallExpr *call)
                             ? type_of(args->elems[key_i].get()) : A.dyn_ty();
             if (is_unknown(static_type_resolve(kt)))
                 return;
-            contribute(bs, A.dict_of(kt, vt), bid->start);
+            contribute(bs, A.dict_of(kt, vt), bid->start());
         } else if (bt->kind == StaticTypeKind::Array) {
-            contribute(bs, A.array_of(vt), bid->start);
+            contribute(bs, A.array_of(vt), bid->start());
         }
         /* unknown/other base kind: skip (don't guess) */
     };
@@ -2813,7 +2989,7 @@ void Inferencer::accumulate_call(CallExpr *call)
                 FuncInfo *cb = callee_funcinfo(args->elems[1].get());
                 if (cb && !cb->params.empty())
                     contribute_arg(cb->params[0], A.int_ty(),
-                                   args->elems[1]->start);
+                                   args->elems[1]->start());
             }
             return;
         } else {
@@ -2828,7 +3004,7 @@ void Inferencer::accumulate_call(CallExpr *call)
             static_type_resolve(type_of(args->elems[cont_i].get()));
         StaticTypeRef el = ct->kind == StaticTypeKind::Array ? ct->elem
                   : ct->kind == StaticTypeKind::Dict  ? ct->key : A.dyn_ty();
-        Loc fl = args->elems[func_i]->start;
+        Loc fl = args->elems[func_i]->start();
         auto &ps = cb->params;
         if (!ps.empty())
             contribute_arg(ps[0], el, fl);
@@ -2845,14 +3021,14 @@ void Inferencer::spread_idlist(IdList *idl, Construct *rvalue)
         if (la->elems.size() == idl->elems.size()) {
             for (size_t i = 0; i < idl->elems.size(); i++)
                 contribute(id_sym[idl->elems[i].get()],
-                           type_of(la->elems[i].get()), idl->elems[i]->start);
+                           type_of(la->elems[i].get()), idl->elems[i]->start());
             return;
         }
     }
 
     StaticTypeRef each = rt->kind == StaticTypeKind::Array ? rt->elem : rt;
     for (auto &id : idl->elems)
-        contribute(id_sym[id.get()], each, id->start);
+        contribute(id_sym[id.get()], each, id->start());
 }
 
 void Inferencer::accumulate_assign(Expr14 *e)
@@ -2882,7 +3058,7 @@ void Inferencer::accumulate_assign(Expr14 *e)
         return;
     }
 
-    contribute_to_lvalue(lv, ct, e->start);
+    contribute_to_lvalue(lv, ct, e->start());
 }
 
 /*
@@ -2907,13 +3083,13 @@ void Inferencer::contribute_to_lvalue(Construct *lv, StaticTypeRef ct, Loc loc)
         if (auto *bid = dynamic_cast<Identifier *>(sub->what.get())) {
             auto it = id_sym.find(bid);
             if (it != id_sym.end() && it->second) {
-                StaticTypeRef bt = static_type_resolve(it->second->type);
+                StaticTypeRef bt = static_type_resolve(sym_type(it->second));
                 if (bt->kind == StaticTypeKind::Dict)
                     contribute(it->second,
                                A.dict_of(type_of(sub->index.get()), ct),
-                               bid->start);
+                               bid->start());
                 else if (bt->kind == StaticTypeKind::Array)
-                    contribute(it->second, A.array_of(ct), bid->start);
+                    contribute(it->second, A.array_of(ct), bid->start());
             }
         }
         return;
@@ -2923,9 +3099,9 @@ void Inferencer::contribute_to_lvalue(Construct *lv, StaticTypeRef ct, Loc loc)
         if (auto *bid = dynamic_cast<Identifier *>(mem->what.get())) {
             auto it = id_sym.find(bid);
             if (it != id_sym.end() && it->second &&
-                static_type_resolve(it->second->type)->kind ==
+                static_type_resolve(sym_type(it->second))->kind ==
                     StaticTypeKind::Dict)
-                contribute(it->second, A.dict_of(A.str_ty(), ct), bid->start);
+                contribute(it->second, A.dict_of(A.str_ty(), ct), bid->start());
         }
         return;
     }
@@ -2956,18 +3132,18 @@ void Inferencer::accumulate_foreach(ForeachStmt *fe)
 
     if (fe->indexed) {
         /* enumerate-style: first id is the int index, the rest the element */
-        contribute(sym_of(0), A.int_ty(), ids[0]->start);
+        contribute(sym_of(0), A.int_ty(), ids[0]->start());
         StaticTypeRef el = c->kind == StaticTypeKind::Array ? c->elem
                     : c->kind == StaticTypeKind::Str ? A.str_ty()
                     : c->kind == StaticTypeKind::Dict ? c->key : A.dyn_ty();
         for (size_t i = 1; i < ids.size(); i++)
-            contribute(sym_of(i), el, ids[i]->start);
+            contribute(sym_of(i), el, ids[i]->start());
         return;
     }
 
     if (c->kind == StaticTypeKind::Dict && ids.size() >= 2) {
-        contribute(sym_of(0), c->key, ids[0]->start);
-        contribute(sym_of(1), c->val, ids[1]->start);
+        contribute(sym_of(0), c->key, ids[0]->start());
+        contribute(sym_of(1), c->val, ids[1]->start());
         return;
     }
 
@@ -2976,14 +3152,14 @@ void Inferencer::accumulate_foreach(ForeachStmt *fe)
                 : c->kind == StaticTypeKind::Dict ? c->key : A.dyn_ty();
 
     if (ids.size() == 1) {
-        contribute(sym_of(0), el, ids[0]->start);
+        contribute(sym_of(0), el, ids[0]->start());
     } else {
         /* tuple-unpack each element (an array) into the ids */
         StaticTypeRef inner = static_type_resolve(el)->kind ==
             StaticTypeKind::Array
                            ? static_type_resolve(el)->elem : el;
         for (size_t i = 0; i < ids.size(); i++)
-            contribute(sym_of(i), inner, ids[i]->start);
+            contribute(sym_of(i), inner, ids[i]->start());
     }
 }
 
@@ -3031,15 +3207,15 @@ void Inferencer::check_binops(MultiOpConstruct *mo, bool comparison,
 
         if (logical) {
             /* && / || require int operands (verified runtime behaviour) */
-            require_nonopt(left, mo->start, mo->end, "with operator &&/||");
-            require_nonopt(right, rnode->start, rnode->end,
+            require_nonopt(left, mo->start(), mo->end(), "with operator &&/||");
+            require_nonopt(right, rnode->start(), rnode->end(),
                            "with operator &&/||");
         } else if (comparison) {
             Op o = op;
             if (o != Op::eq && o != Op::noteq) {
                 /* ordering: numeric or string only, non-opt */
-                require_nonopt(left, mo->start, mo->end, "in a comparison");
-                require_nonopt(right, rnode->start, rnode->end,
+                require_nonopt(left, mo->start(), mo->end(), "in a comparison");
+                require_nonopt(right, rnode->start(), rnode->end(),
                                "in a comparison");
                 StaticTypeRef l = strip(static_type_resolve(left));
                 StaticTypeRef r = strip(static_type_resolve(right));
@@ -3052,13 +3228,13 @@ void Inferencer::check_binops(MultiOpConstruct *mo, bool comparison,
                             static_type_to_string(left) +
                                      "' with '" + static_type_to_string(right)
                                          + "'",
-                                 mo->start, rnode->end);
+                                 mo->start(), rnode->end());
                 }
             }
         } else if (arith) {
-            require_nonopt(left, mo->start, mo->end,
+            require_nonopt(left, mo->start(), mo->end(),
                            "in an arithmetic operation");
-            require_nonopt(right, rnode->start, rnode->end,
+            require_nonopt(right, rnode->start(), rnode->end(),
                            "in an arithmetic operation");
             StaticTypeRef res = binop_result(op, left, right);
             StaticTypeRef l = strip(static_type_resolve(left)), r =
@@ -3068,7 +3244,7 @@ void Inferencer::check_binops(MultiOpConstruct *mo, bool comparison,
                 mismatch("operator does not apply to '" +
                     static_type_to_string(left) +
                              "' and '" + static_type_to_string(right) + "'",
-                         mo->start, rnode->end);
+                         mo->start(), rnode->end());
             }
         }
         left = binop_result(op, left, right);
@@ -3231,19 +3407,19 @@ bool Inferencer::fold_type_query(CallExpr *call)
     ExprList *args = call->args.get();
     if (args->elems.size() != 1)
         argcount(std::string(fn) + " expects exactly one argument",
-                 call->start, call->end);
+                 call->start(), call->end());
 
     StaticTypeRef t;
     if (is_decltype) {
         auto *argid = dynamic_cast<Identifier *>(args->elems[0].get());
         if (!argid)
             mismatch("decltype expects a variable (an identifier)",
-                     args->elems[0]->start, args->elems[0]->end);
+                     args->elems[0]->start(), args->elems[0]->end());
         auto it = id_sym.find(argid);
         if (it == id_sym.end() || !it->second)
             mismatch("decltype: '" + std::string(argid->uid->val) +
                          "' is not a variable in scope",
-                     argid->start, argid->end);
+                     argid->start(), argid->end());
         t = it->second->type;
     } else {
         t = type_of(args->elems[0].get());
@@ -3332,15 +3508,15 @@ void Inferencer::check(Construct *n)
         Op op = e2->elems[0].first;
         if (op == Op::plus || op == Op::minus) {
             StaticTypeRef t = type_of(e2->elems[0].second.get());
-            require_nonopt(t, n->start, n->end, "with a unary +/-");
+            require_nonopt(t, n->start(), n->end(), "with a unary +/-");
             StaticTypeRef u = strip(static_type_resolve(t));
             if (!is_dyn(u) && !is_unknown(u) && !is_num(u))
                 mismatch("unary +/- needs a number, got '" +
                     static_type_to_string(t) +
-                             "'", n->start, n->end);
+                             "'", n->start(), n->end());
         } else if (op == Op::bnot) {
             StaticTypeRef t = type_of(e2->elems[0].second.get());
-            require_nonopt(t, n->start, n->end, "with a unary ~");
+            require_nonopt(t, n->start(), n->end(), "with a unary ~");
             StaticTypeRef u = strip(static_type_resolve(t));
             /* ~ is int-only (bool promotes); float/str/... is an error */
             if (!is_dyn(u) && !is_unknown(u) &&
@@ -3348,7 +3524,7 @@ void Inferencer::check(Construct *n)
                     StaticTypeKind::Bool)
                 mismatch("unary ~ needs an int, got '" +
                     static_type_to_string(t) +
-                             "'", n->start, n->end);
+                             "'", n->start(), n->end());
         }
         return;
     }
@@ -3357,7 +3533,7 @@ void Inferencer::check(Construct *n)
         check(sub->what.get());
         check(sub->index.get());
         StaticTypeRef w = type_of(sub->what.get());
-        require_nonopt(w, sub->what->start, sub->what->end,
+        require_nonopt(w, sub->what->start(), sub->what->end(),
                        "as a subscript base");
         StaticTypeRef wr = strip(static_type_resolve(w));
         if (!is_dyn(wr) && !is_unknown(wr) && wr->kind !=
@@ -3365,7 +3541,7 @@ void Inferencer::check(Construct *n)
             wr->kind != StaticTypeKind::Dict && wr->kind != StaticTypeKind::Str)
             mismatch("type '" + static_type_to_string(w) +
                 "' is not subscriptable",
-                     sub->what->start, sub->what->end);
+                     sub->what->start(), sub->what->end());
         return;
     }
 
@@ -3374,13 +3550,14 @@ void Inferencer::check(Construct *n)
         check(sl->start_idx.get());
         check(sl->end_idx.get());
         StaticTypeRef w = type_of(sl->what.get());
-        require_nonopt(w, sl->what->start, sl->what->end, "as a slice base");
+        require_nonopt(w, sl->what->start(), sl->what->end(),
+                       "as a slice base");
         StaticTypeRef wr = strip(static_type_resolve(w));
         if (!is_dyn(wr) && !is_unknown(wr) && wr->kind !=
             StaticTypeKind::Array &&
             wr->kind != StaticTypeKind::Str)
             mismatch("type '" + static_type_to_string(w) + "' is not sliceable",
-                     sl->what->start, sl->what->end);
+                     sl->what->start(), sl->what->end());
         return;
     }
 
@@ -3397,11 +3574,11 @@ void Inferencer::check(Construct *n)
                         mismatch("field '" + std::string(mem->memUid->val) +
                                      "' needs an instance of '" +
                                      std::string(def->name->val) + "'",
-                                 mem->start, mem->end);
+                                 mem->start(), mem->end());
                     mismatch("struct '" + std::string(def->name->val) +
                                  "' has no member '" +
                                  std::string(mem->memUid->val) + "'",
-                             mem->start, mem->end);
+                             mem->start(), mem->end());
                 }
                 return;
             }
@@ -3411,7 +3588,7 @@ void Inferencer::check(Construct *n)
         /* `a?.b` deliberately accepts a nullable base (none short-circuits);
          * a plain `a.b` requires a non-opt base. */
         if (!mem->optional)
-            require_nonopt(w, mem->what->start, mem->what->end,
+            require_nonopt(w, mem->what->start(), mem->what->end(),
                            "as a member-access base");
         StaticTypeRef wr = strip(static_type_resolve(w));
 
@@ -3423,14 +3600,14 @@ void Inferencer::check(Construct *n)
                 mismatch("struct '" + std::string(def->name->val) +
                              "' has no member '" +
                              std::string(mem->memUid->val) + "'",
-                         mem->start, mem->end);
+                         mem->start(), mem->end());
             return;
         }
 
         if (!is_dyn(wr) && !is_unknown(wr) && wr->kind != StaticTypeKind::Dict)
             mismatch("type '" + static_type_to_string(w) +
                          "' has no members (only a struct or dict does)",
-                     mem->what->start, mem->what->end);
+                     mem->what->start(), mem->what->end());
         return;
     }
 
@@ -3438,7 +3615,7 @@ void Inferencer::check(Construct *n)
         check(fe->container.get());
         check(fe->body.get());
         StaticTypeRef c = type_of(fe->container.get());
-        require_nonopt(c, fe->container->start, fe->container->end,
+        require_nonopt(c, fe->container->start(), fe->container->end(),
                        "as a foreach container");
         return;
     }
@@ -3453,7 +3630,7 @@ void Inferencer::check(Construct *n)
         if (!id && !dynamic_cast<Subscript *>(opnd)
                 && !dynamic_cast<MemberExpr *>(opnd)) {
             mismatch("'++'/'--' needs a variable, array element, or field",
-                     idc->start, idc->end);
+                     idc->start(), idc->end());
             return;
         }
 
@@ -3461,11 +3638,11 @@ void Inferencer::check(Construct *n)
         if (id) {
             auto it = id_sym.find(id);
             if (it != id_sym.end() && it->second && it->second->const_decl)
-                mismatch("cannot '++'/'--' a const", idc->start, idc->end);
+                mismatch("cannot '++'/'--' a const", idc->start(), idc->end());
         }
 
         StaticTypeRef t = type_of(opnd);
-        require_nonopt(t, opnd->start, opnd->end, "with '++'/'--'");
+        require_nonopt(t, opnd->start(), opnd->end(), "with '++'/'--'");
 
         /* int or float ONLY (bool / str / array / ... are rejected); a `dyn`
          * operand defers the check to runtime. */
@@ -3475,7 +3652,7 @@ void Inferencer::check(Construct *n)
                     StaticTypeKind::Float)
             mismatch("'++'/'--' requires an int or float, got '" +
                          static_type_to_string(t) + "'",
-                     opnd->start, opnd->end);
+                     opnd->start(), opnd->end());
         return;
     }
 
@@ -3502,7 +3679,7 @@ void Inferencer::check(Construct *n)
                                         "' is declared '" +
                                             static_type_to_string(d) +
                                         "' and cannot be none",
-                                    e14->start, e14->end);
+                                    e14->start(), e14->end());
                 }
             }
         }
@@ -3511,9 +3688,9 @@ void Inferencer::check(Construct *n)
             /* compound assign: validate the implied binary op */
             StaticTypeRef l = type_of(e14->lvalue.get());
             StaticTypeRef r = type_of(e14->rvalue.get());
-            require_nonopt(l, e14->lvalue->start, e14->lvalue->end,
+            require_nonopt(l, e14->lvalue->start(), e14->lvalue->end(),
                            "in a compound assignment");
-            require_nonopt(r, e14->rvalue->start, e14->rvalue->end,
+            require_nonopt(r, e14->rvalue->start(), e14->rvalue->end(),
                            "in a compound assignment");
             StaticTypeRef res = binop_result(compound_binop(e14->op), l, r);
             StaticTypeRef ls = strip(static_type_resolve(l)), rs =
@@ -3522,7 +3699,7 @@ void Inferencer::check(Construct *n)
                 mismatch("operator does not apply to '" +
                     static_type_to_string(l) +
                              "' and '" + static_type_to_string(r) + "'",
-                         e14->start, e14->end);
+                         e14->start(), e14->end());
         }
         return;
     }
@@ -3538,7 +3715,7 @@ void Inferencer::check(Construct *n)
                 StaticTypeKind::None)
             mismatch("can only throw a struct instance, got '" +
                          static_type_to_string(type_of(th->elem.get())) + "'",
-                     th->elem->start, th->elem->end);
+                     th->elem->start(), th->elem->end());
         return;
     }
 
@@ -3568,7 +3745,7 @@ void Inferencer::check_struct_construction(CallExpr *call,
             : std::to_string(min_args) + " to " + std::to_string(nfields);
         argcount("struct '" + std::string(def->name->val) + "' expects " +
                      want + " field value(s), got " + std::to_string(nargs),
-                 call->start, call->end);
+                 call->start(), call->end());
     }
 
     for (size_t i = 0; i < nargs && i < nfields; i++) {
@@ -3578,7 +3755,7 @@ void Inferencer::check_struct_construction(CallExpr *call,
         if (!fd.is_opt && is_optish(at))
             nullability("field '" + std::string(fd.name->val) +
                             "' is not 'opt' but the value may be none",
-                        args->elems[i]->start, args->elems[i]->end);
+                        args->elems[i]->start(), args->elems[i]->end());
 
         if (fd.kind == FieldKind::f_dyn || is_dyn(at))
             continue;
@@ -3589,7 +3766,7 @@ void Inferencer::check_struct_construction(CallExpr *call,
             mismatch("field '" + std::string(fd.name->val) + "' expects '" +
                          static_type_to_string(ft) + "' but got '" +
                          static_type_to_string(at) + "'",
-                     args->elems[i]->start, args->elems[i]->end);
+                     args->elems[i]->start(), args->elems[i]->end());
     }
 }
 
@@ -3640,7 +3817,7 @@ void Inferencer::check_call(CallExpr *call)
             mismatch("'" + std::string(cid->uid->val) +
                          "' is not callable (type '" +
                              static_type_to_string(s->type) +
-                         "')", call->what->start, call->what->end);
+                         "')", call->what->start(), call->what->end());
         } else {
             return;                       /* unresolved -> dyn (Q4) */
         }
@@ -3653,8 +3830,8 @@ void Inferencer::check_call(CallExpr *call)
             callable_known = true;
         } else {
             mismatch("expression of type '" + static_type_to_string(ct) +
-                         "' is not callable", call->what->start,
-                     call->what->end);
+                         "' is not callable", call->what->start(),
+                     call->what->end());
         }
     }
 
@@ -3686,7 +3863,7 @@ void Inferencer::check_call(CallExpr *call)
             : std::to_string(min_args) + " to " + std::to_string(nparams);
         argcount("function expects " + want + " argument(s), got " +
                      std::to_string(nargs),
-                 call->start, call->end);
+                 call->start(), call->end());
     }
 
     if (template_call)
@@ -3723,7 +3900,7 @@ void Inferencer::check_call(CallExpr *call)
             else
                 nullability("argument " + std::to_string(i + 1) +
                                 " may be none but the parameter is not 'opt'",
-                            anode->start, anode->end);
+                            anode->start(), anode->end());
         }
 
         /* TYPE check: a dyn parameter or a dyn argument accepts any type (the
@@ -3737,7 +3914,7 @@ void Inferencer::check_call(CallExpr *call)
                          static_type_to_string(at) +
                              "' but the parameter is '" +
                          static_type_to_string(ptype) + "'",
-                     anode->start, anode->end);
+                     anode->start(), anode->end());
     }
 }
 
@@ -3764,8 +3941,8 @@ make_typed(TypedScalarExpr::Cat cat, TypeHint kind, TypeHint result_th,
            MultiOpConstruct *mo)
 {
     auto t = std::make_unique<TypedScalarExpr>(cat, kind);
-    t->start = mo->start;
-    t->end = mo->end;
+    t->start() = mo->start();
+    t->end() = mo->end();
     t->is_const = mo->is_const;
     t->th = result_th;
     t->elems = std::move(mo->elems);
@@ -3843,6 +4020,22 @@ static unique_ptr<Construct> try_specialize(unique_ptr<Construct> n)
 
 static unique_ptr<Construct> specialize(unique_ptr<Construct> n);
 
+/*
+ * Bounds-check elision state (see try_range_subscript). `g_spec_fsize` is the
+ * size of the frame the code being specialized runs in - the root Block's
+ * slot_count or a resolved function's frame_size, null where there is none -
+ * so a loop guard can take a fresh slot. `g_bce_loops` holds the enclosing
+ * ForRangeStmts (innermost last) whose body is being specialized.
+ */
+struct BceLoop {
+    ForRangeStmt *fr;
+    bool enabled;                   /* the body never shrinks an array */
+    std::unordered_set<int> written;    /* local slots the body rebinds */
+};
+
+static int *g_spec_fsize = nullptr;
+static std::vector<BceLoop> g_bce_loops;
+
 /* Recurse into every unique_ptr<Construct> child, specializing it in place. */
 static void specialize_children(Construct *n)
 {
@@ -3908,7 +4101,14 @@ static void specialize_children(Construct *n)
         return;
     }
     if (auto *fd = dynamic_cast<FuncDeclStmt *>(n)) {
+        /* a new frame: no enclosing loop's guard is visible in there */
+        int *const saved_fsize = g_spec_fsize;
+        std::vector<BceLoop> saved_loops;
+        saved_loops.swap(g_bce_loops);
+        g_spec_fsize = fd->resolved ? &fd->frame_size : nullptr;
         if (fd->body) fd->body = specialize(std::move(fd->body));
+        g_spec_fsize = saved_fsize;
+        g_bce_loops.swap(saved_loops);
         return;
     }
     if (auto *ld = dynamic_cast<LiteralDict *>(n)) {
@@ -3961,7 +4161,7 @@ static const UniqueId *fr_base_id(const Construct *lv)
 static bool fr_is_const_builtin(const Construct *callee)
 {
     auto *id = dynamic_cast<const Identifier *>(callee);
-    return id && EvalContext::const_builtins.count(id->uid) != 0;
+    return id && is_const_builtin(id->uid);
 }
 
 /* The set of effectively-pure USER functions in the program being specialized
@@ -4137,6 +4337,123 @@ static bool fr_immutable(
     return false;
 }
 
+/* An int-valued bound/step. A literal the resolver folded in after inference
+ * (e.g. `i < n` with `n` auto-const) carries no hint but is an int all the
+ * same; it is accepted only under --parallel-loops, so a top-level loop over
+ * a const bound can go parallel without changing what a normal run
+ * specializes. */
+static bool fr_is_int(const Construct *e)
+{
+    return e->th == TypeHint::i ||
+           (g_parallel_loops && dynamic_cast<const LiteralInt *>(e));
+}
+
+/* ---------------- bounds-check elision (RangeSubscript) ------------------ */
+
+static void bce_add_ids(const Construct *lv, std::unordered_set<int> &written)
+{
+    if (auto *id = dynamic_cast<const Identifier *>(lv)) {
+        if (id->sym.kind == SymKind::local)
+            written.insert(id->sym.slot);
+    } else if (auto *il = dynamic_cast<const IdList *>(lv)) {
+        for (auto &e : il->elems)
+            bce_add_ids(e.get(), written);
+    }
+}
+
+/*
+ * Scan a ForRangeStmt body: collect the local slots it (re)binds - an
+ * assignment, a declaration, `++`/`--`, a foreach or catch var - into
+ * `written`, and return false if it may SHRINK an array some other way: a
+ * pop()/erase() (through any alias), or a call that can run arbitrary code
+ * (an impure or indirect callee, a callback-taking builtin). Growth and
+ * element writes are fine - the guard only needs every array to stay at least
+ * as long as it was on loop entry. Nested functions are not entered.
+ */
+static bool bce_scan(Construct *c, std::unordered_set<int> &written)
+{
+    if (!c || dynamic_cast<FuncDeclStmt *>(c))
+        return true;
+
+    if (auto *e = dynamic_cast<Expr14 *>(c)) {
+        bce_add_ids(e->lvalue.get(), written);
+    } else if (auto *idc = dynamic_cast<IncDecExpr *>(c)) {
+        bce_add_ids(idc->lvalue.get(), written);
+    } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
+        bce_add_ids(fe->ids.get(), written);
+    } else if (auto *t = dynamic_cast<TryCatchStmt *>(c)) {
+        for (auto &cs : t->catchStmts)
+            bce_add_ids(cs.first.asId.get(), written);
+    } else if (auto *ce = dynamic_cast<CallExpr *>(c)) {
+        auto *callee = dynamic_cast<const Identifier *>(ce->what.get());
+        if (!callee)
+            return false;
+        const size_t nargs = ce->args ? ce->args->elems.size() : 0;
+        if (callee->sym.kind == SymKind::builtin) {
+            const std::string_view n = callee->uid->val;
+            if (n == "pop" || n == "erase" || builtin_runs_user_code(n, nargs))
+                return false;
+        } else if (!fr_is_pure_func(callee)) {
+            return false;
+        }
+    }
+
+    bool ok = true;
+    Inferencer::for_each_child(c, [&](Construct *ch) {
+        if (ok && !bce_scan(ch, written))
+            ok = false;
+    });
+    return ok;
+}
+
+/*
+ * `arr[i]` directly inside the body of a ForRangeStmt over `i`, with `arr` a
+ * slotted local the body never rebinds and the body unable to shrink any
+ * array: rewrite it to a RangeSubscript tied to that loop's guard slot
+ * (allocated on first use) and record `arr` for the loop's entry check. The
+ * innermost loop over `i` decides, so `a[i]` under a nested loop over `j`
+ * still belongs to the outer one.
+ */
+static unique_ptr<Construct> try_range_subscript(unique_ptr<Construct> n)
+{
+    auto *sub = dynamic_cast<Subscript *>(n.get());
+    if (!sub || sub->in_range || !g_spec_fsize)
+        return n;
+
+    auto *arr = dynamic_cast<Identifier *>(sub->what.get());
+    auto *idx = dynamic_cast<Identifier *>(sub->index.get());
+    if (!arr || !idx ||
+        arr->sym.kind != SymKind::local || idx->sym.kind != SymKind::local)
+        return n;
+
+    for (auto it = g_bce_loops.rbegin(); it != g_bce_loops.rend(); ++it) {
+
+        ForRangeStmt *fr = it->fr;
+        if (fr->i_slot != idx->sym.slot)
+            continue;
+        if (!it->enabled || it->written.count(arr->sym.slot))
+            return n;
+
+        if (fr->bce_slot < 0)
+            fr->bce_slot = (*g_spec_fsize)++;
+        if (std::find(fr->bce_arrays.begin(), fr->bce_arrays.end(),
+                      arr->sym.slot) == fr->bce_arrays.end())
+            fr->bce_arrays.push_back(arr->sym.slot);
+
+        auto rs = make_unique<RangeSubscript>();
+        rs->start() = sub->start();
+        rs->end() = sub->end();
+        rs->th = sub->th;
+        rs->arr_slot = arr->sym.slot;
+        rs->i_slot = fr->i_slot;
+        rs->guard_slot = fr->bce_slot;
+        rs->what = std::move(sub->what);
+        rs->index = std::move(sub->index);
+        return rs;
+    }
+    return n;
+}
+
 /*
  * If `n` is one of the two specializable counted-`for` forms, return an
  * equivalent ForRangeStmt (its kept sub-trees specialized); else return `n`
@@ -4172,7 +4489,7 @@ static unique_ptr<Construct> try_for_range(unique_ptr<Construct> n)
     else if (cmp_op == Op::ge || cmp_op == Op::gt) cmp_asc = false;
     else return n;
     Construct *bound = cond->elems[1].second.get();
-    if (bound->th != TypeHint::i)
+    if (!fr_is_int(bound))
         return n;
 
     /* inc: `i += step` / `i++` (asc) or `i -= step` / `i--` (desc) */
@@ -4194,7 +4511,7 @@ static unique_ptr<Construct> try_for_range(unique_ptr<Construct> n)
         else if (inc14->op == Op::subeq)  inc_asc = false;
         else return n;
         step = inc14->rvalue.get();
-        if (step->th != TypeHint::i)
+        if (!fr_is_int(step))
             return n;
     } else {
         return n;
@@ -4216,19 +4533,34 @@ static unique_ptr<Construct> try_for_range(unique_ptr<Construct> n)
     /* Build the ForRangeStmt; specialize the kept sub-trees (the body is the
      * hot part - M8 still applies inside it). */
     auto fr = make_unique<ForRangeStmt>();
-    fr->start = f->start;
-    fr->end = f->end;
+    fr->start() = f->start();
+    fr->end() = f->end();
     fr->i_slot = i_slot;
     fr->cmp_op = cmp_op;
     fr->bound = specialize(std::move(cond->elems[1].second));
     if (step)
         fr->step = specialize(std::move(inc14->rvalue));
     fr->init = specialize(std::move(f->init));
+
+    /* the body's `arr[i]` reads/stores may drop their bounds checks (see
+     * try_range_subscript); `i` itself must never be rebound in there */
+    BceLoop bl{ fr.get(), true, {} };
+    bl.enabled = bce_scan(f->body.get(), bl.written) &&
+                 !bl.written.count(i_slot);
+    g_bce_loops.push_back(std::move(bl));
     fr->body = specialize(std::move(f->body));
+    g_bce_loops.pop_back();
+
+    if (fr->bce_slot >= 0)
+        TRACE(specialize, 0, "for at line " + std::to_string(fr->start().line) +
+              "  bounds checks elided for " +
+              std::to_string(fr->bce_arrays.size()) + " array(s)");
+
+    fr->hoisted = std::move(f->hoisted);
 
     /* -a/--analyze: green the `for` keyword of a specialized counted loop. */
     if (g_specialize_analyze)
-        g_specialize_analyze->mark(fr->start, 3, AnnoKind::counted_for);
+        g_specialize_analyze->mark(fr->start(), 3, AnnoKind::counted_for);
 
     return fr;
 }
@@ -4245,9 +4577,346 @@ static unique_ptr<Construct> specialize(unique_ptr<Construct> n)
             return n;     /* matched: sub-trees already specialized */
     }
     specialize_children(n.get());     /* bottom-up: children first */
+    if (!g_bce_loops.empty() && n->is_subscript())
+        return try_range_subscript(std::move(n));
     return try_specialize(std::move(n));
 }
 
+/* ---------------- parallel-safe callbacks (FuncDeclStmt::par_safe) -------- */
+
+/* A proven scalar (int/float) - by value, no refcounted payload. */
+static bool par_scalar(const Construct *e)
+{
+    return e->th == TypeHint::i || e->th == TypeHint::f;
+}
+
+/*
+ * True if evaluating `n` (part of a function body) on a worker thread is
+ * race-free given scalar arguments: it may only read/write the function's own
+ * frame slots and build scalars, never copy (refcount-bump) a value another
+ * thread can reach - a string literal, a global, a capture, a FuncObject. A
+ * deliberately small WHITELIST: anything not listed (a user call, a subscript,
+ * a nested func, try/throw, foreach, ...) makes the function sequential-only.
+ */
+static bool par_safe_node(const Construct *n)
+{
+    if (!n)
+        return true;
+
+    if (dynamic_cast<const LiteralInt *>(n) ||
+        dynamic_cast<const LiteralFloat *>(n) ||
+        dynamic_cast<const LiteralBool *>(n) ||
+        dynamic_cast<const LiteralNone *>(n) ||
+        dynamic_cast<const NopConstruct *>(n) ||
+        dynamic_cast<const BreakStmt *>(n) ||
+        dynamic_cast<const ContinueStmt *>(n))
+        return true;
+
+    if (auto *id = dynamic_cast<const Identifier *>(n)) {
+        /* a builtin read as a VALUE must be a numeric constant (math_pi) */
+        if (id->sym.kind == SymKind::builtin)
+            return fr_is_const_builtin(id) && par_scalar(id);
+        return id->sym.kind == SymKind::local;
+    }
+
+    if (auto *ce = dynamic_cast<const CallExpr *>(n)) {
+        /* only a CONST builtin with a proven-scalar result (abs, sqrt, len,
+         * ...): a fresh scalar out, nothing shared touched. */
+        auto *callee = dynamic_cast<const Identifier *>(ce->what.get());
+        if (!callee || callee->sym.kind != SymKind::builtin ||
+            !fr_is_const_builtin(callee) || !par_scalar(ce) ||
+            builtin_runs_user_code(callee->uid->val, ce->args
+                                   ? ce->args->elems.size() : 0))
+            return false;
+        if (ce->args)
+            for (const auto &a : ce->args->elems)
+                if (!par_safe_node(a.get()))
+                    return false;
+        return true;
+    }
+
+    if (auto *e = dynamic_cast<const Expr14 *>(n))
+        return dynamic_cast<const Identifier *>(e->lvalue.get()) &&
+               par_safe_node(e->lvalue.get()) && par_safe_node(e->rvalue.get());
+
+    if (auto *idc = dynamic_cast<const IncDecExpr *>(n))
+        return dynamic_cast<const Identifier *>(idc->lvalue.get()) &&
+               par_safe_node(idc->lvalue.get());
+
+    /* not a MultiOpConstruct, so for_each_child doesn't see its operands */
+    if (auto *ts = dynamic_cast<const TypedScalarExpr *>(n)) {
+        for (const auto &pr : ts->elems)
+            if (!par_safe_node(pr.second.get()))
+                return false;
+        return true;
+    }
+
+    const bool structural =
+        dynamic_cast<const InlinedCallExpr *>(n) ||
+        dynamic_cast<const HoistedExpr *>(n) ||  /* a slot of the call's frame */
+        dynamic_cast<const MultiOpConstruct *>(n) ||    /* Expr01..Expr12 */
+        dynamic_cast<const TernaryExpr *>(n) ||
+        dynamic_cast<const IfStmt *>(n) ||
+        dynamic_cast<const Block *>(n) ||
+        dynamic_cast<const ReturnStmt *>(n) ||
+        dynamic_cast<const WhileStmt *>(n) ||
+        dynamic_cast<const ForStmt *>(n) ||
+        dynamic_cast<const ForRangeStmt *>(n);
+    if (!structural)
+        return false;
+
+    bool ok = true;
+    Inferencer::for_each_child(const_cast<Construct *>(n), [&](Construct *c) {
+        if (ok && !par_safe_node(c))
+            ok = false;
+    });
+    return ok;
+}
+
+/* Set FuncDeclStmt::par_safe on every function in the tree (nested too). */
+static void mark_par_safe(Construct *c)
+{
+    if (!c)
+        return;
+    if (auto *fd = dynamic_cast<FuncDeclStmt *>(c)) {
+        fd->par_safe = fd->resolved && fd->body &&
+                       (fd->effective_pure || fd->explicit_pure) &&
+                       (!fd->captures || fd->captures->elems.empty()) &&
+                       par_safe_node(fd->body.get());
+    }
+    Inferencer::for_each_child(c, mark_par_safe);
+}
+
+/* ---------------- parallel counted loops (--parallel-loops) ---------------- */
+
+/*
+ * What a candidate ForRangeStmt body touches, collected while proving it
+ * iteration-independent (par_loop_node). Slots are frame slots of the
+ * enclosing function (or main); `decls` are the locals the body itself
+ * declares - each worker has a private copy of them.
+ */
+struct ParLoopInfo {
+    int i_slot;
+    std::unordered_set<int> decls;
+    std::vector<int> stores;          /* `X[i] = ...` targets */
+    std::vector<int> reads;           /* `X[idx]` read bases */
+    std::vector<int> own_reads;       /* `X[i]` read bases (own element) */
+    std::vector<int> calls;           /* DirectCallExpr global slots */
+};
+
+static void par_loop_decls(Construct *c, std::unordered_set<int> &decls)
+{
+    if (!c)
+        return;
+    if (auto *e = dynamic_cast<Expr14 *>(c))
+        if (e->fl & pFlags::pInDecl)
+            if (auto *id = dynamic_cast<Identifier *>(e->lvalue.get()))
+                if (id->sym.kind == SymKind::local)
+                    decls.insert(id->sym.slot);
+    Inferencer::for_each_child(c, [&](Construct *ch) {
+        par_loop_decls(ch, decls);
+    });
+}
+
+static bool par_is_i(const Construct *e, int i_slot)
+{
+    auto *id = dynamic_cast<const Identifier *>(e);
+    return id && id->sym.kind == SymKind::local && id->sym.slot == i_slot;
+}
+
+/* A local array base `X` of `X[...]`, declared outside the body. */
+static const Identifier *par_outer_array(const Construct *e,
+                                         const ParLoopInfo &li)
+{
+    auto *id = dynamic_cast<const Identifier *>(e);
+    if (!id || id->sym.kind != SymKind::local ||
+        id->sym.slot == li.i_slot || li.decls.count(id->sym.slot))
+        return nullptr;
+    return id;
+}
+
+/*
+ * Can `n` (in a candidate loop body) run on a worker with its own Frame copy?
+ * Like par_safe_node (every value read or built is a scalar, so no refcount
+ * is ever touched off the main thread), plus: a flat array may be read at any
+ * index and stored to at the loop var's index only, assignments may target
+ * only the body's own locals, and a user call must be a direct call (checked
+ * for par_safe at run time). `depth` counts nested loops (a `break` at depth
+ * 0 would cut the iteration space short) and `inl` inlined bodies (whose
+ * `return` is their own boundary).
+ */
+static bool par_loop_node(const Construct *n, ParLoopInfo &li,
+                          int depth, int inl)
+{
+    if (!n)
+        return true;
+
+    if (dynamic_cast<const LiteralInt *>(n) ||
+        dynamic_cast<const LiteralFloat *>(n) ||
+        dynamic_cast<const LiteralBool *>(n) ||
+        dynamic_cast<const LiteralNone *>(n) ||
+        dynamic_cast<const NopConstruct *>(n) ||
+        dynamic_cast<const ContinueStmt *>(n))
+        return true;
+
+    if (dynamic_cast<const BreakStmt *>(n))
+        return depth > 0;
+
+    if (auto *r = dynamic_cast<const ReturnStmt *>(n))
+        return inl > 0 && par_loop_node(r->elem.get(), li, depth, inl);
+
+    if (auto *id = dynamic_cast<const Identifier *>(n)) {
+        if (!par_scalar(id))
+            return false;
+        if (id->sym.kind == SymKind::builtin)
+            return fr_is_const_builtin(id);
+        return id->sym.kind == SymKind::local ||
+               id->sym.kind == SymKind::global;
+    }
+
+    if (auto *sub = dynamic_cast<const Subscript *>(n)) {
+        const Identifier *b = par_outer_array(sub->what.get(), li);
+        if (!b || !par_scalar(sub) || !par_scalar(sub->index.get()) ||
+            !par_loop_node(sub->index.get(), li, depth, inl))
+            return false;
+        (par_is_i(sub->index.get(), li.i_slot) ? li.own_reads : li.reads)
+            .push_back(b->sym.slot);
+        return true;
+    }
+
+    if (auto *ce = dynamic_cast<const CallExpr *>(n)) {
+        if (!par_scalar(ce))
+            return false;
+        auto *callee = dynamic_cast<const Identifier *>(ce->what.get());
+        if (!callee)
+            return false;
+        if (callee->sym.kind == SymKind::builtin) {
+            if (!fr_is_const_builtin(callee) ||
+                builtin_runs_user_code(callee->uid->val, ce->args
+                                       ? ce->args->elems.size() : 0))
+                return false;
+        } else if (dynamic_cast<const DirectCallExpr *>(ce) &&
+                   !dynamic_cast<const CachedCallExpr *>(ce)) {
+            li.calls.push_back(ce->direct_func_slot);
+        } else {
+            return false;
+        }
+        if (ce->args)
+            for (const auto &a : ce->args->elems)
+                if (!par_scalar(a.get()) ||
+                    !par_loop_node(a.get(), li, depth, inl))
+                    return false;
+        return true;
+    }
+
+    if (auto *e = dynamic_cast<const Expr14 *>(n)) {
+        if (!par_scalar(e->rvalue.get()) ||
+            !par_loop_node(e->rvalue.get(), li, depth, inl))
+            return false;
+        if (auto *id = dynamic_cast<const Identifier *>(e->lvalue.get()))
+            return id->sym.kind == SymKind::local &&
+                   li.decls.count(id->sym.slot);
+        if (auto *sub = dynamic_cast<const Subscript *>(e->lvalue.get())) {
+            const Identifier *b = par_outer_array(sub->what.get(), li);
+            if (!b || !par_is_i(sub->index.get(), li.i_slot))
+                return false;
+            li.stores.push_back(b->sym.slot);
+            return true;
+        }
+        return false;
+    }
+
+    if (auto *idc = dynamic_cast<const IncDecExpr *>(n)) {
+        auto *id = dynamic_cast<const Identifier *>(idc->lvalue.get());
+        return id && id->sym.kind == SymKind::local &&
+               li.decls.count(id->sym.slot);
+    }
+
+    if (auto *ts = dynamic_cast<const TypedScalarExpr *>(n)) {
+        for (const auto &pr : ts->elems)
+            if (!par_loop_node(pr.second.get(), li, depth, inl))
+                return false;
+        return true;
+    }
+
+    const bool loop =
+        dynamic_cast<const WhileStmt *>(n) ||
+        dynamic_cast<const ForStmt *>(n) ||
+        dynamic_cast<const ForRangeStmt *>(n);
+    const bool inlined = dynamic_cast<const InlinedCallExpr *>(n) != nullptr;
+
+    const bool structural =
+        loop || inlined ||
+        dynamic_cast<const HoistedExpr *>(n) ||   /* slot in the worker's frame */
+        dynamic_cast<const Expr01 *>(n) ||
+        dynamic_cast<const MultiOpConstruct *>(n) ||    /* Expr02..Expr12 */
+        dynamic_cast<const TernaryExpr *>(n) ||
+        dynamic_cast<const IfStmt *>(n) ||
+        dynamic_cast<const Block *>(n);
+    if (!structural)
+        return false;
+
+    bool ok = true;
+    Inferencer::for_each_child(const_cast<Construct *>(n), [&](Construct *c) {
+        if (ok && !par_loop_node(c, li, depth + loop, inl + inlined))
+            ok = false;
+    });
+    return ok;
+}
+
+/*
+ * Mark every ForRangeStmt whose iterations are independent (see
+ * ForRangeStmt::parallel). A loop qualifies when its body stores to at least
+ * one `X[i]`, and no stored-to array is read at any index but `i` (a
+ * cross-iteration dependency). Aliasing between two local names is left to the
+ * runtime check; an inner loop of a parallel one is not marked (it already
+ * runs inside a worker).
+ */
+static void mark_parallel_loops(Construct *c)
+{
+    if (!c)
+        return;
+
+    auto *fr = dynamic_cast<ForRangeStmt *>(c);
+    if (!fr) {
+        Inferencer::for_each_child(c, mark_parallel_loops);
+        return;
+    }
+
+    ParLoopInfo li;
+    li.i_slot = fr->i_slot;
+    par_loop_decls(fr->body.get(), li.decls);
+
+    bool ok = par_loop_node(fr->body.get(), li, 0, 0) && !li.stores.empty();
+
+    for (int s : li.reads)
+        if (std::find(li.stores.begin(), li.stores.end(), s) != li.stores.end())
+            ok = false;
+
+    if (!ok) {
+        Inferencer::for_each_child(c, mark_parallel_loops);
+        return;
+    }
+
+    const auto uniq = [](std::vector<int> &v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    };
+    uniq(li.stores);
+    uniq(li.reads);
+    uniq(li.own_reads);
+    uniq(li.calls);
+
+    fr->parallel = true;
+    fr->par_stores = move(li.stores);
+    fr->par_reads = move(li.reads);
+    fr->par_own = move(li.own_reads);
+    fr->par_calls = move(li.calls);
+
+    TRACE(specialize, 0, "for at line " + std::to_string(fr->start().line) +
+          "  independent iterations -> parallel loop");
+}
+
 }  /* anonymous namespace */
 
 void infer_types(Construct *root, bool enable, bool strict)
@@ -4295,7 +4964,7 @@ void Inferencer::collect_arrays(AnalysisInfo &out)
         else
             continue;   /* a general but non-dynamic array: leave default */
 
-        out.mark(id->start, static_cast<int>(id->get_str().length()), k);
+        out.mark(id->start(), static_cast<int>(id->get_str().length()), k);
     }
 }
 
@@ -4353,8 +5022,16 @@ void specialize_types(Construct *root, bool enable, EvalContext *prior_scope,
         }
     }
 
+    g_spec_fsize = &blk->slot_count;
     for (auto &e : blk->elems)
         e = specialize(std::move(e));
+    g_spec_fsize = nullptr;
+
+    /* on the final (specialized) tree: which callbacks may run in parallel,
+     * and (opt-in) which counted loops */
+    mark_par_safe(root);
+    if (g_parallel_loops)
+        mark_parallel_loops(root);
 
     g_fr_pure.clear();
     g_specialize_analyze = nullptr;
@@ -30,6 +30,12 @@ struct AnalysisInfo;
  */
 void infer_types(Construct *root, bool enable = true, bool strict = true);
 
+/*
+ * Make the fixpoint walk every unit every round instead of replaying the
+ * clean ones: the reference the worklist is checked against (the unit tests).
+ */
+extern bool g_fixpoint_walk_all;
+
 /*
  * --debug-ti: run inference (non-strict) and dump every declared identifier's
  * inferred type + use sites (machine-readable, tab-separated) to `os`. Used to
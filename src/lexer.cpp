@@ -3,7 +3,7 @@
 #include "errors.h"
 #include "lexer.h"
 
-#include <map>
+#include <array>
 #include <vector>
 #include <cctype>
 
@@ -12,22 +12,30 @@ const Tok invalid_tok;
 using std::string;
 using std::string_view;
 
-static const std::map<string, Op, std::less<>> operators = [] {
-
-    std::map<string, Op, std::less<>> ret;
-
-    for (size_t i = 1; i < OpString.size(); i++)
-        ret.emplace(OpString[i], (Op)i);
+/*
+ * Keywords: a perfect hash on (length, first char, last char). The table is
+ * filled from KwString at startup, and the ML_CHECK there fails if a new
+ * keyword collides (then pick other multipliers or a bigger table). A lookup
+ * is the hash plus one string compare, for every identifier the lexer sees.
+ */
+static constexpr size_t kw_hash_size = 64;
 
-    return ret;
-}();
+static inline size_t kw_hash(string_view s)
+{
+    return (s.size() + 19 * static_cast<unsigned char>(s.front()) +
+            17 * static_cast<unsigned char>(s.back())) & (kw_hash_size - 1);
+}
 
-static const std::map<string, Keyword, std::less<>> keywords = [] {
+static const std::array<Keyword, kw_hash_size> kw_table = [] {
 
-    std::map<string, Keyword, std::less<>> ret;
+    std::array<Keyword, kw_hash_size> ret;
+    ret.fill(Keyword::kw_invalid);
 
-    for (size_t i = 1; i < KwString.size(); i++)
-        ret.emplace(KwString[i], (Keyword)i);
+    for (size_t i = 1; i < KwString.size(); i++) {
+        const size_t h = kw_hash(KwString[i]);
+        ML_CHECK_MSG(ret[h] == Keyword::kw_invalid, "keyword hash collision");
+        ret[h] = (Keyword)i;
+    }
 
     return ret;
 }();
@@ -36,36 +44,123 @@ static Keyword get_keyword(string_view val)
 {
     if (!val.empty()) {
 
-        auto it = keywords.find(val);
+        const Keyword kw = kw_table[kw_hash(val)];
 
-        if (it != keywords.end())
-            return it->second;
+        if (kw != Keyword::kw_invalid && KwString[(int)kw] == val)
+            return kw;
     }
 
     return Keyword::kw_invalid;
 }
 
-static Op get_op_type(string_view val)
+/* Does `c` start an operator? (Every multi-char operator starts with a
+ * single-char one, see match_op.) */
+static inline bool is_op_char(char c)
 {
-    if (!val.empty()) {
-
-        auto it = operators.find(val);
-
-        if (it != operators.end())
-            return it->second;
+    switch (c) {
+        case '+': case '-': case '*': case '/': case '%':
+        case '(': case ')': case '[': case ']': case '{': case '}':
+        case '<': case '>': case '=': case '!': case '&': case '|':
+        case '^': case '~': case ';': case ',': case ':': case '.':
+        case '?':
+            return true;
+        default:
+            return false;
     }
-
-    return Op::invalid;
 }
 
-inline bool is_operator(string_view s)
+/*
+ * The operator at the start of `s` (non-empty, s[0] an operator char), by
+ * maximal munch: `>>>` before `>>` before `>`. `len` gets its length.
+ */
+static Op match_op(string_view s, size_t &len)
 {
-    return get_op_type(s) != Op::invalid;
-}
+    const char c1 = s.size() > 1 ? s[1] : '\0';
+    len = 2;
+
+    switch (s[0]) {
+
+        case '+':
+            if (c1 == '=') return Op::addeq;
+            if (c1 == '+') return Op::inc;
+            len = 1; return Op::plus;
+
+        case '-':
+            if (c1 == '=') return Op::subeq;
+            if (c1 == '-') return Op::dec;
+            len = 1; return Op::minus;
+
+        case '*':
+            if (c1 == '=') return Op::muleq;
+            len = 1; return Op::times;
+
+        case '/':
+            if (c1 == '=') return Op::diveq;
+            len = 1; return Op::div;
+
+        case '%':
+            if (c1 == '=') return Op::modeq;
+            len = 1; return Op::mod;
+
+        case '<':
+            if (c1 == '=') return Op::le;
+            if (c1 == '<') return Op::shl;
+            len = 1; return Op::lt;
+
+        case '>':
+            if (c1 == '=') return Op::ge;
+            if (c1 == '>') {
+                if (s.size() > 2 && s[2] == '>') {
+                    len = 3;
+                    return Op::ushr;
+                }
+                return Op::shr;
+            }
+            len = 1; return Op::gt;
 
-inline bool is_keyword(string_view s)
-{
-    return get_keyword(s) != Keyword::kw_invalid;
+        case '=':
+            if (c1 == '=') return Op::eq;
+            if (c1 == '>') return Op::arrow;
+            len = 1; return Op::assign;
+
+        case '!':
+            if (c1 == '=') return Op::noteq;
+            len = 1; return Op::lnot;
+
+        case '&':
+            if (c1 == '&') return Op::land;
+            len = 1; return Op::band;
+
+        case '|':
+            if (c1 == '|') return Op::lor;
+            len = 1; return Op::bor;
+
+        case '?':
+            if (c1 == '?') return Op::coalesce;
+            if (c1 == '.') return Op::qmdot;
+            len = 1; return Op::questionmark;
+
+        default:
+            break;
+    }
+
+    len = 1;
+
+    switch (s[0]) {
+        case '(': return Op::parenL;
+        case ')': return Op::parenR;
+        case '[': return Op::bracketL;
+        case ']': return Op::bracketR;
+        case '{': return Op::braceL;
+        case '}': return Op::braceR;
+        case '^': return Op::bxor;
+        case '~': return Op::bnot;
+        case ';': return Op::semicolon;
+        case ',': return Op::comma;
+        case ':': return Op::colon;
+        case '.': return Op::dot;
+        default:  return Op::invalid;
+    }
 }
 
 ostream &operator<<(ostream &s, TokType t)
@@ -242,41 +337,22 @@ lexer_ctx::handle_space_or_op()
      * operator's second char instead of its first.
      */
     const Loc op_loc = cur_loc();
-    string_view op = in_str.substr(i, 1);
-
-    if (i + 1 < in_str.length()) {
-
-        if (c == '.') {
-
-            if (isdigit(static_cast<unsigned char>(in_str[i + 1]))) {
-
-                tok_start = i;
-                tok_loc = op_loc;
-                tok_type = TokType::floatnum;
-                i++;
-                return;
-            }
-        }
 
-        /*
-         * Maximal-munch: try a 3-char operator (`>>>`) first, then 2-char.
-         * Note: each requires its shorter prefixes to exist as operators too
-         * (`>>>` needs `>>` and `>`, `<=` needs `<`), because the 1-char `op`
-         * default above is what bootstraps the scan.
-         */
-        if (i + 2 < in_str.length() && is_operator(in_str.substr(i, 3))) {
-
-            op = in_str.substr(i, 3);
-            i += 2;
-
-        } else if (is_operator(in_str.substr(i, 2))) {
-
-            op = in_str.substr(i, 2);
-            i++;
-        }
+    if (c == '.' && i + 1 < in_str.length() &&
+        isdigit(static_cast<unsigned char>(in_str[i + 1])))
+    {
+        tok_start = i;
+        tok_loc = op_loc;
+        tok_type = TokType::floatnum;
+        i++;
+        return;
     }
 
-    result.emplace_back(TokType::op, op_loc, get_op_type(op));
+    size_t len;
+    const Op op = match_op(in_str.substr(i), len);
+    i += len - 1;
+
+    result.emplace_back(TokType::op, op_loc, op);
 }
 
 void
@@ -455,7 +531,7 @@ lexer(string_view in_str, int line, std::vector<Tok> &result)
             ctx.tok_loc = ctx.cur_loc();
         }
 
-        const bool is_op = is_operator(string_view(&c, 1));
+        const bool is_op = is_op_char(c);
         const bool in_integer = ctx.tok_type == TokType::integer;
         const bool exp_sign = ctx.exp_sign_ok && (c == '+' || c == '-');
 
@@ -26,7 +26,7 @@ enum class TokType : int {
     count       = 8,
 };
 
-static const std::array<std::string, (int)Op::op_count> OpString =
+inline constexpr std::array<std::string_view, (int)Op::op_count> OpString =
 {
     "invalid",
 
@@ -110,7 +110,7 @@ enum class Keyword : int {
     kw_count    = 28,
 };
 
-static const std::array<std::string, (int)Keyword::kw_count> KwString =
+inline constexpr std::array<std::string_view, (int)Keyword::kw_count> KwString =
 {
     "invalid",
 
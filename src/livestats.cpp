@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "livestats.h"
+#include "eval.h"
+#include "syntax.h"
+#include "memacct.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+volatile std::sig_atomic_t g_live_dump_pending = 0;
+
+namespace {
+
+struct TopTime {
+    uint64_t calls = 0;
+    int64_t ns = 0;
+    string name;            /* kept: a REPL input's AST can be freed */
+};
+
+std::unordered_map<const FuncDeclStmt *, TopTime> top_times;
+
+/* The rows of freed functions: their address may be reused by another. */
+vector<TopTime> retired_times;
+
+/* The last function charged: a top-level loop calls the same one again. */
+const FuncDeclStmt *last_f;
+TopTime *last_t;
+
+int64_t start_ns;
+unsigned dumps;
+
+#ifndef _WIN32
+void on_sigusr1(int)
+{
+    g_live_dump_pending = 1;
+}
+#endif
+
+string func_name(const FuncDeclStmt *f)
+{
+    if (!f->display_name.empty())
+        return f->display_name;
+    return f->id ? string(f->id->get_str()) : "<lambda>";
+}
+
+void frame_line(std::ostream &o, const string &name, int line)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "  line %-6s  ",
+             line > 0 ? std::to_string(line).c_str() : "?");
+    o << buf << name << "\n";
+}
+
+/*
+ * The frames of one physical frame `name`, at `line` in the code spliced in
+ * by the inline chain `inl` (innermost callee first): one virtual frame per
+ * inlined callee, then the physical one at the outermost call site.
+ */
+void frames(std::ostream &o, const string &name, int line,
+            const InlineCtx *inl)
+{
+    for (; inl; inl = inl->parent) {
+        frame_line(o, inl->callee_name, line);
+        line = inl->call_site.line;
+    }
+
+    frame_line(o, name, line);
+}
+
+double secs(int64_t ns)
+{
+    return ns / 1e9;
+}
+
+}  /* anonymous namespace */
+
+int64_t live_clock_ns()
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void live_top_call_done(const FuncDeclStmt *f, int64_t t0_ns)
+{
+    if (f != last_f) {
+        last_f = f;
+        last_t = &top_times[f];
+        if (last_t->name.empty()) {
+            last_t->name = func_name(f);
+            f->live_timed = true;
+        }
+    }
+
+    last_t->calls++;
+    last_t->ns += live_clock_ns() - t0_ns;
+}
+
+void live_forget(const FuncDeclStmt *f)
+{
+    const auto it = top_times.find(f);
+
+    if (it == top_times.end())
+        return;
+
+    retired_times.push_back(move(it->second));
+    top_times.erase(it);
+
+    if (last_f == f) {
+        last_f = nullptr;
+        last_t = nullptr;
+    }
+}
+
+void live_stats_install()
+{
+    start_ns = live_clock_ns();
+
+#ifndef _WIN32
+    struct sigaction sa = {};
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags = SA_RESTART;     /* a dump must not fail a blocking read */
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, nullptr);
+#endif
+}
+
+void live_stats_dump(int line, const InlineCtx *inl)
+{
+    if (par_in_worker())
+        return;
+
+    g_live_dump_pending = 0;
+
+    const int64_t now = live_clock_ns();
+    std::ostringstream o;
+    char buf[128];
+
+    snprintf(buf, sizeof(buf), "\n=== live stats #%u (SIGUSR1), %.1f s ===\n",
+             ++dumps, secs(now - start_ns));
+    o << buf << "\nBacktrace (innermost first)\n\n";
+
+    /* Each call's frames, at the line where it is now; then its caller's, at
+     * the call site, out to the top level. */
+    const ActiveCall *top = nullptr;
+
+    for (const ActiveCall *ac = active_calls(); ac; ac = ac->caller) {
+        frames(o, func_name(ac->func->func), line, inl);
+        line = ac->call_site.line;
+        inl = ac->call_site_inl;
+        top = ac;
+    }
+
+    frames(o, "main", line, inl);
+    mem_report(o, "live = held now");
+
+    /* The top-level function running now: its time so far counts too. */
+    std::unordered_map<const FuncDeclStmt *, TopTime> t = top_times;
+
+    if (top) {
+        TopTime &r = t[top->func->func];
+        r.ns += now - top->t0_ns;
+        if (r.name.empty())
+            r.name = func_name(top->func->func);
+    }
+
+    vector<std::pair<const FuncDeclStmt *, TopTime>> rows(t.begin(), t.end());
+
+    for (const TopTime &r : retired_times)
+        rows.emplace_back(nullptr, r);
+
+    std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.second.ns > b.second.ns;
+    });
+
+    o << "\nTop-level functions by wall time\n\n";
+    snprintf(buf, sizeof(buf), "  %12s %10s  %s\n", "calls", "seconds", "name");
+    o << buf;
+
+    for (const auto &r : rows) {
+        snprintf(buf, sizeof(buf), "  %12llu %10.3f  ",
+                 static_cast<unsigned long long>(r.second.calls),
+                 secs(r.second.ns));
+        o << buf << r.second.name
+          << (top && r.first == top->func->func ? "  (running)" : "") << "\n";
+    }
+
+    std::cerr << o.str() << std::flush;
+}
+
+void live_stats_dump(const Construct *at)
+{
+    live_stats_dump(at->start().line, at->inline_ctx());
+}
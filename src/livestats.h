@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <csignal>
+#include <cstdint>
+
+struct InlineCtx;
+class Construct;
+class FuncDeclStmt;
+
+/*
+ * Live statistics on demand: `kill -USR1 <pid>` makes a running script print,
+ * to stderr, where it is (the MyLang backtrace), its heap use by value kind
+ * (memacct.h) and the wall time spent so far in each top-level function - a
+ * stalled job can be looked at without killing it.
+ *
+ * The handler only sets g_live_dump_pending. The evaluator polls it at safe
+ * points (every loop back-edge and every function call), where the AST and
+ * the call chain (active_calls()) are consistent: one load and an untaken
+ * branch when no dump is pending. A pool worker (parallel.h) leaves the dump
+ * to the main thread.
+ *
+ * Top-level functions are the ones called from the script's top level (or
+ * from a builtin it called): their calls are timed with the coarse monotonic
+ * clock, which costs a few ns, so a top-level loop calling a small function
+ * stays cheap. Unix-only (there is no SIGUSR1 on Windows).
+ */
+
+extern volatile std::sig_atomic_t g_live_dump_pending;
+
+/* Install the SIGUSR1 handler (main() does, for every run). */
+void live_stats_install();
+
+/* A safe point at `line` (plus the inlined-at chain of the code there): dump
+ * if a dump is pending. Call through live_safe_point. */
+void live_stats_dump(int line, const InlineCtx *inl);
+
+/* The same at node `at` (its line and inlined-at chain), which are only read
+ * when a dump is pending: they live in the node's cold side table. */
+void live_stats_dump(const Construct *at);
+
+inline void live_safe_point(int line, const InlineCtx *inl)
+{
+    if (g_live_dump_pending)
+        live_stats_dump(line, inl);
+}
+
+inline void live_safe_point(const Construct *at)
+{
+    if (g_live_dump_pending)
+        live_stats_dump(at);
+}
+
+/* The coarse monotonic clock, in ns, and a finished top-level call of `f`
+ * that started at `t0_ns`. */
+int64_t live_clock_ns();
+void live_top_call_done(const FuncDeclStmt *f, int64_t t0_ns);
+
+/* `f` is being freed: keep its row in the report, but no longer under its
+ * address (FuncDeclStmt's destructor, for a timed function). */
+void live_forget(const FuncDeclStmt *f);
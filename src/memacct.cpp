@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "memacct.h"
+
+#include <cstdio>
+#include <iostream>
+
+MemCounters g_mem[static_cast<unsigned>(MemKind::count_)];
+
+namespace {
+
+const char *const kind_names[] = {
+    "str",
+    "arr_general",
+    "arr_ints",
+    "arr_floats",
+    "arr_bools",
+    "arr_structs",
+    "dict",
+    "struct",
+    "func",
+    "exception",
+    "frame_spill",
+    "pure_cache",
+};
+
+static_assert(sizeof(kind_names) / sizeof(kind_names[0]) ==
+              static_cast<unsigned>(MemKind::count_),
+              "one name per MemKind");
+
+}  /* anonymous namespace */
+
+const char *mem_kind_name(MemKind k)
+{
+    return kind_names[static_cast<unsigned>(k)];
+}
+
+void *mem_new_obj(MemKind k, size_t n)
+{
+    void *p = ::operator new(n);
+    mem_alloc_obj(k, n);
+    return p;
+}
+
+void mem_delete_obj(MemKind k, void *p, size_t n) noexcept
+{
+    mem_free_obj(k, n);
+    ::operator delete(p);
+}
+
+void mem_reset_peaks()
+{
+    for (MemCounters &c : g_mem)
+        c.peak.store(c.live.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+}
+
+void mem_report_at_exit()
+{
+    mem_report(std::cerr, "live = still held at exit");
+}
+
+void mem_report(std::ostream &o, const char *live_means)
+{
+    char buf[128];
+    uint64_t peak_sum = 0;
+
+    o << "\nMemory by value kind (" << live_means << ")\n\n";
+    snprintf(buf, sizeof(buf), "  %-12s %14s %14s %14s %14s\n",
+             "kind", "allocs", "frees", "live bytes", "peak bytes");
+    o << buf;
+
+    for (unsigned i = 0; i < static_cast<unsigned>(MemKind::count_); i++) {
+
+        const MemCounters &c = g_mem[i];
+        const uint64_t allocs = c.allocs.load(std::memory_order_relaxed);
+
+        if (!allocs)
+            continue;
+
+        snprintf(buf, sizeof(buf), "  %-12s %14llu %14llu %14llu %14llu\n",
+                 kind_names[i],
+                 static_cast<unsigned long long>(allocs),
+                 static_cast<unsigned long long>(c.frees.load()),
+                 static_cast<unsigned long long>(c.live.load()),
+                 static_cast<unsigned long long>(c.peak.load()));
+        o << buf;
+        peak_sum += c.peak.load();
+    }
+
+    snprintf(buf, sizeof(buf), "\n  sum of peaks: %llu bytes\n",
+             static_cast<unsigned long long>(peak_sum));
+    o << buf;
+}
@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <new>
+
+#include "trace.h"
+
+/*
+ * Heap accounting by value kind (the `memstats()` builtin, `--memstats`).
+ *
+ * Every heap block behind a runtime value is charged to one MemKind: the
+ * refcounted payload objects through a class-level operator new/delete
+ * (MemCounted) or, where the kind is only known after construction (an array's
+ * Storage, a string's length), in the constructor/destructor; their element
+ * buffers through a counting allocator (MemAlloc) on the container type. So
+ * `live` is what the kind holds right now, block for block, and a 20 GB RSS
+ * can be pinned on "flat int arrays" vs "dict nodes" without an external heap
+ * profiler.
+ *
+ * Always on: a charge is a relaxed fetch_add/fetch_sub next to a malloc, so a
+ * pool worker (parallel.h) charging concurrently (a Frame spill) never loses
+ * an update - `live` can't drift, let alone wrap below zero. Only `peak` is a
+ * plain load/store: a racing charge may under-report the high-water mark.
+ * Against plain load/store counters, the allocation-heavy bench/my scripts
+ * (array/str/dict building, map/filter, closures, sort with a callback) show
+ * no difference outside run-to-run noise, so accounting isn't gated behind
+ * --memstats: memstats() can be called at any time and must see every block.
+ */
+
+enum class MemKind : unsigned {
+    str,              /* StrObj + its character buffer */
+    arr_general,      /* array SharedObject, per Storage kind, + its buffer */
+    arr_ints,
+    arr_floats,
+    arr_bools,
+    arr_structs,
+    dict,             /* DictObject + its nodes and buckets */
+    struct_obj,       /* StructObject + its field slots / POD bytes */
+    func,             /* FuncObject (a function value / closure) */
+    exception,        /* ExceptionObject */
+    frame_spill,      /* Frame slots past Frame::INLINE_SLOTS */
+    pure_cache,       /* the per-frame PureCache's nodes and buckets */
+    count_
+};
+
+struct MemCounters {
+    std::atomic<uint64_t> allocs{0};
+    std::atomic<uint64_t> frees{0};
+    std::atomic<uint64_t> live{0};      /* bytes */
+    std::atomic<uint64_t> peak{0};      /* the high-water mark of `live` */
+    std::atomic<uint64_t> objects{0};   /* live payload objects (not buffers) */
+};
+
+extern MemCounters g_mem[static_cast<unsigned>(MemKind::count_)];
+
+/* The user-facing name of a kind ("str", "arr_ints", ...). */
+const char *mem_kind_name(MemKind k);
+
+inline void mem_charge(MemKind k, size_t bytes)
+{
+    MemCounters &c = g_mem[static_cast<unsigned>(k)];
+    const uint64_t live =
+        c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    if (live > c.peak.load(std::memory_order_relaxed))
+        c.peak.store(live, std::memory_order_relaxed);
+}
+
+inline void mem_alloc(MemKind k, size_t bytes)
+{
+    MemCounters &c = g_mem[static_cast<unsigned>(k)];
+    c.allocs.fetch_add(1, std::memory_order_relaxed);
+    mem_charge(k, bytes);
+
+    if (bytes >= TRACE_LARGE_ALLOC && trace_enabled(TraceCat::allocs))
+        trace_event_instant(TraceCat::allocs, mem_kind_name(k),
+                            static_cast<long long>(bytes));
+}
+
+inline void mem_free(MemKind k, size_t bytes)
+{
+    MemCounters &c = g_mem[static_cast<unsigned>(k)];
+    c.frees.fetch_add(1, std::memory_order_relaxed);
+    c.live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+/* A payload object (not a buffer) of kind `k` was created / destroyed: also
+ * counts it, so heap_snapshot() can tell live objects from reachable ones. */
+inline void mem_alloc_obj(MemKind k, size_t bytes)
+{
+    MemCounters &c = g_mem[static_cast<unsigned>(k)];
+    c.objects.fetch_add(1, std::memory_order_relaxed);
+    mem_alloc(k, bytes);
+}
+
+inline void mem_free_obj(MemKind k, size_t bytes)
+{
+    MemCounters &c = g_mem[static_cast<unsigned>(k)];
+    c.objects.fetch_sub(1, std::memory_order_relaxed);
+    mem_free(k, bytes);
+}
+
+/* A block of kind `k` grew or shrank in place (a string append). */
+inline void mem_resize(MemKind k, size_t before, size_t after)
+{
+    if (after >= before) {
+        mem_charge(k, after - before);
+    } else {
+        MemCounters &c = g_mem[static_cast<unsigned>(k)];
+        c.live.fetch_sub(before - after, std::memory_order_relaxed);
+    }
+}
+
+/* Reset the peaks to the current values (`memstats(true)`). */
+void mem_reset_peaks();
+
+/* Print the per-kind table (the `--memstats` report). */
+void mem_report_at_exit();
+
+/* The same table to `o`, at any time; `live_means` goes in the heading. */
+void mem_report(std::ostream &o, const char *live_means);
+
+/*
+ * The block of a MemCounted object, charged to `k`. Out of line: inlined into
+ * the class operators, GCC sees the class's operator delete free a block from
+ * ::operator new and warns (-Wmismatched-new-delete).
+ */
+void *mem_new_obj(MemKind k, size_t n);
+void mem_delete_obj(MemKind k, void *p, size_t n) noexcept;
+
+/*
+ * Base of a refcounted payload whose size is fixed at `new` time: charges the
+ * whole object to K. The sized delete gets the dynamic size for a class with
+ * a virtual destructor (ExceptionObject), so it always matches the charge.
+ */
+template <MemKind K>
+struct MemCounted {
+
+    static void *operator new(size_t n)
+    {
+        return mem_new_obj(K, n);
+    }
+
+    static void operator delete(void *p, size_t n) noexcept
+    {
+        mem_delete_obj(K, p, n);
+    }
+};
+
+/*
+ * A stateless allocator that charges each block to K: the element buffer of a
+ * vector, the nodes and bucket array of an unordered_map. Same size as
+ * std::allocator (empty), and all instances compare equal, so containers move
+ * and swap as before.
+ */
+template <class T, MemKind K>
+struct MemAlloc {
+
+    typedef T value_type;
+
+    template <class U>
+    struct rebind { typedef MemAlloc<U, K> other; };
+
+    MemAlloc() noexcept = default;
+
+    template <class U>
+    MemAlloc(const MemAlloc<U, K> &) noexcept { }
+
+    T *allocate(size_t n)
+    {
+        T *p = static_cast<T *>(::operator new(n * sizeof(T)));
+        mem_alloc(K, n * sizeof(T));
+        return p;
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        mem_free(K, n * sizeof(T));
+        ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const MemAlloc<U, K> &) const noexcept { return true; }
+
+    template <class U>
+    bool operator!=(const MemAlloc<U, K> &) const noexcept { return false; }
+};
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "memo.h"
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+bool g_memoize_all = false;
+size_t g_memo_cap = static_cast<size_t>(64) * 1024 * 1024;
+
+namespace {
+
+/*
+ * CLOCK replacement: `ring` lists the live entries (pointers to the map's
+ * nodes, which never move on rehash); a hit sets the entry's `ref` bit, and
+ * the hand - sweeping the ring only when a store needs room - clears a set bit
+ * (a second chance) or evicts an entry whose bit is already clear. A hit is
+ * one hash lookup and a bit store; nothing is reordered per access (as an LRU
+ * list would).
+ */
+class MemoTable {
+
+    struct Entry {
+        EvalValue val;
+        size_t bytes;
+        bool ref;
+    };
+
+    typedef std::unordered_map<PureCacheKey, Entry, PureCacheKeyHash> MapT;
+
+    MapT map;
+    std::vector<MapT::value_type *> ring;
+    size_t hand = 0;
+    MemoStats st;
+
+    /* The map node (+ its bucket pointer), the args' heap buffer and the ring
+     * pointer: an estimate, but one that grows with the key like the real
+     * footprint does. */
+    static size_t entry_bytes(const PureCacheKey &k)
+    {
+        return sizeof(MapT::value_type) + 3 * sizeof(void *) +
+               k.args.capacity() * sizeof(EvalValue);
+    }
+
+    void evict_at_hand()
+    {
+        st.bytes -= ring[hand]->second.bytes;
+        map.erase(map.find(ring[hand]->first));
+        ring[hand] = ring.back();
+        ring.pop_back();
+        st.evictions++;
+    }
+
+public:
+
+    const EvalValue *lookup(const PureCacheKey &k)
+    {
+        auto it = map.find(k);
+
+        if (it == map.end()) {
+            st.misses++;
+            return nullptr;
+        }
+
+        st.hits++;
+        it->second.ref = true;
+        return &it->second.val;
+    }
+
+    void store(PureCacheKey &&k, const EvalValue &v)
+    {
+        const size_t b = entry_bytes(k);
+        if (b > g_memo_cap)
+            return;
+
+        while (!ring.empty() && st.bytes + b > g_memo_cap) {
+
+            if (hand >= ring.size())
+                hand = 0;
+
+            Entry &e = ring[hand]->second;
+            if (e.ref) {
+                e.ref = false;
+                hand++;
+            } else {
+                evict_at_hand();
+            }
+        }
+
+        auto r = map.emplace(std::move(k), Entry{ v, b, false });
+        if (!r.second)
+            return;         /* a nested call with the same key stored it */
+
+        ring.push_back(&*r.first);
+        st.bytes += b;
+    }
+
+    void forget(const void *fn)
+    {
+        for (size_t i = 0; i < ring.size(); ) {
+            if (ring[i]->first.fn == fn) {
+                hand = i;
+                evict_at_hand();
+                st.evictions--;          /* not a capacity eviction */
+            } else {
+                i++;
+            }
+        }
+        hand = 0;
+    }
+
+    void clear()
+    {
+        map.clear();
+        ring.clear();
+        hand = 0;
+        st = MemoStats();
+    }
+
+    MemoStats stats() const
+    {
+        MemoStats s = st;
+        s.entries = map.size();
+        return s;
+    }
+};
+
+MemoTable &table()
+{
+    static MemoTable t;
+    return t;
+}
+
+}  /* anonymous namespace */
+
+const EvalValue *memo_lookup(const PureCacheKey &key)
+{
+    return table().lookup(key);
+}
+
+void memo_store(PureCacheKey &&key, const EvalValue &val)
+{
+    table().store(std::move(key), val);
+}
+
+void memo_forget(const void *fn)
+{
+    table().forget(fn);
+}
+
+void memo_clear()
+{
+    table().clear();
+}
+
+MemoStats memo_stats()
+{
+    return table().stats();
+}
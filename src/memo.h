@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include "eval.h"
+
+#include <cstddef>
+
+/*
+ * Opt-in CROSS-CALL memoization of pure functions. The per-frame PureCache
+ * (eval.h) only dedups the duplicate self-calls of one unrolled recursion and
+ * dies with its frame; a memoized function (FuncDeclStmt::memoized) instead
+ * shares one program-wide table, so a subproblem computed by one top-level
+ * call is a hit for every later one.
+ *
+ * A function is memoized by `memoize(f)` (the resolver also spots a top-level
+ * `memoize(f)` statement, so it happens before inlining) or, with the
+ * `--memoize` CLI flag, every function the resolver proves pure. It must be
+ * pure and capture nothing, so its result depends on its arguments alone. The
+ * key is the same PureCacheKey as the per-frame cache, and only a call with
+ * SCALAR arguments and a scalar result is stored (a container argument could
+ * be mutated between calls; a container result would alias across callers).
+ *
+ * The table is bounded: past `g_memo_cap` bytes (an estimate per entry) the
+ * CLOCK hand evicts entries not hit since its last sweep. Not thread-safe: a
+ * pool worker (parallel.h) always calls through uncached.
+ */
+
+/* `--memoize`: memoize every effectively-pure, capture-less named function. */
+extern bool g_memoize_all;
+
+/* `--memo-cap <MB>`: the table's memory cap, in bytes. */
+extern size_t g_memo_cap;
+
+struct MemoStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;       /* estimated memory held by the entries */
+};
+
+/* The cached result for `key` (counting a hit), or null (counting a miss). */
+const EvalValue *memo_lookup(const PureCacheKey &key);
+
+/* Record `val` as the result for `key`, evicting as needed to stay under the
+ * cap. An entry bigger than the whole cap is not stored. */
+void memo_store(PureCacheKey &&key, const EvalValue &val);
+
+/* Drop every entry of function `fn` (a FuncDeclStmt going away). */
+void memo_forget(const void *fn);
+
+/* Drop every entry and reset the counters. */
+void memo_clear();
+
+MemoStats memo_stats();
@@ -12,9 +12,18 @@
 #include "repl.h"
 #include "errfmt.h"
 #include "trace.h"
+#include "parallel.h"
+#include "memo.h"
+#include "profiler.h"
+#include "evalstats.h"
+#include "memacct.h"
+#include "passtimer.h"
+#include "perfcount.h"
+#include "livestats.h"
+#include "compilecache.h"
+#include "srcbuf.h"
 
 #include <initializer_list>
-#include <fstream>
 #include <cstring>
 #include <cstdlib>
 #include <cctype>
@@ -35,25 +44,26 @@ static bool opt_debug_ti;
 static bool opt_analyze;
 static bool opt_no_color;
 static bool opt_repl;
+static string opt_profile_out;   /* --profile: collapsed-stacks file */
+static bool opt_perf_counters;   /* --perf-counters */
+static string opt_cache_dir;     /* --cache-dir / $MYLANG_CACHE_DIR */
+#ifdef EVAL_STATS
+static bool opt_stats;           /* --stats */
+#endif
 
-static std::vector<string> lines;
+/* The whole source as one buffer, memory-mapped. The lexer scans it in one
+ * pass so strings / block comments can span lines; token string_views point
+ * into it, so it must outlive parsing (it is static => program lifetime). Its
+ * lines are only split out for error carets and `-a`. */
+static SourceBuffer source;
 static std::vector<Tok> tokens;
-/* The whole source as one buffer (lines re-joined with '\n'). The lexer scans
- * it in one pass so strings / block comments can span lines; token string_views
- * point into it, so it must outlive parsing (it is static => program lifetime).
- * `lines` is kept separately for per-line error carets. */
-static string source;
 
 static void
 lex_all()
 {
-    source.clear();
-    for (size_t i = 0; i < lines.size(); i++) {
-        if (i)
-            source += '\n';
-        source += lines[i];
-    }
-    lexer(source, 1, tokens);
+    PassTimer pt("lex");
+    lexer(source.text(), 1, tokens);
+    pt.note(std::to_string(tokens.size()) + " tokens");
 }
 
 void run_tests(bool dump_syntax_tree);
@@ -69,6 +79,44 @@ void help()
     cout << "  -ni      No function inlining (debug)" << endl;
     cout << "  -it N    Inline threshold: max inlined body size (default 24)"
          << endl;
+    cout << " -nlicm    No loop-invariant code motion (debug)" << endl;
+    cout << " -npm      No parallel map/filter (pure callbacks run sequentially)"
+         << endl;
+    cout << " --parallel-loops  Run independent counted `for` loops on all"
+         << endl;
+    cout << "           cores (body writes only a[i], reads invariant data)"
+         << endl;
+    cout << " --par-threads N  Size the worker pool to N threads (default:"
+         << endl;
+    cout << "           one per hardware thread)" << endl;
+    cout << " --memoize Memoize every pure function's calls across the"
+         << endl;
+    cout << "           program (scalar args/result; see memoize(f))" << endl;
+    cout << " --memo-cap MB  Memory cap of the memo table (default 64)"
+         << endl;
+    cout << " --profile FILE  Sample the MyLang call stack; at exit print"
+         << endl;
+    cout << "           per-function/line time to stderr and write collapsed"
+         << endl;
+    cout << "           stacks (flame-graph input) to FILE" << endl;
+    cout << " --memstats  At exit, print allocs/frees/live/peak bytes per"
+         << endl;
+    cout << "           value kind (see memstats())" << endl;
+    cout << " --perf-counters  At exit, print hardware counters (cycles,"
+         << endl;
+    cout << "           instructions, cache/branch misses) for the run and"
+         << endl;
+    cout << "           each perf_begin()/perf_end() region (Linux)" << endl;
+    cout << " --time-passes  At exit, print wall time, peak-RSS growth and"
+         << endl;
+    cout << "           AST node counts per compile pass (=csv: as CSV)"
+         << endl;
+    cout << " --stats   Count node evaluations per class/line and the"
+         << endl;
+    cout << "           boxed/unboxed, flat/general, cached and inlined paths"
+         << endl;
+    cout << "           taken; print them at exit (a STATS=ON build only)"
+         << endl;
     cout << "  -nr      Don't run, just validate" << endl;
     cout << " -nti      No type inference / checking (debug)" << endl;
     cout << " --debug-ti  Dump inferred types of all identifiers, then exit"
@@ -81,8 +129,19 @@ void help()
          << endl;
     cout << "           CATS is comma-separated: infer,inline,specialize,"
          << endl;
-    cout << "           template,autoconst,autopure,arrays,fold, or all"
+    cout << "           template,autoconst,autopure,arrays,fold,licm, or all"
+         << endl;
+    cout << "           Runtime: calls,builtins,exceptions,allocs,promotions"
+         << endl;
+    cout << "           record events for --trace-out" << endl;
+    cout << " --trace-out FILE  At exit, write the runtime trace events as"
          << endl;
+    cout << "           Chrome trace JSON (open it in Perfetto)" << endl;
+    cout << " --cache-dir DIR  Keep compiled scripts in DIR and reuse them"
+         << endl;
+    cout << "           when the source, interpreter and flags are unchanged"
+         << endl;
+    cout << "           (default: $MYLANG_CACHE_DIR; unset = no cache)" << endl;
 
 #ifdef TESTS
     cout << "  -rt      Run unit tests" << endl;
@@ -92,25 +151,10 @@ void help()
 void
 read_script(const char *filename)
 {
-    {
-        string line;
-        std::ifstream filestream(filename);
-
-        if (filestream.is_open()) {
-
-            while (getline(filestream, line)) {
-                lines.push_back(move(line));
-                line.clear(); /* Put the string is a known state */
-            }
-
-        } else {
-
-            cout << "Failed to open file '" << filename << "'\n";
-            exit(1);
-        }
+    if (!source.load_file(filename)) {
+        cout << "Failed to open file '" << filename << "'\n";
+        exit(1);
     }
-
-    lex_all();
 }
 
 void
@@ -189,6 +233,82 @@ parse_args(int argc, char **argv)
 
             g_pure_cache_enabled = false;   /* recursion unroll, no per-frame cache */
 
+        } else if (!strcmp(arg, "-nlicm")) {
+
+            g_licm_enabled = false;         /* no loop-invariant hoisting */
+
+        } else if (!strcmp(arg, "-npm")) {
+
+            g_parallel_enabled = false;     /* map/filter always sequential */
+
+        } else if (!strcmp(arg, "--parallel-loops")) {
+
+            g_parallel_loops = true;        /* independent `for` loops -> pool */
+
+        } else if (!strcmp(arg, "--par-threads")) {
+
+            if (argc < 2 || atoi(argv[1]) <= 0) {
+                cout << "error: --par-threads requires a thread count" << endl;
+                exit(1);
+            }
+
+            par_set_threads(static_cast<unsigned>(atoi(argv[1])));
+            argc--; argv++;   /* consume the value */
+
+        } else if (!strcmp(arg, "--memoize")) {
+
+            g_memoize_all = true;           /* every pure func: global memo */
+
+        } else if (!strcmp(arg, "--memo-cap")) {
+
+            if (argc < 2 || atoi(argv[1]) <= 0) {
+                cout << "error: --memo-cap requires a size in MB" << endl;
+                exit(1);
+            }
+
+            g_memo_cap = static_cast<size_t>(atoi(argv[1])) * 1024 * 1024;
+            argc--; argv++;   /* consume the value */
+
+        } else if (!strcmp(arg, "--profile")) {
+
+            if (argc < 2) {
+                cout << "error: --profile requires an output file "
+                     << "(the collapsed stacks)" << endl;
+                exit(1);
+            }
+
+            opt_profile_out = argv[1];
+            argc--; argv++;   /* consume the value */
+
+        } else if (!strcmp(arg, "--memstats")) {
+
+            atexit(mem_report_at_exit);     /* heap use by value kind */
+
+        } else if (!strcmp(arg, "--perf-counters")) {
+
+            opt_perf_counters = true;       /* counted from root->eval */
+            atexit(perf_report_at_exit);
+
+        } else if (!strcmp(arg, "--time-passes")) {
+
+            g_time_passes = true;           /* per-pass compile costs */
+            atexit(pass_report_at_exit);
+
+        } else if (!strcmp(arg, "--time-passes=csv")) {
+
+            g_time_passes = true;           /* the same, for scripts */
+            atexit(pass_report_csv_at_exit);
+
+        } else if (!strcmp(arg, "--stats")) {
+
+#ifdef EVAL_STATS
+            opt_stats = true;
+#else
+            cout << "error: --stats needs a build with the execution "
+                 << "counters (cmake -DSTATS=ON, or make STATS=1)" << endl;
+            exit(1);
+#endif
+
         } else if (!strcmp(arg, "-it")) {
 
             if (argc < 2) {
@@ -242,6 +362,27 @@ parse_args(int argc, char **argv)
                 pos = comma + 1;
             }
 
+        } else if (!strcmp(arg, "--trace-out")) {
+
+            if (argc < 2) {
+                cout << "error: --trace-out requires an output file" << endl;
+                exit(1);
+            }
+
+            trace_set_out_path(argv[1]);
+            atexit(trace_dump_at_exit);
+            argc--; argv++;   /* consume the value */
+
+        } else if (!strcmp(arg, "--cache-dir")) {
+
+            if (argc < 2) {
+                cout << "error: --cache-dir requires a directory" << endl;
+                exit(1);
+            }
+
+            opt_cache_dir = argv[1];
+            argc--; argv++;   /* consume the value */
+
         } else if (!strcmp(arg, "--no-color")) {
 
             opt_no_color = true;
@@ -269,25 +410,45 @@ parse_args(int argc, char **argv)
             for (int i = 1; i < argc; i++)
                 vec.emplace_back(SharedStr(string(argv[i])), false);
 
-            EvalContext::builtins.emplace(
-
-                make_pair(
-                    UniqueId::get("argv"),
-                    LValue(
-                        EvalValue(SharedArrayObj(move(vec))),
-                        false
-                    )
-                )
-            );
+            add_builtin("argv", EvalValue(SharedArrayObj(move(vec))));
 
             break;
         }
     }
 
-    if (in_tokens) {
-        lines.emplace_back(move(inline_text));
-        lex_all();
-    }
+    if (in_tokens)
+        source.assign(move(inline_text));
+}
+
+/*
+ * The flags that change the tree the compiler emits: part of the compile
+ * cache key, so `-ni` and the default never share an entry.
+ */
+static string
+compile_flags()
+{
+    return "nc=" + std::to_string(opt_no_const_eval) +
+           " ni=" + std::to_string(opt_no_inline) +
+           " it=" + std::to_string(opt_inline_threshold) +
+           " nti=" + std::to_string(opt_no_type_infer) +
+           " npc=" + std::to_string(!g_pure_cache_enabled) +
+           " nlicm=" + std::to_string(!g_licm_enabled) +
+           " ploops=" + std::to_string(g_parallel_loops) +
+           " memoize=" + std::to_string(g_memoize_all);
+}
+
+/*
+ * The compile cache serves plain runs only: the dump, analysis and
+ * validation modes exist to show the compiler at work, and so does tracing
+ * one of its categories (those sit below the runtime ones in the mask).
+ */
+static bool
+compile_cache_usable()
+{
+    return !opt_cache_dir.empty() &&
+           !opt_show_tokens && !opt_show_syntax_tree && !opt_no_run &&
+           !opt_debug_ti && !opt_analyze &&
+           !(g_trace_mask & (static_cast<unsigned>(TraceCat::calls) - 1));
 }
 
 /* anno_code + render_analysis now live in analyzer.cpp (shared with the REPL's
@@ -306,6 +467,7 @@ int main(int argc, char **argv)
     try {
 
         parse_args(argc, argv);
+        live_stats_install();               /* kill -USR1: where is it? */
 
         /* Color the trace tags on a stderr TTY (the trace sink is stderr for a
          * script), unless --no-color. Harmless when no category is enabled. */
@@ -316,90 +478,159 @@ int main(int argc, char **argv)
         if (opt_repl)
             return run_repl();
 
-        ParseContext ctx(TokenStream(tokens), !opt_no_const_eval);
-
-        /* -a: the parser records parse-time folds/DCE it would otherwise erase
-         * (magenta folded calls, dim dead branches) into this collector; the
-         * later passes add to it. Set before pBlock so the parser records. */
-        AnalysisInfo analyze_info;
-        if (opt_analyze)
-            ctx.analysis = &analyze_info;
+        if (opt_cache_dir.empty())
+            if (const char *dir = getenv("MYLANG_CACHE_DIR"))
+                opt_cache_dir = dir;
 
-        if (opt_show_tokens) {
-            cout << "Tokens" << endl;
-            cout << "--------------------------" << endl;
+        /* --cache-dir: a script compiled before (same source, interpreter and
+         * flags) skips the whole pipeline and runs its stored tree. */
+        bool use_cache = compile_cache_usable();
+        string cache_key;
 
-            for (const auto &tok : tokens) {
-                cout << tok << endl;
-            }
+        if (use_cache && !cc_dir_ok(opt_cache_dir)) {
+            cerr << "warning: compile cache disabled: '" << opt_cache_dir
+                 << "' is not a writable directory" << endl;
+            use_cache = false;
+        }
 
-            cout << endl;
+        if (use_cache) {
+            PassTimer pt("cache load");
+            cache_key = cc_key(source.text(), compile_flags());
+            root = cc_load(opt_cache_dir, cache_key);
+            pt.note(root ? "hit" : "miss");
         }
 
-        root = pBlock(ctx);
+        /* Both outlive the compile, as they always have: the parser's const
+         * scope lives until the program ends. */
+        unique_ptr<ParseContext> pctx;
+        AnalysisInfo analyze_info;
+
+        if (!root) {
 
-        if (opt_show_syntax_tree) {
-            cout << "Syntax tree" << endl;
-            cout << "--------------------------" << endl;
-            cout << *root << endl;
-            cout << "--------------------------" << endl;
-        }
+            lex_all();
+            pctx = make_unique<ParseContext>(TokenStream(tokens),
+                                             !opt_no_const_eval);
+            ParseContext &ctx = *pctx;
 
-        if (!ctx.eoi())
-            throw SyntaxErrorEx(
-                Loc(ctx.get_tok().loc),
-                "Unexpected token at the end",
-                &ctx.get_tok()
-            );
-
-        /* Implicit top-level `var`: a bare `name = expr` to an undeclared name
-         * at the outermost scope is a declaration. Runs before inference so all
-         * later passes see it as an ordinary var decl. (Script: no prior
-         * globals.) */
-        mark_implicit_globals(root.get(), {});
-
-        /* --debug-ti: dump the inferred type of every identifier + its use
-         * sites (machine-readable) and exit, without running. */
-        if (opt_debug_ti) {
-            dump_type_info(root.get(), cout);
-            return 0;
-        }
+            /* -a: the parser records parse-time folds/DCE it would otherwise
+             * erase (magenta folded calls, dim dead branches) into this
+             * collector; the later passes add to it. Set before pBlock so the
+             * parser records. */
+            if (opt_analyze)
+                ctx.analysis = &analyze_info;
 
-        /* -a/--analyze: collect optimization decisions and reprint the source
-         * with colors, then exit. Array-storage colors come from inference (on
-         * the clean tree); the resolver passes run next and record auto-const /
-         * dead-code / inlined / specialized / folded as the tree mutates. */
-        if (opt_analyze) {
-            /* analyze_info already holds the parser's records; the shared
-             * pipeline adds the inference (array storage) and resolver
-             * (auto-const/inline/etc.) decisions, then reprints colored. */
-            analyze_and_render(cout, root.get(), analyze_info, lines,
-                               !opt_no_color, /*repl_mode=*/false,
-                               !opt_no_inline, opt_inline_threshold);
-            return 0;
-        }
+            if (opt_show_tokens) {
+                cout << "Tokens" << endl;
+                cout << "--------------------------" << endl;
 
-        /* Static type inference + checking (compile-time). Runs before
-         * resolve_names, on the clean source tree. A type violation throws a
-         * compile-time exception here. Validation-only (-nr) still runs it. */
-        infer_types(root.get(), !opt_no_type_infer);
+                for (const auto &tok : tokens) {
+                    cout << tok << endl;
+                }
+
+                cout << endl;
+            }
+
+            {
+                PassTimer pt("parse");
+                root = pBlock(ctx);
+            }
 
-        if (!opt_no_run) {
-            /* Run the optimizer pipeline (resolve_names + specialize_types -
-             * the SAME helper the REPL uses), then run the script. The root
-             * block builds its own "main" Frame for slotted top-level vars. */
-            run_optimizers(root.get(), !opt_no_inline, opt_inline_threshold,
-                           !opt_no_type_infer);
-
-            /* -s also dumps the tree AFTER the optimizer (inlining, unroll,
-             * specialization) so the actual optimized AST is inspectable. */
             if (opt_show_syntax_tree) {
-                cout << "Optimized syntax tree" << endl;
+                cout << "Syntax tree" << endl;
                 cout << "--------------------------" << endl;
                 cout << *root << endl;
                 cout << "--------------------------" << endl;
             }
 
+            if (!ctx.eoi())
+                throw SyntaxErrorEx(
+                    Loc(ctx.get_tok().loc),
+                    "Unexpected token at the end",
+                    &ctx.get_tok()
+                );
+
+            /* Implicit top-level `var`: a bare `name = expr` to an undeclared
+             * name at the outermost scope is a declaration. Runs before
+             * inference so all later passes see it as an ordinary var decl.
+             * (Script: no prior globals.) */
+            {
+                PassTimer pt("implicit globals");
+                mark_implicit_globals(root.get(), {});
+            }
+
+            /* --debug-ti: dump the inferred type of every identifier + its use
+             * sites (machine-readable) and exit, without running. */
+            if (opt_debug_ti) {
+                dump_type_info(root.get(), cout);
+                return 0;
+            }
+
+            /* -a/--analyze: collect optimization decisions and reprint the
+             * source with colors, then exit. Array-storage colors come from
+             * inference (on the clean tree); the resolver passes run next and
+             * record auto-const / dead-code / inlined / specialized / folded as
+             * the tree mutates. */
+            if (opt_analyze) {
+                /* analyze_info already holds the parser's records; the shared
+                 * pipeline adds the inference (array storage) and resolver
+                 * (auto-const/inline/etc.) decisions, then reprints colored. */
+                const std::vector<std::string_view> sv = source.lines();
+                analyze_and_render(cout, root.get(), analyze_info,
+                                   std::vector<string>(sv.begin(), sv.end()),
+                                   !opt_no_color, /*repl_mode=*/false,
+                                   !opt_no_inline, opt_inline_threshold);
+                return 0;
+            }
+
+            /* Static type inference + checking (compile-time). Runs before
+             * resolve_names, on the clean source tree. A type violation throws
+             * a compile-time exception here. Validation-only (-nr) still runs
+             * it. */
+            {
+                PassTimer pt("infer types");
+                infer_types(root.get(), !opt_no_type_infer);
+            }
+
+            if (!opt_no_run) {
+                /* Run the optimizer pipeline (resolve_names + specialize_types
+                 * - the SAME helper the REPL uses), then run the script. The
+                 * root block builds its own "main" Frame for slotted top-level
+                 * vars. */
+                {
+                    PassTimer pt("optimize");
+                    run_optimizers(root.get(), !opt_no_inline,
+                                   opt_inline_threshold, !opt_no_type_infer);
+                }
+
+                /* -s also dumps the tree AFTER the optimizer (inlining,
+                 * unroll, specialization) so the actual optimized AST is
+                 * inspectable. */
+                if (opt_show_syntax_tree) {
+                    cout << "Optimized syntax tree" << endl;
+                    cout << "--------------------------" << endl;
+                    cout << *root << endl;
+                    cout << "--------------------------" << endl;
+                }
+
+                if (use_cache)
+                    cc_store(opt_cache_dir, cache_key, root.get());
+            }
+        }
+
+        if (!opt_no_run) {
+
+            if (!opt_profile_out.empty() && !prof_start(opt_profile_out))
+                cerr << "warning: --profile is not supported on this "
+                     << "platform" << endl;
+
+#ifdef EVAL_STATS
+            if (opt_stats)
+                stats_start();
+#endif
+
+            if (opt_perf_counters)
+                perf_run_begin();
+
             root->eval(nullptr);
         }
 
@@ -414,12 +645,12 @@ int main(int argc, char **argv)
             e.loc_end = tokens.back().loc + 2;
         }
 
-        format_exception(cerr, e, lines);
+        format_exception(cerr, e, source.lines());
         return 1;
 
     } catch (const Exception &e) {
 
-        format_exception(cerr, e, lines);
+        format_exception(cerr, e, source.lines());
         return 1;
     }
 
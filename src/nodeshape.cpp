@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "nodeshape.h"
+#include "defs.h"
+
+NodeShapeCache g_node_shapes;
+
+static unsigned cached_count;
+
+static NodeShape classify(const Construct *c)
+{
+    if (dynamic_cast<const SingleChildConstruct *>(c))
+        return NodeShape::single;
+    if (dynamic_cast<const MultiOpConstruct *>(c))
+        return NodeShape::multi_op;
+    if (dynamic_cast<const TypedScalarExpr *>(c))
+        return NodeShape::typed_scalar;
+    if (dynamic_cast<const IncDecExpr *>(c))
+        return NodeShape::incdec;
+    if (dynamic_cast<const TernaryExpr *>(c))
+        return NodeShape::ternary;
+    if (dynamic_cast<const CoalesceExpr *>(c))
+        return NodeShape::coalesce;
+    if (dynamic_cast<const CallExpr *>(c))
+        return NodeShape::call;
+    if (dynamic_cast<const IfStmt *>(c))
+        return NodeShape::if_stmt;
+    if (dynamic_cast<const WhileStmt *>(c))
+        return NodeShape::while_stmt;
+    if (dynamic_cast<const ForStmt *>(c))
+        return NodeShape::for_stmt;
+    if (dynamic_cast<const ForRangeStmt *>(c))
+        return NodeShape::for_range;
+    if (dynamic_cast<const ForeachStmt *>(c))
+        return NodeShape::foreach;
+    if (dynamic_cast<const Subscript *>(c))
+        return NodeShape::subscript;
+    if (dynamic_cast<const Slice *>(c))
+        return NodeShape::slice;
+    if (dynamic_cast<const MemberExpr *>(c))
+        return NodeShape::member;
+    if (dynamic_cast<const ReturnStmt *>(c))
+        return NodeShape::ret;
+    if (dynamic_cast<const Expr14 *>(c))
+        return NodeShape::expr14;
+    if (dynamic_cast<const LiteralDictKVPair *>(c))
+        return NodeShape::kv_pair;
+    if (dynamic_cast<const FuncDeclStmt *>(c))
+        return NodeShape::func_decl;
+    if (dynamic_cast<const TryCatchStmt *>(c))
+        return NodeShape::try_catch;
+    if (dynamic_cast<const MultiElemConstruct<Construct> *>(c))
+        return NodeShape::elems;
+    if (dynamic_cast<const MultiElemConstruct<Identifier> *>(c))
+        return NodeShape::ids;
+    if (dynamic_cast<const MultiElemConstruct<LiteralDictKVPair> *>(c))
+        return NodeShape::dict;
+
+    return NodeShape::leaf;
+}
+
+NodeShape node_shape_slow(const Construct *c, const std::type_info *t)
+{
+    const NodeShape s = classify(c);
+    unsigned i = NodeShapeCache::hash(t);
+
+    /* There are a few dozen node classes: the table can never fill up. */
+    cached_count++;
+    ML_CHECK(cached_count < NodeShapeCache::size);
+
+    while (g_node_shapes.keys[i])
+        i = (i + 1) & (NodeShapeCache::size - 1);
+
+    g_node_shapes.keys[i] = t;
+    g_node_shapes.shapes[i] = s;
+    return s;
+}
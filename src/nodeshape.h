@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include "syntax.h"
+
+#include <cstdint>
+#include <typeinfo>
+
+/*
+ * Child layout of an AST node, for the compile-time tree walkers (the
+ * resolver's for_each_child / for_each_child_slot, the inferencer's
+ * for_each_child). Each walker used to find a node's children with a chain of
+ * up to twenty dynamic_casts, re-run at every node of every pass - a leaf
+ * failed all of them, and a failed cast compares type names. node_shape() runs
+ * that chain once per DYNAMIC TYPE and caches the answer by its type_info, so a
+ * walk dispatches on one table probe and a switch, and the walkers are
+ * templates over the callback instead of taking a std::function.
+ *
+ * The shapes follow the class hierarchy in syntax.h, which is single
+ * inheritance: every node class maps to exactly one shape, so the order of the
+ * old cast chains never mattered. Each walker still decides for itself which
+ * shapes it descends into.
+ */
+enum class NodeShape : unsigned char {
+
+    leaf,           /* literals, Identifier, Break/Continue/Rethrow/Nop, ... */
+    single,         /* SingleChildConstruct: Expr01, Throw, InlinedCall, ... */
+    multi_op,       /* MultiOpConstruct: Expr02 .. Expr12 */
+    typed_scalar,   /* TypedScalarExpr */
+    incdec,         /* IncDecExpr */
+    ternary,        /* TernaryExpr */
+    coalesce,       /* CoalesceExpr */
+    call,           /* CallExpr and its devirtualized subclasses */
+    if_stmt,        /* IfStmt */
+    while_stmt,     /* WhileStmt */
+    for_stmt,       /* ForStmt */
+    for_range,      /* ForRangeStmt */
+    foreach,        /* ForeachStmt */
+    subscript,      /* Subscript, RangeSubscript */
+    slice,          /* Slice */
+    member,         /* MemberExpr */
+    ret,            /* ReturnStmt */
+    expr14,         /* Expr14 */
+    kv_pair,        /* LiteralDictKVPair */
+    func_decl,      /* FuncDeclStmt */
+    try_catch,      /* TryCatchStmt */
+    elems,          /* MultiElemConstruct<>: Block, ExprList, LiteralArray */
+    ids,            /* MultiElemConstruct<Identifier>: IdList */
+    dict,           /* MultiElemConstruct<LiteralDictKVPair>: LiteralDict */
+};
+
+/* The type_info -> shape cache: open addressing over a table far larger than
+ * the number of node classes, so a probe almost always hits its first slot. */
+struct NodeShapeCache {
+
+    static constexpr unsigned size = 256;
+
+    const std::type_info *keys[size];
+    NodeShape shapes[size];
+
+    static unsigned hash(const std::type_info *t) {
+        return static_cast<unsigned>(reinterpret_cast<std::uintptr_t>(t) >> 4)
+               & (size - 1);
+    }
+};
+
+extern NodeShapeCache g_node_shapes;
+
+/* Classify `t` with the dynamic_cast chain and cache it (first sight only). */
+NodeShape node_shape_slow(const Construct *c, const std::type_info *t);
+
+inline NodeShape node_shape(const Construct *c)
+{
+    if (!c)
+        return NodeShape::leaf;
+
+    const std::type_info *t = &typeid(*c);
+
+    for (unsigned i = NodeShapeCache::hash(t); ;
+         i = (i + 1) & (NodeShapeCache::size - 1))
+    {
+        if (g_node_shapes.keys[i] == t)
+            return g_node_shapes.shapes[i];
+
+        if (!g_node_shapes.keys[i])
+            return node_shape_slow(c, t);
+    }
+}
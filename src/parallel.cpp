@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+bool g_parallel_enabled = true;
+bool g_parallel_loops = false;
+
+namespace {
+
+thread_local bool t_in_worker = false;
+thread_local unsigned t_worker_id = 0;
+
+/*
+ * One job at a time (the interpreter is single-threaded outside par_for, so
+ * only the main thread ever submits). A job is published by bumping `gen`;
+ * every participant (the workers + the submitter) then claims chunk indexes
+ * from `next_chunk` until they run out. The submitter returns only once every
+ * chunk is done AND no worker is still inside run_chunks, so the next job's
+ * fields are never rewritten under a straggler.
+ */
+class WorkerPool {
+
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    unsigned long gen = 0;
+    unsigned active = 0;      /* workers inside run_chunks for this job */
+    bool stop = false;
+
+    const std::function<void(size_t, size_t)> *job = nullptr;
+    size_t job_n = 0;
+    size_t chunk_size = 0;
+    size_t nchunks = 0;
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<size_t> chunks_left{0};
+
+    void run_chunks()
+    {
+        for (;;) {
+
+            const size_t c = next_chunk.fetch_add(1);
+            if (c >= nchunks)
+                return;
+
+            const size_t b = c * chunk_size;
+            (*job)(b, std::min(job_n, b + chunk_size));
+
+            chunks_left.fetch_sub(1);
+        }
+    }
+
+    void worker_main(unsigned id)
+    {
+        t_in_worker = true;
+        t_worker_id = id;
+        unsigned long seen = 0;
+
+        for (;;) {
+
+            {
+                std::unique_lock<std::mutex> lk(mtx);
+                work_cv.wait(lk, [&] { return stop || gen != seen; });
+                if (stop)
+                    return;
+                seen = gen;
+                active++;
+            }
+
+            run_chunks();
+
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                active--;
+            }
+            done_cv.notify_one();
+        }
+    }
+
+public:
+
+    /* `nthreads` participants in all: nthreads - 1 pool threads + the
+     * submitter. */
+    explicit WorkerPool(unsigned nthreads)
+    {
+        for (unsigned i = 1; i < nthreads; i++)
+            threads.emplace_back([this, i] { worker_main(i); });
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            stop = true;
+        }
+        work_cv.notify_all();
+        for (auto &t : threads)
+            t.join();
+    }
+
+    unsigned size() const { return static_cast<unsigned>(threads.size()) + 1; }
+
+    void run(size_t n, const std::function<void(size_t, size_t)> &fn)
+    {
+        /* A few chunks per thread, so an uneven per-item cost still balances
+         * (chunks are claimed dynamically). */
+        const size_t want = static_cast<size_t>(size()) * 4;
+
+        {
+            /* A worker that woke late for the PREVIOUS job may still be in
+             * run_chunks (finding no chunk left): publish only once it left. */
+            std::unique_lock<std::mutex> lk(mtx);
+            done_cv.wait(lk, [&] { return active == 0; });
+
+            chunk_size = std::max<size_t>(1, (n + want - 1) / want);
+            nchunks = (n + chunk_size - 1) / chunk_size;
+            job = &fn;
+            job_n = n;
+            chunks_left.store(nchunks);
+            next_chunk.store(0);
+            gen++;
+        }
+        work_cv.notify_all();
+
+        run_chunks();     /* the submitter is a worker too */
+
+        std::unique_lock<std::mutex> lk(mtx);
+        done_cv.wait(lk, [&] {
+            return chunks_left.load() == 0 && active == 0;
+        });
+    }
+};
+
+unsigned forced_threads = 0;          /* par_set_threads; 0: the hardware */
+std::unique_ptr<WorkerPool> the_pool;
+
+WorkerPool &pool()
+{
+    if (!the_pool) {
+        const unsigned hw = std::thread::hardware_concurrency(); /* 0: unknown */
+        the_pool = std::make_unique<WorkerPool>(
+            forced_threads ? forced_threads : std::max(1u, hw));
+    }
+    return *the_pool;
+}
+
+}  /* anonymous namespace */
+
+unsigned par_workers()
+{
+    if (!g_parallel_enabled || t_in_worker)
+        return 1;
+    return pool().size();
+}
+
+void par_set_threads(unsigned n)
+{
+    the_pool.reset();       /* joins the old threads; rebuilt on next use */
+    forced_threads = n;
+}
+
+bool par_in_worker()
+{
+    return t_in_worker;
+}
+
+unsigned par_worker_id()
+{
+    return t_worker_id;
+}
+
+void par_for(size_t n, const std::function<void(size_t, size_t)> &fn)
+{
+    if (!n)
+        return;
+
+    if (par_workers() <= 1) {
+        fn(0, n);
+        return;
+    }
+
+    pool().run(n, fn);
+}
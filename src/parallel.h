@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/*
+ * A tiny fork-join worker pool for data-parallel work: map/filter over a flat
+ * array with a parallel-safe callback (FuncDeclStmt::par_safe) and, opt-in,
+ * independent counted loops (ForRangeStmt::parallel).
+ *
+ * The interpreter is NOT thread-safe in general: intrusive_ptr refcounts are
+ * plain ints, UniqueId interning is a shared std::set, and a Frame/FlowState
+ * is per-call state. So a worker may only evaluate code that reads scalar
+ * inputs, builds nothing shared and writes only its own output range - the
+ * static par_safe proof (inferencer.cpp) guarantees exactly that, and a caller
+ * never hands a worker anything else.
+ *
+ * The pool is created lazily on the first parallel run (hardware_concurrency
+ * - 1 threads, or par_set_threads' count - 1; the caller's thread is the extra
+ * worker) and joined at exit.
+ */
+
+/* Disabled by the `-npm` CLI flag (everything then runs sequentially). */
+extern bool g_parallel_enabled;
+
+/*
+ * Opt-in (`--parallel-loops`): specialize_types marks a proven-independent
+ * counted `for` (ForRangeStmt::parallel) and its iterations run in chunks on
+ * the pool. Read at compile time only - a tree compiled without it never has
+ * a parallel loop.
+ */
+extern bool g_parallel_loops;
+
+/* Inputs shorter than this never go parallel: the fork-join handoff costs
+ * more than it saves. */
+constexpr size_t PAR_MIN_ITEMS = 2048;
+
+/* The same for a parallel loop, whose body is usually much heavier than one
+ * callback call (a row of a kernel, an inner loop). */
+constexpr size_t PAR_MIN_ITERS = 16;
+
+/* The number of threads a par_for would use (1 == no parallelism). */
+unsigned par_workers();
+
+/*
+ * Size the pool to `n` threads (the caller's included) instead of
+ * hardware_concurrency; 0 goes back to the hardware. `--par-threads N`, and the
+ * unit tests, so the parallel paths run even on a 1-CPU machine. Main thread
+ * only, outside any par_for.
+ */
+void par_set_threads(unsigned n);
+
+/* True on a pool worker thread (a nested par_for there runs inline). */
+bool par_in_worker();
+
+/* This thread's index in [0, par_workers()) during a par_for: 0 for the
+ * submitting thread, 1.. for the pool threads. Lets a caller hand each
+ * participant its own pre-built state (e.g. a Frame copy). */
+unsigned par_worker_id();
+
+/*
+ * Run `fn(begin, end)` over [0, n), split into contiguous chunks, on the pool
+ * AND the calling thread; returns when every chunk is done. `fn` must not throw
+ * (a caller catches inside its chunk and records the failure itself).
+ */
+void par_for(size_t n, const std::function<void(size_t, size_t)> &fn);
@@ -5,6 +5,7 @@
 #include "syntax.h"
 #include "analyzer.h"
 
+#include <set>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -71,16 +72,7 @@ ParseContext::~ParseContext() = default;
 
 unique_ptr<Construct> pExpr01(ParseContext &c, unsigned fl); // ops: ()
 unique_ptr<Construct> pExpr02(ParseContext &c, unsigned fl); // ops: + (unary), - (unary), !
-unique_ptr<Construct> pExpr03(ParseContext &c, unsigned fl); // ops: *, /
-unique_ptr<Construct> pExpr04(ParseContext &c, unsigned fl); // ops: +, -
-unique_ptr<Construct> pExpr05(ParseContext &c, unsigned fl); // ops: <<, >>, >>>
-unique_ptr<Construct> pExpr06(ParseContext &c, unsigned fl); // ops: <, >, <=, >=
-unique_ptr<Construct> pExpr07(ParseContext &c, unsigned fl); // ops: ==, !=
-unique_ptr<Construct> pExpr08(ParseContext &c, unsigned fl); // ops: & (bitwise)
-unique_ptr<Construct> pExpr09(ParseContext &c, unsigned fl); // ops: ^ (bitwise)
-unique_ptr<Construct> pExpr10(ParseContext &c, unsigned fl); // ops: | (bitwise)
-unique_ptr<Construct> pExpr11(ParseContext &c, unsigned fl); // ops: &&
-unique_ptr<Construct> pExpr12(ParseContext &c, unsigned fl); // ops: ||
+unique_ptr<Construct> pExprBinary(ParseContext &c, unsigned fl, int max_level); // ops: * ... || (levels 03-12)
 unique_ptr<Construct> pExprCoalesce(ParseContext &c, unsigned fl); // ?? r-assoc
 unique_ptr<Construct> pExpr13(ParseContext &c, unsigned fl); // ?: r-assoc
 unique_ptr<Construct> pExpr14(ParseContext &c, unsigned fl); // ops: = (assignment)
@@ -479,20 +471,20 @@ build_zero_struct_init(const StructTypeDef *def, Loc loc)
                                          break;
             }
         }
-        a->start = loc;
-        a->end = loc;
+        a->start() = loc;
+        a->end() = loc;
         args->elems.push_back(move(a));
     }
 
     auto callee = make_unique<Identifier>(def->name->val);
-    callee->start = loc;
-    callee->end = loc;
+    callee->start() = loc;
+    callee->end() = loc;
 
     auto call = make_unique<CallExpr>();
     call->what = move(callee);
     call->args = move(args);
-    call->start = loc;
-    call->end = loc;
+    call->start() = loc;
+    call->end() = loc;
     return call;
 }
 
@@ -575,23 +567,23 @@ pAcceptLiteralInt(ParseContext &c, unique_ptr<Construct> &v)
         }
 
         v.reset(new LiteralInt(ival));
-        v->start = start;
-        v->end = c.get_loc() + (s.length() + 1);
+        v->start() = start;
+        v->end() = c.get_loc() + (s.length() + 1);
         c++;
         return true;
 
     } else if (pAcceptKeyword(c, Keyword::kw_true)) {
 
         v.reset(new LiteralBool(true));
-        v->start = start;
-        v->end = c.get_loc() + 5;
+        v->start() = start;
+        v->end() = c.get_loc() + 5;
         return true;
 
     } else if (pAcceptKeyword(c, Keyword::kw_false)) {
 
         v.reset(new LiteralBool(false));
-        v->start = start;
-        v->end = c.get_loc() + 6;
+        v->start() = start;
+        v->end() = c.get_loc() + 6;
         return true;
     }
 
@@ -615,8 +607,8 @@ pAcceptLiteralFloat(ParseContext &c, unique_ptr<Construct> &v)
         }
 
         v.reset(new LiteralFloat(fval));
-        v->start = start;
-        v->end = c.get_loc() + (s.length() + 1);
+        v->start() = start;
+        v->end() = c.get_loc() + (s.length() + 1);
         c++;
         return true;
     }
@@ -629,8 +621,8 @@ pAcceptLiteralStr(ParseContext &c, unique_ptr<Construct> &v)
 {
     if (*c == TokType::str) {
         v.reset(new LiteralStr(c.get_str()));
-        v->start = c.get_loc();
-        v->end = c.get_loc() + (c.get_str().length() + 1);
+        v->start() = c.get_loc();
+        v->end() = c.get_loc() + (c.get_str().length() + 1);
         c++;
         return true;
     }
@@ -681,8 +673,8 @@ pAcceptId(ParseContext &c, unique_ptr<Construct> &v, bool resolve_const = true)
             }
         }
 
-        v->start = c.get_loc();
-        v->end = c.get_loc() + (c.get_str().length() + 1);
+        v->start() = c.get_loc();
+        v->end() = c.get_loc() + (c.get_str().length() + 1);
         c++;
         return true;
     }
@@ -715,7 +707,8 @@ pAcceptKeyword(ParseContext &c, Keyword exp)
 void pExpectOp(ParseContext &c, Op exp)
 {
     if (!pAcceptOp(c, exp))
-        throw SyntaxErrorEx(c.get_loc(), "Expected operator", &c.get_tok(), exp);
+        throw SyntaxErrorEx(c.get_loc(), "Expected operator", &c.get_tok(),
+                            exp);
 }
 
 Op
@@ -867,7 +860,7 @@ pList(ParseContext &c,
     unique_ptr<typename T::ElemType> subexpr;
     bool is_const = true;
 
-    ret->start = c.get_loc();
+    ret->start() = c.get_loc();
     subexpr = lowerE(c, fl);
 
     if (subexpr) {
@@ -888,7 +881,7 @@ pList(ParseContext &c,
         }
     }
 
-    ret->end = c.get_loc() + 1;
+    ret->end() = c.get_loc() + 1;
     ret->is_const = is_const;
     return ret;
 }
@@ -909,7 +902,7 @@ pArgList(ParseContext &c, unsigned fl)
     unique_ptr<ExprList> ret(new ExprList);
     bool is_const = true, any_named = false, seen_named = false;
 
-    ret->start = c.get_loc();
+    ret->start() = c.get_loc();
 
     if (*c != Op::parenR) {
         for (;;) {
@@ -947,7 +940,7 @@ pArgList(ParseContext &c, unsigned fl)
             /* Make a labeled arg's span cover `name:` so an error points at the
              * label, not just the value. */
             if (name)
-                e->start = name_loc;
+                e->start() = name_loc;
 
             is_const = is_const && e->is_const;
             ret->arg_names.push_back(name);
@@ -958,7 +951,7 @@ pArgList(ParseContext &c, unsigned fl)
         }
     }
 
-    ret->end = c.get_loc() + 1;
+    ret->end() = c.get_loc() + 1;
     /* All-positional: drop arg_names so empty() is the fast path consumers key
      * off. A named call's const-ness is the AND of its argument values, same as
      * a positional one - but folding it requires desugaring to positional
@@ -1014,7 +1007,7 @@ pAcceptCallExpr(ParseContext &c,
         unique_ptr<CallExpr> expr(new CallExpr);
 
         ret.reset();
-        expr->start = what->start;
+        expr->start() = what->start();
         expr->what = move(what);
         expr->args = pArgList(c, fl);
 
@@ -1041,7 +1034,7 @@ pAcceptCallExpr(ParseContext &c,
              * color the callee identifier magenta before it is gone. */
             if (c.analysis)
                 if (auto *cid = dynamic_cast<Identifier *>(expr->what.get()))
-                    c.analysis->mark(cid->start,
+                    c.analysis->mark(cid->start(),
                         static_cast<int>(cid->get_str().length()),
                         AnnoKind::folded);
 
@@ -1057,7 +1050,7 @@ pAcceptCallExpr(ParseContext &c,
         if (!ret) {
             /* end spans through the closing ')': the caret convention is
              * loc_end = last-char-column + 2, and get_loc() is the ')' here. */
-            expr->end = c.get_loc() + 2;
+            expr->end() = c.get_loc() + 2;
             ret = move(expr);
         }
 
@@ -1076,7 +1069,7 @@ pAcceptSubscript(ParseContext &c,
 {
     if (pAcceptOp(c, Op::bracketL)) {
 
-        const Loc wstart = what->start;   /* subscripted expr's start */
+        const Loc wstart = what->start();   /* subscripted expr's start */
         unique_ptr<Construct> start = pExprTop(c, fl);
         bool in_slice = false;
 
@@ -1115,8 +1108,8 @@ pAcceptSubscript(ParseContext &c,
 
         /* Set the node's own span (start of the subscripted expr, through ']'),
          * so errors point here and not at an enclosing construct. */
-        ret->start = wstart;
-        ret->end = c.get_loc() + 2;   /* get_loc() is the ']' */
+        ret->start() = wstart;
+        ret->end() = c.get_loc() + 2;   /* get_loc() is the ']' */
 
         if (c.const_eval && ret->is_const) {
 
@@ -1201,20 +1194,21 @@ pAcceptMember(ParseContext &c,
     /* an optional access can yield none, so it is never a parse-time const */
     mem->is_const = what->is_const && !opt;
     mem->optional = opt;
-    mem->start = what->start;
+    mem->start() = what->start();
     mem->what = move(what);
 
     unique_ptr<Construct> tmpId;
 
     if (!pAcceptId(c, tmpId, false)) {
-        throw SyntaxErrorEx(c.get_loc(), "Expected identifier, got", &c.get_tok());
+        throw SyntaxErrorEx(c.get_loc(), "Expected identifier, got",
+                            &c.get_tok());
     }
 
-    mem->end = c.get_loc();
+    mem->end() = c.get_loc();
     unique_ptr<Identifier> id(dynamic_cast<Identifier *>(tmpId.release()));
 
     if (!id)
-        throw InternalErrorEx(mem->start, mem->end);
+        throw InternalErrorEx(mem->start(), mem->end());
 
     mem->memId = SharedStr(string(id->get_str()));
     mem->memUid = UniqueId::get(id->get_str());
@@ -1242,8 +1236,8 @@ pExpr01(ParseContext &c, unsigned fl)
 
         /* `null` is an alias for `none`. */
         main.reset(new LiteralNone());
-        main->start = start;
-        main->end = c.get_loc();
+        main->start() = start;
+        main->end() = c.get_loc();
         return main;     /* Not subscriptable, nor callable */
     }
 
@@ -1263,15 +1257,15 @@ pExpr01(ParseContext &c, unsigned fl)
     } else if (pAcceptOp(c, Op::bracketL)) {
 
         main = pArray(c, fl);
-        main->start = start;            /* the '[' */
-        main->end = c.get_loc() + 2;    /* span through the ']' */
+        main->start() = start;            /* the '[' */
+        main->end() = c.get_loc() + 2;    /* span through the ']' */
         pExpectOp(c, Op::bracketR);
 
     } else if (pAcceptOp(c, Op::braceL)) {
 
         main = pDict(c, fl);
-        main->start = start;            /* the '{' */
-        main->end = c.get_loc() + 2;    /* span through the '}' */
+        main->start() = start;            /* the '{' */
+        main->end() = c.get_loc() + 2;    /* span through the '}' */
         pExpectOp(c, Op::braceR);
 
     } else if (pAcceptId(c, main)) {
@@ -1299,8 +1293,8 @@ pExpr01(ParseContext &c, unsigned fl)
         const Loc opLoc = c.get_loc();
         c++;
         auto id = make_unique<IncDecExpr>();
-        id->start = main->start;
-        id->end = opLoc + 2;       /* span through the ++ / -- */
+        id->start() = main->start();
+        id->end() = opLoc + 2;       /* span through the ++ / -- */
         id->is_prefix = false;
         id->is_inc = is_inc;
         id->lvalue = move(main);
@@ -1310,49 +1304,6 @@ pExpr01(ParseContext &c, unsigned fl)
     return main;
 }
 
-template <class ExprT>
-unique_ptr<Construct>
-pExprGeneric(ParseContext &c,
-             unique_ptr<Construct> (*lowerExpr)(ParseContext&, unsigned),
-             std::initializer_list<Op> ops,
-             unsigned fl)
-{
-    Op op;
-    const Loc start = c.get_loc();
-    unique_ptr<Construct> lowerE = lowerExpr(c, fl);
-    unique_ptr<ExprT> ret;
-    bool is_const;
-
-    if (!lowerE || lowerE->is_nop())
-        return lowerE;
-
-    is_const = lowerE->is_const;
-
-    while ((op = AcceptOneOf(c, ops)) != Op::invalid) {
-
-        if (!ret) {
-            ret.reset(new ExprT);
-            ret->elems.emplace_back(Op::invalid, move(lowerE));
-        }
-
-        lowerE = lowerExpr(c, fl);
-
-        if (!lowerE)
-            noExprError(c);
-
-        is_const = is_const && lowerE->is_const;
-        ret->elems.emplace_back(op, move(lowerE));
-    }
-
-    if (!ret)
-        return lowerE;
-
-    ret->start = start;
-    ret->end = c.get_loc();
-    ret->is_const = is_const;
-    return ret;
-}
-
 unique_ptr<Construct>
 pExpr02(ParseContext &c, unsigned fl)
 {
@@ -1371,8 +1322,8 @@ pExpr02(ParseContext &c, unsigned fl)
         if (!elem)
             noExprError(c);
         auto id = make_unique<IncDecExpr>();
-        id->start = start;
-        id->end = c.get_loc();
+        id->start() = start;
+        id->end() = c.get_loc();
         id->is_prefix = true;
         id->is_inc = is_inc;
         id->lvalue = move(elem);
@@ -1407,93 +1358,118 @@ pExpr02(ParseContext &c, unsigned fl)
         return elem;
 
     ret.reset(new Expr02);
-    ret->start = start;
-    ret->end = c.get_loc();
+    ret->start() = start;
+    ret->end() = c.get_loc();
     ret->is_const = elem->is_const;
     ret->elems.emplace_back(op, move(elem));
     return ret;
 }
 
-unique_ptr<Construct>
-pExpr03(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr03>(
-        c, pExpr02, {Op::times, Op::div, Op::mod}, fl
-    );
-}
+/*
+ * The binary operators of levels 03 (`* / %`) to 12 (`||`), C precedence: a
+ * single precedence-climbing loop instead of one function per level. It builds
+ * the same trees a descent through the levels would - one Expr03..Expr12 node
+ * per run of same-level operators (`a - b + c` is one Expr04 with 3 elems), no
+ * node for a level without operators - but a bare operand costs one table
+ * lookup instead of ten nested calls.
+ */
 
-unique_ptr<Construct>
-pExpr04(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr04>(
-        c, pExpr03, {Op::plus, Op::minus}, fl
-    );
-}
+struct BinopLevels {
+
+    unsigned char level[static_cast<int>(Op::op_count)] = { };
+
+    BinopLevels() {
+        level[static_cast<int>(Op::times)] = 3;
+        level[static_cast<int>(Op::div)] = 3;
+        level[static_cast<int>(Op::mod)] = 3;
+        level[static_cast<int>(Op::plus)] = 4;
+        level[static_cast<int>(Op::minus)] = 4;
+        level[static_cast<int>(Op::shl)] = 5;      /* shift: between additive */
+        level[static_cast<int>(Op::shr)] = 5;      /* and the comparisons     */
+        level[static_cast<int>(Op::ushr)] = 5;
+        level[static_cast<int>(Op::lt)] = 6;
+        level[static_cast<int>(Op::gt)] = 6;
+        level[static_cast<int>(Op::le)] = 6;
+        level[static_cast<int>(Op::ge)] = 6;
+        level[static_cast<int>(Op::eq)] = 7;
+        level[static_cast<int>(Op::noteq)] = 7;
+        level[static_cast<int>(Op::band)] = 8;     /* bitwise &, ^, |: between */
+        level[static_cast<int>(Op::bxor)] = 9;     /* equality and `&&`        */
+        level[static_cast<int>(Op::bor)] = 10;
+        level[static_cast<int>(Op::land)] = 11;
+        level[static_cast<int>(Op::lor)] = 12;
+    }
+};
 
-/* shift `<< >> >>>` : between additive and the comparisons (C precedence). */
-unique_ptr<Construct>
-pExpr05(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr05>(
-        c, pExpr04, {Op::shl, Op::shr, Op::ushr}, fl
-    );
-}
+static const BinopLevels binop_table;
+static constexpr int binop_max_level = 12;
 
-unique_ptr<Construct>
-pExpr06(ParseContext &c, unsigned fl)
+/* The binary level of the current token (0: not a binary operator). */
+static inline int
+binop_level(ParseContext &c)
 {
-    return pExprGeneric<Expr06>(
-        c, pExpr05, {Op::lt, Op::gt, Op::le, Op::ge}, fl
-    );
+    const Tok &t = c.get_tok();
+    return t.type == TokType::op ? binop_table.level[static_cast<int>(t.op)] : 0;
 }
 
-unique_ptr<Construct>
-pExpr07(ParseContext &c, unsigned fl)
+static MultiOpConstruct *
+new_binop_expr(int level)
 {
-    return pExprGeneric<Expr07>(
-        c, pExpr06, {Op::eq, Op::noteq}, fl
-    );
+    switch (level) {
+        case 3:  return new Expr03;
+        case 4:  return new Expr04;
+        case 5:  return new Expr05;
+        case 6:  return new Expr06;
+        case 7:  return new Expr07;
+        case 8:  return new Expr08;
+        case 9:  return new Expr09;
+        case 10: return new Expr10;
+        case 11: return new Expr11;
+        default: return new Expr12;
+    }
 }
 
-/* bitwise `&`, then `^`, then `|` : between equality and `&&` (C precedence). */
+/* An expression whose binary operators are all of level <= max_level. */
 unique_ptr<Construct>
-pExpr08(ParseContext &c, unsigned fl)
+pExprBinary(ParseContext &c, unsigned fl, int max_level)
 {
-    return pExprGeneric<Expr08>(
-        c, pExpr07, {Op::band}, fl
-    );
-}
+    const Loc start = c.get_loc();
+    unique_ptr<Construct> lhs = pExpr02(c, fl);
+    int level;
 
-unique_ptr<Construct>
-pExpr09(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr09>(
-        c, pExpr08, {Op::bxor}, fl
-    );
-}
+    if (!lhs || lhs->is_nop())
+        return lhs;
 
-unique_ptr<Construct>
-pExpr10(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr10>(
-        c, pExpr09, {Op::bor}, fl
-    );
-}
+    while ((level = binop_level(c)) && level <= max_level) {
 
-unique_ptr<Construct>
-pExpr11(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr11>(
-        c, pExpr10, {Op::land}, fl
-    );
-}
+        unique_ptr<MultiOpConstruct> ret(new_binop_expr(level));
+        bool is_const = lhs->is_const;
 
-unique_ptr<Construct>
-pExpr12(ParseContext &c, unsigned fl)
-{
-    return pExprGeneric<Expr12>(
-        c, pExpr11, {Op::lor}, fl
-    );
+        ret->elems.emplace_back(Op::invalid, move(lhs));
+
+        /* The operands bind tighter, so after the run the next operator (if
+         * any) is of a looser level and wraps `ret` in turn. */
+        while (binop_level(c) == level) {
+
+            const Op op = c.get_tok().op;
+            c++;
+
+            unique_ptr<Construct> rhs = pExprBinary(c, fl, level - 1);
+
+            if (!rhs)
+                noExprError(c);
+
+            is_const = is_const && rhs->is_const;
+            ret->elems.emplace_back(op, move(rhs));
+        }
+
+        ret->start() = start;
+        ret->end() = c.get_loc();
+        ret->is_const = is_const;
+        lhs = move(ret);
+    }
+
+    return lhs;
 }
 
 /*
@@ -1504,18 +1480,18 @@ pExpr12(ParseContext &c, unsigned fl)
 unique_ptr<Construct>
 pExprCoalesce(ParseContext &c, unsigned fl)
 {
-    unique_ptr<Construct> lhs = pExpr12(c, fl);
+    unique_ptr<Construct> lhs = pExprBinary(c, fl, binop_max_level);
 
     if (!lhs || !pAcceptOp(c, Op::coalesce))
         return lhs;
 
     unique_ptr<CoalesceExpr> co(new CoalesceExpr);
-    co->start = lhs->start;
+    co->start() = lhs->start();
     co->lhs = move(lhs);
     co->rhs = pExprCoalesce(c, fl);          /* right-associative */
     if (!co->rhs)
         noExprError(c);
-    co->end = co->rhs->end;
+    co->end() = co->rhs->end();
 
     if (c.const_eval && co->lhs->is_const) {
         const EvalValue &v = co->lhs->eval(c.const_ctx);
@@ -1540,7 +1516,7 @@ pExpr13(ParseContext &c, unsigned fl)
 
     const unsigned bfl = fl & ~(pFlags::pInStmt | pFlags::pInDecl);
     unique_ptr<TernaryExpr> t(new TernaryExpr);
-    t->start = cond->start;
+    t->start() = cond->start();
     t->condExpr = move(cond);
     t->thenExpr = pExpr14(c, bfl);           /* middle: full expr, up to ':' */
     if (!t->thenExpr)
@@ -1549,7 +1525,7 @@ pExpr13(ParseContext &c, unsigned fl)
     t->elseExpr = pExpr13(c, bfl);           /* right-associative */
     if (!t->elseExpr)
         noExprError(c);
-    t->end = t->elseExpr->end;
+    t->end() = t->elseExpr->end();
 
     if (c.const_eval && t->condExpr->is_const) {
         const EvalValue &v = t->condExpr->eval(c.const_ctx);
@@ -1761,8 +1737,8 @@ pExpr14(ParseContext &c, unsigned fl)
     }
 
     ret->fl = fl & pFlags::pInDecl;
-    ret->start = start;
-    ret->end = c.get_loc();
+    ret->start() = start;
+    ret->end() = c.get_loc();
 
     /* Propagate a `var opt`/`var dyn` modifier onto the declared identifier(s),
      * so the type inferencer (which reads Identifier::opt_mod/dyn_mod) sees it. */
@@ -1835,7 +1811,8 @@ pExpr14(ParseContext &c, unsigned fl)
     if (c.const_eval && fl & pFlags::pInConstDecl) {
 
         if (!ret->rvalue->is_const)
-            throw ExpressionIsNotConstEx(ret->rvalue->start, ret->rvalue->end);
+            throw ExpressionIsNotConstEx(ret->rvalue->start(),
+                                         ret->rvalue->end());
 
         /*
          * A typed const SCALAR is inlined before the inferencer runs, so check
@@ -1849,7 +1826,7 @@ pExpr14(ParseContext &c, unsigned fl)
                 dt == DeclType::f || dt == DeclType::s) {
                 EvalValue cv = check_coerce_const_scalar(
                     RValue(ret->rvalue->eval(c.const_ctx)), dt,
-                    ret->rvalue->start, ret->rvalue->end);
+                    ret->rvalue->start(), ret->rvalue->end());
                 MakeConstructFromConstVal(cv, ret->rvalue);
             }
         }
@@ -1904,8 +1881,8 @@ pAcceptReturnStmt(ParseContext &c,
 
         stmt->elem = pExpr14(c, fl);
         pExpectOp(c, Op::semicolon);
-        stmt->start = start;
-        stmt->end = c.get_loc();
+        stmt->start() = start;
+        stmt->end() = c.get_loc();
         ret = move(stmt);
         return true;
     }
@@ -1928,8 +1905,8 @@ pAcceptThrowStmt(ParseContext &c,
         if (!t->elem)
             noExprError(c);
 
-        t->start = start;
-        t->end = c.get_loc();
+        t->start() = start;
+        t->end() = c.get_loc();
         ret = move(t);
         return true;
     }
@@ -2036,7 +2013,7 @@ pBlock(ParseContext &c, unsigned fl, bool push_const_scope)
     unique_ptr<Construct> stmt, tmp;
     bool added_elem;
 
-    ret->start = c.get_loc();
+    ret->start() = c.get_loc();
 
     /*
      * A block normally gets its own nested const scope (popped on exit). The
@@ -2074,7 +2051,7 @@ pBlock(ParseContext &c, unsigned fl, bool push_const_scope)
         } while (added_elem);
     }
 
-    ret->end = c.get_loc();
+    ret->end() = c.get_loc();
     c.cse->pop();                      // pop the CSE cache scope
     if (push_const_scope)
         c.const_ctx = c.const_ctx->parent; // restore the previous const ctx
@@ -2132,8 +2109,8 @@ pAcceptIfStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
         }
     }
 
-    ifstmt->start = start;
-    ifstmt->end = c.get_loc();
+    ifstmt->start() = start;
+    ifstmt->end() = c.get_loc();
 
     if (c.const_eval && ifstmt->condExpr->is_const) {
 
@@ -2145,7 +2122,7 @@ pAcceptIfStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
             Construct *dead = t ? ifstmt->elseBlock.get()
                                 : ifstmt->thenBlock.get();
             if (dead)
-                c.analysis->mark_dead(dead->start, dead->end);
+                c.analysis->mark_dead(dead->start(), dead->end());
         }
 
         if (t)
@@ -2189,8 +2166,8 @@ pAcceptWhileStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
     if (!pAcceptBracedBlock(c, whileStmt->body, fl | pFlags::pInLoop))
         whileStmt->body = pStmt(c, fl | pFlags::pInLoop);
 
-    whileStmt->start = start;
-    whileStmt->end = c.get_loc();
+    whileStmt->start() = start;
+    whileStmt->end() = c.get_loc();
 
     if (c.const_eval && whileStmt->condExpr->is_const) {
 
@@ -2200,8 +2177,9 @@ pAcceptWhileStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
             /* -a: while (false) is dead - dim the loop (the body's end, not
              * whileStmt->end, which points at the next token). */
             if (c.analysis)
-                c.analysis->mark_dead(whileStmt->start,
-                    whileStmt->body ? whileStmt->body->end : whileStmt->end);
+                c.analysis->mark_dead(whileStmt->start(),
+                    whileStmt->body ? whileStmt->body->end()
+                                    : whileStmt->end());
             /* a Nop, not NULL: pBlock discards it; a NULL would be read as
              * end-of-block and make the next statement a syntax error. */
             ret = make_unique<NopConstruct>();
@@ -2238,7 +2216,7 @@ pAcceptFuncDecl(ParseContext &c,
     }
 
     unique_ptr<FuncDeclStmt> func(new FuncDeclStmt);
-    func->start = start;
+    func->start() = start;
     func->is_const = is_pure;
     func->explicit_pure = is_pure;
     func->effective_pure = is_pure;
@@ -2249,7 +2227,8 @@ pAcceptFuncDecl(ParseContext &c,
         func->id = pIdentifier(c, fl);
 
         if (!func->id)
-            throw SyntaxErrorEx(c.get_loc(), "Expected identifier, got", &c.get_tok());
+            throw SyntaxErrorEx(c.get_loc(), "Expected identifier, got",
+                                &c.get_tok());
 
     } else {
 
@@ -2285,7 +2264,7 @@ pAcceptFuncDecl(ParseContext &c,
         );
     }
 
-    func->end = c.get_loc() + 1;
+    func->end() = c.get_loc() + 1;
 
     if (c.const_eval && is_pure && func->id)
         func->eval(c.const_ctx);
@@ -2424,7 +2403,7 @@ pAcceptStructDecl(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
         return false;
 
     auto stmt = make_unique<StructDeclStmt>();
-    stmt->start = start;
+    stmt->start() = start;
     stmt->id = pIdentifier(c, fl & ~pFlags::pInStmt);
 
     if (!stmt->id)
@@ -2463,7 +2442,7 @@ pAcceptStructDecl(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
             if (!rv)
                 noExprError(c);
             if (!rv->is_const)
-                throw ExpressionIsNotConstEx(rv->start, rv->end);
+                throw ExpressionIsNotConstEx(rv->start(), rv->end());
 
             EvalValue cv = make_const_clone(RValue(rv->eval(c.const_ctx)));
             stmt->def->consts.emplace_back(cn, move(cv));
@@ -2549,7 +2528,7 @@ pAcceptStructDecl(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
         field_locs.push_back(mloc);
     }
 
-    stmt->end = c.get_loc() + 1;
+    stmt->end() = c.get_loc() + 1;
 
     /* reject an infinitely-recursive struct (a non-opt self/mutual struct
      * field) with a clear "box it as 'dyn?'" message - before compute_layout,
@@ -2856,7 +2835,8 @@ pAcceptTryCatchStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
     bool have_catch_anything = false;
 
     if (!pAcceptBracedBlock(c, stmt->tryBody, fl))
-        throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got", &c.get_tok());
+        throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got",
+                            &c.get_tok());
 
     while (pAcceptKeyword(c, Keyword::kw_catch)) {
 
@@ -2907,7 +2887,8 @@ pAcceptTryCatchStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
         }
 
         if (!pAcceptBracedBlock(c, body, fl | pFlags::pInCatchBody))
-            throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got", &c.get_tok());
+            throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got",
+                                &c.get_tok());
 
         stmt->catchStmts.emplace_back(
             AllowedExList{move(exList), move(asId)},
@@ -2918,7 +2899,8 @@ pAcceptTryCatchStmt(ParseContext &c, unique_ptr<Construct> &ret, unsigned fl)
     if (pAcceptKeyword(c, Keyword::kw_finally)) {
 
         if (!pAcceptBracedBlock(c, stmt->finallyBody, fl))
-            throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got", &c.get_tok());
+            throw SyntaxErrorEx(c.get_loc(), "Expected { } block, got",
+                                &c.get_tok());
     }
 
     if (!stmt->catchStmts.size() && !stmt->finallyBody) {
@@ -2955,7 +2937,8 @@ pAcceptForeachStmt(ParseContext &c,
         throw SyntaxErrorEx(c.get_loc(), "Expected at least one identifier");
 
     if (!pAcceptKeyword(c, Keyword::kw_in))
-        throw SyntaxErrorEx(c.get_loc(), "Expected keyword `in`, got", &c.get_tok());
+        throw SyntaxErrorEx(c.get_loc(), "Expected keyword `in`, got",
+                            &c.get_tok());
 
     if (pAcceptKeyword(c, Keyword::kw_indexed))
         stmt->indexed = true;
@@ -2966,8 +2949,8 @@ pAcceptForeachStmt(ParseContext &c,
         noExprError(c);
 
     pExpectOp(c, Op::parenR);
-    stmt->start = start;
-    stmt->end = c.get_loc();
+    stmt->start() = start;
+    stmt->end() = c.get_loc();
 
     if (!pAcceptBracedBlock(c, stmt->body, fl | pFlags::pInLoop))
         stmt->body = pStmt(c, fl | pFlags::pInLoop);
@@ -2986,8 +2969,8 @@ pAcceptForeachStmt(ParseContext &c,
             }
 
         } catch (Exception &e) {
-            e.loc_start = stmt->container->start;
-            e.loc_end = stmt->container->end;
+            e.loc_start = stmt->container->start();
+            e.loc_end = stmt->container->end();
             throw;
         }
     }
@@ -3007,7 +2990,7 @@ pAcceptForStmt(ParseContext &c,
         return false;
 
     unique_ptr<ForStmt> stmt(new ForStmt);
-    stmt->start = start;
+    stmt->start() = start;
     pExpectOp(c, Op::parenL);
 
     {
@@ -3030,7 +3013,7 @@ pAcceptForStmt(ParseContext &c,
     if (!pAcceptBracedBlock(c, stmt->body, fl | pFlags::pInLoop))
         stmt->body = pStmt(c, fl);
 
-    stmt->end = c.get_loc();
+    stmt->end() = c.get_loc();
     ret = move(stmt);
     return true;
 }
@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "passtimer.h"
+#include "syntax.h"
+#include "statictype.h"
+#include "astarena.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using std::string;
+using std::vector;
+
+bool g_time_passes = false;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct PassRec {
+    const char *name;
+    int depth;
+    Clock::time_point t0, t1;
+    long rss0 = 0, rss1 = 0;                /* peak RSS, KB */
+    size_t nodes0 = 0, nodes1 = 0;          /* live AST nodes */
+    size_t types0 = 0, types1 = 0;          /* static types allocated */
+    bool done = false;
+    string note;
+};
+
+vector<PassRec> recs;
+int depth = 0;
+
+long peak_rss_kb()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;        /* KB on Linux (bytes on macOS) */
+#endif
+}
+
+double pass_ms(const PassRec &r)
+{
+    return std::chrono::duration<double, std::milli>(r.t1 - r.t0).count();
+}
+
+long pass_peak_rss_kb()
+{
+    long rss = 0;
+    for (const PassRec &r : recs)
+        rss = std::max(rss, r.rss1);
+    return rss;
+}
+
+}  /* anonymous namespace */
+
+int pass_begin(const char *name)
+{
+    PassRec r;
+    r.name = name;
+    r.depth = depth++;
+    r.rss0 = peak_rss_kb();
+    r.nodes0 = Construct::live_count;
+    r.types0 = StaticTypeArena::allocated;
+    r.t0 = Clock::now();
+
+    recs.push_back(move(r));
+    return static_cast<int>(recs.size() - 1);
+}
+
+void pass_end(int i)
+{
+    PassRec &r = recs[i];
+
+    r.t1 = Clock::now();
+    r.rss1 = peak_rss_kb();
+    r.nodes1 = Construct::live_count;
+    r.types1 = StaticTypeArena::allocated;
+    r.done = true;
+    depth--;
+}
+
+void pass_note(int i, const string &note)
+{
+    recs[i].note = note;
+}
+
+void pass_reset()
+{
+    recs.clear();
+    depth = 0;
+}
+
+void pass_report(std::ostream &o)
+{
+    char buf[160];
+    double total_ms = 0;
+
+    o << "\nCompile passes\n\n";
+    snprintf(buf, sizeof(buf), "  %-26s %10s %10s %10s %10s %10s\n",
+             "pass", "wall ms", "+RSS KB", "AST nodes", "+nodes", "+types");
+    o << buf;
+
+    for (const PassRec &r : recs) {
+
+        /* A pass an exception escaped from has no end: skip it. */
+        if (!r.done)
+            continue;
+
+        const double ms = pass_ms(r);
+        const string label = string(2 * r.depth, ' ') + r.name;
+
+        if (!r.depth)
+            total_ms += ms;
+
+        snprintf(buf, sizeof(buf), "  %-26s %10.2f %10ld %10zu %+10ld %10zu",
+                 label.c_str(), ms, r.rss1 - r.rss0, r.nodes1,
+                 static_cast<long>(r.nodes1) - static_cast<long>(r.nodes0),
+                 r.types1 - r.types0);
+        o << buf;
+
+        if (!r.note.empty())
+            o << "  (" << r.note << ")";
+
+        o << "\n";
+    }
+
+    snprintf(buf, sizeof(buf),
+             "  %-26s %10.2f   (peak RSS %ld KB, AST arena %zu KB)\n",
+             "total", total_ms, pass_peak_rss_kb(), ast_arena_bytes() / 1024);
+    o << buf;
+}
+
+void pass_report_csv(std::ostream &o)
+{
+    char buf[160];
+    double total_ms = 0;
+
+    o << "pass,depth,wall_ms,rss_kb,ast_nodes,node_delta,types,note\n";
+
+    for (const PassRec &r : recs) {
+
+        if (!r.done)
+            continue;
+
+        const double ms = pass_ms(r);
+
+        if (!r.depth)
+            total_ms += ms;
+
+        snprintf(buf, sizeof(buf), "%s,%d,%.3f,%ld,%zu,%ld,%zu,",
+                 r.name, r.depth, ms, r.rss1 - r.rss0, r.nodes1,
+                 static_cast<long>(r.nodes1) - static_cast<long>(r.nodes0),
+                 r.types1 - r.types0);
+        o << buf;
+
+        /* the notes are free text: keep the row's column count */
+        string note = r.note;
+        std::replace(note.begin(), note.end(), ',', ';');
+        o << note << "\n";
+    }
+
+    snprintf(buf, sizeof(buf), "total,0,%.3f,%ld,,,,AST arena %zu KB\n",
+             total_ms, pass_peak_rss_kb(), ast_arena_bytes() / 1024);
+    o << buf;
+}
+
+void pass_report_at_exit()
+{
+    pass_report(std::cerr);
+}
+
+void pass_report_csv_at_exit()
+{
+    pass_report_csv(std::cerr);
+}
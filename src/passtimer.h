@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <string>
+#include <iosfwd>
+
+/*
+ * Per-pass compile timing (`--time-passes`): wall time, peak-RSS growth, and
+ * the AST node and static-type counts around each stage of the pipeline main
+ * runs before `root->eval` (lex, parse, implicit globals, type inference, the
+ * optimizers) and the sub-passes inside them (the inferencer's fixpoint and
+ * monomorphization, the resolver's auto-const, the inliner, LICM, ...). The
+ * table goes to stderr at exit, sub-passes indented under their stage (or, with
+ * `--time-passes=csv`, one CSV row per pass).
+ *
+ * A stage is a PassTimer scope; with the flag off the constructor and
+ * destructor each test one bool, and the compile pipeline runs once anyway.
+ */
+
+extern bool g_time_passes;
+
+int pass_begin(const char *name);
+void pass_end(int rec);
+void pass_note(int rec, const std::string &note);
+
+/* Print the table to `o`; the at-exit form (registered with atexit by
+ * `--time-passes`) prints it to stderr. */
+void pass_report(std::ostream &o);
+void pass_report_at_exit();
+
+/* The same rows as CSV, for scripts (`--time-passes=csv`, bench/run.py
+ * --compile): `pass,depth,wall_ms,rss_kb,ast_nodes,node_delta,types,note`,
+ * where rss_kb is the pass's peak-RSS growth. A last `total` row has the
+ * top-level wall time and the process's peak RSS. */
+void pass_report_csv(std::ostream &o);
+void pass_report_csv_at_exit();
+
+/* Forget the recorded passes (the unit tests). */
+void pass_reset();
+
+class PassTimer {
+
+    int rec = -1;
+
+public:
+
+    explicit PassTimer(const char *name)
+    {
+        if (g_time_passes)
+            rec = pass_begin(name);
+    }
+
+    ~PassTimer()
+    {
+        if (rec >= 0)
+            pass_end(rec);
+    }
+
+    /* A detail shown on the pass's row (e.g. the fixpoint's round count). */
+    void note(const std::string &s)
+    {
+        if (rec >= 0)
+            pass_note(rec, s);
+    }
+
+    PassTimer(const PassTimer &) = delete;
+    PassTimer &operator=(const PassTimer &) = delete;
+};
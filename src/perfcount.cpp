@@ -0,0 +1,273 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "perfcount.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+using std::string;
+using std::vector;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const char *const counter_names[perf_counter_count] = {
+    "cycles",
+    "instructions",
+    "cache_misses",
+    "branch_misses",
+};
+
+/* The group: fds[i] is counter i, or -1; `slot[i]` its index in a read. */
+bool opened = false;
+int fds[perf_counter_count] = { -1, -1, -1, -1 };
+int slot[perf_counter_count] = { -1, -1, -1, -1 };
+int leader = -1;
+int nr_open = 0;
+string open_error;
+
+struct Region {
+    string name;
+    uint64_t count = 0;
+    PerfSample total{};
+};
+
+struct OpenRegion {
+    size_t region;
+    PerfSample start;
+};
+
+vector<Region> regions;                     /* in first-opened order */
+std::unordered_map<string, size_t> region_idx;
+vector<OpenRegion> open_stack;
+
+#ifdef __linux__
+
+int open_counter(uint64_t config, int group_fd)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0 /* this thread */,
+                -1 /* any cpu */, group_fd, 0)
+    );
+}
+
+void open_group()
+{
+    static const uint64_t configs[perf_counter_count] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    for (unsigned i = 0; i < perf_counter_count; i++) {
+
+        const int fd = open_counter(configs[i], leader);
+
+        if (fd < 0) {
+            if (open_error.empty())
+                open_error = string(counter_names[i]) + ": " + strerror(errno);
+            continue;
+        }
+
+        if (leader < 0)
+            leader = fd;
+
+        fds[i] = fd;
+        slot[i] = nr_open++;
+    }
+}
+
+#endif
+
+PerfSample sample()
+{
+    PerfSample s;
+
+    for (int64_t &v : s.ctr)
+        v = -1;
+
+    s.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+
+    if (!opened) {
+#ifdef __linux__
+        open_group();
+#else
+        open_error = "perf_event_open is Linux-only";
+#endif
+        opened = true;
+    }
+
+#ifdef __linux__
+    if (leader < 0)
+        return s;
+
+    /* PERF_FORMAT_GROUP: nr, time_enabled, time_running, values[nr] */
+    uint64_t buf[3 + perf_counter_count];
+
+    if (read(leader, buf, sizeof(buf)) < static_cast<ssize_t>(
+            (3 + nr_open) * sizeof(uint64_t)))
+        return s;
+
+    const uint64_t enabled = buf[1], running = buf[2];
+    const double scale =
+        running && running < enabled ? double(enabled) / running : 1.0;
+
+    for (unsigned i = 0; i < perf_counter_count; i++)
+        if (slot[i] >= 0)
+            s.ctr[i] = static_cast<int64_t>(buf[3 + slot[i]] * scale);
+#endif
+
+    return s;
+}
+
+void close_innermost(const PerfSample &now, PerfSample *out)
+{
+    const OpenRegion o = open_stack.back();
+    open_stack.pop_back();
+
+    Region &r = regions[o.region];
+    PerfSample d;
+
+    for (unsigned i = 0; i < perf_counter_count; i++) {
+
+        if (o.start.ctr[i] < 0 || now.ctr[i] < 0) {
+            d.ctr[i] = -1;
+            r.total.ctr[i] = -1;
+            continue;
+        }
+
+        d.ctr[i] = now.ctr[i] - o.start.ctr[i];
+
+        if (r.total.ctr[i] >= 0)
+            r.total.ctr[i] += d.ctr[i];
+    }
+
+    d.wall_ns = now.wall_ns - o.start.wall_ns;
+    r.total.wall_ns += d.wall_ns;
+    r.count++;
+
+    if (out)
+        *out = d;
+}
+
+}  /* anonymous namespace */
+
+const char *perf_counter_name(unsigned c)
+{
+    return counter_names[c];
+}
+
+void perf_region_begin(const string &name)
+{
+    auto it = region_idx.find(name);
+    size_t idx;
+
+    if (it == region_idx.end()) {
+        idx = regions.size();
+        regions.emplace_back();
+        regions.back().name = name;
+        region_idx.emplace(name, idx);
+    } else {
+        idx = it->second;
+    }
+
+    /* Sample last, so the region's own bookkeeping isn't counted. */
+    open_stack.push_back(OpenRegion{ idx, PerfSample() });
+    open_stack.back().start = sample();
+}
+
+bool perf_region_end(const string &name, PerfSample &out)
+{
+    const PerfSample now = sample();
+
+    if (open_stack.empty() || regions[open_stack.back().region].name != name)
+        return false;
+
+    close_innermost(now, &out);
+    return true;
+}
+
+void perf_run_begin()
+{
+    perf_region_begin("<run>");
+}
+
+void perf_report_at_exit()
+{
+    const PerfSample now = sample();
+
+    /* A region open at exit (the whole run, or one an exit() cut short). */
+    while (!open_stack.empty())
+        close_innermost(now, nullptr);
+
+    std::ostream &o = std::cerr;
+    char buf[200];
+
+    o << "\nHardware counters by region (inclusive; main thread)\n\n";
+
+    if (leader < 0)
+        o << "  counters unavailable (" << open_error << "; see "
+          << "/proc/sys/kernel/perf_event_paranoid): wall time only\n\n";
+    else if (!open_error.empty())
+        o << "  some counters unavailable (" << open_error << ")\n\n";
+
+    snprintf(buf, sizeof(buf), "  %-20s %8s %10s %14s %14s %6s %10s %10s\n",
+             "region", "count", "wall ms", "cycles", "instructions",
+             "IPC", "cmiss/Ki", "bmiss/Ki");
+    o << buf;
+
+    for (const Region &r : regions) {
+
+        const int64_t *c = r.total.ctr;
+        const double kinstr = c[perf_instructions] / 1000.0;
+        char cyc[24] = "-", ins[24] = "-";
+        char ipc[16] = "-", cm[16] = "-", bm[16] = "-";
+
+        if (c[perf_cycles] >= 0)
+            snprintf(cyc, sizeof(cyc), "%lld",
+                     static_cast<long long>(c[perf_cycles]));
+        if (c[perf_instructions] >= 0)
+            snprintf(ins, sizeof(ins), "%lld",
+                     static_cast<long long>(c[perf_instructions]));
+
+        if (c[perf_cycles] > 0 && c[perf_instructions] >= 0)
+            snprintf(ipc, sizeof(ipc), "%.2f",
+                     double(c[perf_instructions]) / c[perf_cycles]);
+        if (kinstr > 0 && c[perf_cache_misses] >= 0)
+            snprintf(cm, sizeof(cm), "%.2f", c[perf_cache_misses] / kinstr);
+        if (kinstr > 0 && c[perf_branch_misses] >= 0)
+            snprintf(bm, sizeof(bm), "%.2f", c[perf_branch_misses] / kinstr);
+
+        snprintf(buf, sizeof(buf),
+                 "  %-20s %8llu %10.2f %14s %14s %6s %10s %10s\n",
+                 r.name.c_str(), static_cast<unsigned long long>(r.count),
+                 r.total.wall_ns / 1e6, cyc, ins, ipc, cm, bm);
+        o << buf;
+    }
+}
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Hardware performance counters for script regions (the `perf_begin(name)` /
+ * `perf_end(name)` builtins, `--perf-counters`).
+ *
+ * One Linux perf_event_open group (cycles, instructions, cache misses, branch
+ * misses), user-space only, opened on first use and left running: a region is
+ * the difference of two reads of the group, so opening and closing one costs
+ * a read(2) each. When the kernel multiplexes the group the counts are scaled
+ * by enabled/running time, as `perf stat` does. A counter the machine or the
+ * perf_event_paranoid setting refuses reads as -1; wall time is always there.
+ *
+ * Regions nest (each counts inclusively) and must close innermost first. The
+ * counters follow the main thread only: work a parallel loop hands to the
+ * pool (parallel.h) is not counted. `--perf-counters` wraps the run in a
+ * "<run>" region and prints every region's totals to stderr at exit; without
+ * it, perf_end's result is the only report.
+ */
+
+enum PerfCounter : unsigned {
+    perf_cycles,
+    perf_instructions,
+    perf_cache_misses,
+    perf_branch_misses,
+    perf_counter_count
+};
+
+struct PerfSample {
+    int64_t ctr[perf_counter_count];    /* -1: counter unavailable */
+    int64_t wall_ns;
+};
+
+/* The user-facing name of a counter ("cycles", "cache_misses", ...). */
+const char *perf_counter_name(unsigned c);
+
+/* Open a region. */
+void perf_region_begin(const std::string &name);
+
+/* Close the innermost region, which must be `name`: returns false (and does
+ * nothing) otherwise. On success `out` is the region's counts. */
+bool perf_region_end(const std::string &name, PerfSample &out);
+
+/* `--perf-counters`: open the "<run>" region; the report at exit closes any
+ * region still open and prints the table. */
+void perf_run_begin();
+void perf_report_at_exit();
@@ -0,0 +1,417 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "profiler.h"
+#include "syntax.h"
+#include "errors.h"
+#include "backtrace.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/time.h>
+#endif
+
+using std::string;
+using std::vector;
+
+bool g_profiling = false;
+
+namespace {
+
+/* The sampling period, in microseconds of process CPU time. */
+constexpr long PROF_INTERVAL_US = 1000;
+
+/* Rows printed per report table. */
+constexpr size_t PROF_TOP = 20;
+
+/* Bumped by the SIGPROF handler; drained at the next safe point. */
+std::atomic<unsigned> g_ticks{0};
+
+struct ShadowFrame {
+    const FuncDeclStmt *fn;      /* null for the top level ("main") */
+    const Construct *stmt;       /* the statement now running, if any */
+};
+
+/* shadow[0] is "main"; the innermost call is at the back. */
+vector<ShadowFrame> shadow;
+
+/* A sampled frame, resolved to strings (the AST is gone by report time). */
+struct ProfFrame {
+    string func;
+    int line;
+};
+
+vector<ProfFrame> frames;                          /* frame id -> frame */
+std::map<std::pair<string, int>, unsigned> frame_ids;
+
+/* (fn, stmt) -> its frame ids, outermost first: one id, or more when the
+ * statement was spliced in by inlining. */
+std::map<std::pair<const void *, const void *>, vector<unsigned>> resolved;
+
+/* Sample counts per distinct stack of frame ids (outermost first). */
+std::map<vector<unsigned>, unsigned long> stacks;
+unsigned long total_samples = 0;
+
+string folded_out;
+
+/* Process CPU time at prof_start: the report spreads the CPU time actually
+ * used over the samples, since a kernel may deliver the timer coarser than
+ * the requested period. */
+std::clock_t start_clock;
+
+#ifndef _WIN32
+void on_sigprof(int)
+{
+    g_ticks.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+string func_name(const FuncDeclStmt *f)
+{
+    if (!f)
+        return "main";
+
+    if (!f->display_name.empty())
+        return f->display_name;         /* e.g. a specialized clone */
+
+    return f->id ? string(f->id->get_str()) : "<lambda>";
+}
+
+unsigned frame_id(const string &func, int line)
+{
+    auto r = frame_ids.emplace(std::make_pair(func, line),
+                               static_cast<unsigned>(frames.size()));
+
+    if (r.second)
+        frames.push_back({ func, line });
+
+    return r.first->second;
+}
+
+const vector<unsigned> &resolve(const ShadowFrame &sf)
+{
+    auto r = resolved.emplace(std::make_pair(sf.fn, sf.stmt),
+                              vector<unsigned>());
+    vector<unsigned> &ids = r.first->second;
+
+    if (!r.second)
+        return ids;
+
+    const string name = func_name(sf.fn);
+
+    if (!sf.stmt) {
+        /* An expression-bodied function has no statements: its own line. */
+        ids.push_back(frame_id(name, sf.fn ? sf.fn->start().line : 0));
+        return ids;
+    }
+
+    /*
+     * An inlined statement: the physical frame is at the outermost call site,
+     * then the backtrace's virtual frames (inline_frames, innermost first),
+     * each at the call site of the next one in; the innermost is at the
+     * statement itself.
+     */
+    vector<BacktraceFrame> chain;
+    inline_frames(sf.stmt->inline_ctx(), chain);
+
+    if (chain.empty()) {
+        ids.push_back(frame_id(name, sf.stmt->start().line));
+        return ids;
+    }
+
+    ids.push_back(frame_id(name, chain.back().call_site.line));
+
+    for (size_t i = chain.size(); i-- > 0; ) {
+        const int line = i ? chain[i - 1].call_site.line
+                           : sf.stmt->start().line;
+        ids.push_back(frame_id(chain[i].name, line));
+    }
+
+    return ids;
+}
+
+/* Charge the pending ticks to the shadow stack as it stands. */
+void take()
+{
+    const unsigned n = g_ticks.exchange(0, std::memory_order_relaxed);
+
+    if (!n)
+        return;
+
+    vector<unsigned> key;
+
+    for (const ShadowFrame &sf : shadow) {
+        const vector<unsigned> &ids = resolve(sf);
+        key.insert(key.end(), ids.begin(), ids.end());
+    }
+
+    stacks[key] += n;
+    total_samples += n;
+}
+
+struct Row {
+    string label;
+    unsigned long self = 0;
+    unsigned long total = 0;
+};
+
+void print_table(std::ostream &o, const char *what, std::map<string, Row> &m,
+                 double ms)
+{
+    vector<Row> rows;
+
+    for (auto &kv : m)
+        rows.push_back(kv.second);
+
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) {
+        if (a.self != b.self)
+            return a.self > b.self;
+        if (a.total != b.total)
+            return a.total > b.total;
+        return a.label < b.label;
+    });
+
+    char buf[96];
+
+    o << "\n  self ms   self%  total ms  total%  " << what << "\n";
+
+    for (size_t i = 0; i < rows.size() && i < PROF_TOP; i++) {
+
+        snprintf(buf, sizeof(buf), "%9.0f  %5.1f%%  %8.0f  %5.1f%%  ",
+                 rows[i].self * ms, 100.0 * rows[i].self / total_samples,
+                 rows[i].total * ms, 100.0 * rows[i].total / total_samples);
+
+        o << buf << rows[i].label << "\n";
+    }
+
+    if (rows.size() > PROF_TOP)
+        o << "  ... " << rows.size() - PROF_TOP << " more\n";
+}
+
+/* The collapsed stacks to the --profile file; an empty file for a run that
+ * took no sample, so a consumer always finds one. */
+void write_folded(std::ostream &o,
+                  const std::map<string, unsigned long> &folded)
+{
+    if (folded_out.empty())
+        return;                     /* a REPL :profile session */
+
+    std::ofstream fs(folded_out);
+
+    if (!fs) {
+        o << "\nProfile: cannot write '" << folded_out << "'\n";
+        return;
+    }
+
+    for (const auto &kv : folded)
+        fs << kv.first << " " << kv.second << "\n";
+
+    o << "\nCollapsed stacks written to '" << folded_out << "'\n";
+}
+
+void report(std::ostream &o)
+{
+    std::map<string, Row> funcs, lines;
+    std::map<string, unsigned long> folded;
+
+    if (!total_samples) {
+        o << "\nProfile: no samples (the program ran for less than "
+          << PROF_INTERVAL_US / 1000.0 << " ms of CPU time)\n";
+        write_folded(o, folded);
+        return;
+    }
+
+    for (const auto &kv : stacks) {
+
+        const vector<unsigned> &st = kv.first;
+        const unsigned long n = kv.second;
+        std::set<string> seen_f, seen_l;
+        string fold;
+
+        for (size_t i = 0; i < st.size(); i++) {
+
+            const ProfFrame &f = frames[st[i]];
+            const string ln = f.func + "  line " + std::to_string(f.line);
+
+            if (seen_f.insert(f.func).second)
+                funcs[f.func].total += n;
+            if (seen_l.insert(ln).second)
+                lines[ln].total += n;
+
+            fold += (i ? ";" : "") + f.func;
+        }
+
+        const ProfFrame &leaf = frames[st.back()];
+        funcs[leaf.func].self += n;
+        lines[leaf.func + "  line " + std::to_string(leaf.line)].self += n;
+        folded[fold] += n;
+    }
+
+    for (auto &kv : funcs)
+        kv.second.label = kv.first;
+    for (auto &kv : lines)
+        kv.second.label = kv.first;
+
+    const double cpu_ms =
+        1000.0 * (std::clock() - start_clock) / CLOCKS_PER_SEC;
+
+    o << "\nProfile: " << total_samples << " samples over "
+      << static_cast<long>(cpu_ms) << " ms of CPU time\n";
+
+    print_table(o, "function", funcs, cpu_ms / total_samples);
+    print_table(o, "line", lines, cpu_ms / total_samples);
+    write_folded(o, folded);
+}
+
+#ifndef _WIN32
+void start_timer()
+{
+    shadow.reserve(256);
+    shadow.push_back({ nullptr, nullptr });
+    start_clock = std::clock();
+
+    struct sigaction sa = {};
+    sa.sa_handler = on_sigprof;
+    sa.sa_flags = SA_RESTART;     /* a sample must not fail a blocking read */
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, nullptr);
+
+    itimerval it = {};
+    it.it_interval.tv_usec = PROF_INTERVAL_US;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_PROF, &it, nullptr);
+    g_profiling = true;
+}
+
+void stop_timer()
+{
+    itimerval off = {};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    g_profiling = false;
+}
+
+void prof_finish()
+{
+    stop_timer();
+
+    /*
+     * Pending ticks (less than one period) are dropped, not charged: by now
+     * main() has returned and the AST the shadow stack points into is gone.
+     */
+    report(std::cerr);
+}
+#endif
+
+}  /* anonymous namespace */
+
+bool prof_start(const string &folded_path)
+{
+#ifdef _WIN32
+
+    (void)folded_path;
+    return false;
+
+#else
+
+    folded_out = folded_path;
+    start_timer();
+
+    /* At exit, so an exit() from the script still reports. */
+    atexit(prof_finish);
+    return true;
+
+#endif
+}
+
+bool prof_session_begin()
+{
+#ifdef _WIN32
+
+    return false;
+
+#else
+
+    if (g_profiling)
+        return false;
+
+    /* Nothing survives from the last session: its AST may be gone, and a new
+     * node could reuse a resolved (fn, stmt) address. */
+    shadow.clear();
+    frames.clear();
+    frame_ids.clear();
+    resolved.clear();
+    stacks.clear();
+    total_samples = 0;
+    folded_out.clear();
+    g_ticks.store(0, std::memory_order_relaxed);
+
+    start_timer();
+    return true;
+
+#endif
+}
+
+void prof_session_end(std::ostream &out)
+{
+#ifndef _WIN32
+
+    /* Unlike at exit, the AST is still alive: charge the pending ticks. */
+    take();
+    stop_timer();
+    shadow.clear();
+    report(out);
+
+#endif
+}
+
+vector<std::pair<string, int>>
+prof_resolve(const FuncDeclStmt *fn, const Construct *s)
+{
+    vector<std::pair<string, int>> out;
+
+    for (unsigned id : resolve({ fn, s }))
+        out.emplace_back(frames[id].func, frames[id].line);
+
+    /* Not kept: the node may be gone before the next lookup at its address. */
+    resolved.erase(std::make_pair(static_cast<const void *>(fn),
+                                  static_cast<const void *>(s)));
+    return out;
+}
+
+void prof_stmt(const Construct *s)
+{
+    if (par_in_worker())
+        return;
+
+    take();
+    shadow.back().stmt = s;
+}
+
+void prof_enter(const FuncDeclStmt *f)
+{
+    if (par_in_worker())
+        return;
+
+    take();
+    shadow.push_back({ f, nullptr });
+}
+
+void prof_leave()
+{
+    if (par_in_worker())
+        return;
+
+    take();
+    shadow.pop_back();
+}
@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <string>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+
+class Construct;
+class FuncDeclStmt;
+
+/*
+ * Script-level sampling profiler (`--profile FILE`).
+ *
+ * While profiling, the evaluator keeps a SHADOW call stack of MyLang frames:
+ * do_func_call pushes the callee (ProfScope) and every Block statement records
+ * itself as its frame's current statement (prof_stmt). A CPU-time interval
+ * timer (SIGPROF) only bumps an atomic tick counter - the handler touches
+ * nothing else - and the next statement boundary or function return (a safe
+ * point) charges the pending ticks to the stack as it stands. So a tick lands
+ * on the statement that was running when it fired, and a long builtin call is
+ * charged to its own statement, not to the next one.
+ *
+ * A sampled frame is resolved at once to (function name, line), expanding an
+ * inlined statement's InlineCtx chain into the same virtual frames the
+ * backtrace shows (inline_frames), so an inlined callee still appears.
+ * At exit the report (per-function and per-line self/total time) goes to
+ * stderr and the collapsed stacks ("main;f;g 42" lines, the input of the
+ * usual flame-graph tools) to the file.
+ *
+ * Only the main thread's stack is tracked: a pool worker (parallel.h) neither
+ * pushes nor records, and a tick taken there is charged to the main thread's
+ * stack (the par_for that spawned it). Unix-only (no SIGPROF on Windows).
+ */
+
+/* True while profiling; the eval hooks test only this when it's off. */
+extern bool g_profiling;
+
+/* Start the timer and arrange for the report at exit. `folded_path` receives
+ * the collapsed stacks. Returns false where profiling is unsupported. */
+bool prof_start(const std::string &folded_path);
+
+/* Profile one stretch of evaluation (the REPL's `:profile`): start the timer
+ * without the at-exit report; the end prints the tables, but no collapsed
+ * stacks, to `out`. Returns false where unsupported or while --profile runs. */
+bool prof_session_begin();
+void prof_session_end(std::ostream &out);
+
+/* The (function, line) frames a sample taken at statement `s` of `fn` (null:
+ * the top level) is charged to, outermost first; the unit tests. */
+std::vector<std::pair<std::string, int>>
+prof_resolve(const FuncDeclStmt *fn, const Construct *s);
+
+/* Statement boundary: charge pending ticks, then make `s` the current
+ * statement of the innermost frame. Call only when g_profiling. */
+void prof_stmt(const Construct *s);
+
+void prof_enter(const FuncDeclStmt *f);
+void prof_leave();
+
+/* A MyLang call frame on the shadow stack, for the duration of a call. */
+class ProfScope {
+
+    bool active = false;
+
+public:
+
+    explicit ProfScope(const FuncDeclStmt *f)
+    {
+        if (g_profiling) {
+            prof_enter(f);
+            active = true;
+        }
+    }
+
+    ~ProfScope()
+    {
+        if (active)
+            prof_leave();
+    }
+
+    ProfScope(const ProfScope &) = delete;
+    ProfScope &operator=(const ProfScope &) = delete;
+};
@@ -18,6 +18,7 @@
 #include "trace.h"
 #include "reflect.h"
 #include "coderender.h"
+#include "profiler.h"
 
 #include <iostream>
 #include <fstream>
@@ -28,6 +29,8 @@
 #include <algorithm>
 #include <iterator>
 #include <cctype>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>     /* getenv */
 #ifndef _WIN32
 #include <unistd.h>    /* isatty */
@@ -67,15 +70,30 @@ repl_echo_none(const Construct *c)
             dynamic_cast<const LiteralNone *>(c));        /* none / null */
 }
 
+/* Where one input's time went (the :time and :profile commands), in ms. */
+struct ReplTiming {
+    double parse = 0;           /* lex + parse (incl. parse-time folding) */
+    double infer = 0;           /* implicit globals + type checking */
+    double optimize = 0;        /* run_optimizers */
+    double run = 0;
+    bool compiled = false;      /* got as far as the run */
+    bool ran = false;           /* compiled and ran without an error */
+
+    bool profile = false;       /* in: sample the run (profiler.h) */
+    bool profiled = false;      /* out: it was, the tables are in `report` */
+    std::ostringstream report;
+};
+
 /* Width budget for the `=>` echo's pretty-printer: a value whose single-line
  * form is wider than this is expanded across lines. */
 static const int REPL_PRETTY_WIDTH = 80;
 
 /*
  * Persistent interpreter state for the REPL. The const context and the runtime
- * global scope are both roots that live for the whole session; the const one
- * auto-loads const_builtins, the runtime one const_builtins + builtins (see the
- * EvalContext root constructor). `retained` keeps every committed input's AST
+ * global scope are both roots that live for the whole session, created in
+ * REPL mode so they copy the builtins into their maps: the const one the const
+ * builtins, the runtime one all of them (see the EvalContext root
+ * constructor). `retained` keeps every committed input's AST
  * alive so a prior pure func / struct / kept const stays valid for later
  * inputs.
  * `lines` is the ever-growing source, so an error caret points at the right
@@ -91,7 +109,8 @@ struct ReplEngine::Impl {
     bool color = false;            /* set by ReplEngine::set_color */
 
     Impl()
-        : const_ctx(new EvalContext(nullptr, /*const_ctx=*/true))
+        : const_ctx(new EvalContext(nullptr, /*const_ctx=*/true,
+                                    /*func_ctx=*/false, /*repl=*/true))
         , runtime_ctx(new EvalContext(nullptr, /*const_ctx=*/false,
                                       /*func_ctx=*/false, /*repl=*/true))
     {
@@ -123,7 +142,8 @@ struct ReplEngine::Impl {
         return names;
     }
 
-    string do_eval(const string &src, bool echo);
+    string do_eval(const string &src, bool echo,
+                   ReplTiming *timing = nullptr);
     string meta_command(const string &src);
     string cmd_tree(const string &code);
     string cmd_analyze(const string &code);
@@ -133,6 +153,8 @@ struct ReplEngine::Impl {
     string cmd_type(const string &code);
     string cmd_show(const string &arg);
     string cmd_undef(const string &name);
+    string cmd_time(const string &code);
+    string cmd_profile(const string &code);
 
     /* GC a redefined function's now-orphaned template/spec instances */
     void gc_redefined_instances(Block *blk,
@@ -368,9 +390,21 @@ repl_auto_terminate(const string &src)
 }
 
 string
-ReplEngine::Impl::do_eval(const string &src, bool echo)
+ReplEngine::Impl::do_eval(const string &src, bool echo, ReplTiming *timing)
 {
+    typedef std::chrono::steady_clock Clock;
     std::ostringstream out;
+    Clock::time_point t_stage = Clock::now();
+
+    /* Charge the time since the last mark to `field` of *timing, if timing. */
+    auto mark = [&](double ReplTiming::*field) {
+        const Clock::time_point now = Clock::now();
+        if (timing)
+            timing->*field =
+                std::chrono::duration<double, std::milli>(now - t_stage)
+                    .count();
+        t_stage = now;
+    };
 
     /* A REPL input is not semicolon-terminated the way a script is (you don't
      * type `;` at a prompt, like Ruby): auto-insert them per line. */
@@ -431,6 +465,8 @@ ReplEngine::Impl::do_eval(const string &src, bool echo)
         return format_error(e);
     }
 
+    mark(&ReplTiming::parse);
+
     /* 2a-bis. Implicit top-level `var`: a bare `name = expr` to a name not
      *     already a committed global (or builtin) is a declaration. Seed the
      *     "known" set with this REPL's prior globals (runtime + const scopes)
@@ -471,9 +507,11 @@ ReplEngine::Impl::do_eval(const string &src, bool echo)
      * the REPL's tree transformation is on par with a script's - just with
      * repl_mode (top-level decls stay map globals) and the prior-input scope
      * seeded for cross-input fold / inline / specialize. */
+    mark(&ReplTiming::infer);
     run_optimizers(root.get(), /*enable_inline=*/true, /*inline_threshold=*/24,
                    /*enable_specialize=*/true, /*repl_mode=*/true,
                    /*prior_scope=*/runtime_ctx.get());
+    mark(&ReplTiming::optimize);
 
     /* 3. Evaluate each top-level statement directly in the persistent global
      *    scope, capturing print() output and the last statement's value. */
@@ -481,15 +519,35 @@ ReplEngine::Impl::do_eval(const string &src, bool echo)
     EvalValue last;
     const Construct *last_elem = nullptr;   /* the last top-level statement */
     const std::vector<const UniqueId *> names_before = global_names();
+
+    /* :profile samples just the run, ended on every path out of it. */
+    struct ProfileGuard {
+        ReplTiming *t;
+        ~ProfileGuard() {
+            if (t && t->profiled)
+                prof_session_end(t->report);
+        }
+    } prof_guard{ timing };
+
+    if (timing) {
+        timing->compiled = true;
+        if (timing->profile)
+            timing->profiled = prof_session_begin();
+    }
+
     std::streambuf *old_cout = std::cout.rdbuf(out.rdbuf());
 
     try {
         if (blk) {
             for (const auto &e : blk->elems) {
+
+                if (g_profiling)            /* :profile: the top-level line */
+                    prof_stmt(e.get());
+
                 EvalValue v = e->eval(runtime_ctx.get());
                 if (v.is<UndefinedId>())
                     throw UndefinedVariableEx(
-                        v.get<UndefinedId>().id, e->start, e->end);
+                        v.get<UndefinedId>().id, e->start(), e->end());
                 last = move(v);
                 last_elem = e.get();
             }
@@ -503,6 +561,10 @@ ReplEngine::Impl::do_eval(const string &src, bool echo)
 
     std::cout.rdbuf(old_cout);
     retained.push_back(move(root));
+    mark(&ReplTiming::run);
+
+    if (timing)
+        timing->ran = true;
 
     /* (Removing a global from the type environment is the `:undef` command's
      * job now - there is no runtime undef() builtin to detect here.) */
@@ -566,6 +628,10 @@ ReplEngine::Impl::meta_command(const string &src)
         return cmd_show(arg);
     if (cmd == "undef")
         return cmd_undef(arg);
+    if (cmd == "time")
+        return cmd_time(arg);
+    if (cmd == "profile")
+        return cmd_profile(arg);
     if (cmd == "quit" || cmd == "q")
         return "";              /* the loop handles the actual exit */
 
@@ -694,6 +760,57 @@ ReplEngine::Impl::cmd_source(const string &path)
     return out.str();
 }
 
+/*
+ * :time - evaluate `code` exactly as a plain input (it commits, and its result
+ * is echoed), then report where the time went: compiling it (parse, type
+ * inference, the optimizers) apart from running it. The interpreter compiles
+ * every input before running it, so a slow first call can be either.
+ */
+string
+ReplEngine::Impl::cmd_time(const string &code)
+{
+    if (code.empty())
+        return "usage: :time <code>\n";
+
+    ReplTiming t;
+    string out = do_eval(code, /*echo=*/true, &t);
+
+    if (!t.ran)
+        return out;
+
+    char buf[160];
+    snprintf(buf, sizeof(buf),
+             "time: compile %.3f ms (parse %.3f, infer %.3f, optimize %.3f), "
+             "run %.3f ms\n",
+             t.parse + t.infer + t.optimize, t.parse, t.infer, t.optimize,
+             t.run);
+    return out + buf;
+}
+
+/*
+ * :profile - evaluate `code` as a plain input under the sampling profiler
+ * (profiler.h) and print its per-function and per-line tables after the
+ * result. Only the run is sampled, not the compile. Top-level statements are
+ * "main" at their REPL line number.
+ */
+string
+ReplEngine::Impl::cmd_profile(const string &code)
+{
+    if (code.empty())
+        return "usage: :profile <code>\n";
+
+    ReplTiming t;
+    t.profile = true;
+
+    const string out = do_eval(code, /*echo=*/true, &t);
+
+    if (t.compiled && !t.profiled)
+        return out + "(the profiler is not available here, or --profile "
+                     "is on)\n";
+
+    return out + t.report.str();
+}
+
 /*
  * :trace - toggle the diagnostic trace categories (see trace.h).
  *   :trace                       show the active categories
@@ -792,8 +909,7 @@ ReplEngine::Impl::cmd_globals()
     std::vector<std::pair<const UniqueId *, const LValue *>> rsyms;
     runtime_ctx->collect_symbols(rsyms);
     for (const auto &kv : rsyms) {
-        if (EvalContext::const_builtins.count(kv.first) ||
-            EvalContext::builtins.count(kv.first))
+        if (builtin_slot_index(kv.first) >= 0)
             continue;
         seen.insert(kv.first);
         rows.push_back(classify(kv.first, kv.second->get(),
@@ -804,8 +920,7 @@ ReplEngine::Impl::cmd_globals()
     std::vector<std::pair<const UniqueId *, const LValue *>> csyms;
     const_ctx->collect_symbols(csyms);
     for (const auto &kv : csyms) {
-        if (EvalContext::const_builtins.count(kv.first) ||
-            seen.count(kv.first))
+        if (is_const_builtin(kv.first) || seen.count(kv.first))
             continue;
         rows.push_back(classify(kv.first, kv.second->get(), true));
     }
@@ -1081,7 +1196,7 @@ ReplEngine::completions(const string &buf, size_t cursor) const
         start--;
     const string prefix = buf.substr(start, cursor - start);
 
-    auto starts_with = [&](const string &s) {
+    auto starts_with = [&](std::string_view s) {
         return s.size() >= prefix.size() &&
                s.compare(0, prefix.size(), prefix) == 0;
     };
@@ -1128,7 +1243,7 @@ ReplEngine::completions(const string &buf, size_t cursor) const
 
         for (int i = 1; i < static_cast<int>(Keyword::kw_count); i++)
             if (starts_with(KwString[i]))
-                out.push_back(KwString[i]);
+                out.emplace_back(KwString[i]);
 
         std::vector<std::pair<const UniqueId *, const LValue *>> syms;
         impl->runtime_ctx->collect_symbols(syms);
@@ -134,6 +134,45 @@ const BuiltinDoc builtin_docs[] = {
   "True if f is effectively pure (declared pure OR proven pure).", nullptr },
 { "ispuredecl", "reflect", "ispuredecl(f)",
   "True only if f was explicitly declared pure.", nullptr },
+{ "memoize", "reflect", "memoize(f)",
+  "Memoize f's calls across the whole program; returns f.",
+  "f must be pure and capture nothing. Only calls with scalar arguments and a "
+  "scalar result are cached, in one table bounded by --memo-cap (CLOCK "
+  "eviction). A top-level memoize(f) statement takes effect before inlining; "
+  "mylang --memoize memoizes every pure function." },
+{ "memostats", "reflect", "memostats()",
+  "The memo table's counters: hits, misses, evictions, entries, bytes.",
+  nullptr },
+{ "memstats", "reflect", "memstats(reset = false)",
+  "Heap use by value kind: allocs, frees, live and peak bytes.",
+  "A dict keyed by kind (str, arr_general, arr_ints, arr_floats, arr_bools, "
+  "arr_structs, dict, struct, func, exception, frame_spill, pure_cache), each "
+  "a dict of counters. memstats(true) then resets each peak to its live value, "
+  "to measure the next phase. mylang --memstats prints the table at exit." },
+{ "heap_snapshot", "reflect", "heap_snapshot(path)",
+  "Write the reachable object graph to a file; returns a summary dict.",
+  "Walks the globals, main's frame and every active call's frame: lists the "
+  "largest objects with the path that holds each, storage pinned only by "
+  "slices, reference cycles, and per kind the objects live but unreachable "
+  "(a count that grows between snapshots is a leak). Returns objects, bytes, "
+  "cycles and unreachable." },
+{ "bench", "reflect", "bench(func, [options])",
+  "Micro-benchmark a zero-argument function: median, MAD, 95% CI.",
+  "Warms up and calibrates (doubling batches), then times `samples` batches "
+  "of about `sample_ms` each. options: samples (10; a whole number in "
+  "3..1000000), warmup_ms (50) and sample_ms (10), both at most 60000. Returns iters, samples, median_ns, mad_ns, ci_low_ns, "
+  "ci_high_ns, min_ns, mean_ns and folded: true when the optimizer reduced "
+  "the body to a constant, so only the call is being timed." },
+{ "perf_begin", "reflect", "perf_begin(name)",
+  "Open a hardware-counter region (Linux perf_event_open).",
+  "Counts cycles, instructions, cache misses and branch misses on the main "
+  "thread until the matching perf_end(name). Regions nest and close innermost "
+  "first. mylang --perf-counters prints every region's totals, with IPC and "
+  "misses per 1000 instructions, at exit." },
+{ "perf_end", "reflect", "perf_end(name)",
+  "Close the innermost perf_begin region; returns its counts.",
+  "A dict of cycles, instructions, cache_misses, branch_misses and wall_ns. A "
+  "counter the machine or perf_event_paranoid refuses is -1." },
 { "trace", "reflect", "trace(category, on)",
   "Enable/disable a diagnostic trace category that narrates the compiler.",
   "category is a single category name or \"all\". In the REPL use :trace; for "
@@ -144,6 +183,13 @@ const BuiltinDoc builtin_docs[] = {
   "Disable all diagnostic trace categories.", nullptr },
 { "tracing", "reflect", "tracing()",
   "The active trace categories as a sorted array<str>.", nullptr },
+{ "trace_dump", "reflect", "trace_dump(path)",
+  "Write the recorded runtime trace events as Chrome trace JSON.",
+  "Enable a runtime category first (calls, builtins, exceptions, allocs, "
+  "promotions), with trace() or mylang -T. The events sit in a ring buffer "
+  "(the oldest overwritten); a dump writes and drops them and returns their "
+  "count. Open the file in Perfetto or chrome://tracing. mylang --trace-out "
+  "FILE dumps at exit." },
 
 /* --- array --- */
 { "array", "array", "array(n, [fill])",
@@ -168,14 +214,17 @@ const BuiltinDoc builtin_docs[] = {
   "Sort a in place descending (or by cmp).", nullptr },
 { "reverse", "array", "reverse(a)",
   "Reverse a in place.", nullptr },
-{ "sum", "array", "sum(a, [reduce])",
-  "Sum the elements of a, or fold them with reduce(acc, x).",
+{ "sum", "array", "sum(a, [f])",
+  "Sum the elements of a, or f(x) of each element x.",
   "An all-int array sums in a tight unboxed loop; sum of an array<bool> counts "
   "the trues." },
 { "map", "array", "map(f, c)",
-  "A new array applying f to each element of an array/dict.", nullptr },
+  "A new array applying f to each element of an array/dict.",
+  "Over a large flat array with a pure, scalar-only f, the calls are spread "
+  "across a worker pool (same result, in order; -npm disables it)." },
 { "filter", "array", "filter(f, c)",
-  "A new container of the elements of c for which f(x) is true.", nullptr },
+  "A new container of the elements of c for which f(x) is true.",
+  "Runs f in parallel under the same conditions as map()." },
 { "append", "array", "append(a, x)",
   "Append x to array a (mutates a).", nullptr },
 { "push", "array", "push(a, x)",
@@ -623,6 +672,13 @@ const LangFeature lang_features[] = {
   "rewritten to an unboxed TypedScalarExpr evaluated with no promotion "
   "dispatch and no intermediate boxing - ~2-3x on numeric loops. :analyze "
   "marks specialized call sites." },
+{ "licm", "optimizations", "Loop-invariant code motion",
+  "while (i < n) { s += a[i] * sqrt(k); i++; }   // sqrt(k) once per loop",
+  "A pure expression whose value cannot change across a loop's iterations - "
+  "len(a), sqrt(k), d[\"key\"], a pure call with invariant args - is computed "
+  "once per loop entry, when first reached, instead of every iteration. A loop "
+  "calling an impure function is left alone. :trace licm lists the hoists; "
+  ":analyze underlines them; -nlicm disables it." },
 { "flatarrays", "optimizations", "Flat arrays",
   "array_storage(a) == \"int\"",
   "A homogeneous int/float/bool array (and array<PodStruct>) is stored unboxed "
@@ -712,6 +768,17 @@ const CommandDoc command_docs[] = {
       "Remove a global symbol so it can be redeclared (even with a new type).",
       "A REPL-only convenience: a script's symbols are fixed slots at compile "
       "time, so there is no `undef` builtin - a script re-defines a name." },
+    { "time", ":time <code>",
+      "Evaluate <code> as an input and report compile vs run time.",
+      "Compile is parse (with parse-time folding), type inference and the "
+      "optimizers, each shown; run is the evaluation. The input commits like "
+      "any other. For a statistical timing of a function, see bench()." },
+    { "profile", ":profile <code>",
+      "Evaluate <code> under the sampling profiler; print its hot spots.",
+      "Per-function and per-line self/total time of the run (not the "
+      "compile), top-level statements as `main` at their REPL line. Samples "
+      "are 1 ms of CPU time apart, so give it a run of a few hundred ms. "
+      "(Script equivalent: mylang --profile FILE.)" },
     { "quit", ":quit",
       "Exit the REPL (also Ctrl-D at the prompt).", nullptr },
 };
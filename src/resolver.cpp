@@ -7,6 +7,10 @@
 #include "errors.h"
 #include "eval.h"
 #include "trace.h"
+#include "coderender.h"
+#include "memo.h"
+#include "passtimer.h"
+#include "nodeshape.h"
 
 #include <functional>
 #include <unordered_set>
@@ -73,7 +77,178 @@ namespace {
  * the map (effectively never hit). */
 constexpr int MAX_SLOTS = 1 << 20;
 
-void for_each_child(Construct *c, const std::function<void(Construct *)> &fn);
+/*
+ * Invoke `fn` on every direct child Construct of `c`. Used for the generic,
+ * scope-neutral nodes (if/while/call/subscript/...); the nodes that introduce
+ * names or scopes (Block/for/foreach/try/Expr14/func) are handled in
+ * Resolver::walk and never reach here. Children may be null (e.g. an `if` with
+ * no else), so callers tolerate null. A template over the callback and a
+ * switch on the node's cached shape (nodeshape.h): every pass walks the whole
+ * tree through here, so neither a std::function call nor a dynamic_cast chain
+ * is paid per node.
+ */
+template <class Fn>
+void for_each_child(Construct *c, Fn &&fn)
+{
+    switch (node_shape(c)) {
+
+        case NodeShape::single:
+            fn(static_cast<SingleChildConstruct *>(c)->elem.get());
+            break;
+
+        case NodeShape::multi_op:
+            for (auto &p : static_cast<MultiOpConstruct *>(c)->elems)
+                fn(p.second.get());
+            break;
+
+        case NodeShape::typed_scalar:
+            /* an M8 specialized node: same elems shape as MultiOpConstruct.
+             * The inliner normally runs before specialize_types and never
+             * sees one, but a CROSS-INPUT inlined prior body is already
+             * specialized. */
+            for (auto &p : static_cast<TypedScalarExpr *>(c)->elems)
+                fn(p.second.get());
+            break;
+
+        case NodeShape::incdec:
+            fn(static_cast<IncDecExpr *>(c)->lvalue.get());
+            break;
+
+        case NodeShape::ternary: {
+            auto *n = static_cast<TernaryExpr *>(c);
+            fn(n->condExpr.get());
+            fn(n->thenExpr.get());
+            fn(n->elseExpr.get());
+            break;
+        }
+
+        case NodeShape::coalesce: {
+            auto *n = static_cast<CoalesceExpr *>(c);
+            fn(n->lhs.get());
+            fn(n->rhs.get());
+            break;
+        }
+
+        case NodeShape::call: {
+            auto *n = static_cast<CallExpr *>(c);
+            fn(n->what.get());
+            fn(static_cast<Construct *>(n->args.get()));
+            break;
+        }
+
+        case NodeShape::if_stmt: {
+            auto *n = static_cast<IfStmt *>(c);
+            fn(n->condExpr.get());
+            fn(n->thenBlock.get());
+            fn(n->elseBlock.get());
+            break;
+        }
+
+        case NodeShape::while_stmt: {
+            auto *n = static_cast<WhileStmt *>(c);
+            fn(n->condExpr.get());
+            fn(n->body.get());
+            break;
+        }
+
+        case NodeShape::subscript: {
+            auto *n = static_cast<Subscript *>(c);
+            fn(n->what.get());
+            fn(n->index.get());
+            break;
+        }
+
+        case NodeShape::slice: {
+            auto *n = static_cast<Slice *>(c);
+            fn(n->what.get());
+            fn(n->start_idx.get());
+            fn(n->end_idx.get());
+            break;
+        }
+
+        case NodeShape::member:
+            fn(static_cast<MemberExpr *>(c)->what.get());
+            break;
+
+        case NodeShape::ret:
+            fn(static_cast<ReturnStmt *>(c)->elem.get());
+            break;
+
+        case NodeShape::kv_pair: {
+            auto *n = static_cast<LiteralDictKVPair *>(c);
+            fn(n->key.get());
+            fn(n->value.get());
+            break;
+        }
+
+        case NodeShape::elems:
+            /* ExprList, LiteralArray (Block is handled in walk) */
+            for (auto &e : static_cast<MultiElemConstruct<> *>(c)->elems)
+                fn(e.get());
+            break;
+
+        case NodeShape::ids:
+            for (auto &e :
+                 static_cast<MultiElemConstruct<Identifier> *>(c)->elems)
+                fn(static_cast<Construct *>(e.get()));
+            break;
+
+        case NodeShape::dict:
+            for (auto &e :
+                 static_cast<MultiElemConstruct<LiteralDictKVPair> *>(c)->elems)
+                fn(static_cast<Construct *>(e.get()));
+            break;
+
+        default:
+            /* literals, Identifier, childless constructs, and the scoping
+             * nodes walk handles itself */
+            break;
+    }
+}
+
+/*
+ * Complete child visitor: for_each_child plus the nodes it leaves to
+ * Resolver::walk (Block/for/foreach/try/Expr14). For the analyses that must
+ * see a whole function body (purity, self-reference counts, ...). Does not
+ * enter a nested FuncDeclStmt.
+ */
+template <class Fn>
+void for_each_child_complete(Construct *c, Fn &&fn)
+{
+    switch (node_shape(c)) {
+
+        case NodeShape::for_stmt: {
+            auto *f = static_cast<ForStmt *>(c);
+            fn(f->init.get()); fn(f->cond.get());
+            fn(f->inc.get()); fn(f->body.get());
+            break;
+        }
+
+        case NodeShape::foreach: {
+            auto *fe = static_cast<ForeachStmt *>(c);
+            fn(fe->container.get()); fn(fe->body.get());
+            break;
+        }
+
+        case NodeShape::try_catch: {
+            auto *t = static_cast<TryCatchStmt *>(c);
+            fn(t->tryBody.get());
+            for (auto &p : t->catchStmts) fn(p.second.get());
+            fn(t->finallyBody.get());
+            break;
+        }
+
+        case NodeShape::expr14: {
+            auto *e = static_cast<Expr14 *>(c);
+            fn(e->lvalue.get()); fn(e->rvalue.get());
+            break;
+        }
+
+        default:
+            for_each_child(c, fn);
+            break;
+    }
+}
 
 /*
  * A lexical scope (a function's param scope, a block, a for/foreach header, or
@@ -192,35 +367,17 @@ static bool produces_bool(const Construct *c)
 }
 
 /* True if `uid` is referenced anywhere in the subtree. A COMPLETE traversal
- * (handles the containers for_each_child stops at), so a self-call buried in a
- * block body is found. Used to detect a (self-)recursive function. */
+ * (for_each_child_complete), so a self-call buried in a block body is found.
+ * Used to detect a (self-)recursive function. */
 static bool refs_uid(const Construct *c, const UniqueId *uid)
 {
     if (!c)
         return false;
-    if (auto *id = dynamic_cast<const Identifier *>(c))
-        return id->uid == uid;
-    if (auto *b = dynamic_cast<const Block *>(c)) {
-        for (auto &e : b->elems)
-            if (refs_uid(e.get(), uid)) return true;
-        return false;
-    }
-    if (auto *f = dynamic_cast<const ForStmt *>(c))
-        return refs_uid(f->init.get(), uid) || refs_uid(f->cond.get(), uid)
-            || refs_uid(f->inc.get(), uid) || refs_uid(f->body.get(), uid);
-    if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-        return refs_uid(fe->container.get(), uid) || refs_uid(fe->body.get(), uid);
-    if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-        if (refs_uid(tc->tryBody.get(), uid)) return true;
-        for (auto &p : tc->catchStmts)
-            if (refs_uid(p.second.get(), uid)) return true;
-        return refs_uid(tc->finallyBody.get(), uid);
-    }
-    if (auto *e = dynamic_cast<const Expr14 *>(c))
-        return refs_uid(e->lvalue.get(), uid) || refs_uid(e->rvalue.get(), uid);
+    if (c->is_id())
+        return static_cast<const Identifier *>(c)->uid == uid;
     bool found = false;
-    for_each_child(const_cast<Construct *>(c),
-        [&](Construct *ch) { if (refs_uid(ch, uid)) found = true; });
+    for_each_child_complete(const_cast<Construct *>(c),
+        [&](Construct *ch) { found = found || refs_uid(ch, uid); });
     return found;
 }
 
@@ -241,27 +398,10 @@ static int count_uid(const Construct *c, const UniqueId *uid)
 {
     if (!c)
         return 0;
-    if (auto *id = dynamic_cast<const Identifier *>(c))
-        return id->uid == uid ? 1 : 0;
+    if (c->is_id())
+        return static_cast<const Identifier *>(c)->uid == uid ? 1 : 0;
     int n = 0;
-    if (auto *b = dynamic_cast<const Block *>(c)) {
-        for (auto &e : b->elems) n += count_uid(e.get(), uid);
-        return n;
-    }
-    if (auto *f = dynamic_cast<const ForStmt *>(c))
-        return count_uid(f->init.get(), uid) + count_uid(f->cond.get(), uid)
-             + count_uid(f->inc.get(), uid) + count_uid(f->body.get(), uid);
-    if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-        return count_uid(fe->container.get(), uid)
-             + count_uid(fe->body.get(), uid);
-    if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-        n += count_uid(tc->tryBody.get(), uid);
-        for (auto &p : tc->catchStmts) n += count_uid(p.second.get(), uid);
-        return n + count_uid(tc->finallyBody.get(), uid);
-    }
-    if (auto *e = dynamic_cast<const Expr14 *>(c))
-        return count_uid(e->lvalue.get(), uid) + count_uid(e->rvalue.get(), uid);
-    for_each_child(const_cast<Construct *>(c),
+    for_each_child_complete(const_cast<Construct *>(c),
         [&](Construct *ch) { n += count_uid(ch, uid); });
     return n;
 }
@@ -276,6 +416,20 @@ static bool func_is_cacheable_recursive(const FuncDeclStmt *fd)
         && count_uid(fd->body.get(), fd->id->uid) >= 2;
 }
 
+/*
+ * Would evaluating `id` in the fold context `cctx` (a const root, with no
+ * frame, globals or captures) find a value? The same lookup Identifier::do_eval
+ * does there: a resolved builtin is visible if it is a const one, any other
+ * name only through cctx's map.
+ */
+static bool resolves_in(EvalContext &cctx, const Identifier *id)
+{
+    if (id->sym.kind == SymKind::builtin)
+        return builtin_is_const(id->sym.slot);
+
+    return cctx.lookup(id) != nullptr;
+}
+
 class AutoConst {
 
     EvalContext cctx;   /* const context for evaluating folded constants */
@@ -445,26 +599,8 @@ private:
             return;
         }
 
-        auto rec = [&](Construct *ch) { register_pure_funcs(ch); };
-
-        if (auto *b = dynamic_cast<Block *>(c)) {
-            for (auto &e : b->elems)
-                rec(e.get());
-        } else if (auto *f = dynamic_cast<ForStmt *>(c)) {
-            rec(f->init.get()); rec(f->cond.get());
-            rec(f->inc.get());  rec(f->body.get());
-        } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
-            rec(fe->container.get()); rec(fe->body.get());
-        } else if (auto *tc = dynamic_cast<TryCatchStmt *>(c)) {
-            rec(tc->tryBody.get());
-            for (auto &p : tc->catchStmts)
-                rec(p.second.get());
-            rec(tc->finallyBody.get());
-        } else if (auto *e14 = dynamic_cast<Expr14 *>(c)) {
-            rec(e14->lvalue.get()); rec(e14->rvalue.get());
-        } else {
-            for_each_child(c, rec);
-        }
+        for_each_child_complete(c,
+            [&](Construct *ch) { register_pure_funcs(ch); });
     }
 
     /* Fold one function body. Only block bodies are folded; a `=> expr` body is
@@ -566,35 +702,13 @@ private:
                     block(id.get());
         }
 
-        /* Complete recursion. for_each_child intentionally skips the nodes the
-         * resolver's walk() handles itself (Block/for/foreach/try), so descend
-         * into those explicitly here. */
-        auto rec = [&](Construct *ch) {
+        /* Complete recursion: for_each_child intentionally skips the nodes
+         * the resolver's walk() handles itself (Block/for/foreach/try/Expr14 -
+         * whose lvalue reaches `a[i]=`/`a.k=` bases and whose rvalue reaches a
+         * func-expr's captures). */
+        for_each_child_complete(c, [&](Construct *ch) {
             prescan_blocked(ch, blocked, block_subscript_bases);
-        };
-
-        if (auto *b = dynamic_cast<Block *>(c)) {
-            for (auto &e : b->elems)
-                rec(e.get());
-        } else if (auto *f = dynamic_cast<ForStmt *>(c)) {
-            rec(f->init.get());
-            rec(f->cond.get());
-            rec(f->inc.get());
-            rec(f->body.get());
-        } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
-            rec(fe->container.get());
-            rec(fe->body.get());
-        } else if (auto *tc = dynamic_cast<TryCatchStmt *>(c)) {
-            rec(tc->tryBody.get());
-            for (auto &p : tc->catchStmts)
-                rec(p.second.get());
-            rec(tc->finallyBody.get());
-        } else if (auto *e14 = dynamic_cast<Expr14 *>(c)) {
-            rec(e14->lvalue.get());        /* reaches `a[i]=`/`a.k=` bases */
-            rec(e14->rvalue.get());        /* reaches a func-expr's captures */
-        } else {
-            for_each_child(c, rec);
-        }
+        });
     }
 
     /* A block's statements: promote const decls, fold, drop dead code. */
@@ -617,7 +731,7 @@ private:
                         /* write-once scalar const: record it and drop the decl;
                          * all uses fold to the literal. */
                         if (analysis)
-                            analysis->mark(id->start,
+                            analysis->mark(id->start(),
                                 static_cast<int>(id->get_str().length()),
                                 AnnoKind::auto_const);
                         fc.consts[id->sym.slot] = coerce_decl_scalar(
@@ -685,7 +799,7 @@ private:
                     Construct *dead = t ? iff->elseBlock.get()
                                         : iff->thenBlock.get();
                     if (dead)
-                        analysis->mark_dead(dead->start, dead->end);
+                        analysis->mark_dead(dead->start(), dead->end());
                 }
                 unique_ptr<Construct> taken =
                     t ? move(iff->thenBlock) : move(iff->elseBlock);
@@ -712,8 +826,8 @@ private:
                      * not w->end, which points at the next token) and drop it
                      * without folding the body. */
                     if (analysis)
-                        analysis->mark_dead(w->start,
-                            w->body ? w->body->end : w->end);
+                        analysis->mark_dead(w->start(),
+                            w->body ? w->body->end() : w->end());
                     return false;
                 }
             }
@@ -800,7 +914,7 @@ private:
                     /* A use of an auto-const var folds to its literal here -
                      * color the original identifier yellow before it's gone. */
                     if (analysis)
-                        analysis->mark(id->start,
+                        analysis->mark(id->start(),
                             static_cast<int>(id->get_str().length()),
                             AnnoKind::auto_const);
                     /* Scalars inline as a literal. A seeded array/dict const
@@ -936,10 +1050,13 @@ private:
              * the lookup throws UndefinedVariableEx and we leave the call for
              * runtime. Any OTHER exception is a real error in fully-constant
              * code and propagates (a build error), per the auto-const rule.
+             * A callee cctx can't resolve is known to throw, so it isn't
+             * evaluated at all: the first C++ throw of a process costs more
+             * than compiling a small script (the unwinder loads its tables).
              */
-            if (all_const && callee) {
+            if (all_const && callee && resolves_in(cctx, callee)) {
                 /* Capture callee loc + name before the node may be freed. */
-                const Loc cloc = callee->start;
+                const Loc cloc = callee->start();
                 const std::string cname(callee->get_str());
                 const int clen = static_cast<int>(cname.length());
                 try {
@@ -1086,8 +1203,10 @@ public:
         /* Promote write-once scalar vars to constants and fold (uses the write
          * counts just collected; the top-level frame's in main_st.writes).
          * prior_pure seeds the fold context so cross-input pure calls fold. */
-        if (auto *rb = dynamic_cast<Block *>(root))
+        if (auto *rb = dynamic_cast<Block *>(root)) {
+            PassTimer pt("auto-const");
             AutoConst(analysis, prior_pure).run(rb, main_st.writes);
+        }
     }
 
 private:
@@ -1178,7 +1297,7 @@ private:
             if (!id)
                 continue;
             if (global_func_slots.count(id->uid))
-                throw AlreadyDefinedEx(id->start, id->end);
+                throw AlreadyDefinedEx(id->start(), id->end());
             id->sym = ResolvedSym{ SymKind::global, add_global_slot(id->uid) };
         }
     }
@@ -1202,7 +1321,7 @@ private:
          * outermost scope: a nested-block var legitimately shadows a global. */
         if (cur->is_main && cur->scopes.size() == 1 &&
             global_func_slots.count(id->uid))
-            throw AlreadyDefinedEx(id->start, id->end);
+            throw AlreadyDefinedEx(id->start(), id->end());
 
         /*
          * A top-level variable that some function reads (escaped) goes in the
@@ -1306,7 +1425,7 @@ private:
     {
         for (const auto &d : cur->scopes.back().decls) {
             if (d.name == id->uid)
-                throw AlreadyDefinedEx(id->start, id->end);
+                throw AlreadyDefinedEx(id->start(), id->end());
         }
     }
 
@@ -1421,79 +1540,6 @@ private:
     }
 };
 
-/*
- * Invoke `fn` on every direct child Construct of `c`. Used for the generic,
- * scope-neutral nodes (if/while/call/subscript/...); the nodes that introduce
- * names or scopes are handled in Resolver::walk and never reach here.
- * Children may be null (e.g. an `if` with no else), so callers tolerate null.
- */
-void
-for_each_child(Construct *c, const std::function<void(Construct *)> &fn)
-{
-    if (auto *n = dynamic_cast<SingleChildConstruct *>(c)) {
-        fn(n->elem.get());
-    } else if (auto *n = dynamic_cast<MultiOpConstruct *>(c)) {
-        for (auto &p : n->elems) {
-            fn(p.second.get());
-        }
-    } else if (auto *n = dynamic_cast<TypedScalarExpr *>(c)) {
-        /* an M8 specialized node: same elems shape as MultiOpConstruct. The
-         * inliner normally runs before specialize_types and never sees one,
-         * but a CROSS-INPUT inlined prior body is already specialized. */
-        for (auto &p : n->elems) fn(p.second.get());
-    } else if (auto *n = dynamic_cast<IncDecExpr *>(c)) {
-        fn(n->lvalue.get());
-    } else if (auto *n = dynamic_cast<TernaryExpr *>(c)) {
-        fn(n->condExpr.get());
-        fn(n->thenExpr.get());
-        fn(n->elseExpr.get());
-    } else if (auto *n = dynamic_cast<CoalesceExpr *>(c)) {
-        fn(n->lhs.get());
-        fn(n->rhs.get());
-    } else if (auto *n = dynamic_cast<CallExpr *>(c)) {
-        fn(n->what.get());
-        fn(n->args.get());
-    } else if (auto *n = dynamic_cast<IfStmt *>(c)) {
-        fn(n->condExpr.get());
-        fn(n->thenBlock.get());
-        fn(n->elseBlock.get());
-    } else if (auto *n = dynamic_cast<WhileStmt *>(c)) {
-        fn(n->condExpr.get());
-        fn(n->body.get());
-    } else if (auto *n = dynamic_cast<Subscript *>(c)) {
-        fn(n->what.get());
-        fn(n->index.get());
-    } else if (auto *n = dynamic_cast<Slice *>(c)) {
-        fn(n->what.get());
-        fn(n->start_idx.get());
-        fn(n->end_idx.get());
-    } else if (auto *n = dynamic_cast<MemberExpr *>(c)) {
-        fn(n->what.get());
-    } else if (auto *n = dynamic_cast<ReturnStmt *>(c)) {
-        fn(n->elem.get());
-    } else if (auto *n = dynamic_cast<LiteralDictKVPair *>(c)) {
-        fn(n->key.get());
-        fn(n->value.get());
-    } else if (auto *n = dynamic_cast<MultiElemConstruct<Construct> *>(c)) {
-        /* ExprList, LiteralArray (Block is handled in walk) */
-        for (auto &e : n->elems) {
-            fn(e.get());
-        }
-    } else if (auto *n = dynamic_cast<MultiElemConstruct<Identifier> *>(c)) {
-        /* IdList */
-        for (auto &e : n->elems) {
-            fn(e.get());
-        }
-    } else if (auto *n =
-                   dynamic_cast<MultiElemConstruct<LiteralDictKVPair> *>(c)) {
-        /* LiteralDict */
-        for (auto &e : n->elems) {
-            fn(e.get());
-        }
-    }
-    /* literals, Identifier and childless constructs have no children */
-}
-
 /*
  * Auto-pure test: true if a function body is "effectively pure" - every free
  * identifier (sym.kind != local, i.e. not a param/local) is a compile-time
@@ -1533,31 +1579,6 @@ static const UniqueId *fmi_base_id(const Construct *lv)
     return nullptr;
 }
 
-/* Complete child visitor (the resolver's for_each_child omits the nodes its
- * walk handles - Block/for/foreach/try/Expr14 - so add them here). */
-static void fmi_children(Construct *c,
-                         const std::function<void(Construct *)> &fn)
-{
-    if (!c)
-        return;
-    if (auto *b = dynamic_cast<Block *>(c)) {
-        for (auto &e : b->elems) fn(e.get());
-    } else if (auto *f = dynamic_cast<ForStmt *>(c)) {
-        fn(f->init.get()); fn(f->cond.get());
-        fn(f->inc.get()); fn(f->body.get());
-    } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
-        fn(fe->container.get()); fn(fe->body.get());
-    } else if (auto *t = dynamic_cast<TryCatchStmt *>(c)) {
-        fn(t->tryBody.get());
-        for (auto &p : t->catchStmts) fn(p.second.get());
-        fn(t->finallyBody.get());
-    } else if (auto *e = dynamic_cast<Expr14 *>(c)) {
-        fn(e->lvalue.get()); fn(e->rvalue.get());
-    } else {
-        for_each_child(c, fn);
-    }
-}
-
 /* `e`'s subtree reads some tainted id (over-approximates "may alias one"). */
 static bool fmi_mentions(const Construct *e,
                          const std::unordered_set<const UniqueId *> &t)
@@ -1567,8 +1588,8 @@ static bool fmi_mentions(const Construct *e,
     if (auto *id = dynamic_cast<const Identifier *>(e))
         return t.count(id->uid) != 0;
     bool found = false;
-    fmi_children(const_cast<Construct *>(e),
-                 [&](Construct *ch) { if (fmi_mentions(ch, t)) found = true; });
+    for_each_child_complete(const_cast<Construct *>(e),
+        [&](Construct *ch) { if (fmi_mentions(ch, t)) found = true; });
     return found;
 }
 
@@ -1603,7 +1624,8 @@ static void fmi_propagate(Construct *c,
             for (auto &p : fe->ids->elems)
                 if (t.insert(p->uid).second) changed = true;
     }
-    fmi_children(c, [&](Construct *ch) { fmi_propagate(ch, t, changed); });
+    for_each_child_complete(c,
+        [&](Construct *ch) { fmi_propagate(ch, t, changed); });
 }
 
 /* True if `c` writes an element/field (`x[i]=`, `x.f=`, `x[i]++`) through a
@@ -1625,7 +1647,7 @@ static bool fmi_has_tainted_write(
             return true;
     }
     bool found = false;
-    fmi_children(const_cast<Construct *>(c), [&](Construct *ch) {
+    for_each_child_complete(const_cast<Construct *>(c), [&](Construct *ch) {
         if (fmi_has_tainted_write(ch, t)) found = true;
     });
     return found;
@@ -1664,34 +1686,8 @@ func_body_is_pure(const Construct *c,
     if (dynamic_cast<const FuncDeclStmt *>(c))
         return false;   /* a nested function: be conservative */
 
-    if (auto *b = dynamic_cast<const Block *>(c)) {
-        for (auto &e : b->elems)
-            if (!func_body_is_pure(e.get(), pure_names))
-                return false;
-        return true;
-    }
-    if (auto *f = dynamic_cast<const ForStmt *>(c))
-        return func_body_is_pure(f->init.get(), pure_names)
-            && func_body_is_pure(f->cond.get(), pure_names)
-            && func_body_is_pure(f->inc.get(), pure_names)
-            && func_body_is_pure(f->body.get(), pure_names);
-    if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-        return func_body_is_pure(fe->container.get(), pure_names)
-            && func_body_is_pure(fe->body.get(), pure_names);
-    if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-        if (!func_body_is_pure(tc->tryBody.get(), pure_names))
-            return false;
-        for (auto &p : tc->catchStmts)
-            if (!func_body_is_pure(p.second.get(), pure_names))
-                return false;
-        return func_body_is_pure(tc->finallyBody.get(), pure_names);
-    }
-    if (auto *e14 = dynamic_cast<const Expr14 *>(c))
-        return func_body_is_pure(e14->lvalue.get(), pure_names)
-            && func_body_is_pure(e14->rvalue.get(), pure_names);
-
     bool ok = true;
-    for_each_child(const_cast<Construct *>(c), [&](Construct *ch) {
+    for_each_child_complete(const_cast<Construct *>(c), [&](Construct *ch) {
         ok = ok && func_body_is_pure(ch, pure_names);
     });
     return ok;
@@ -1765,7 +1761,7 @@ Resolver::process_function(FuncDeclStmt *fd)
 
             if (p->const_param) {
                 if (reassigned)
-                    throw CannotRebindConstEx(p->start, p->end);
+                    throw CannotRebindConstEx(p->start(), p->end());
             } else if (!reassigned) {
                 p->auto_const_param = true;
             }
@@ -2073,74 +2069,156 @@ alloc_inline_ctx(InlineCtx ic)
  * hold a call and are skipped. Mirrors for_each_child but yields replaceable
  * unique_ptr<Construct>& slots.
  */
-static void
-for_each_child_slot(Construct *c,
-                    const std::function<void(unique_ptr<Construct> &)> &fn)
+template <class Fn>
+void for_each_child_slot(Construct *c, Fn &&fn)
 {
-    if (auto *n = dynamic_cast<SingleChildConstruct *>(c)) {
-        fn(n->elem);
-    } else if (auto *n = dynamic_cast<MultiOpConstruct *>(c)) {
-        for (auto &p : n->elems) fn(p.second);
-    } else if (auto *n = dynamic_cast<TypedScalarExpr *>(c)) {
-        /* M8 specialized node (same elems shape); a cross-input inlined prior
-         * body is already specialized, so substitution must descend here. */
-        for (auto &p : n->elems) fn(p.second);
-    } else if (auto *n = dynamic_cast<IncDecExpr *>(c)) {
-        fn(n->lvalue);
-    } else if (auto *n = dynamic_cast<CallExpr *>(c)) {
-        fn(n->what);
-        for (auto &e : n->args->elems) fn(e);
-    } else if (auto *n = dynamic_cast<IfStmt *>(c)) {
-        fn(n->condExpr);
-        if (n->thenBlock) fn(n->thenBlock);
-        if (n->elseBlock) fn(n->elseBlock);
-    } else if (auto *n = dynamic_cast<WhileStmt *>(c)) {
-        fn(n->condExpr); fn(n->body);
-    } else if (auto *n = dynamic_cast<ForStmt *>(c)) {
-        if (n->init) fn(n->init);
-        if (n->cond) fn(n->cond);
-        if (n->inc) fn(n->inc);
-        fn(n->body);
-    } else if (auto *n = dynamic_cast<ForeachStmt *>(c)) {
-        fn(n->container); fn(n->body);
-    } else if (auto *n = dynamic_cast<Subscript *>(c)) {
-        fn(n->what); fn(n->index);
-    } else if (auto *n = dynamic_cast<Slice *>(c)) {
-        fn(n->what);
-        if (n->start_idx) fn(n->start_idx);
-        if (n->end_idx) fn(n->end_idx);
-    } else if (auto *n = dynamic_cast<MemberExpr *>(c)) {
-        fn(n->what);
-    } else if (auto *n = dynamic_cast<TernaryExpr *>(c)) {
-        fn(n->condExpr); fn(n->thenExpr); fn(n->elseExpr);
-    } else if (auto *n = dynamic_cast<CoalesceExpr *>(c)) {
-        fn(n->lhs); fn(n->rhs);
-    } else if (auto *n = dynamic_cast<ReturnStmt *>(c)) {
-        if (n->elem) fn(n->elem);
-    } else if (auto *n = dynamic_cast<Expr14 *>(c)) {
-        if (n->lvalue) fn(n->lvalue);
-        if (n->rvalue) fn(n->rvalue);
-    } else if (auto *n = dynamic_cast<LiteralDictKVPair *>(c)) {
-        fn(n->key); fn(n->value);
-    } else if (auto *n = dynamic_cast<FuncDeclStmt *>(c)) {
-        if (n->body) fn(n->body);
-    } else if (auto *n = dynamic_cast<TryCatchStmt *>(c)) {
-        fn(n->tryBody);
-        for (auto &p : n->catchStmts) fn(p.second);
-        if (n->finallyBody) fn(n->finallyBody);
-    } else if (auto *n = dynamic_cast<MultiElemConstruct<Construct> *>(c)) {
-        for (auto &e : n->elems) fn(e);   /* Block, ExprList, LiteralArray */
-    } else if (auto *n =
-                   dynamic_cast<MultiElemConstruct<LiteralDictKVPair> *>(c)) {
-        for (auto &e : n->elems) { fn(e->key); fn(e->value); }
+    switch (node_shape(c)) {
+
+        case NodeShape::single:
+            fn(static_cast<SingleChildConstruct *>(c)->elem);
+            break;
+
+        case NodeShape::multi_op:
+            for (auto &p : static_cast<MultiOpConstruct *>(c)->elems)
+                fn(p.second);
+            break;
+
+        case NodeShape::typed_scalar:
+            /* M8 specialized node (same elems shape); a cross-input inlined
+             * prior body is already specialized, so substitution must descend
+             * here. */
+            for (auto &p : static_cast<TypedScalarExpr *>(c)->elems)
+                fn(p.second);
+            break;
+
+        case NodeShape::incdec:
+            fn(static_cast<IncDecExpr *>(c)->lvalue);
+            break;
+
+        case NodeShape::call: {
+            auto *n = static_cast<CallExpr *>(c);
+            fn(n->what);
+            for (auto &e : n->args->elems) fn(e);
+            break;
+        }
+
+        case NodeShape::if_stmt: {
+            auto *n = static_cast<IfStmt *>(c);
+            fn(n->condExpr);
+            if (n->thenBlock) fn(n->thenBlock);
+            if (n->elseBlock) fn(n->elseBlock);
+            break;
+        }
+
+        case NodeShape::while_stmt: {
+            auto *n = static_cast<WhileStmt *>(c);
+            fn(n->condExpr); fn(n->body);
+            break;
+        }
+
+        case NodeShape::for_stmt: {
+            auto *n = static_cast<ForStmt *>(c);
+            if (n->init) fn(n->init);
+            if (n->cond) fn(n->cond);
+            if (n->inc) fn(n->inc);
+            fn(n->body);
+            break;
+        }
+
+        case NodeShape::foreach: {
+            auto *n = static_cast<ForeachStmt *>(c);
+            fn(n->container); fn(n->body);
+            break;
+        }
+
+        case NodeShape::subscript: {
+            auto *n = static_cast<Subscript *>(c);
+            fn(n->what); fn(n->index);
+            break;
+        }
+
+        case NodeShape::slice: {
+            auto *n = static_cast<Slice *>(c);
+            fn(n->what);
+            if (n->start_idx) fn(n->start_idx);
+            if (n->end_idx) fn(n->end_idx);
+            break;
+        }
+
+        case NodeShape::member:
+            fn(static_cast<MemberExpr *>(c)->what);
+            break;
+
+        case NodeShape::ternary: {
+            auto *n = static_cast<TernaryExpr *>(c);
+            fn(n->condExpr); fn(n->thenExpr); fn(n->elseExpr);
+            break;
+        }
+
+        case NodeShape::coalesce: {
+            auto *n = static_cast<CoalesceExpr *>(c);
+            fn(n->lhs); fn(n->rhs);
+            break;
+        }
+
+        case NodeShape::ret: {
+            auto *n = static_cast<ReturnStmt *>(c);
+            if (n->elem) fn(n->elem);
+            break;
+        }
+
+        case NodeShape::expr14: {
+            auto *n = static_cast<Expr14 *>(c);
+            if (n->lvalue) fn(n->lvalue);
+            if (n->rvalue) fn(n->rvalue);
+            break;
+        }
+
+        case NodeShape::kv_pair: {
+            auto *n = static_cast<LiteralDictKVPair *>(c);
+            fn(n->key); fn(n->value);
+            break;
+        }
+
+        case NodeShape::func_decl: {
+            auto *n = static_cast<FuncDeclStmt *>(c);
+            if (n->body) fn(n->body);
+            break;
+        }
+
+        case NodeShape::try_catch: {
+            auto *n = static_cast<TryCatchStmt *>(c);
+            fn(n->tryBody);
+            for (auto &p : n->catchStmts) fn(p.second);
+            if (n->finallyBody) fn(n->finallyBody);
+            break;
+        }
+
+        case NodeShape::elems:
+            /* Block, ExprList, LiteralArray */
+            for (auto &e : static_cast<MultiElemConstruct<> *>(c)->elems)
+                fn(e);
+            break;
+
+        case NodeShape::dict:
+            for (auto &e :
+                 static_cast<MultiElemConstruct<LiteralDictKVPair> *>(c)->elems)
+            {
+                fn(e->key); fn(e->value);
+            }
+            break;
+
+        default:
+            /* literals, Identifier, IdList, childless: nothing inlinable */
+            break;
     }
-    /* literals, Identifier, IdList, childless: nothing inlinable */
 }
 
-/* True if `c` holds a ForRangeStmt anywhere (walking statement containers - a
- * ForRangeStmt only ever appears as a statement). Used to keep cross-input
- * inlining off a post-specialization body that contains one (see Inliner). */
-static bool has_for_range(const Construct *c)
+/* True if `c` holds a loop that owns frame slots of its own - a ForRangeStmt,
+ * or a loop with LICM-hoisted expressions (walking statement containers - a
+ * loop only ever appears as a statement). Used to keep cross-input inlining off
+ * a post-optimization body that contains one (see Inliner). */
+static bool has_slotted_loop(const Construct *c)
 {
     if (!c)
         return false;
@@ -2148,26 +2226,26 @@ static bool has_for_range(const Construct *c)
         return true;
     if (auto *b = dynamic_cast<const Block *>(c)) {
         for (auto &e : b->elems)
-            if (has_for_range(e.get()))
+            if (has_slotted_loop(e.get()))
                 return true;
         return false;
     }
     if (auto *i = dynamic_cast<const IfStmt *>(c))
-        return has_for_range(i->thenBlock.get()) ||
-               has_for_range(i->elseBlock.get());
+        return has_slotted_loop(i->thenBlock.get()) ||
+               has_slotted_loop(i->elseBlock.get());
     if (auto *w = dynamic_cast<const WhileStmt *>(c))
-        return has_for_range(w->body.get());
+        return !w->hoisted.empty() || has_slotted_loop(w->body.get());
     if (auto *f = dynamic_cast<const ForStmt *>(c))
-        return has_for_range(f->body.get());
+        return !f->hoisted.empty() || has_slotted_loop(f->body.get());
     if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-        return has_for_range(fe->body.get());
+        return !fe->hoisted.empty() || has_slotted_loop(fe->body.get());
     if (auto *t = dynamic_cast<const TryCatchStmt *>(c)) {
-        if (has_for_range(t->tryBody.get()))
+        if (has_slotted_loop(t->tryBody.get()))
             return true;
         for (auto &p : t->catchStmts)
-            if (has_for_range(p.second.get()))
+            if (has_slotted_loop(p.second.get()))
                 return true;
-        return has_for_range(t->finallyBody.get());
+        return has_slotted_loop(t->finallyBody.get());
     }
     return false;
 }
@@ -2295,7 +2373,9 @@ public:
         root_block = root;   /* for slotting spec-clone names in script mode */
         for (auto &e : root->elems) {
             auto *fd = dynamic_cast<FuncDeclStmt *>(e.get());
-            if (!fd || !fd->id)
+            /* a memoized function stays a real call: the call is where the
+             * memo table is consulted (and it is never unrolled) */
+            if (!fd || !fd->id || fd->memoized)
                 continue;
             if (inlinable_decl(fd))
                 add_unique(funcs, fd);
@@ -2327,13 +2407,14 @@ public:
                  * global state, so inlining it across inputs is unsound (the
                  * state may differ at the new site) - and its result isn't
                  * "known at compile time" anyway, so folding gains nothing. */
-                if (!fd->id || !fd->effective_pure)
+                if (!fd->id || !fd->effective_pure || fd->memoized)
                     continue;
-                /* A prior body is POST-specialization, so it may hold a
-                 * ForRangeStmt whose i_slot the inliner's substitution / tail
-                 * re-resolution does not remap; don't inline/specialize such a
-                 * body across inputs (it still runs correctly as a call). */
-                if (has_for_range(fd->body.get()))
+                /* A prior body is POST-optimization, so it may hold a
+                 * ForRangeStmt i_slot or HoistedExpr slots that the inliner's
+                 * substitution / tail re-resolution does not remap; don't
+                 * inline/specialize such a body across inputs (it still runs
+                 * correctly as a call). */
+                if (has_slotted_loop(fd->body.get()))
                     continue;
                 if (inlinable_decl(fd))
                     funcs.emplace(kv.first, fd);
@@ -2517,8 +2598,8 @@ private:
             if (id->sym.kind == SymKind::local && id->sym.slot == slot) {
                 auto r = repl->clone();
                 r->th = ref->th;
-                r->start = ref->start;
-                r->end = ref->end;
+                r->start() = ref->start();
+                r->end() = ref->end();
                 ref = move(r);
             }
             return;
@@ -2918,29 +2999,9 @@ private:
             return false;
         if (dynamic_cast<const FuncDeclStmt *>(c))
             return true;
-        if (auto *b = dynamic_cast<const Block *>(c)) {
-            for (auto &e : b->elems)
-                if (contains_func(e.get())) return true;
-            return false;
-        }
-        if (auto *f = dynamic_cast<const ForStmt *>(c))
-            return contains_func(f->init.get()) || contains_func(f->cond.get())
-                || contains_func(f->inc.get()) || contains_func(f->body.get());
-        if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-            return contains_func(fe->container.get())
-                || contains_func(fe->body.get());
-        if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-            if (contains_func(tc->tryBody.get())) return true;
-            for (auto &p : tc->catchStmts)
-                if (contains_func(p.second.get())) return true;
-            return contains_func(tc->finallyBody.get());
-        }
-        if (auto *e = dynamic_cast<const Expr14 *>(c))
-            return contains_func(e->lvalue.get())
-                || contains_func(e->rvalue.get());
         bool found = false;
-        for_each_child(const_cast<Construct *>(c),
-            [&](Construct *ch) { if (contains_func(ch)) found = true; });
+        for_each_child_complete(const_cast<Construct *>(c),
+            [&](Construct *ch) { found = found || contains_func(ch); });
         return found;
     }
 
@@ -3081,7 +3142,7 @@ private:
          */
         const InlineCtx *ic = alloc_inline_ctx(
             { std::string(f->id->get_str()), param_names(f),
-              ce->start, ce->inline_ctx });
+              ce->start(), ce->inline_ctx() });
 
         unique_ptr<Construct> body = f->body->clone();
 
@@ -3092,7 +3153,7 @@ private:
         tag_inline(body.get(), ic);
 
         if (analysis)
-            analysis->mark(callee->start,
+            analysis->mark(callee->start(),
                 static_cast<int>(callee->get_str().length()),
                 AnnoKind::inlined);
 
@@ -3210,8 +3271,8 @@ private:
             if (id->sym.kind == SymKind::local) {
                 if (id->sym.slot < nparams) {
                     unique_ptr<Construct> a = args[id->sym.slot]->clone();
-                    a->start = id->start;     /* keep the param's source loc */
-                    a->end = id->end;
+                    a->start() = id->start(); /* keep the param's source loc */
+                    a->end() = id->end();
                     ref = move(a);
                 } else {
                     id->sym.slot += off;
@@ -3442,7 +3503,7 @@ private:
 
         const InlineCtx *ic = alloc_inline_ctx(
             { std::string(f->id->get_str()), param_names(f),
-              ce->start, ce->inline_ctx });
+              ce->start(), ce->inline_ctx() });
 
         /* If the spliced body is a temp-free guard chain, emit an EXPRESSIBLE
          * ternary instead of an InlinedCall(Block(...return...)). The ternary is
@@ -3471,7 +3532,7 @@ private:
         }
 
         if (analysis)
-            analysis->mark(callee->start,
+            analysis->mark(callee->start(),
                 static_cast<int>(callee->get_str().length()),
                 AnnoKind::inlined);
 
@@ -3591,11 +3652,11 @@ private:
 
         const InlineCtx *ic = alloc_inline_ctx(
             { std::string(f->id->get_str()), param_names(f),
-              ce->start, ce->inline_ctx });
+              ce->start(), ce->inline_ctx() });
         tag_inline(spliced.get(), ic);
 
         if (analysis)
-            analysis->mark(callee->start,
+            analysis->mark(callee->start(),
                 static_cast<int>(callee->get_str().length()),
                 AnnoKind::inlined);
 
@@ -3702,25 +3763,7 @@ private:
         if (!c)
             return 0;
         int w = node_weight(c);
-        if (auto *b = dynamic_cast<const Block *>(c)) {
-            for (auto &e : b->elems) w += body_weight(e.get());
-            return w;
-        }
-        if (auto *f = dynamic_cast<const ForStmt *>(c))
-            return w + body_weight(f->init.get()) + body_weight(f->cond.get())
-                 + body_weight(f->inc.get()) + body_weight(f->body.get());
-        if (auto *fe = dynamic_cast<const ForeachStmt *>(c))
-            return w + body_weight(fe->container.get())
-                 + body_weight(fe->body.get());
-        if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-            w += body_weight(tc->tryBody.get());
-            for (auto &p : tc->catchStmts) w += body_weight(p.second.get());
-            return w + body_weight(tc->finallyBody.get());
-        }
-        if (auto *e = dynamic_cast<const Expr14 *>(c))
-            return w + body_weight(e->lvalue.get())
-                 + body_weight(e->rvalue.get());
-        for_each_child(const_cast<Construct *>(c),
+        for_each_child_complete(const_cast<Construct *>(c),
             [&](Construct *ch) { w += body_weight(ch); });
         return w;
     }
@@ -3737,30 +3780,8 @@ private:
         if (!c)
             return 0;
         int n = 1;
-
-        if (auto *b = dynamic_cast<const Block *>(c)) {
-            for (auto &e : b->elems)
-                n += count_all_nodes(e.get());
-        } else if (auto *e14 = dynamic_cast<const Expr14 *>(c)) {
-            n += count_all_nodes(e14->lvalue.get());
-            n += count_all_nodes(e14->rvalue.get());
-        } else if (auto *f = dynamic_cast<const ForStmt *>(c)) {
-            n += count_all_nodes(f->init.get());
-            n += count_all_nodes(f->cond.get());
-            n += count_all_nodes(f->inc.get());
-            n += count_all_nodes(f->body.get());
-        } else if (auto *fe = dynamic_cast<const ForeachStmt *>(c)) {
-            n += count_all_nodes(fe->container.get());
-            n += count_all_nodes(fe->body.get());
-        } else if (auto *tc = dynamic_cast<const TryCatchStmt *>(c)) {
-            n += count_all_nodes(tc->tryBody.get());
-            for (auto &p : tc->catchStmts)
-                n += count_all_nodes(p.second.get());
-            n += count_all_nodes(tc->finallyBody.get());
-        } else {
-            for_each_child(const_cast<Construct *>(c),
-                [&](Construct *ch) { n += count_all_nodes(ch); });
-        }
+        for_each_child_complete(const_cast<Construct *>(c),
+            [&](Construct *ch) { n += count_all_nodes(ch); });
         return n;
     }
 
@@ -3819,6 +3840,16 @@ private:
             || dynamic_cast<const CallExpr *>(c);
     }
 
+    /* A call whose callee `cctx` can't resolve (print, a non-pure function):
+     * evaluating it can only throw UndefinedVariableEx, so don't try. */
+    bool is_unresolved_call(const Construct *c)
+    {
+        auto *ce = dynamic_cast<const CallExpr *>(c);
+        auto *id = ce ? dynamic_cast<const Identifier *>(ce->what.get())
+                      : nullptr;
+        return id && !resolves_in(cctx, id);
+    }
+
     /*
      * Does the subtree reference a slotted local (a runtime param/local)? That
      * read would deref the frame, which `cctx` doesn't have, so we must not try
@@ -3873,16 +3904,17 @@ private:
         }
 
         Construct *c = slot.get();
-        if (is_const_literal(c) || !is_foldable_expr(c) || has_slotted_local(c))
+        if (is_const_literal(c) || !is_foldable_expr(c) ||
+            is_unresolved_call(c) || has_slotted_local(c))
             return;
 
         try {
             unique_ptr<Construct> lit;
             if (MakeConstructFromConstVal(
                     RValue(c->eval(&cctx)), lit, true, false)) {
-                lit->start = c->start;
-                lit->end = c->end;
-                lit->inline_ctx = c->inline_ctx;
+                lit->start() = c->start();
+                lit->end() = c->end();
+                lit->inline_ctx() = c->inline_ctx();
                 slot = move(lit);
             }
         } catch (const Exception &) {
@@ -3968,7 +4000,7 @@ private:
             return;
 
         if (analysis)
-            analysis->mark(callee->start,
+            analysis->mark(callee->start(),
                 static_cast<int>(callee->get_str().length()),
                 AnnoKind::specialized);
 
@@ -3980,8 +4012,8 @@ private:
          * Carry the clone's resolved sym onto the new callee so the call reads
          * the clone's slot directly (no map walk); unresolved in the REPL. */
         auto what = make_unique<Identifier>(clone->id->get_str());
-        what->start = ce->what->start;
-        what->end = ce->what->end;
+        what->start() = ce->what->start();
+        what->end() = ce->what->end();
         what->sym = clone->id->sym;
         ce->what = move(what);
 
@@ -4100,8 +4132,10 @@ private:
         if (auto *id = dynamic_cast<Identifier *>(slot.get())) {
             if (id->uid == uid) {
                 unique_ptr<Construct> a = arg->clone();  /* fresh per use */
-                a->start = slot->start;   /* keep the param's source position */
-                a->end = slot->end;       /* so errors point as in the callee */
+                /* keep the param's source position, so errors point as in
+                 * the callee */
+                a->start() = slot->start();
+                a->end() = slot->end();
                 slot = move(a);
                 return;
             }
@@ -4128,11 +4162,404 @@ private:
     {
         if (!c)
             return;
-        c->inline_ctx = rebase(c->inline_ctx, ic);
+        c->inline_ctx() = rebase(c->inline_ctx(), ic);
         for_each_child(c, [&](Construct *ch) { tag_inline(ch, ic); });
     }
 };
 
+bool g_licm_enabled = true;
+
+/*
+ * Loop-invariant code motion (LICM), run after the inliner so the calls a
+ * spliced body exposes are covered too. In each loop it finds the MAXIMAL
+ * subexpressions whose value cannot change across the iterations - `len(a)`,
+ * `sqrt(n)`, `d["key"]`, a pure call with invariant args - and wraps each one
+ * in a HoistedExpr bound to a fresh slot of the enclosing frame, so it is
+ * computed once per loop entry (lazily - see HoistedExpr in syntax.h).
+ *
+ * Invariance is keyed by UniqueId over the whole repeated region (a nested
+ * loop included), like the inferencer's for-range bound proof
+ * (fr_collect_mutated). There is no alias analysis, so the heap is treated as
+ * one unit:
+ *   - a loop that may run arbitrary code - a call to a user function that is
+ *     not effectively pure, a call through anything but a plain name, a
+ *     builtin given a callback - is left alone (it may write any global,
+ *     captured or heap state);
+ *   - any element/field write or in-place sort in the loop stops every
+ *     element/field read, and every container argument but `len`'s, from
+ *     being invariant (the written container may alias the read one);
+ *   - a length-changing builtin (append, pop, ...) stops `len` too.
+ * A call is hoisted only when its result is a proven int/float, so a fresh
+ * container is never shared across iterations. A `for` condition is left to
+ * specialize_types, whose ForRangeStmt caches an invariant bound already.
+ */
+class LoopHoister {
+
+    struct LoopFacts {
+        std::unordered_set<const UniqueId *> written;  /* reassigned/declared */
+        bool heap_written = false;    /* element/field write, in-place sort */
+        bool len_changed = false;     /* append/push/pop/insert/erase */
+        bool opaque = false;          /* may run arbitrary code: skip loop */
+    };
+
+    /* top-level effectively-pure user functions (callable from a loop) */
+    std::unordered_set<const UniqueId *> pure_funcs;
+    AnalysisInfo *analysis;
+    bool repl_mode;
+
+    static bool scalar_th(const Construct *e)
+    {
+        return e->th == TypeHint::i || e->th == TypeHint::f;
+    }
+
+    static const Identifier *builtin_callee(const CallExpr *ce)
+    {
+        auto *id = dynamic_cast<const Identifier *>(ce->what.get());
+        return id && id->sym.kind == SymKind::builtin ? id : nullptr;
+    }
+
+    /* Builtins that inspect their argument's syntax or binding rather than
+     * just its value, or are not meant to run once: never hoist an arg. */
+    static bool is_barrier_builtin(std::string_view n)
+    {
+        return n == "defined" || n == "isconst" || n == "isconstdecl"
+            || n == "ispure" || n == "ispuredecl" || n == "intptr"
+            || n == "array_storage" || n == "type" || n == "decltype"
+            || n == "typestr" || n == "kindstr" || n == "show"
+            || n == "signature" || n == "layout" || n == "specializations"
+            || n == "globals" || n == "runtime";
+    }
+
+    /* Const builtins that still reorder their array argument in place. */
+    static bool sorts_in_place(std::string_view n)
+    {
+        return n == "sort" || n == "rev_sort" || n == "reverse";
+    }
+
+    static void collect_ids(const Construct *lv, LoopFacts &lf)
+    {
+        if (auto *id = dynamic_cast<const Identifier *>(lv))
+            lf.written.insert(id->uid);
+        else if (auto *il = dynamic_cast<const IdList *>(lv))
+            for (auto &e : il->elems)
+                lf.written.insert(e->uid);
+        else
+            lf.heap_written = true;     /* `x[i] = v`, `o.f = v`, `x[i]++` */
+    }
+
+    void collect(Construct *c, LoopFacts &lf)
+    {
+        if (!c || lf.opaque || dynamic_cast<FuncDeclStmt *>(c))
+            return;
+
+        if (auto *e = dynamic_cast<Expr14 *>(c)) {
+            collect_ids(e->lvalue.get(), lf);
+        } else if (auto *idc = dynamic_cast<IncDecExpr *>(c)) {
+            collect_ids(idc->lvalue.get(), lf);
+        } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
+            if (fe->ids)
+                collect_ids(fe->ids.get(), lf);
+        } else if (auto *t = dynamic_cast<TryCatchStmt *>(c)) {
+            for (auto &p : t->catchStmts)
+                if (p.first.asId)
+                    lf.written.insert(p.first.asId->uid);
+        } else if (auto *ce = dynamic_cast<CallExpr *>(c)) {
+            const size_t nargs = ce->args ? ce->args->elems.size() : 0;
+            auto *callee = dynamic_cast<Identifier *>(ce->what.get());
+            if (!callee) {
+                lf.opaque = true;
+            } else if (callee->sym.kind == SymKind::builtin) {
+                const std::string_view n = callee->get_str();
+                if (builtin_runs_user_code(n, nargs))
+                    lf.opaque = true;
+                if (sorts_in_place(n))
+                    lf.heap_written = true;
+                if (is_lvalue_arg_builtin(n) && n != "intptr" && nargs) {
+                    lf.heap_written = lf.len_changed = true;
+                    if (auto *b = dynamic_cast<Identifier *>(
+                            ce->args->elems[0].get()))
+                        lf.written.insert(b->uid);
+                }
+            } else if (callee->sym.kind != SymKind::global ||
+                       !pure_funcs.count(callee->uid)) {
+                lf.opaque = true;
+            }
+        }
+
+        for_each_child_slot(c,
+            [&](unique_ptr<Construct> &ch) { collect(ch.get(), lf); });
+    }
+
+    /*
+     * True if `e` has the same value on every iteration. `len_arg`: `e` is
+     * the argument of `len`, where a container only needs a stable length.
+     */
+    bool invariant(const Construct *e, const LoopFacts &lf,
+                   bool len_arg = false) const
+    {
+        if (!e)
+            return false;
+
+        if (dynamic_cast<const LiteralInt *>(e) ||
+            dynamic_cast<const LiteralFloat *>(e) ||
+            dynamic_cast<const LiteralBool *>(e) ||
+            dynamic_cast<const LiteralNone *>(e) ||
+            dynamic_cast<const LiteralStr *>(e) ||
+            dynamic_cast<const HoistedExpr *>(e))
+            return true;
+
+        if (auto *id = dynamic_cast<const Identifier *>(e)) {
+            switch (id->sym.kind) {
+                case SymKind::builtin:
+                    return true;
+                case SymKind::local:
+                case SymKind::global:
+                case SymKind::capture:
+                    break;
+                default:
+                    return false;   /* map-resident (REPL): not tracked */
+            }
+            if (lf.written.count(id->uid))
+                return false;
+            if (scalar_th(id))
+                return true;
+            return len_arg ? !lf.len_changed : !lf.heap_written;
+        }
+
+        if (auto *sub = dynamic_cast<const Subscript *>(e))
+            return !lf.heap_written &&
+                   invariant(sub->what.get(), lf) &&
+                   invariant(sub->index.get(), lf);
+
+        if (auto *m = dynamic_cast<const MemberExpr *>(e))
+            return !lf.heap_written && invariant(m->what.get(), lf);
+
+        if (auto *ce = dynamic_cast<const CallExpr *>(e)) {
+            auto *callee = dynamic_cast<const Identifier *>(ce->what.get());
+            if (!callee || !scalar_th(ce))
+                return false;
+            bool is_len = false;
+            if (callee->sym.kind == SymKind::builtin) {
+                const std::string_view n = callee->get_str();
+                if (!is_const_builtin(callee->uid) ||
+                    is_barrier_builtin(n) || builtin_callback_arg(n) >= 0 ||
+                    sorts_in_place(n))
+                    return false;
+                is_len = n == "len";
+            } else if (callee->sym.kind != SymKind::global ||
+                       !pure_funcs.count(callee->uid)) {
+                return false;
+            }
+            if (ce->args)
+                for (auto &a : ce->args->elems)
+                    if (!invariant(a.get(), lf, is_len))
+                        return false;
+            return true;
+        }
+
+        if (auto *u = dynamic_cast<const Expr01 *>(e))
+            return invariant(u->elem.get(), lf);
+
+        if (auto *mo = dynamic_cast<const MultiOpConstruct *>(e)) {
+            for (auto &p : mo->elems)
+                if (!invariant(p.second.get(), lf))
+                    return false;
+            return true;
+        }
+
+        if (auto *t = dynamic_cast<const TernaryExpr *>(e))
+            return invariant(t->condExpr.get(), lf) &&
+                   invariant(t->thenExpr.get(), lf) &&
+                   invariant(t->elseExpr.get(), lf);
+
+        if (auto *co = dynamic_cast<const CoalesceExpr *>(e))
+            return invariant(co->lhs.get(), lf) && invariant(co->rhs.get(), lf);
+
+        return false;
+    }
+
+    /* Worth a slot: does real work (a call or a container read) that is not
+     * already hoisted. An all-arithmetic expression is cheaper to recompute. */
+    static bool worth_hoisting(const Construct *e)
+    {
+        if (dynamic_cast<const HoistedExpr *>(e))
+            return false;
+        if (dynamic_cast<const CallExpr *>(e) ||
+            dynamic_cast<const Subscript *>(e) ||
+            dynamic_cast<const MemberExpr *>(e))
+            return true;
+        bool found = false;
+        for_each_child_slot(const_cast<Construct *>(e),
+            [&](unique_ptr<Construct> &ch) {
+                if (!found && ch && worth_hoisting(ch.get()))
+                    found = true;
+            });
+        return found;
+    }
+
+    /* Where `e` starts in the source: an operator chain has no Loc of its
+     * own, so take its first operand's. */
+    static Loc expr_start(const Construct *e)
+    {
+        if (!e->start().line)
+            if (auto *mo = dynamic_cast<const MultiOpConstruct *>(e))
+                if (!mo->elems.empty() && mo->elems[0].second)
+                    return expr_start(mo->elems[0].second.get());
+        return e->start();
+    }
+
+    static const char *loop_kind(const Construct *loop)
+    {
+        if (dynamic_cast<const WhileStmt *>(loop))
+            return "while";
+        return dynamic_cast<const ForStmt *>(loop) ? "for" : "foreach";
+    }
+
+    void hoist(unique_ptr<Construct> &slot, const Construct *loop,
+               std::vector<int> &hoisted, int *fsize)
+    {
+        auto h = make_unique<HoistedExpr>();
+        slot->copy_base_fields(*h);
+        h->th = slot->th;
+        h->slot = (*fsize)++;
+
+        const std::string code = render_construct_code(slot.get());
+        const Loc at = expr_start(slot.get());
+
+        TRACE(licm, 0, std::string(loop_kind(loop)) + " at line " +
+              std::to_string(loop->start().line) + "  hoists " + code +
+              " (line " + std::to_string(at.line) + ") -> slot " +
+              std::to_string(h->slot));
+
+        /* -a: underline it. A binary chain carries no Loc of its own and the
+         * node ends are not uniform, so the width is the rendered code's
+         * (the source spelling, modulo spacing). */
+        if (analysis)
+            analysis->mark(at, static_cast<int>(code.length()),
+                           AnnoKind::hoisted);
+
+        hoisted.push_back(h->slot);
+        h->elem = move(slot);
+        slot = move(h);
+    }
+
+    /* Hoist every maximal invariant candidate under `slot` out of `loop`. */
+    void hoist_in(unique_ptr<Construct> &slot, const Construct *loop,
+                  const LoopFacts &lf, std::vector<int> &hoisted, int *fsize)
+    {
+        Construct *c = slot.get();
+        if (!c || dynamic_cast<FuncDeclStmt *>(c) ||
+            dynamic_cast<HoistedExpr *>(c) ||
+            dynamic_cast<IncDecExpr *>(c))
+            return;
+
+        auto rec = [&](unique_ptr<Construct> &ch) {
+            hoist_in(ch, loop, lf, hoisted, fsize);
+        };
+
+        if (auto *e = dynamic_cast<Expr14 *>(c)) {
+            if (e->rvalue)
+                rec(e->rvalue);     /* never an assignment target */
+            return;
+        }
+
+        if (auto *fs = dynamic_cast<ForStmt *>(c)) {
+            /* an inner loop: its cond stays for the for-range rewrite */
+            if (fs->init) rec(fs->init);
+            if (fs->inc) rec(fs->inc);
+            rec(fs->body);
+            return;
+        }
+
+        if (invariant(c, lf) && worth_hoisting(c)) {
+            hoist(slot, loop, hoisted, fsize);
+            return;
+        }
+
+        if (auto *ce = dynamic_cast<CallExpr *>(c)) {
+            if (!ce->args)
+                return;
+            size_t first = 0;
+            if (auto *b = builtin_callee(ce)) {
+                if (is_barrier_builtin(b->get_str()))
+                    return;
+                if (is_lvalue_arg_builtin(b->get_str()))
+                    first = 1;
+            }
+            for (size_t i = first; i < ce->args->elems.size(); i++)
+                rec(ce->args->elems[i]);
+            return;
+        }
+
+        for_each_child_slot(c, rec);
+    }
+
+    void process_loop(Construct *loop, int *fsize)
+    {
+        LoopFacts lf;
+
+        if (auto *w = dynamic_cast<WhileStmt *>(loop)) {
+            collect(w->condExpr.get(), lf);
+            collect(w->body.get(), lf);
+            if (lf.opaque)
+                return;
+            hoist_in(w->condExpr, loop, lf, w->hoisted, fsize);
+            hoist_in(w->body, loop, lf, w->hoisted, fsize);
+        } else if (auto *f = dynamic_cast<ForStmt *>(loop)) {
+            collect(f->cond.get(), lf);
+            collect(f->inc.get(), lf);
+            collect(f->body.get(), lf);
+            if (lf.opaque)
+                return;
+            hoist_in(f->body, loop, lf, f->hoisted, fsize);
+        } else if (auto *fe = dynamic_cast<ForeachStmt *>(loop)) {
+            if (fe->ids)
+                collect_ids(fe->ids.get(), lf);
+            collect(fe->body.get(), lf);
+            if (lf.opaque)
+                return;
+            hoist_in(fe->body, loop, lf, fe->hoisted, fsize);
+        }
+    }
+
+    /* `fsize`: the frame to add slots to, or null where there is none (an
+     * unresolved function, the REPL's map-resident top level). */
+    void walk(Construct *c, int *fsize)
+    {
+        if (!c)
+            return;
+
+        if (auto *fd = dynamic_cast<FuncDeclStmt *>(c)) {
+            if (fd->body)
+                walk(fd->body.get(), fd->resolved ? &fd->frame_size : nullptr);
+            return;
+        }
+
+        if (fsize && (dynamic_cast<WhileStmt *>(c) ||
+                      dynamic_cast<ForStmt *>(c) ||
+                      dynamic_cast<ForeachStmt *>(c)))
+            process_loop(c, fsize);    /* outer first: it takes the most */
+
+        for_each_child_slot(c,
+            [&](unique_ptr<Construct> &ch) { walk(ch.get(), fsize); });
+    }
+
+public:
+
+    LoopHoister(AnalysisInfo *a, bool repl) : analysis(a), repl_mode(repl) { }
+
+    void run(Block *root)
+    {
+        for (auto &e : root->elems)
+            if (auto *fd = dynamic_cast<FuncDeclStmt *>(e.get()))
+                if (fd->id && fd->effective_pure)
+                    pure_funcs.insert(fd->id->uid);
+
+        for (auto &e : root->elems)
+            walk(e.get(), repl_mode ? nullptr : &root->slot_count);
+    }
+};
+
 /*
  * Public entry point: run the name-resolution pass over the parsed tree (the
  * top-level frame size is recorded on the root Block's slot_count; the runtime
@@ -4147,101 +4574,186 @@ private:
  * not perturbed. Slot-based (for_each_child_slot yields replaceable slots), so
  * the node is swapped in place. Runs after the inliner, so it also covers the
  * inliner's spec clones and their redirected calls.
+ *
+ * One walk: the same traversal collects the global slots of the functions the
+ * inliner marked cache_results (a pure, tree-recursive func it unrolled). A
+ * call may come before its callee's decl, so the walk only remembers the
+ * DirectCallExprs it made; the ones whose callee turned out cacheable become
+ * CachedCallExprs afterwards (so their recursion's duplicate self-calls dedup
+ * in the per-frame cache).
  */
-static void
-devirtualize_calls(unique_ptr<Construct> &slot,
-                   const std::unordered_set<int> &cacheable)
-{
-    if (!slot)
-        return;
+class Devirtualizer {
 
-    if (auto *call = dynamic_cast<CallExpr *>(slot.get())) {
-        /* Skip an already-specialized node (idempotent). */
-        if (!dynamic_cast<DirectCallExpr *>(call) &&
-            !dynamic_cast<DirectBuiltinCallExpr *>(call)) {
-
-            auto *id = dynamic_cast<Identifier *>(call->what.get());
-
-            if (id && id->sym.kind == SymKind::builtin) {
-                /* Unshadowed builtin: bake its (immutable, singleton-table)
-                 * function pointer. Never set in the REPL, where builtins stay
-                 * map-resident (sym.kind isn't builtin). */
-                auto d = make_unique<DirectBuiltinCallExpr>();
-                call->copy_base_fields(*d);
-                d->what = move(call->what);
-                d->args = move(call->args);
-                d->builtin = builtin_slot(id->sym.slot).getval<Builtin>();
-                slot = move(d);
-            } else if (call->direct_func_slot >= 0) {
-                /* Global-slot callee (function / struct / escaped global). A
-                 * cacheable pure-recursive callee becomes a CachedCallExpr so
-                 * its recursion's duplicate self-calls dedup in the per-frame
-                 * cache; every other global call is a plain DirectCallExpr (no
-                 * per-call cache check). */
-                unique_ptr<DirectCallExpr> d =
-                    cacheable.count(call->direct_func_slot)
-                        ? unique_ptr<DirectCallExpr>(new CachedCallExpr())
-                        : make_unique<DirectCallExpr>();
-                call->copy_base_fields(*d);
-                d->what = move(call->what);
-                d->args = move(call->args);
-                d->direct_func_slot = call->direct_func_slot;
-                slot = move(d);
+    std::unordered_set<int> cacheable;
+    std::vector<unique_ptr<Construct> *> direct;
+
+    void walk(unique_ptr<Construct> &slot)
+    {
+        if (!slot)
+            return;
+
+        switch (node_shape(slot.get())) {
+
+            case NodeShape::call:
+                devirtualize(slot);
+                break;
+
+            case NodeShape::func_decl: {
+                auto *fd = static_cast<FuncDeclStmt *>(slot.get());
+                if (fd->id && fd->id->sym.kind == SymKind::global &&
+                    fd->cache_results)
+                {
+                    cacheable.insert(fd->id->sym.slot);
+                }
+                break;
             }
+
+            default:
+                break;
         }
+
+        for_each_child_slot(slot.get(),
+            [this](unique_ptr<Construct> &ch) { walk(ch); });
     }
 
-    for_each_child_slot(slot.get(),
-        [&](unique_ptr<Construct> &ch) { devirtualize_calls(ch, cacheable); });
-}
+    void devirtualize(unique_ptr<Construct> &slot)
+    {
+        auto *call = static_cast<CallExpr *>(slot.get());
 
-/* Collect the global-table slots of functions the inliner marked cache_results
- * (a pure, tree-recursive func it unrolled), so a call to one becomes a
- * CachedCallExpr. A complete walk (cacheable funcs may be nested). */
-static void
-collect_cacheable_slots(Construct *c, std::unordered_set<int> &out)
-{
-    if (!c)
-        return;
-    if (auto *fd = dynamic_cast<FuncDeclStmt *>(c)) {
-        if (fd->id && fd->id->sym.kind == SymKind::global && fd->cache_results)
-            out.insert(fd->id->sym.slot);
-        if (fd->body)
-            collect_cacheable_slots(fd->body.get(), out);
-        return;
+        /* Skip an already-specialized node (idempotent). */
+        if (dynamic_cast<DirectCallExpr *>(call) ||
+            dynamic_cast<DirectBuiltinCallExpr *>(call))
+            return;
+
+        auto *id = dynamic_cast<Identifier *>(call->what.get());
+
+        if (id && id->sym.kind == SymKind::builtin) {
+            /* Unshadowed builtin: bake its (immutable, singleton-table)
+             * function pointer. Never set in the REPL, where builtins stay
+             * map-resident (sym.kind isn't builtin). */
+            auto d = make_unique<DirectBuiltinCallExpr>();
+            call->copy_base_fields(*d);
+            d->what = move(call->what);
+            d->args = move(call->args);
+            d->builtin = builtin_slot(id->sym.slot).getval<Builtin>();
+            slot = move(d);
+        } else if (call->direct_func_slot >= 0) {
+            /* Global-slot callee (function / struct / escaped global). */
+            auto d = make_unique<DirectCallExpr>();
+            call->copy_base_fields(*d);
+            d->what = move(call->what);
+            d->args = move(call->args);
+            d->direct_func_slot = call->direct_func_slot;
+            slot = move(d);
+            direct.push_back(&slot);
+        }
     }
-    if (auto *b = dynamic_cast<Block *>(c)) {
-        for (auto &e : b->elems) collect_cacheable_slots(e.get(), out);
-        return;
+
+    /* A call to a cacheable callee gets the per-frame cache check; every
+     * other global call stays a plain DirectCallExpr. Moving the args list
+     * keeps the slots recorded inside it valid (`what` is the callee
+     * Identifier, it holds no call). */
+    void use_cached_calls()
+    {
+        if (cacheable.empty())
+            return;
+
+        for (unique_ptr<Construct> *slot : direct) {
+
+            auto *call = static_cast<DirectCallExpr *>(slot->get());
+
+            if (!cacheable.count(call->direct_func_slot))
+                continue;
+
+            unique_ptr<DirectCallExpr> d(new CachedCallExpr());
+            call->copy_base_fields(*d);
+            d->what = move(call->what);
+            d->args = move(call->args);
+            d->direct_func_slot = call->direct_func_slot;
+            *slot = move(d);
+        }
     }
-    for_each_child(c, [&](Construct *ch) { collect_cacheable_slots(ch, out); });
-}
 
+public:
+
+    void run(Construct *root)
+    {
+        if (!root)
+            return;
+
+        for_each_child_slot(root,
+            [this](unique_ptr<Construct> &ch) { walk(ch); });
+        use_cached_calls();
+    }
+};
+
+/*
+ * Cross-call memoization (memo.h), decided before the inliner so a memoized
+ * function stays a real call: with `--memoize` every pure, capture-less
+ * top-level function, else those a top-level `memoize(f)` statement names (the
+ * builtin re-checks and marks at run time too; this just lets it happen before
+ * the inliner would splice or unroll the calls away).
+ */
 static void
-devirtualize_direct_calls(Construct *root)
+mark_memoized(Block *root)
 {
-    if (!root)
-        return;
-    std::unordered_set<int> cacheable;
-    collect_cacheable_slots(root, cacheable);
-    for_each_child_slot(root,
-        [&](unique_ptr<Construct> &ch) { devirtualize_calls(ch, cacheable); });
+    std::unordered_set<std::string_view> named;
+
+    for (auto &e : root->elems) {
+        auto *ce = dynamic_cast<CallExpr *>(e.get());
+        auto *callee = ce ? dynamic_cast<Identifier *>(ce->what.get()) : nullptr;
+        if (!callee || callee->sym.kind != SymKind::builtin ||
+            callee->get_str() != "memoize" || ce->args->elems.size() != 1)
+            continue;
+        if (auto *f = dynamic_cast<Identifier *>(ce->args->elems[0].get()))
+            named.insert(f->get_str());
+    }
+
+    /* a template instance / specialization of a named function (display_name)
+     * is memoized with it: the calls were redirected to it */
+    for (auto &e : root->elems) {
+        auto *fd = dynamic_cast<FuncDeclStmt *>(e.get());
+        if (!fd || !fd->id || !fd->effective_pure ||
+            (fd->captures && !fd->captures->elems.empty()))
+            continue;
+        if (g_memoize_all || named.count(fd->id->get_str()) ||
+            named.count(fd->display_name)) {
+            fd->memoized = true;
+            TRACE(autopure, 0, std::string(fd->id->get_str()) +
+                  "  memoized across calls");
+        }
+    }
 }
 
 void
 resolve_names(Construct *root, bool enable_inline, int inline_threshold,
               AnalysisInfo *analysis, bool repl_mode, EvalContext *prior_pure)
 {
-    Resolver().run(root, analysis, repl_mode, prior_pure);
+    {
+        PassTimer pt("resolve names");
+        Resolver().run(root, analysis, repl_mode, prior_pure);
+    }
+
+    if (auto *rb = dynamic_cast<Block *>(root))
+        mark_memoized(rb);
 
     if (enable_inline)
-        if (auto *rb = dynamic_cast<Block *>(root))
+        if (auto *rb = dynamic_cast<Block *>(root)) {
+            PassTimer pt("inline");
             Inliner(inline_threshold, analysis, prior_pure, repl_mode).run(rb);
+        }
+
+    if (g_licm_enabled)
+        if (auto *rb = dynamic_cast<Block *>(root)) {
+            PassTimer pt("licm");
+            LoopHoister(analysis, repl_mode).run(rb);
+        }
 
     /* Devirtualize direct (global-slot) calls into DirectCallExpr nodes. After
      * the inliner so spec clones + redirected calls are covered; before
      * specialize_types, which treats a DirectCallExpr as the CallExpr it is. */
-    devirtualize_direct_calls(root);
+    PassTimer pt("devirtualize");
+    Devirtualizer().run(root);
 }
 
 void
@@ -4251,6 +4763,8 @@ run_optimizers(Construct *root, bool enable_inline, int inline_threshold,
 {
     resolve_names(root, enable_inline, inline_threshold, /*analysis=*/nullptr,
                   repl_mode, prior_scope);
+
+    PassTimer pt("specialize types");
     specialize_types(root, enable_specialize, prior_scope);
 }
 
@@ -4333,14 +4847,14 @@ void collect_resolver_analysis(Construct *root, AnalysisInfo &out)
         if (auto *fd = dynamic_cast<FuncDeclStmt *>(c)) {
 
             if (fd->id && fd->effective_pure && !fd->explicit_pure)
-                out.mark(fd->id->start,
+                out.mark(fd->id->start(),
                          static_cast<int>(fd->id->get_str().length()),
                          AnnoKind::auto_const);
 
             if (fd->params)
                 for (auto &p : fd->params->elems)
                     if (p->auto_const_param && !p->const_param)
-                        out.mark(p->start,
+                        out.mark(p->start(),
                                  static_cast<int>(p->get_str().length()),
                                  AnnoKind::auto_const);
 
@@ -4348,24 +4862,7 @@ void collect_resolver_analysis(Construct *root, AnalysisInfo &out)
             return;
         }
 
-        if (auto *b = dynamic_cast<Block *>(c)) {
-            for (auto &e : b->elems)
-                walk(e.get());
-        } else if (auto *f = dynamic_cast<ForStmt *>(c)) {
-            walk(f->init.get()); walk(f->cond.get());
-            walk(f->inc.get());  walk(f->body.get());
-        } else if (auto *fe = dynamic_cast<ForeachStmt *>(c)) {
-            walk(fe->container.get()); walk(fe->body.get());
-        } else if (auto *tc = dynamic_cast<TryCatchStmt *>(c)) {
-            walk(tc->tryBody.get());
-            for (auto &p : tc->catchStmts)
-                walk(p.second.get());
-            walk(tc->finallyBody.get());
-        } else if (auto *e14 = dynamic_cast<Expr14 *>(c)) {
-            walk(e14->lvalue.get()); walk(e14->rvalue.get());
-        } else {
-            for_each_child(c, walk);
-        }
+        for_each_child_complete(c, walk);
     };
 
     walk(root);
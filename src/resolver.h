@@ -54,6 +54,14 @@ struct AnalysisInfo;
  * across inputs (e.g. `func f2() => f(1,2)`). Only pure functions are used, so
  * folding stays sound.
  */
+/*
+ * Loop-invariant code motion, the last step of resolve_names (after inlining):
+ * a pure expression whose value cannot change across a loop's iterations is
+ * computed once per loop entry (HoistedExpr). On by default; the CLI's `-nlicm`
+ * clears it.
+ */
+extern bool g_licm_enabled;
+
 class EvalContext;
 void resolve_names(Construct *root,
                    bool enable_inline = true,
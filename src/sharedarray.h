@@ -6,6 +6,7 @@
 #include "flatval.h"
 #include "intrusiveptr.h"
 #include "errors.h"
+#include "memacct.h"
 #include <vector>
 #include <unordered_set>
 #include <cassert>
@@ -22,16 +23,22 @@ struct StructTypeDef;   /* a struct type (structtype.h); only a pointer here */
  * include order.
  */
 
+/* A general array's element buffer (SharedArrayObjTempl::vec_type), charged
+ * to the arr_general heap accounting (memacct.h). */
+template <class LValueT>
+using ArrayVecTempl =
+    std::vector<LValueT, MemAlloc<LValueT, MemKind::arr_general>>;
+
 template <class LValueT>
 class ArrayConstViewTempl {
 
-    const std::vector<LValueT> &vec;
+    const ArrayVecTempl<LValueT> &vec;
     const size_type off;
     const size_type len;
 
 public:
 
-    ArrayConstViewTempl(const std::vector<LValueT> &vec, size_type off, size_type len)
+    ArrayConstViewTempl(const ArrayVecTempl<LValueT> &vec, size_type off, size_type len)
         : vec(vec), off(off), len(len)
     { }
 
@@ -49,10 +56,17 @@ template <class LValueT>
 class SharedArrayObjTempl final {
 
 public:
-    typedef std::vector<LValueT>      vec_type;
-    typedef std::vector<int_type>     ivec_type;
-    typedef std::vector<float_type>   fvec_type;
-    typedef std::vector<unsigned char> bvec_type;   /* one byte per bool */
+    /* Each buffer is charged to its kind's heap accounting (memacct.h). */
+    typedef ArrayVecTempl<LValueT>    vec_type;
+    typedef std::vector<int_type, MemAlloc<int_type, MemKind::arr_ints>>
+        ivec_type;
+    typedef std::vector<float_type, MemAlloc<float_type, MemKind::arr_floats>>
+        fvec_type;
+    typedef std::vector<unsigned char,               /* one byte per bool */
+                        MemAlloc<unsigned char, MemKind::arr_bools>>
+        bvec_type;
+    typedef std::vector<char, MemAlloc<char, MemKind::arr_structs>>
+        sbuf_type;
 
     /*
      * Flat storage for an array of POD structs (plans/structs.md phase 7): the
@@ -66,11 +80,11 @@ public:
      * (creation / append / subscript read / foreach) touch the bytes directly.
      */
     struct svec_type {
-        std::vector<char> buf;
+        sbuf_type buf;
         StructTypeDef *def = nullptr;
         int stride = 0;
         svec_type() = default;
-        svec_type(std::vector<char> &&b, StructTypeDef *d, int s)
+        svec_type(sbuf_type &&b, StructTypeDef *d, int s)
             : buf(move(b)), def(d), stride(s) { }
     };
 
@@ -130,24 +144,46 @@ private:
         size_t hash_cache = 0;
         bool hash_valid = false;
 
-        SharedObject() : kind(Storage::general) { new (&vec) vec_type(); }
+        /* The kind this object (header + buffer) is charged to. The header
+         * is charged in the ctor, not by a MemCounted base, since only the
+         * ctor knows the Storage. */
+        static MemKind mem_kind(Storage k) {
+            switch (k) {
+                case Storage::ints:    return MemKind::arr_ints;
+                case Storage::floats:  return MemKind::arr_floats;
+                case Storage::bools:   return MemKind::arr_bools;
+                case Storage::structs: return MemKind::arr_structs;
+                default:               return MemKind::arr_general;
+            }
+        }
+
+        SharedObject() : kind(Storage::general) {
+            new (&vec) vec_type();
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
+        }
         SharedObject(vec_type &&a) : kind(Storage::general) {
             new (&vec) vec_type(move(a));
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
         }
         SharedObject(ivec_type &&a) : kind(Storage::ints) {
             new (&ivec) ivec_type(move(a));
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
         }
         SharedObject(fvec_type &&a) : kind(Storage::floats) {
             new (&fvec) fvec_type(move(a));
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
         }
         SharedObject(bvec_type &&a) : kind(Storage::bools) {
             new (&bvec) bvec_type(move(a));
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
         }
         SharedObject(svec_type &&a) : kind(Storage::structs) {
             new (&svec) svec_type(move(a));
+            mem_alloc_obj(mem_kind(kind), sizeof(SharedObject));
         }
 
         ~SharedObject() {
+            mem_free_obj(mem_kind(kind), sizeof(SharedObject));
             switch (kind) {
                 case Storage::general: vec.~vec_type();   break;
                 case Storage::ints:    ivec.~ivec_type(); break;
@@ -405,17 +441,58 @@ public:
         }
     }
     void invalidate_hash() {
-        if (shobj)
+        /* test first: an element write on an already-invalid hash (every write
+         * but the first) then stores nothing to the shared object */
+        if (shobj && shobj->hash_valid)
             shobj->hash_valid = false;
     }
 
+    /* Does any live slice view this array's storage? */
+    bool has_slices() const { return shobj && !shobj->slices.empty(); }
+
     bool is_slice() const { return slice; }
     size_type offset() const { return slice ? off : 0; }
 
     /* Element count without promoting (kind-aware). */
     size_type size() const {
-        if (slice)
-            return len;
+        return slice ? len : storage_size();
+    }
+
+    /*
+     * The shared storage behind this array, whatever range of it this alias or
+     * slice covers: its identity, element count, and bytes (header + buffer
+     * capacity). The heap snapshot (heapsnap.h) keys objects on storage_id(),
+     * so aliases and slices of one array are one object.
+     */
+    const void *storage_id() const { return shobj.get(); }
+
+    MemKind storage_mem_kind() const {
+        return SharedObject::mem_kind(shobj->kind);
+    }
+
+    size_t storage_bytes() const {
+        size_t buf;
+        switch (shobj->kind) {
+            case Storage::ints:
+                buf = shobj->ivec.capacity() * sizeof(int_type);
+                break;
+            case Storage::floats:
+                buf = shobj->fvec.capacity() * sizeof(float_type);
+                break;
+            case Storage::bools:
+                buf = shobj->bvec.capacity();
+                break;
+            case Storage::structs:
+                buf = shobj->svec.buf.capacity();
+                break;
+            default:
+                buf = shobj->vec.capacity() * sizeof(LValueT);
+                break;
+        }
+        return sizeof(SharedObject) + buf;
+    }
+
+    size_type storage_size() const {
         switch (shobj->kind) {
             case Storage::ints:   return shobj->ivec.size();
             case Storage::floats: return shobj->fvec.size();
@@ -5,13 +5,19 @@
 #include "defs.h"
 #include "flatval.h"
 #include "intrusiveptr.h"
+#include "memacct.h"
 #include <unordered_map>
 
 template <class EvalValueT, class LValueT>
-class DictObjectTempl : public RefCounted {
+class DictObjectTempl : public RefCounted,
+                        public MemCounted<MemKind::dict> {
 
 public:
-    typedef std::unordered_map<EvalValueT, LValueT> inner_type;
+    /* Nodes and buckets are charged to the dict kind (memacct.h). */
+    typedef std::unordered_map<
+        EvalValueT, LValueT, std::hash<EvalValueT>, std::equal_to<EvalValueT>,
+        MemAlloc<std::pair<const EvalValueT, LValueT>, MemKind::dict>
+    > inner_type;
 
 private:
     inner_type data;
@@ -5,6 +5,7 @@
 #include "defs.h"
 #include "flatval.h"
 #include "intrusiveptr.h"
+#include "memacct.h"
 #include <string>
 
 class SharedStr final {
@@ -29,7 +30,19 @@ private:
          */
         mutable size_t hash_cache = 0;
         mutable bool hash_valid = false;
-        StrObj(inner_type &&str) : s(move(str)) { }
+        StrObj(inner_type &&str) : s(move(str)) {
+            mem_alloc_obj(MemKind::str, mem_bytes());
+        }
+        ~StrObj() { mem_free_obj(MemKind::str, mem_bytes()); }
+
+        /* This object plus its character buffer, unless the characters fit
+         * in the string itself (the small-string buffer). Charged in the
+         * ctor/dtor and re-charged by TypeStr::append, the one in-place
+         * mutation (see memacct.h). */
+        size_t mem_bytes() const {
+            const size_t sso = inner_type().capacity();
+            return sizeof(StrObj) + (s.capacity() > sso ? s.capacity() + 1 : 0);
+        }
     };
 
     intrusive_ptr<StrObj> obj;
@@ -74,10 +87,25 @@ public:
         return std::string_view(obj->s.data() + offset(), size());
     }
 
+    /* Append to a non-slice string in place (the one in-place mutation of a
+     * string), keeping its heap accounting in step with the buffer. */
+    void append_in_place(std::string_view sv) {
+        ML_CHECK(!slice);
+        const size_t before = obj->mem_bytes();
+        obj->s += sv;
+        mem_resize(MemKind::str, before, obj->mem_bytes());
+    }
+
     bool is_slice() const { return slice; }
     size_type offset() const { return slice ? off : 0; }
     size_type size() const { return slice ? len : obj->s.size(); }
 
+    /* The shared StrObj behind this string or slice, for the heap snapshot
+     * (heapsnap.h): its identity, length, and bytes as charged above. */
+    const void *storage_id() const { return obj.get(); }
+    size_type storage_size() const { return obj->s.size(); }
+    size_t storage_bytes() const { return obj->mem_bytes(); }
+
     /*
      * Hash of the string's value. A full (non-slice) string caches it on the
      * shared StrObj (computed once); a slice hashes its sub-view on demand.
@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#include "srcbuf.h"
+
+#include <fstream>
+#include <iterator>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using std::string;
+using std::string_view;
+
+SourceBuffer::~SourceBuffer()
+{
+#ifndef _WIN32
+    if (map)
+        munmap(const_cast<char *>(map), map_len);
+#endif
+}
+
+/* Drop the one trailing '\n' a line-by-line read would not have kept. */
+static string_view
+strip_final_newline(string_view s)
+{
+    if (!s.empty() && s.back() == '\n')
+        s.remove_suffix(1);
+
+    return s;
+}
+
+bool
+SourceBuffer::load_file(const char *path)
+{
+#ifndef _WIN32
+
+    const int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    const bool have_st = !fstat(fd, &st);
+
+    /* A directory opens fine but fails on the first read. */
+    if (have_st && S_ISDIR(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    /* A regular, non-empty file is mapped; anything else (an empty file, a
+     * pipe like /dev/stdin) is read below. The mapping is private and
+     * read-only: the script is only ever lexed from it. */
+    if (have_st && S_ISREG(st.st_mode) && st.st_size > 0) {
+
+        void *p = mmap(nullptr, static_cast<size_t>(st.st_size),
+                       PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (p != MAP_FAILED) {
+            close(fd);
+            madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            map = static_cast<const char *>(p);
+            map_len = static_cast<size_t>(st.st_size);
+            txt = strip_final_newline(string_view(map, map_len));
+            line_starts.clear();
+            return true;
+        }
+    }
+
+    close(fd);
+#endif
+
+    std::ifstream f(path, std::ios::binary);
+
+    if (!f.is_open())
+        return false;
+
+    /* libstdc++ reports a read error (EIO, EISDIR) by throwing from
+     * underflow, even with no exceptions() mask set. */
+    try {
+        owned.assign(std::istreambuf_iterator<char>(f),
+                     std::istreambuf_iterator<char>());
+    } catch (const std::ios_base::failure &) {
+        return false;
+    }
+
+    txt = strip_final_newline(owned);
+    line_starts.clear();
+    return true;
+}
+
+void
+SourceBuffer::assign(string s)
+{
+    owned = move(s);
+    txt = owned;
+    line_starts.clear();
+}
+
+void
+SourceBuffer::index_lines() const
+{
+    if (!line_starts.empty())
+        return;
+
+    line_starts.push_back(0);
+
+    for (size_t i = 0; i < txt.size(); i++)
+        if (txt[i] == '\n')
+            line_starts.push_back(i + 1);
+}
+
+int
+SourceBuffer::line_count() const
+{
+    index_lines();
+    return static_cast<int>(line_starts.size());
+}
+
+string_view
+SourceBuffer::line(int n) const
+{
+    index_lines();
+
+    if (n < 1 || n > static_cast<int>(line_starts.size()))
+        return string_view();
+
+    const size_t b = line_starts[n - 1];
+    const size_t e = static_cast<size_t>(n) < line_starts.size()
+        ? line_starts[n] - 1
+        : txt.size();
+
+    return txt.substr(b, e - b);
+}
+
+std::vector<string_view>
+SourceBuffer::lines() const
+{
+    std::vector<string_view> ret;
+    const int n = line_count();
+
+    ret.reserve(n);
+    for (int i = 1; i <= n; i++)
+        ret.push_back(line(i));
+
+    return ret;
+}
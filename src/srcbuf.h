@@ -0,0 +1,53 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+ * A script's source as ONE buffer: the file memory-mapped read-only (read into
+ * a string where mmap isn't available, or for `-e` text). The lexer scans it in
+ * place and its tokens are string_views into it, so a SourceBuffer must outlive
+ * parsing (the driver's is static). Nothing is split into per-line strings up
+ * front: the line start offsets are computed on the first line()/lines() call,
+ * i.e. only when an error excerpt or `-a` needs them.
+ *
+ * text() is the file minus one trailing newline, which is exactly the old
+ * line-by-line read joined with '\n' (so locs, and compile cache keys, don't
+ * depend on how the file was read).
+ */
+class SourceBuffer {
+
+    std::string owned;                  /* `-e` text, or the non-mmap read */
+    const char *map = nullptr;          /* the mapping, when mmap'd */
+    size_t map_len = 0;
+    std::string_view txt;
+    mutable std::vector<size_t> line_starts;
+
+    void index_lines() const;
+
+public:
+
+    SourceBuffer() = default;
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    /* Map (or read) `path`; false if it can't be opened. */
+    bool load_file(const char *path);
+
+    /* Use `s` (e.g. `-e` text) as the source. */
+    void assign(std::string s);
+
+    std::string_view text() const { return txt; }
+
+    /* The number of lines, and line `n` (1-based, without its '\n'). */
+    int line_count() const;
+    std::string_view line(int n) const;
+
+    /* Every line, as views into the buffer (for error excerpts and `-a`). */
+    std::vector<std::string_view> lines() const;
+};
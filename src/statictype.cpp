@@ -28,8 +28,11 @@ StaticTypeArena::StaticTypeArena()
     g_dyn[1] = alloc(StaticTypeKind::Dyn);  g_dyn[1]->opt = true;
 }
 
+size_t StaticTypeArena::allocated = 0;
+
 StaticTypeRef StaticTypeArena::alloc(StaticTypeKind k)
 {
+    allocated++;
     nodes.push_back(std::make_unique<StaticType>(k));
     return nodes.back().get();
 }
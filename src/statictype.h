@@ -76,6 +76,9 @@ public:
 
     StaticTypeArena();
 
+    /* Types allocated by every arena so far (`--time-passes`). */
+    static size_t allocated;
+
     /* Ground singletons (cached per opt-flag). */
     StaticTypeRef bool_ty(bool opt = false)  { return
         ground(StaticTypeKind::Bool, opt); }
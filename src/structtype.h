@@ -230,7 +230,8 @@ struct StructTypeDef {
  * read-only). v1 storage is `fields` (a boxed LValue slot array); the POD byte
  * buffer is added later.
  */
-class StructObject : public RefCounted {
+class StructObject : public RefCounted,
+                     public MemCounted<MemKind::struct_obj> {
 
 public:
 
@@ -242,8 +243,10 @@ public:
      * bytes) for a POD struct. The unused one stays an empty vector (cheap).
      * The default copy ctor copies both, so clone/COW work for either layout.
      */
-    std::vector<LValue> fields;     /* boxed: by slot */
-    std::vector<char> bytes;        /* POD: def->size bytes */
+    std::vector<LValue, MemAlloc<LValue, MemKind::struct_obj>>
+        fields;                     /* boxed: by slot */
+    std::vector<char, MemAlloc<char, MemKind::struct_obj>>
+        bytes;                      /* POD: def->size bytes */
 
     StructObject() = default;
     explicit StructObject(StructTypeDef *d) : def(d) {
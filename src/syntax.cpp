@@ -2,6 +2,8 @@
 
 #include "errors.h"
 #include "syntax.h"
+#include "memo.h"
+#include "livestats.h"
 
 using std::string;
 using std::string_view;
@@ -10,6 +12,34 @@ using std::string_view;
  * at 1 so 0 can stay a "no node" sentinel. Single-threaded interpreter, so a
  * plain increment is fine. */
 uint64_t Construct::next_node_id = 1;
+size_t Construct::live_count = 0;
+std::deque<NodeInfo> &Construct::infos = *new std::deque<NodeInfo>;
+std::vector<uint32_t> &Construct::free_infos = *new std::vector<uint32_t>;
+
+uint32_t Construct::new_info(const char *name)
+{
+    const NodeInfo i = { name, next_node_id++, Loc(), Loc(), nullptr, nullptr };
+
+    if (!free_infos.empty()) {
+        const uint32_t idx = free_infos.back();
+        free_infos.pop_back();
+        infos[idx] = i;
+        return idx;
+    }
+
+    infos.push_back(i);
+    return static_cast<uint32_t>(infos.size() - 1);
+}
+
+NodeInfo &Construct::info()
+{
+    return infos[info_idx];
+}
+
+const NodeInfo &Construct::info() const
+{
+    return infos[info_idx];
+}
 
 #ifdef RECYCLE_ALLOC
 
@@ -162,7 +192,7 @@ void ChildlessConstruct::serialize(ostream &s, int level) const
 {
     string indent(level * 2, ' ');
     s << indent;
-    s << name;
+    s << name();
 }
 
 static void
@@ -198,7 +228,7 @@ generic_single_child_serialize(const char *name,
 
 void SingleChildConstruct::serialize(ostream &s, int level) const
 {
-    generic_single_child_serialize(name, elem, s, level);
+    generic_single_child_serialize(name(), elem, s, level);
 }
 
 void
@@ -207,7 +237,7 @@ MultiOpConstruct::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     for (const auto &[op, e] : elems) {
 
@@ -367,7 +397,7 @@ void CallExpr::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     what->serialize(s, level + 1);
     s << endl;
@@ -389,7 +419,7 @@ void ExprList::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     for (size_t i = 0; i < elems.size(); i++) {
         if (i < arg_names.size() && arg_names[i])
@@ -429,7 +459,7 @@ void desugar_named_call(CallExpr *call, const std::vector<ParamSpec> &params)
                 throw WrongArgCountEx(
                     intern_msg("function expects at most " +
                                std::to_string(nparams) + " argument(s)"),
-                    call->start, call->end);
+                    call->start(), call->end());
         } else {
             /* named arg: match a parameter by its interned name */
             slot = nparams;
@@ -439,7 +469,7 @@ void desugar_named_call(CallExpr *call, const std::vector<ParamSpec> &params)
                 throw TypeMismatchEx(
                     intern_msg("no parameter named '" +
                                std::string(args->arg_names[i]->val) + "'"),
-                    anode->start, anode->end);
+                    anode->start(), anode->end());
         }
 
         if (static_cast<int>(slot) <= last)
@@ -448,7 +478,7 @@ void desugar_named_call(CallExpr *call, const std::vector<ParamSpec> &params)
                            std::string(params[slot].name->val) +
                            "' is out of order or duplicates an earlier argument"
                            " (named arguments must follow parameter order)"),
-                anode->start, anode->end);
+                anode->start(), anode->end());
 
         bound[slot] = move(args->elems[i]);
         last = static_cast<int>(slot);
@@ -457,8 +487,8 @@ void desugar_named_call(CallExpr *call, const std::vector<ParamSpec> &params)
     /* Rebuild a contiguous positional list 0..last; an interior gap must be an
      * opt param and is filled with `none`. */
     auto positional = make_unique<ExprList>();
-    positional->start = args->start;
-    positional->end = args->end;
+    positional->start() = args->start();
+    positional->end() = args->end();
     bool all_const = true;
 
     for (int slot = 0; slot <= last; slot++) {
@@ -470,7 +500,7 @@ void desugar_named_call(CallExpr *call, const std::vector<ParamSpec> &params)
                 throw WrongArgCountEx(
                     intern_msg("missing required argument '" +
                                std::string(params[slot].name->val) + "'"),
-                    call->start, call->end);
+                    call->start(), call->end());
             positional->elems.push_back(make_unique<LiteralNone>());
         }
     }
@@ -515,7 +545,7 @@ void Expr14::serialize(ostream &s, int level) const
             s << "VarDecl";
 
     } else {
-        s << name;
+        s << name();
     }
 
     s << "(\n";
@@ -564,7 +594,7 @@ void IfStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     condExpr->serialize(s, level+1);
     s << endl;
@@ -601,7 +631,7 @@ void WhileStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
     condExpr->serialize(s, level+1);
     s << endl;
 
@@ -620,12 +650,21 @@ void WhileStmt::serialize(ostream &s, int level) const
     s << ")";
 }
 
+FuncDeclStmt::~FuncDeclStmt()
+{
+    if (memoized)
+        memo_forget(this);
+
+    if (live_timed)
+        live_forget(this);
+}
+
 void FuncDeclStmt::serialize(ostream &s, int level) const
 {
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     if (id) {
 
@@ -669,7 +708,7 @@ void FuncDeclStmt::serialize(ostream &s, int level) const
 
 void ReturnStmt::serialize(ostream &s, int level) const
 {
-    generic_single_child_serialize(name, elem, s, level);
+    generic_single_child_serialize(name(), elem, s, level);
 }
 
 void Subscript::serialize(ostream &s, int level) const
@@ -677,7 +716,7 @@ void Subscript::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
     what->serialize(s, level+1);
     s << endl;
     index->serialize(s, level+1);
@@ -691,7 +730,7 @@ void Slice::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
     what->serialize(s, level+1);
     s << endl;
 
@@ -726,7 +765,7 @@ void TryCatchStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     tryBody->serialize(s, level+1);
     s << endl;
@@ -779,7 +818,7 @@ void ForeachStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     ids->serialize(s, level + 1);
     s << endl;
@@ -807,7 +846,7 @@ void ForRangeStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
     string sub((level + 1) * 2, ' ');
 
-    s << indent << name << "(i " << OpString[(int)cmp_op] << " bound"
+    s << indent << name() << "(i " << OpString[(int)cmp_op] << " bound"
       << ", slot " << i_slot << "\n";
 
     init->serialize(s, level + 1);
@@ -827,7 +866,7 @@ void ForStmt::serialize(ostream &s, int level) const
     string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     if (init) {
 
@@ -7,6 +7,9 @@
 #include "parser.h"
 #include "uniqueid.h"
 #include "structtype.h"
+#include "astarena.h"
+
+#include <deque>
 
 enum pFlags : unsigned {
 
@@ -21,7 +24,7 @@ enum pFlags : unsigned {
     pInDynDecl      = 1 << 8,   /* `var dyn`/`const dyn`: declared dynamic */
 };
 
-enum class ConstructType {
+enum class ConstructType : unsigned char {
 
     other,
     nop,
@@ -97,11 +100,17 @@ struct ResolvedSym {
 
 struct InlineCtx;
 
-class Construct {
+/*
+ * The cold per-node fields: the class name, the identity, the source span and
+ * the rare annotations. They live in a side table (Construct::infos) indexed by
+ * the node's info slot instead of in the node, so the header the evaluator
+ * drags into cache with every node is just the vptr + 8 bytes, and common
+ * nodes (Identifier, LiteralInt, TypedScalarExpr) fit in one cache line. Only
+ * the compiler, the error path and the dumpers read these.
+ */
+struct NodeInfo {
 
-public:
-    const char *const name;
-    const ConstructType ct;     /* Purpose: avoid dynamic_cast in some cases */
+    const char *name;
 
     /*
      * A process-stable, monotonically-assigned identity. Unlike the node's
@@ -110,25 +119,40 @@ public:
      * hazards") - node_id is never reused, so it is a safe stable identity for
      * debugging and for keying any map that outlives the node. A clone() gets a
      * FRESH id (it runs this constructor); copy_base_fields does NOT copy it.
+     * (The info SLOT is reused once its node is freed; the id is not.)
      */
-    static uint64_t next_node_id;
-    const uint64_t node_id;
+    uint64_t node_id;
+
+    Loc start;
+    Loc end;
+
+    /* The element struct type for ArrHint::flat_s (an empty array<Struct> needs
+     * it, having no element to infer from). Copied by copy_base_fields. */
+    const StructTypeDef *arr_hint_struct;
 
-#ifdef RECYCLE_ALLOC
     /*
-     * Adversarial test allocator (RECYCLE=1 builds only): a LIFO free-list that
-     * hands a just-freed node's address straight back to the next same-size
-     * allocation, so any "AST pointer used as a stable identity" bug manifests
-     * DETERMINISTICALLY under -rt instead of depending on the host allocator's
-     * luck. Defined in syntax.cpp. See CLAUDE.md "Invariants & hazards".
+     * Set on nodes spliced in by function inlining: the "inlined-at" chain used
+     * to rebuild virtual backtrace frames for the (physically absent) inlined
+     * call. Null for the vast majority of nodes; consulted only on the error
+     * path (see Construct::eval / flush_inline_frames). No inliner sets it yet.
      */
-    static void *operator new(std::size_t n);
-    static void operator delete(void *p) noexcept;
-#endif
+    const InlineCtx *inline_ctx;
+};
+
+class Construct {
 
+    /* The side table: a deque, so a NodeInfo reference stays valid while
+     * other nodes are created; freed slots are reused (free_infos). Never
+     * destroyed: nodes owned by other static objects die at exit in any
+     * order. */
+    static std::deque<NodeInfo> &infos;
+    static std::vector<uint32_t> &free_infos;
+
+    static uint32_t new_info(const char *name);
+
+public:
+    const ConstructType ct;     /* Purpose: avoid dynamic_cast in some cases */
     bool is_const;
-    Loc start;
-    Loc end;
 
     /*
      * Set by the type inferencer when this expression is statically a non-null
@@ -147,28 +171,63 @@ public:
      * copy_base_fields().
      */
     ArrHint arr_hint = ArrHint::dflt;
-    /* The element struct type for ArrHint::flat_s (an empty array<Struct> needs
-     * it, having no element to infer from). Copied by copy_base_fields. */
-    const StructTypeDef *arr_hint_struct = nullptr;
 
+private:
+    const uint32_t info_idx;    /* this node's NodeInfo slot */
+
+public:
+    static uint64_t next_node_id;
+
+    /* Nodes alive right now (the AST plus any clone in flight): the node
+     * count column of `--time-passes` (passtimer.h). */
+    static size_t live_count;
+
+#ifdef RECYCLE_ALLOC
     /*
-     * Set on nodes spliced in by function inlining: the "inlined-at" chain used
-     * to rebuild virtual backtrace frames for the (physically absent) inlined
-     * call. Null for the vast majority of nodes; consulted only on the error
-     * path (see Construct::eval / flush_inline_frames). No inliner sets it yet.
+     * Adversarial test allocator (RECYCLE=1 builds only): a LIFO free-list that
+     * hands a just-freed node's address straight back to the next same-size
+     * allocation, so any "AST pointer used as a stable identity" bug manifests
+     * DETERMINISTICALLY under -rt instead of depending on the host allocator's
+     * luck. Defined in syntax.cpp. See CLAUDE.md "Invariants & hazards".
      */
-    const InlineCtx *inline_ctx = nullptr;
+    static void *operator new(std::size_t n);
+    static void operator delete(void *p) noexcept;
+#else
+    /* Nodes come from the current AST arena (astarena.h): contiguous per
+     * program, released in one go with an AstArenaScope. */
+    static void *operator new(std::size_t n) { return ast_alloc(n); }
+    static void operator delete(void *p, std::size_t n) noexcept {
+        ast_free(p, n);
+    }
+#endif
 
     Construct(const char *name,
               bool is_const = false,
               ConstructType ct = ConstructType::other)
-        : name(name)
-        , ct(ct)
-        , node_id(next_node_id++)
+        : ct(ct)
         , is_const(is_const)
-        , start(Loc())
-        , end(Loc())
-    { }
+        , info_idx(new_info(name))
+    {
+        live_count++;
+    }
+
+    /* The cold fields (see NodeInfo), by reference: `n->start() = loc`.
+     * Out of line: hundreds of error paths read them, none of them hot. */
+    NodeInfo &info();
+    const NodeInfo &info() const;
+
+    const char *name() const { return info().name; }
+    uint64_t node_id() const { return info().node_id; }
+    Loc &start() { return info().start; }
+    const Loc &start() const { return info().start; }
+    Loc &end() { return info().end; }
+    const Loc &end() const { return info().end; }
+    const StructTypeDef *&arr_hint_struct() { return info().arr_hint_struct; }
+    const StructTypeDef *arr_hint_struct() const {
+        return info().arr_hint_struct;
+    }
+    const InlineCtx *&inline_ctx() { return info().inline_ctx; }
+    const InlineCtx *inline_ctx() const { return info().inline_ctx; }
 
     bool is_nop() const { return ct == ConstructType::nop; }
     bool is_ret() const { return ct == ConstructType::ret; }
@@ -178,7 +237,11 @@ public:
     bool is_lit_int() const { return ct == ConstructType::lit_int; }
     bool is_subscript() const { return ct == ConstructType::subscript; }
 
-    virtual ~Construct() = default;
+    virtual ~Construct() {
+        live_count--;
+        free_infos.push_back(info_idx);
+    }
+    Construct(const Construct &) = delete;     /* clone() gets a fresh id */
 
     virtual EvalValue do_eval(EvalContext *ctx, bool rec = true) const {
         return none;
@@ -212,13 +275,15 @@ public:
      * call-devirtualization swap (resolver.cpp), which moves a CallExpr's
      * children into a fresh DirectCallExpr. Public so that swap can use it. */
     void copy_base_fields(Construct &d) const {
+        const NodeInfo &i = info();
+        NodeInfo &di = d.info();
         d.is_const = is_const;
-        d.start = start;
-        d.end = end;
-        d.inline_ctx = inline_ctx;
+        di.start = i.start;
+        di.end = i.end;
+        di.inline_ctx = i.inline_ctx;
         d.th = th;
         d.arr_hint = arr_hint;
-        d.arr_hint_struct = arr_hint_struct;
+        di.arr_hint_struct = i.arr_hint_struct;
     }
 };
 
@@ -241,8 +306,8 @@ public:
     ChildlessConstruct(const char *name, Loc start = Loc(), Loc end = Loc())
         : Construct(name)
     {
-        this->start = start;
-        this->end = end;
+        this->start() = start;
+        this->end() = end;
     }
 
     void serialize(ostream &s, int level = 0) const override;
@@ -306,7 +371,7 @@ void MultiElemConstruct<T>::serialize(ostream &s, int level) const
     std::string indent(level * 2, ' ');
 
     s << indent;
-    s << name << "(\n";
+    s << name() << "(\n";
 
     for (const auto &e: elems) {
         e->serialize(s, level + 1);
@@ -541,6 +606,7 @@ public:
     /* The baked const value (read-only). Used by the type inferencer to derive
      * the static type of a folded const array/dict literal. */
     const EvalValue &literal_value() const { return value; }
+    bool is_immutable() const { return immutable; }
 
     unique_ptr<Construct> clone() const override {
         auto c = make_unique<LiteralObj>(value, immutable);
@@ -841,6 +907,38 @@ public:
     }
 };
 
+/*
+ * A loop-invariant subexpression hoisted out of a loop by the LICM pass
+ * (LoopHoister in resolver.cpp). `elem` is the original expression; `slot` a
+ * frame slot the pass added to the enclosing function (or main). The loop
+ * that owns it unbinds the slot on entry (its `hoisted` list), the first
+ * evaluation inside the loop computes `elem` and binds the slot, and every
+ * later iteration just reads it. Lazy on purpose: the value is computed only
+ * if and when the original would be, so an expression under an `if`, or one
+ * that throws, behaves exactly as before - it simply runs once per loop entry
+ * instead of once per iteration. `th` is copied from `elem`, so the M8
+ * specializer still sees a typed operand. As a SingleChildConstruct it is
+ * auto-traversed by every for_each_child walk.
+ */
+class HoistedExpr final: public SingleChildConstruct {
+
+public:
+    int slot = 0;
+
+    HoistedExpr() : SingleChildConstruct("HoistedExpr") { }
+    EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
+    int_type eval_int(EvalContext *ctx) const override;
+    float_type eval_float(EvalContext *ctx) const override;
+
+    unique_ptr<Construct> clone() const override {
+        auto c = make_unique<HoistedExpr>();
+        copy_base_fields(*c);
+        c->elem = clone_as(elem);
+        c->slot = slot;
+        return c;
+    }
+};
+
 /*
  * A normalized view of one callee parameter, enough to desugar named arguments
  * against it: the interned name (pointer-comparable to ExprList::arg_names) and
@@ -1223,6 +1321,7 @@ class WhileStmt final: public Construct {
 public:
     unique_ptr<Construct> condExpr;
     unique_ptr<Construct> body;
+    std::vector<int> hoisted;   /* HoistedExpr slots, unbound on entry */
 
     WhileStmt() : Construct("WhileStmt") { }
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
@@ -1233,6 +1332,7 @@ public:
         copy_base_fields(*c);
         c->condExpr = clone_as(condExpr);
         c->body = clone_as(body);
+        c->hoisted = hoisted;
         return c;
     }
 };
@@ -1288,6 +1388,33 @@ public:
      */
     bool cache_results = false;
 
+    /*
+     * Cross-call memoization (see memo.h): every call to this function looks
+     * its scalar arguments up in the program-wide memo table first. Set by
+     * `memoize(f)` at run time (hence mutable: FuncObject holds a const
+     * pointer) or by the resolver (a top-level `memoize(f)`, `--memoize`),
+     * only for a pure, capture-less function. The destructor drops the
+     * function's entries, so a later function at the same address never hits.
+     */
+    mutable bool memoized = false;
+
+    /*
+     * Set by livestats.cpp when it first times a top-level call of this
+     * function. The destructor then retires its row, so a later function at
+     * the same address starts a fresh one.
+     */
+    mutable bool live_timed = false;
+
+    /*
+     * Set by specialize_types (inferencer.cpp, mark_par_safe) when a call to
+     * this function may run on a worker thread: it is pure, captures nothing,
+     * and its body only touches its own frame slots, scalar-valued builtin
+     * calls and literal numbers - so given scalar arguments it neither reads
+     * nor writes any refcounted object another thread could see. map()/filter()
+     * over a flat array spread such a callback across the worker pool.
+     */
+    bool par_safe = false;
+
     /*
      * Name to show in a backtrace, when it should differ from `id`. Empty for
      * normal functions (the backtrace uses `id`). A specialization clone has a
@@ -1297,6 +1424,7 @@ public:
     std::string display_name;
 
     FuncDeclStmt() : Construct("FuncDeclStmt") { }
+    ~FuncDeclStmt() override;
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
     void serialize(ostream &s, int level = 0) const override;
 
@@ -1312,6 +1440,8 @@ public:
         c->slot_writes = slot_writes;
         c->explicit_pure = explicit_pure;
         c->effective_pure = effective_pure;
+        c->memoized = memoized;
+        c->par_safe = par_safe;
         c->display_name = display_name;
         return c;
     }
@@ -1335,12 +1465,17 @@ public:
     unique_ptr<Construct> clone() const override;
 };
 
-class Subscript final: public Construct {
+class Subscript: public Construct {
+
+protected:
+    explicit Subscript(const char *name)
+        : Construct(name, false, ConstructType::subscript) { }
 
 public:
 
     unique_ptr<Construct> what;
     unique_ptr<Construct> index;
+    bool in_range = false;        /* a RangeSubscript (the store fast path) */
 
     Subscript() : Construct("Subscript", false, ConstructType::subscript) { }
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
@@ -1357,6 +1492,44 @@ public:
     }
 };
 
+/*
+ * `arr[i]` inside a ForRangeStmt whose loop var is `i`, with `arr` a slotted
+ * local the loop never reassigns, redeclares or shrinks (emitted by
+ * specialize_types). The loop computes, once on entry, whether every array it
+ * indexes this way holds at least as many elements as the index range it will
+ * walk, and stores that 0/1 in the frame slot `guard_slot`. While it holds, a
+ * flat (ints/floats/bools) read or a store takes the element straight from
+ * `arr_slot` at `i_slot` - no `what`/index evaluation, no bounds check. A
+ * false guard (or a non-flat array) runs the plain Subscript path, errors
+ * included, so the check is elided only where it can never fire.
+ */
+class RangeSubscript final: public Subscript {
+
+public:
+    int arr_slot = 0;
+    int i_slot = 0;
+    int guard_slot = 0;
+
+    RangeSubscript() : Subscript("RangeSubscript") { in_range = true; }
+    EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
+    int_type eval_int(EvalContext *ctx) const override;
+    float_type eval_float(EvalContext *ctx) const override;
+
+    /* The array's LValue and `i`, when the guard holds; else null. */
+    LValue *checked_base(EvalContext *ctx, int_type &idx) const;
+
+    unique_ptr<Construct> clone() const override {
+        auto c = make_unique<RangeSubscript>();
+        copy_base_fields(*c);
+        c->what = clone_as(what);
+        c->index = clone_as(index);
+        c->arr_slot = arr_slot;
+        c->i_slot = i_slot;
+        c->guard_slot = guard_slot;
+        return c;
+    }
+};
+
 class Slice final: public Construct {
 
 public:
@@ -1455,6 +1628,7 @@ public:
     unique_ptr<Construct> body;
     bool idsVarDecl;
     bool indexed;
+    std::vector<int> hoisted;   /* HoistedExpr slots, unbound on entry */
 
     ForeachStmt() : Construct("ForeachStmt"), idsVarDecl(false), indexed(false) { }
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
@@ -1468,6 +1642,7 @@ public:
         c->body = clone_as(body);
         c->idsVarDecl = idsVarDecl;
         c->indexed = indexed;
+        c->hoisted = hoisted;
         return c;
     }
 };
@@ -1580,6 +1755,7 @@ public:
     unique_ptr<Construct> cond;
     unique_ptr<Construct> inc;
     unique_ptr<Construct> body;
+    std::vector<int> hoisted;   /* HoistedExpr slots, unbound on entry */
 
     ForStmt() : Construct("ForStmt") { }
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
@@ -1592,6 +1768,7 @@ public:
         c->cond = clone_as(cond);
         c->inc = clone_as(inc);
         c->body = clone_as(body);
+        c->hoisted = hoisted;
         return c;
     }
 };
@@ -1619,6 +1796,32 @@ public:
     unique_ptr<Construct> body;
     int i_slot = 0;               /* the loop var's frame slot */
     Op cmp_op = Op::lt;           /* lt/le -> ascending; ge/gt -> descending */
+    std::vector<int> hoisted;     /* HoistedExpr slots (from the ForStmt) */
+
+    /*
+     * Bounds-check elision (see RangeSubscript): `bce_slot` is the frame slot
+     * of the loop's 0/1 guard (-1: no RangeSubscript uses this loop's `i`),
+     * `bce_arrays` the slots of the arrays whose length it checks on entry.
+     */
+    int bce_slot = -1;
+    std::vector<int> bce_arrays;
+
+    /*
+     * `--parallel-loops` (see mark_parallel_loops in inferencer.cpp): the body
+     * was proven iteration-independent - it writes only `a[i]` (i the loop
+     * var) and its own locals, reads only loop-invariant data, and calls only
+     * scalar const builtins / par_safe functions. The runtime re-checks what
+     * it can't know statically: `par_stores` are the frame slots of the
+     * stored-to arrays, `par_reads` / `par_own` those read at any index / only
+     * at `i` (all must hold flat arrays; a `par_reads` one must not share
+     * storage with a stored-to one), `par_calls` the global slots of the
+     * called functions (each must still hold a par_safe FuncObject).
+     */
+    bool parallel = false;
+    std::vector<int> par_stores;
+    std::vector<int> par_reads;
+    std::vector<int> par_own;
+    std::vector<int> par_calls;
 
     ForRangeStmt() : Construct("ForRangeStmt") { }
     EvalValue do_eval(EvalContext *ctx, bool rec = true) const override;
@@ -1633,6 +1836,14 @@ public:
         c->body = clone_as(body);
         c->i_slot = i_slot;
         c->cmp_op = cmp_op;
+        c->hoisted = hoisted;
+        c->bce_slot = bce_slot;
+        c->bce_arrays = bce_arrays;
+        c->parallel = parallel;
+        c->par_stores = par_stores;
+        c->par_reads = par_reads;
+        c->par_own = par_own;
+        c->par_calls = par_calls;
         return c;
     }
 };
@@ -1,11 +1,17 @@
 /* SPDX-License-Identifier: BSD-2-Clause */
 
 #include "trace.h"
+#include "parallel.h"
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstring>
+#include <unordered_map>
 
 unsigned g_trace_mask = 0;
 
@@ -37,6 +43,18 @@ const CatName cat_names[] = {
       "flat (unboxed) vs general array storage" },
     { "fold",       TraceCat::fold,       "\x1b[90m",     /* gray */
       "const expressions / calls folded to literals" },
+    { "licm",       TraceCat::licm,       "\x1b[94m",     /* bright blue */
+      "loop-invariant expressions hoisted out of a loop" },
+    { "calls",      TraceCat::calls,      "",
+      "runtime: function calls (to --trace-out / trace_dump)" },
+    { "builtins",   TraceCat::builtins,   "",
+      "runtime: builtin calls" },
+    { "exceptions", TraceCat::exceptions, "",
+      "runtime: exceptions thrown and caught" },
+    { "allocs",     TraceCat::allocs,     "",
+      "runtime: heap blocks of 1 MB or more" },
+    { "promotions", TraceCat::promotions, "",
+      "runtime: struct arrays promoted to general storage" },
 };
 
 const CatName *lookup(TraceCat c)
@@ -50,6 +68,145 @@ const CatName *lookup(TraceCat c)
 bool g_trace_color = false;
 std::ostream *g_trace_sink = &std::cerr;
 
+/*
+ * The runtime event ring. An event is 24 bytes, its name an index into the
+ * interned names; the buffer is allocated on the first event, so a run that
+ * never enables a runtime category pays nothing for it.
+ */
+struct Event {
+    uint64_t ts_ns;         /* since the first event */
+    int64_t arg;
+    uint32_t name;
+    char phase;             /* 'B', 'E' or 'i' (Chrome's phases) */
+    uint8_t cat;            /* bit index of the TraceCat */
+};
+
+typedef std::chrono::steady_clock Clock;
+
+const size_t ring_cap = 256 * 1024;
+
+std::vector<Event> ring;
+size_t ring_next = 0;           /* the slot the next event goes to */
+bool ring_wrapped = false;
+Clock::time_point ring_t0;
+
+std::vector<std::string> ev_names;
+std::unordered_map<std::string, uint32_t> ev_name_ids;
+
+std::string out_path;
+
+uint8_t cat_bit(TraceCat c)
+{
+    unsigned v = static_cast<unsigned>(c);
+    uint8_t b = 0;
+    while (v >>= 1)
+        b++;
+    return b;
+}
+
+uint32_t intern(std::string_view name)
+{
+    std::string key(name);
+    auto it = ev_name_ids.find(key);
+
+    if (it != ev_name_ids.end())
+        return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(ev_names.size());
+    ev_names.push_back(key);
+    ev_name_ids.emplace(move(key), id);
+    return id;
+}
+
+/*
+ * The guard at the top of the trace_event_* entry points, BEFORE the name is
+ * interned: ev_names/ev_name_ids are main-thread-only, so a pool worker (whose
+ * events are dropped anyway) must not reach intern(). The mask is re-checked
+ * so an event never interns a name for a category that is off.
+ */
+inline bool event_wanted(TraceCat c)
+{
+    return trace_enabled(c) && !par_in_worker();
+}
+
+/*
+ * The runtime events are the main thread's alone, so a call run on a pool
+ * worker would be missing from the timeline without a word. Like --stats
+ * (stats_start), a runtime category being on therefore runs map/filter and
+ * counted loops sequentially; the flags come back once the last one is off.
+ */
+bool par_held = false;
+bool held_parallel_enabled;
+bool held_parallel_loops;
+
+void runtime_cats_changed()
+{
+    const unsigned runtime = ~(static_cast<unsigned>(TraceCat::calls) - 1);
+    const bool on = (g_trace_mask & runtime) != 0;
+
+    if (on && !par_held) {
+        held_parallel_enabled = g_parallel_enabled;
+        held_parallel_loops = g_parallel_loops;
+        g_parallel_enabled = false;
+        g_parallel_loops = false;
+        par_held = true;
+    } else if (!on && par_held) {
+        g_parallel_enabled = held_parallel_enabled;
+        g_parallel_loops = held_parallel_loops;
+        par_held = false;
+    }
+}
+
+/* Append one event; main thread only (the callers check par_in_worker). */
+void record(TraceCat c, char phase, uint32_t name, long long arg)
+{
+    if (ring.empty()) {
+        ring.resize(ring_cap);
+        ring_t0 = Clock::now();
+    }
+
+    Event &e = ring[ring_next];
+    e.ts_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - ring_t0).count());
+    e.arg = arg;
+    e.name = name;
+    e.phase = phase;
+    e.cat = cat_bit(c);
+
+    if (++ring_next == ring.size()) {
+        ring_next = 0;
+        ring_wrapped = true;
+    }
+}
+
+/* The arg's key in the JSON, per category (nullptr: the event has none). */
+const char *arg_key(TraceCat c)
+{
+    switch (c) {
+        case TraceCat::allocs:      return "bytes";
+        case TraceCat::promotions:  return "elems";
+        default:                    return nullptr;
+    }
+}
+
+void json_str(std::ostream &o, const std::string &s)
+{
+    o << '"';
+    for (unsigned char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            o << '\\' << ch;
+        } else if (ch < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            o << buf;
+        } else {
+            o << ch;
+        }
+    }
+    o << '"';
+}
+
 }  /* namespace */
 
 void
@@ -84,6 +241,7 @@ trace_set(const std::string &name, bool on)
             g_trace_mask |= all;
         else
             g_trace_mask &= ~all;
+        runtime_cats_changed();
         return true;
     }
     for (const CatName &cn : cat_names) {
@@ -92,6 +250,7 @@ trace_set(const std::string &name, bool on)
                 g_trace_mask |= static_cast<unsigned>(cn.cat);
             else
                 g_trace_mask &= ~static_cast<unsigned>(cn.cat);
+            runtime_cats_changed();
             return true;
         }
     }
@@ -102,6 +261,7 @@ void
 trace_clear_all()
 {
     g_trace_mask = 0;
+    runtime_cats_changed();
 }
 
 std::vector<std::string>
@@ -158,3 +318,122 @@ trace_set_sink(std::ostream *os)
 }
 
 std::ostream *trace_sink() { return g_trace_sink; }
+
+void
+trace_event_begin(TraceCat c, std::string_view name)
+{
+    if (event_wanted(c))
+        record(c, 'B', intern(name), 0);
+}
+
+void
+trace_event_end(TraceCat c)
+{
+    /* not the mask: a span's end must pair with its begin even if the
+     * category was switched off in between */
+    if (!par_in_worker())
+        record(c, 'E', 0, 0);
+}
+
+void
+trace_event_instant(TraceCat c, std::string_view name, long long arg)
+{
+    if (event_wanted(c))
+        record(c, 'i', intern(name), arg);
+}
+
+size_t
+trace_event_count()
+{
+    return ring_wrapped ? ring.size() : ring_next;
+}
+
+void
+trace_events_clear()
+{
+    ring_next = 0;
+    ring_wrapped = false;
+}
+
+size_t
+trace_dump_json(std::ostream &o)
+{
+    const size_t n = trace_event_count();
+    const size_t first = ring_wrapped ? ring_next : 0;
+
+    /*
+     * Once the ring has wrapped, the oldest surviving events may be the ends
+     * of spans whose begins were overwritten: drop those. A span still open
+     * (the call that dumps, or events lost to a throw) is closed at the last
+     * timestamp, so every B has its E and the viewer nests them correctly.
+     */
+    std::vector<uint32_t> open;
+    size_t written = 0;
+    uint64_t last_ts = 0;
+    char buf[64];
+
+    o << "{\"traceEvents\":[";
+
+    for (size_t k = 0; k < n; k++) {
+
+        const Event &e = ring[(first + k) % ring.size()];
+        const TraceCat c = static_cast<TraceCat>(1u << e.cat);
+        uint32_t name = e.name;
+
+        if (e.phase == 'B') {
+            open.push_back(e.name);
+        } else if (e.phase == 'E') {
+            if (open.empty())
+                continue;
+            name = open.back();
+            open.pop_back();
+        }
+
+        const CatName *cn = lookup(c);
+        last_ts = e.ts_ns;
+
+        o << (written++ ? ",\n" : "\n");
+        o << "{\"name\":";
+        json_str(o, ev_names[name]);
+        o << ",\"cat\":\"" << (cn ? cn->name : "trace") << "\"";
+        o << ",\"ph\":\"" << e.phase << "\"";
+        snprintf(buf, sizeof(buf), "%.3f", e.ts_ns / 1000.0);
+        o << ",\"ts\":" << buf << ",\"pid\":1,\"tid\":1";
+
+        if (e.phase == 'i') {
+            o << ",\"s\":\"t\"";
+            if (const char *key = arg_key(c))
+                o << ",\"args\":{\"" << key << "\":" << e.arg << "}";
+        }
+        o << "}";
+    }
+
+    snprintf(buf, sizeof(buf), "%.3f", last_ts / 1000.0);
+
+    while (!open.empty()) {
+        o << (written++ ? ",\n" : "\n");
+        o << "{\"name\":";
+        json_str(o, ev_names[open.back()]);
+        o << ",\"ph\":\"E\",\"ts\":" << buf << ",\"pid\":1,\"tid\":1}";
+        open.pop_back();
+    }
+
+    o << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return written;
+}
+
+void trace_set_out_path(const std::string &path) { out_path = path; }
+
+void
+trace_dump_at_exit()
+{
+    std::ofstream f(out_path);
+
+    if (!f) {
+        std::cerr << "mylang: cannot open trace output file "
+                  << out_path << "\n";
+        return;
+    }
+
+    trace_dump_json(f);
+}
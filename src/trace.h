@@ -2,6 +2,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <vector>
 #include <iosfwd>
 
@@ -10,14 +12,22 @@
  *
  * A per-category, toggleable narration of the compiler's reasoning: type
  * inference, inlining, specialization, template instantiation, auto-const,
- * auto-pure, array-storage decisions, const-folding. It is OFF by default and
- * built so that when a category is off the only cost is one bitmask test
- * (`trace_enabled`) - the guarded `TRACE(...)` emits can therefore sit on hot
- * compile paths without harming a normal run.
+ * auto-pure, array-storage decisions, const-folding, loop-invariant hoisting.
+ * It is OFF by default and built so that when a category is off the only cost
+ * is one bitmask test (`trace_enabled`) - the guarded `TRACE(...)` emits can
+ * therefore sit on hot compile paths without harming a normal run.
  *
  * Control surface (both, by the builtins-first rule): the `trace()` /
  * `traceoff()` / `tracing()` builtins and the REPL `:trace` meta-command drive
  * `trace_set` / `trace_clear_all` / `trace_active`.
+ *
+ * The runtime categories (calls .. promotions) narrate the running program
+ * instead: they print nothing, but record timestamped events into an
+ * in-memory ring buffer (the oldest overwritten once it is full) that
+ * `trace_dump()` / `--trace-out FILE` write as Chrome trace-event JSON, to be
+ * opened in Perfetto or chrome://tracing. Same cost model: a disabled
+ * category is one mask test at each hook. While one is on, the worker pool
+ * (parallel.h) is off, so every event is the main thread's.
  */
 
 enum class TraceCat : unsigned {
@@ -29,6 +39,14 @@ enum class TraceCat : unsigned {
     autopure   = 1u << 5,
     arrays     = 1u << 6,
     fold       = 1u << 7,
+    licm       = 1u << 8,
+
+    /* runtime events, recorded into the ring buffer */
+    calls      = 1u << 9,
+    builtins   = 1u << 10,
+    exceptions = 1u << 11,
+    allocs     = 1u << 12,
+    promotions = 1u << 13,
 };
 
 /* The enabled-category bitmask; the hot guard reads it directly. */
@@ -60,8 +78,9 @@ void trace_emit(TraceCat c, int indent, const std::string &msg);
     } while (0)
 
 /* Enable/disable a category by NAME ("infer", "inline", "specialize",
- * "template", "autoconst", "autopure", "arrays", "fold", or "all"). Returns
- * false on an unknown name. */
+ * "template", "autoconst", "autopure", "arrays", "fold", "licm", "calls",
+ * "builtins", "exceptions", "allocs", "promotions", or "all").
+ * Returns false on an unknown name. */
 bool trace_set(const std::string &name, bool on);
 void trace_clear_all();
 
@@ -82,3 +101,55 @@ std::string trace_categories_help(const std::string &indent);
 void trace_set_color(bool on);
 void trace_set_sink(std::ostream *os);
 std::ostream *trace_sink();
+
+/*
+ * Runtime event recording. Like trace_emit, call these only inside a
+ * `trace_enabled(c)` guard. `name` is interned on record, so the caller may
+ * pass a temporary. The timeline and the name table are the main thread's:
+ * should a pool worker (parallel.h) still reach these, its event is dropped
+ * before the name is interned.
+ */
+void trace_event_begin(TraceCat c, std::string_view name);
+void trace_event_end(TraceCat c);
+void trace_event_instant(TraceCat c, std::string_view name, long long arg = 0);
+
+/* A heap block at least this big is an `allocs` event. */
+enum : size_t { TRACE_LARGE_ALLOC = 1024 * 1024 };
+
+/* A begin/end pair around a scope; records only if `c` is enabled on entry. */
+class TraceSpan {
+
+    TraceCat cat;
+    bool active = false;
+
+public:
+
+    TraceSpan(TraceCat c, std::string_view name) : cat(c)
+    {
+        if (trace_enabled(c)) {
+            trace_event_begin(c, name);
+            active = true;
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (active)
+            trace_event_end(cat);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+};
+
+/* Write the buffered events as Chrome trace-event JSON; returns how many. */
+size_t trace_dump_json(std::ostream &out);
+
+/* The number of events buffered, and dropping them all. */
+size_t trace_event_count();
+void trace_events_clear();
+
+/* Write the events to `path` at exit (registered with atexit by
+ * `--trace-out`); the path is set by trace_set_out_path. */
+void trace_set_out_path(const std::string &path);
+void trace_dump_at_exit();
@@ -3,6 +3,7 @@
 #include "eval.h"
 #include "bitops.h"
 #include "hashing.h"
+#include "evalstats.h"
 
 #include <unordered_map>
 #include <vector>
@@ -24,7 +25,10 @@
 #include "builtins/generic.cpp.h"
 #include "builtins/reflect.cpp.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <iterator>
 #include <limits>
 
 static const std::array<SharedStr, Type::t_count> TypeNames =
@@ -48,13 +52,13 @@ static const std::array<SharedStr, Type::t_count> TypeNames =
 EvalValue builtin_exit(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     const EvalValue &e = RValue(arg->eval(ctx));
 
     if (!e.is<int_type>())
-        throw TypeErrorEx("Expected integer", arg->start, arg->end);
+        throw TypeErrorEx("Expected integer", arg->start(), arg->end());
 
     exit(static_cast<int>(e.get<int_type>()));
 }
@@ -87,7 +91,7 @@ static EvalValue make_runtime_type_value(const EvalValue &v)
 EvalValue builtin_type(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     if (dynamic_cast<LiteralObj *>(arg))   /* folded Type object */
@@ -98,7 +102,7 @@ EvalValue builtin_type(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_decltype(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     if (dynamic_cast<LiteralObj *>(arg))   /* folded Type object */
@@ -118,7 +122,7 @@ EvalValue builtin_decltype(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_typestr(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     if (dynamic_cast<LiteralStr *>(arg))   /* folded by the inferencer */
@@ -129,7 +133,7 @@ EvalValue builtin_typestr(EvalContext *ctx, ExprList *exprList)
 EvalValue builtin_kindstr(EvalContext *ctx, ExprList *exprList)
 {
     if (exprList->elems.size() != 1)
-        throw InvalidNumberOfArgsEx(exprList->start, exprList->end);
+        throw InvalidNumberOfArgsEx(exprList->start(), exprList->end());
 
     Construct *arg = exprList->elems[0].get();
     if (dynamic_cast<LiteralStr *>(arg))   /* folded by the inferencer */
@@ -169,30 +173,58 @@ const std::array<Type *, Type::t_count> AllTypes =
  */
 
 static const SharedStr empty_str_actual((string()));
-static const SharedArrayObj empty_arr_actual((std::vector<LValue>()));
+static const SharedArrayObj empty_arr_actual((SharedArrayObj::vec_type()));
 
 const EvalValue empty_str(SharedStr(empty_str_actual, 0, 0));
 const EvalValue empty_arr(SharedArrayObj(empty_arr_actual, 0, 0));
 const EvalValue none;
 
-std::set<UniqueId, UniqueId::Comparator> UniqueId::unique_set;
+std::unordered_map<UniqueId::Key, std::unique_ptr<UniqueId>, UniqueId::KeyHash>
+    UniqueId::table;
 
-inline auto make_const_builtin(const char *name, decltype(Builtin::func) f)
+const UniqueId *UniqueId::intern(const std::string_view &str, size_t h)
 {
-    return make_pair(UniqueId::get(name), LValue(Builtin{f}, true));
+    auto u = std::make_unique<UniqueId>(str);
+    const UniqueId *ret = u.get();
+
+    /* the key views the new UniqueId's own string, not the caller's */
+    table.emplace(Key{ret->val, h}, move(u));
+    return ret;
 }
 
-inline auto make_const_builtin(const char *name, float_type val)
+/*
+ * The builtins, as a constant table: no UniqueId, LValue or map node is made
+ * for them at startup, so a short script pays only for the builtins it uses.
+ * A `const` builtin (make_const_builtin) is visible to const-eval and may fold
+ * at compile time; the rest (make_builtin) are runtime-only. A numeric
+ * constant is an entry with no func.
+ */
+struct BuiltinDecl {
+    string_view name;
+    decltype(Builtin::func) func;
+    float_type val;
+    bool is_const;
+};
+
+constexpr BuiltinDecl
+make_const_builtin(string_view name, decltype(Builtin::func) f)
 {
-    return make_pair(UniqueId::get(name), LValue(val, true));
+    return BuiltinDecl{name, f, 0.0, true};
 }
 
-inline auto make_builtin(const char *name, decltype(Builtin::func) f)
+constexpr BuiltinDecl
+make_const_builtin(string_view name, float_type val)
 {
-    return make_pair(UniqueId::get(name), LValue(Builtin{f}, false));
+    return BuiltinDecl{name, nullptr, val, true};
 }
 
-const EvalContext::SymbolsType EvalContext::const_builtins =
+constexpr BuiltinDecl
+make_builtin(string_view name, decltype(Builtin::func) f)
+{
+    return BuiltinDecl{name, f, 0.0, false};
+}
+
+static constexpr BuiltinDecl builtin_decls[] =
 {
     /* Generic builtins */
     make_const_builtin("defined", builtin_defined),
@@ -281,10 +313,7 @@ const EvalContext::SymbolsType EvalContext::const_builtins =
     make_const_builtin("nan", NAN), /* Not a Number */
     make_const_builtin("inf", INFINITY), /* Infinity */
     make_const_builtin("eps", std::numeric_limits<float_type>::epsilon()),
-};
 
-EvalContext::SymbolsType EvalContext::builtins =
-{
     /* Misc builtins */
     make_builtin("assert", builtin_assert),
     make_builtin("exit", builtin_exit),
@@ -293,6 +322,13 @@ EvalContext::SymbolsType EvalContext::builtins =
     make_builtin("isconstdecl", builtin_isconstdecl),
     make_builtin("ispure", builtin_ispure),
     make_builtin("ispuredecl", builtin_ispuredecl),
+    make_builtin("memoize", builtin_memoize),   /* cross-call memo (memo.h) */
+    make_builtin("memostats", builtin_memostats),
+    make_builtin("memstats", builtin_memstats),  /* heap by kind (memacct.h) */
+    make_builtin("heap_snapshot", builtin_heap_snapshot),   /* heapsnap.h */
+    make_builtin("perf_begin", builtin_perf_begin),     /* perfcount.h */
+    make_builtin("perf_end", builtin_perf_end),
+    make_builtin("bench", builtin_bench),           /* bench.h */
     make_builtin("intptr", builtin_intptr),
     make_builtin("array_storage", builtin_array_storage),
 
@@ -315,6 +351,7 @@ EvalContext::SymbolsType EvalContext::builtins =
     make_builtin("trace", builtin_trace),
     make_builtin("traceoff", builtin_traceoff),
     make_builtin("tracing", builtin_tracing),
+    make_builtin("trace_dump", builtin_trace_dump),
     /* dynarray(a): manual promotion - a fresh general (polymorphic) copy of an
      * array. Non-const (fresh mutable value). See builtin_dynarray. */
     make_builtin("dynarray", builtin_dynarray),
@@ -349,53 +386,131 @@ EvalContext::SymbolsType EvalContext::builtins =
     make_builtin("tmpdir", builtin_tmpdir),
 };
 
+constexpr size_t builtin_decl_count = std::size(builtin_decls);
+
+/* builtin_decls' indexes in name order, sorted at compile time: a name lookup
+ * is a binary search, with nothing to build first. */
+static constexpr auto builtin_by_name = [] {
+
+    std::array<unsigned short, builtin_decl_count> idx = { };
+
+    for (size_t i = 0; i < idx.size(); i++)
+        idx[i] = static_cast<unsigned short>(i);
+
+    for (size_t i = 1; i < idx.size(); i++) {
+        for (size_t j = i; j > 0; j--) {
+
+            if (builtin_decls[idx[j - 1]].name <= builtin_decls[idx[j]].name)
+                break;
+
+            const unsigned short t = idx[j];
+            idx[j] = idx[j - 1];
+            idx[j - 1] = t;
+        }
+    }
+
+    return idx;
+}();
+
+static constexpr bool
+builtin_names_unique()
+{
+    for (size_t i = 1; i < builtin_by_name.size(); i++)
+        if (builtin_decls[builtin_by_name[i - 1]].name ==
+            builtin_decls[builtin_by_name[i]].name)
+            return false;
+
+    return true;
+}
+
+static_assert(builtin_names_unique(), "a builtin name is declared twice");
+
 /*
  * The program-wide builtin table (see eval.h): a flat vector of every builtin's
- * value for O(1) SymKind::builtin access, plus a name->index map for the
- * resolver. Built once, lazily, on first lookup - by which time both builtin
- * maps are fully static-initialized. const_builtins are added first so that on
- * the (non-existent today) chance a name is in both, the const one wins -
- * matching the runtime root map, whose std::map::insert keeps the const entry.
- * Every entry is forced is_const, so an `aBuiltin = x` assignment to an
- * unshadowed builtin raises CannotRebindBuiltinEx and the shared table can't be
- * mutated (it outlives any one program, e.g. across -rt tests).
+ * value for O(1) SymKind::builtin access. Slot i is builtin_decls[i]; the
+ * builtins added at startup (add_builtin: argv) follow. Built once, lazily, on
+ * first use - a script that names no builtin never builds it. Every slot is
+ * forced is_const, so an `aBuiltin = x` assignment to an unshadowed builtin
+ * raises CannotRebindBuiltinEx and the shared table can't be mutated (it
+ * outlives any one program, e.g. across -rt tests).
  */
 static std::vector<LValue> g_builtin_slots;
-/* Per slot: did this builtin come from const_builtins? A const-eval context
- * (AutoConst / the inliner's refold) must see ONLY const builtins - mirroring
- * the const EvalContext, which loads only const_builtins - so a runtime-builtin
- * call there stays unfoldable (those passes rely on the resulting "undefined"
- * to keep it a runtime call). See Identifier::do_eval. */
+/* Per slot: is this a const builtin? A const-eval context (AutoConst / the
+ * inliner's refold) must see ONLY const builtins - mirroring the const
+ * EvalContext, which resolves only those - so a runtime-builtin call there
+ * stays unfoldable (those passes rely on the resulting "undefined" to keep it
+ * a runtime call). See Identifier::do_eval. */
 static std::vector<char> g_builtin_is_const;
-static std::unordered_map<const UniqueId *, int> g_builtin_index;
+/* The names of the add_builtin() slots, after the builtin_decls ones. */
+static std::vector<string> g_builtin_extra_names;
 
 static void
 build_builtin_table_once()
 {
-    if (!g_builtin_index.empty())
+    if (!g_builtin_slots.empty())
         return;
 
-    const auto add = [](const UniqueId *uid, const LValue &lv, bool is_const) {
-        if (g_builtin_index.count(uid))
-            return;
-        g_builtin_index[uid] = static_cast<int>(g_builtin_slots.size());
-        g_builtin_slots.emplace_back(lv.get(), /*is_const=*/true);
-        g_builtin_is_const.push_back(is_const ? 1 : 0);
-    };
+    g_builtin_slots.reserve(builtin_decl_count + 1);
+    g_builtin_is_const.reserve(builtin_decl_count + 1);
+
+    for (const BuiltinDecl &d : builtin_decls) {
 
-    for (const auto &kv : EvalContext::const_builtins)
-        add(kv.first, kv.second, /*is_const=*/true);
+        if (d.func)
+            g_builtin_slots.emplace_back(Builtin{d.func}, /*is_const=*/true);
+        else
+            g_builtin_slots.emplace_back(d.val, /*is_const=*/true);
 
-    for (const auto &kv : EvalContext::builtins)
-        add(kv.first, kv.second, /*is_const=*/false);
+        g_builtin_is_const.push_back(d.is_const ? 1 : 0);
+    }
+}
+
+void
+add_builtin(string_view name, EvalValue &&val)
+{
+    build_builtin_table_once();
+    ML_CHECK(builtin_slot_index(UniqueId::get(name)) < 0);
+
+    g_builtin_slots.emplace_back(move(val), /*is_const=*/true);
+    g_builtin_is_const.push_back(0);
+    g_builtin_extra_names.emplace_back(name);
 }
 
 int
 builtin_slot_index(const UniqueId *uid)
 {
     build_builtin_table_once();
-    const auto it = g_builtin_index.find(uid);
-    return it != g_builtin_index.end() ? it->second : -1;
+
+    const string_view name = uid->val;
+    const auto it = std::lower_bound(
+        builtin_by_name.begin(), builtin_by_name.end(), name,
+        [](unsigned short i, string_view n) {
+            return builtin_decls[i].name < n;
+        });
+
+    if (it != builtin_by_name.end() && builtin_decls[*it].name == name)
+        return *it;
+
+    for (size_t i = 0; i < g_builtin_extra_names.size(); i++)
+        if (g_builtin_extra_names[i] == name)
+            return static_cast<int>(builtin_decl_count + i);
+
+    return -1;
+}
+
+int
+builtin_count()
+{
+    build_builtin_table_once();
+    return static_cast<int>(g_builtin_slots.size());
+}
+
+string_view
+builtin_name(int index)
+{
+    if (static_cast<size_t>(index) < builtin_decl_count)
+        return builtin_decls[index].name;
+
+    return g_builtin_extra_names[index - builtin_decl_count];
 }
 
 LValue &
@@ -12,6 +12,7 @@
 #include "evalvalue.h"
 #include "evaltypes.cpp.h"
 #include "structtype.h"
+#include "trace.h"
 #include <cstring>
 
 /* Materialize the POD-struct element at index `i` (already offset-adjusted)
@@ -35,7 +36,13 @@ void SharedArrayObjTempl<LValueT>::promote_structs_to_general()
     if (shobj->kind != Storage::structs)
         return;
 
+    STAT_INC(struct_promote);
+
     const size_type n = size();
+
+    if (trace_enabled(TraceCat::promotions))
+        trace_event_instant(TraceCat::promotions,
+                            "structs -> general", static_cast<long long>(n));
     vec_type nv;
     nv.reserve(n);
     for (size_type i = 0; i < n; i++)
@@ -89,7 +96,7 @@ void SharedArrayObjTempl<LValueT>::clone_internal_vec()
 
         case Storage::structs: {
             const int stride = shobj->svec.stride;
-            std::vector<char> nb(
+            sbuf_type nb(
                 shobj->svec.buf.cbegin() + offset() * stride,
                 shobj->svec.buf.cbegin() + (offset() + size()) * stride
             );
@@ -530,9 +537,34 @@ EvalValue TypeArr::subscript(const EvalValue &what_lval,
     if (!idx_val.is<int_type>())
         throw TypeErrorEx("Expected integer as subscript");
 
+    int_type idx = idx_val.get<int_type>();
+
+    /*
+     * Flat int/float/bool storage read in place, through the LValue: no copy of
+     * the array handle (no refcount traffic) for the common `x = a[i]` read. It
+     * also keeps such a read free of shared writes, which a parallel loop body
+     * (ForRangeStmt::parallel) relies on.
+     */
+    {
+        const EvalValue &base = what_lval.is<LValue *>()
+            ? what_lval.get<LValue *>()->get() : what_lval;
+        const SharedArrayObj &carr = base.get_ref<SharedArrayObj>();
+        const SharedArrayObj::Storage k = carr.skind();
+
+        if (k != SharedArrayObj::Storage::general &&
+            k != SharedArrayObj::Storage::structs)
+        {
+            if (idx < 0)
+                idx += carr.size();
+            if (idx < 0 || static_cast<size_t>(idx) >= carr.size())
+                throw OutOfBoundsEx();
+            STAT_ELEM(false);
+            return arr_elem_at(carr, idx);
+        }
+    }
+
     const EvalValue &what = RValue(what_lval);
     SharedArrayObj &&arr = what.get<SharedArrayObj>();
-    int_type idx = idx_val.get<int_type>();
 
     if (idx < 0)
         idx += arr.size();
@@ -548,9 +580,12 @@ EvalValue TypeArr::subscript(const EvalValue &what_lval,
      * it can't be a mutate-in-place container target either. So every read that
      * reaches here (print(a[i]), a dyn context, a builtin arg, ...) stays flat.
      */
-    if (arr.skind() != SharedArrayObj::Storage::general)
+    if (arr.skind() != SharedArrayObj::Storage::general) {
+        STAT_ELEM(false);
         return arr_elem_at(arr, idx);
+    }
 
+    STAT_ELEM(true);
     SharedArrayObj::vec_type &vec = arr.get_vec();
     LValue *ret = &vec[arr.offset() + idx];
 
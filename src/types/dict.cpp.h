@@ -108,8 +108,10 @@ EvalValue TypeDict::subscript(const EvalValue &what_lval, const EvalValue &key,
      * A read-only (const) dict never hands out an assignable lvalue: present ->
      * the value, missing -> the default (default dict) or KeyNotFoundEx. On a
      * write target a const dict returns an rvalue so the write fails NotLValue.
+     * Same for a temporary base (`f()[k]`, not an LValue): an lvalue into it
+     * would dangle once the caller drops the temporary.
      */
-    if (flatObj->is_readonly()) {
+    if (flatObj->is_readonly() || !what_lval.is<LValue *>()) {
         if (it != data.end())
             return it->second.get();
         if (obj.get_has_default())
@@ -118,7 +118,7 @@ void TypeStr::append(SharedStr &lval, const string_view &s)
 {
     if (!lval.is_slice()) {
 
-        lval.get_ref() += s;
+        lval.append_in_place(s);
 
     } else {
 
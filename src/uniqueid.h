@@ -3,34 +3,53 @@
 #pragma once
 
 #include "defs.h"
-#include <set>
+#include <memory>
 #include <string>
 #include <string_view>
-
+#include <unordered_map>
+
+/*
+ * An interned identifier: one UniqueId per distinct name, so names compare
+ * (and key maps) by pointer. The intern table is a hash map keyed by a view
+ * of the UniqueId's own string plus its hash, computed once and kept only in
+ * the key: a lookup hashes the string_view once and compares only on a hash
+ * match, and a rehash never re-hashes a name. Each UniqueId is its own
+ * allocation, so its address is stable for the program's lifetime.
+ */
 class UniqueId final {
 
-    struct Comparator {
+    struct Key {
 
-        struct is_transparent { };
+        std::string_view s;
+        size_t h;
 
-        bool operator()(const UniqueId &a, const UniqueId &b) const {
-            return a.val < b.val;
+        bool operator==(const Key &rhs) const {
+            return h == rhs.h && s == rhs.s;
         }
+    };
 
-        bool operator()(const UniqueId &a, const std::string_view &b) const {
-            return a.val < b;
-        }
+    struct KeyHash {
+        size_t operator()(const Key &k) const { return k.h; }
     };
 
-    static std::set<UniqueId, Comparator> unique_set;
+    static std::unordered_map<Key, std::unique_ptr<UniqueId>, KeyHash> table;
+
+    static const UniqueId *intern(const std::string_view &str, size_t h);
 
 public:
 
     const std::string val;
 
-    UniqueId(const std::string_view &str) : val(str) { }
+    explicit UniqueId(const std::string_view &str) : val(str) { }
 
     static const UniqueId *get(const std::string_view &str) {
-        return &(*unique_set.emplace(str).first);
+
+        const size_t h = std::hash<std::string_view>()(str);
+        auto it = table.find(Key{str, h});
+
+        if (it != table.end())
+            return it->second.get();
+
+        return intern(str, h);
     }
 };